@@ -0,0 +1,65 @@
+//*****************************************************************************
+//* Grid generator shared by the benchmarks in bench/.
+//*
+//* Fills a MainData2D the way read_grid would, without a grid file, so the
+//* benchmarks can go up to millions of elements.
+//*****************************************************************************
+#ifndef __BENCH_GRID_INCLUDED__
+#define __BENCH_GRID_INCLUDED__
+
+#include <cstring>
+
+#include "../include/EulerUnsteady2D_basic_package.h"
+
+// Structured triangular grid with n x n nodes on [0,1]x[0,1].
+inline void generate_grid(EulerSolver2D::MainData2D& g, int n) {
+
+   g.nnodes = n*n;
+   g.ntria  = 2*(n-1)*(n-1);
+   g.nquad  = 0;
+   g.nelms  = g.ntria;
+   g.nbound = 4;
+
+   g.node = new EulerSolver2D::node_type[g.nnodes];
+   for (int j = 0; j < n; j++) {
+      for (int i = 0; i < n; i++) {
+         g.node[i+j*n].x = real(i)/real(n-1);
+         g.node[i+j*n].y = real(j)/real(n-1);
+      }
+   }
+
+   g.elm = new EulerSolver2D::elm_type[g.nelms];
+   g.e2v_ptr.resize(g.nelms+1);
+   g.e2v.resize(3*g.nelms);
+   for (int i = 0; i <= g.nelms; i++) g.e2v_ptr[i] = 3*i;
+   int ie = 0;
+   for (int j = 0; j < n-1; j++) {
+      for (int i = 0; i < n-1; i++) {
+         int v1 = i+j*n, v2 = v1+1, v3 = v1+n+1, v4 = v1+n;
+         int tri[2][3] = { {v1,v2,v3}, {v1,v3,v4} };
+         for (int t = 0; t < 2; t++) {
+            g.elm[ie].nvtx = 3;
+            for (int k = 0; k < 3; k++) g.e2v[3*ie+k] = tri[t][k];
+            ie++;
+         }
+      }
+   }
+
+   // bottom, right, top, left: counter-clockwise, domain on the left
+   g.bound = new EulerSolver2D::bgrid_type[g.nbound];
+   for (int ib = 0; ib < g.nbound; ib++) {
+      g.bound[ib].nbnodes = n;
+      g.bound[ib].bnode   = new Array2D<int>(n,1);
+      std::strcpy(g.bound[ib].bc_type, "slip_wall");
+      g.bound[ib].bc = EulerSolver2D::BCType::slip_wall;
+   }
+   for (int k = 0; k < n; k++) {
+      (*g.bound[0].bnode)(k) = k;
+      (*g.bound[1].bnode)(k) = (n-1) + k*n;
+      (*g.bound[2].bnode)(k) = (n*n-1) - k;
+      (*g.bound[3].bnode)(k) = (n-1-k)*n;
+   }
+}
+
+
+#endif //__BENCH_GRID_INCLUDED__
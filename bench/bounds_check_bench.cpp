@@ -0,0 +1,106 @@
+//*****************************************************************************
+//* Benchmark: cost of the Array2D / StateVec bounds checks.
+//*
+//* Built twice by "make bench":
+//*
+//*   run/bench_bounds_checked    -O3 -DCFD_BOUNDS_CHECK
+//*   run/bench_bounds_unchecked  -O3
+//*
+//* The kernel mimics the edge loop of the residual/gradient computation:
+//* for each edge (n1,n2), read the two nodal states through A(i,j),
+//* form the difference and scatter weighted contributions to both nodes.
+//*
+//* Usage: run/bench_bounds_unchecked [nnodes] [nrepeat]
+//*****************************************************************************
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../include/array_template.hpp"
+#include "../include/arrayops.hpp"
+#include "../include/statevec.hpp"
+
+typedef double real;
+
+int main(int argc, char** argv) {
+
+   int nnodes  = (argc > 1) ? std::atoi(argv[1]) : 200000;
+   int nrepeat = (argc > 2) ? std::atoi(argv[2]) : 20;
+   const int nq = 4;
+
+   // a structured-like set of edges: each node connected to the next 3
+   int nedges = 3*(nnodes-3);
+   Array2D<int>  edge(nedges,2);
+   Array2D<real> w(nnodes,nq);
+   Array2D<real> gradx(nnodes,nq);
+   Array2D<real> cx(nedges,1);
+
+   int ie = 0;
+   for (int i = 0; i < nnodes-3; i++) {
+      for (int k = 1; k <= 3; k++) {
+         edge(ie,0) = i;
+         edge(ie,1) = i+k;
+         cx(ie)     = 1.0/real(k);
+         ie++;
+      }
+   }
+   for (int i = 0; i < nnodes; i++)
+      for (int iv = 0; iv < nq; iv++) w(i,iv) = 1.0 + 0.001*i + iv;
+
+   //--------------------------------------------------------------------
+   // 1. Array2D (i,j) accessors
+   auto t0 = std::chrono::steady_clock::now();
+   for (int r = 0; r < nrepeat; r++) {
+      gradx = 0.0;
+      for (int e = 0; e < nedges; e++) {
+         int n1 = edge(e,0);
+         int n2 = edge(e,1);
+         for (int iv = 0; iv < nq; iv++) {
+            real dw = w(n2,iv) - w(n1,iv);
+            gradx(n1,iv) += cx(e)*dw;
+            gradx(n2,iv) += cx(e)*dw;
+         }
+      }
+   }
+   auto t1 = std::chrono::steady_clock::now();
+
+   //--------------------------------------------------------------------
+   // 2. same loop, with the edge states gathered into StateVecs
+   for (int r = 0; r < nrepeat; r++) {
+      gradx = 0.0;
+      for (int e = 0; e < nedges; e++) {
+         int n1 = edge(e,0);
+         int n2 = edge(e,1);
+         StateVec<real,nq> w1, w2;
+         for (int iv = 0; iv < nq; iv++) { w1(iv) = w(n1,iv); w2(iv) = w(n2,iv); }
+         StateVec<real,nq> dw = cx(e)*(w2 - w1);
+         for (int iv = 0; iv < nq; iv++) {
+            gradx(n1,iv) += dw(iv);
+            gradx(n2,iv) += dw(iv);
+         }
+      }
+   }
+   auto t2 = std::chrono::steady_clock::now();
+
+   real checksum = 0.0;
+   for (int i = 0; i < nnodes; i++) checksum += gradx(i,0);
+
+   double s1 = std::chrono::duration<double>(t1-t0).count();
+   double s2 = std::chrono::duration<double>(t2-t1).count();
+   double naccess = double(nrepeat)*nedges*nq*6;
+
+#ifdef CFD_BOUNDS_CHECK
+   std::cout << " bounds checks: ON " << std::endl;
+#else
+   std::cout << " bounds checks: OFF" << std::endl;
+#endif
+   std::cout << " nnodes = " << nnodes << " nedges = " << nedges
+             << " nrepeat = " << nrepeat << std::endl;
+   std::cout << " Array2D  edge loop: " << s1 << " s, "
+             << 1.0e9*s1/naccess << " ns/access" << std::endl;
+   std::cout << " StateVec edge loop: " << s2 << " s, "
+             << 1.0e9*s2/naccess << " ns/access" << std::endl;
+   std::cout << " checksum = " << checksum << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,208 @@
+//*****************************************************************************
+//* Benchmark: LSQ gradient reconstruction, Solver::compute_gradient_nc().
+//*
+//* Built by "make bench" as run/bench_gradient.
+//*
+//* Compares, on the same generated grid (see bench_grid.hpp),
+//*
+//*   per-variable : the previous layout, kept here for reference. Each node
+//*                  owns heap Array2D's for its neighbors and LSQ
+//*                  coefficients (and dx, dy, dw for the quadratic LSQ), and
+//*                  the stencil is walked once per variable, with the
+//*                  gradient type compared for every node.
+//*   fused        : compute_gradient_nc, flat CSR-aligned coefficient tables
+//*                  and one stencil pass for all nq variables.
+//*
+//* for the linear and the quadratic (two-step) LSQ. The two paths must give
+//* the same gradients, bit for bit.
+//*
+//* Usage: run/bench_gradient [nelms] [nrepeat]
+//*****************************************************************************
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/EulerUnsteady2D.h"
+#include "../include/StringOps.h"
+#include "bench_grid.hpp"
+
+using EulerSolver2D::MainData2D;
+using EulerSolver2D::NodeFields;
+using EulerSolver2D::zero;
+
+// Per-node data of the previous layout.
+struct legacy_node {
+   int nnghbrs;
+   Array2D<int>*  nghbr;
+   Array2D<real>* lsq2x2_cx;
+   Array2D<real>* lsq2x2_cy;
+   Array2D<real>* lsq5x5_cx;
+   Array2D<real>* lsq5x5_cy;
+   Array2D<real>* dx;
+   Array2D<real>* dy;
+   Array2D<real>* dw;
+};
+
+static void legacy_setup(MainData2D& g, std::vector<legacy_node>& node) {
+
+   node.resize(g.nnodes);
+   for (int i = 0; i < g.nnodes; i++) {
+      legacy_node& ni = node[i];
+      int nn  = g.node[i].nnghbrs;
+      int n55 = g.lsq5x5_ptr[i+1] - g.lsq5x5_ptr[i];
+      ni.nnghbrs   = nn;
+      ni.nghbr     = new Array2D<int>(nn,1);
+      ni.lsq2x2_cx = new Array2D<real>(nn,1);
+      ni.lsq2x2_cy = new Array2D<real>(nn,1);
+      ni.lsq5x5_cx = new Array2D<real>(n55,1);
+      ni.lsq5x5_cy = new Array2D<real>(n55,1);
+      ni.dx        = new Array2D<real>(nn,1);
+      ni.dy        = new Array2D<real>(nn,1);
+      ni.dw        = new Array2D<real>(g.nq,nn);
+      for (int k = 0; k < nn; k++) {
+         (*ni.nghbr)(k)     = g.nghbr_idx[ g.nghbr_ptr[i] + k ];
+         (*ni.lsq2x2_cx)(k) = g.lsq2x2_cx[ g.nghbr_ptr[i] + k ];
+         (*ni.lsq2x2_cy)(k) = g.lsq2x2_cy[ g.nghbr_ptr[i] + k ];
+      }
+      for (int ii = 0; ii < n55; ii++) {
+         (*ni.lsq5x5_cx)(ii) = g.lsq5x5_cx[ g.lsq5x5_ptr[i] + ii ];
+         (*ni.lsq5x5_cy)(ii) = g.lsq5x5_cy[ g.lsq5x5_ptr[i] + ii ];
+      }
+   }
+}
+
+static void legacy_free(std::vector<legacy_node>& node) {
+   for (legacy_node& ni : node) {
+      delete ni.nghbr;
+      delete ni.lsq2x2_cx; delete ni.lsq2x2_cy;
+      delete ni.lsq5x5_cx; delete ni.lsq5x5_cy;
+      delete ni.dx; delete ni.dy; delete ni.dw;
+   }
+}
+
+// The previous compute_gradient_nc / lsq_gradients_nc / lsq_gradients2_nc,
+// for one variable.
+static void legacy_gradient(MainData2D& g, std::vector<legacy_node>& node,
+                            int ivar, std::string grad_type) {
+
+   NodeFields& f = g.field;
+
+   if (trim(grad_type) == "quadratic2") {
+      for (int i = 0; i < g.nnodes; i++) {
+         for (int k = 0; k < node[i].nnghbrs; k++) {
+            int in = (*node[i].nghbr)(k);
+            (*node[i].dx)(k)      = g.node[in].x - g.node[i].x;
+            (*node[i].dy)(k)      = g.node[in].y - g.node[i].y;
+            (*node[i].dw)(ivar,k) = f.w_at(in)[ivar] - f.w_at(i)[ivar];
+         }
+      }
+   }
+
+   for (int i = 0; i < g.nnodes; i++) {
+
+      real ax = zero, ay = zero;
+
+      if (trim(grad_type) == "linear") {
+         for (int k = 0; k < node[i].nnghbrs; k++) {
+            int in  = (*node[i].nghbr)(k);
+            real da = f.w_at(in)[ivar] - f.w_at(i)[ivar];
+            ax = ax + (*node[i].lsq2x2_cx)(k)*da;
+            ay = ay + (*node[i].lsq2x2_cy)(k)*da;
+         }
+      } else if (trim(grad_type) == "quadratic2") {
+         int ii = -1;
+         for (int k = 0; k < node[i].nnghbrs; k++) {
+            int in = (*node[i].nghbr)(k);
+            for (int ell = 0; ell < node[in].nnghbrs; ell++) {
+               real da = f.w_at(in)[ivar] - f.w_at(i)[ivar] + (*node[in].dw)(ivar,ell);
+               if ( (*node[in].nghbr)(ell) == i ) da = f.w_at(in)[ivar] - f.w_at(i)[ivar];
+               ii = ii + 1;
+               ax = ax + (*node[i].lsq5x5_cx)(ii)*da;
+               ay = ay + (*node[i].lsq5x5_cy)(ii)*da;
+            }
+         }
+      }
+
+      f.gradw_at(i,ivar,0) = ax;
+      f.gradw_at(i,ivar,1) = ay;
+   }
+}
+
+int main(int argc, char** argv) {
+
+   long target = (argc > 1) ? std::atol(argv[1]) : 1000000;
+   int nrepeat = (argc > 2) ? std::atoi(argv[2]) : 10;
+   int n = int( std::sqrt(0.5*double(target)) ) + 1;
+
+   // MainData2D and the LSQ setup are chatty: keep their log out
+   std::ostringstream sink;
+   std::streambuf* cout_buf = std::cout.rdbuf(sink.rdbuf());
+
+   MainData2D g;
+   EulerSolver2D::Solver solver;
+   generate_grid(g, n);
+   g.construct_grid_data();
+   g.nq = 4;
+   g.maxit = 1;                     // no per-node LSQ debug output
+   g.gradient_weight_id = EulerSolver2D::GradientWeight::none;
+   g.field.allocate(g.nnodes, g.nq);
+   solver.compute_lsq_coeff_nc(g);
+
+   std::cout.rdbuf(cout_buf);
+
+   // a smooth, nonlinear state
+   for (int i = 0; i < g.nnodes; i++) {
+      real x = g.node[i].x, y = g.node[i].y;
+      for (int iv = 0; iv < g.nq; iv++)
+         g.field.w_at(i)[iv] = 1.0 + iv + std::sin(3.0*x + iv)*std::cos(2.0*y);
+   }
+
+   std::vector<legacy_node> node;
+   legacy_setup(g, node);
+
+   std::cout << " nnodes = " << g.nnodes << " nelms = " << g.nelms
+             << " nrepeat = " << nrepeat << std::endl;
+   std::cout << "   grad_type   per-variable (s)   fused (s)   speedup   max diff" << std::endl;
+
+   const char* names[2] = {"linear", "quadratic2"};
+   const EulerSolver2D::GradientType types[2] = {EulerSolver2D::GradientType::linear,
+                                                 EulerSolver2D::GradientType::quadratic2};
+   for (int t = 0; t < 2; t++) {
+
+      const char* gtype = names[t];
+
+      auto t0 = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrepeat; r++)
+         for (int ivar = 0; ivar < g.nq; ivar++)
+            legacy_gradient(g, node, ivar, gtype);
+      auto t1 = std::chrono::steady_clock::now();
+      std::vector<real> gradw_legacy = g.field.gradw;
+
+      auto t2 = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrepeat; r++)
+         solver.compute_gradient_nc(g, types[t]);
+      auto t3 = std::chrono::steady_clock::now();
+
+      real diff = zero;
+      for (size_t k = 0; k < gradw_legacy.size(); k++)
+         diff = std::max(diff, std::abs(gradw_legacy[k] - g.field.gradw[k]));
+
+      double s_legacy = std::chrono::duration<double>(t1-t0).count();
+      double s_fused  = std::chrono::duration<double>(t3-t2).count();
+
+      std::cout.width(12); std::cout << gtype;
+      std::cout.width(19); std::cout << s_legacy;
+      std::cout.width(12); std::cout << s_fused;
+      std::cout.width(10); std::cout << s_legacy/s_fused;
+      std::cout.width(11); std::cout << diff << std::endl;
+   }
+
+   legacy_free(node);
+
+   return 0;
+}
@@ -0,0 +1,116 @@
+//*****************************************************************************
+//* Benchmark: solution output, MainData2D::write_vtu_file().
+//*
+//* Built by "make bench" as run/bench_output.
+//*
+//* Writes the grid and the nodal solution of a generated grid (see
+//* bench_grid.hpp) as
+//*
+//*   ascii   : Tecplot FEPOINT through ofstream << with setprecision(16),
+//*             the way the ASCII writers of the code do it.
+//*   vtu     : write_vtu_file, then writer.wait() (the whole write, with the
+//*             default zlib compression if built with -DCFD_ZLIB).
+//*   vtu (solver blocked) : write_vtu_file only, the time the solver waits
+//*             before it can go on: the copy of w into a staging buffer. The
+//*             file is built and written on the I/O thread.
+//*
+//* Files are written to the current directory and removed.
+//*
+//* Usage: run/bench_output [nelms] [nrepeat]
+//*****************************************************************************
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../include/EulerUnsteady2D_basic_package.h"
+#include "bench_grid.hpp"
+
+using EulerSolver2D::MainData2D;
+
+static void write_ascii(MainData2D& g, const std::string& datafile) {
+
+   std::ofstream outfile(datafile);
+   outfile << "title = \"solution\" \n";
+   outfile << "variables = \"x\" \"y\" \"rho\" \"u\" \"v\" \"p\" \n";
+   outfile << "zone N=" << g.nnodes << ",E= " << g.nelms << ",ET=quadrilateral,F=FEPOINT \n";
+   for (int i = 0; i < g.nnodes; i++) {
+      const real* w = g.field.w_at(i);
+      outfile << std::setprecision(16) << g.node[i].x << '\t'
+              << std::setprecision(16) << g.node[i].y << '\t'
+              << std::setprecision(16) << w[0] << '\t'
+              << std::setprecision(16) << w[1] << '\t'
+              << std::setprecision(16) << w[2] << '\t'
+              << std::setprecision(16) << w[3] << "\n";
+   }
+   for (int i = 0; i < g.nelms; i++) {
+      const int k = g.e2v_ptr[i], nv = g.e2v_ptr[i+1] - k;
+      outfile << g.e2v[k]+1 << '\t' << g.e2v[k+1]+1 << '\t' << g.e2v[k+2]+1 << '\t'
+              << g.e2v[k+nv-1]+1 << "\n";
+   }
+}
+
+int main(int argc, char** argv) {
+
+   long target = (argc > 1) ? std::atol(argv[1]) : 1000000;
+   int nrepeat = (argc > 2) ? std::atoi(argv[2]) : 3;
+   int n = int( std::sqrt(0.5*double(target)) ) + 1;
+
+   // MainData2D and construct_grid_data are chatty: keep their log out
+   std::ostringstream sink;
+   std::streambuf* cout_buf = std::cout.rdbuf(sink.rdbuf());
+
+   MainData2D g;
+   generate_grid(g, n);
+   g.construct_grid_data();
+   g.nq = 4;
+   g.field.allocate(g.nnodes, g.nq);
+
+   std::cout.rdbuf(cout_buf);
+
+   // a smooth, nonlinear state
+   for (int i = 0; i < g.nnodes; i++) {
+      real x = g.node[i].x, y = g.node[i].y;
+      real* w = g.field.w_at(i);
+      w[0] = 1.0 + 0.5*std::sin(3.0*x)*std::cos(2.0*y);
+      w[1] = 0.3*std::cos(x + y);
+      w[2] = 0.2*std::sin(x - y);
+      w[3] = 1.0/1.4 + 0.1*x*y;
+   }
+
+   std::cout << " nnodes = " << g.nnodes << " nelms = " << g.nelms
+             << " nrepeat = " << nrepeat << std::endl;
+
+   double s_ascii = 0.0, s_vtu = 0.0, s_blocked = 0.0;
+
+   for (int r = 0; r < nrepeat; r++) {
+
+      auto t0 = std::chrono::steady_clock::now();
+      write_ascii(g, "bench_output.dat");
+      auto t1 = std::chrono::steady_clock::now();
+      g.write_vtu_file("bench_output.vtu", 0.0);
+      auto t2 = std::chrono::steady_clock::now();
+      g.writer.wait();
+      auto t3 = std::chrono::steady_clock::now();
+
+      s_ascii   += std::chrono::duration<double>(t1-t0).count();
+      s_blocked += std::chrono::duration<double>(t2-t1).count();
+      s_vtu     += std::chrono::duration<double>(t3-t1).count();
+   }
+
+   std::cout << "   ascii (s)   vtu (s)   vtu, solver blocked (s)   speedup" << std::endl;
+   std::cout.width(12); std::cout << s_ascii/nrepeat;
+   std::cout.width(10); std::cout << s_vtu/nrepeat;
+   std::cout.width(26); std::cout << s_blocked/nrepeat;
+   std::cout.width(10); std::cout << s_ascii/s_blocked << std::endl;
+
+   std::remove("bench_output.dat");
+   std::remove("bench_output.vtu");
+
+   std::fflush(stdout);
+   return 0;
+}
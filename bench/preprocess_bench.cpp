@@ -0,0 +1,69 @@
+//*****************************************************************************
+//* Benchmark: grid preprocessing time, MainData2D::construct_grid_data().
+//*
+//* Built by "make bench" as run/bench_preprocess.
+//*
+//* Generates a structured triangular grid on the unit square in memory
+//* (n x n nodes, 2(n-1)^2 triangles, 4 boundary segments, the same layout
+//* as read_grid would give), then times construct_grid_data on it.
+//* The default runs go from about 10k to 10M elements (the 10M grid needs
+//* several GB of memory).
+//*
+//* Usage: run/bench_preprocess [nelms_1 nelms_2 ...]
+//*****************************************************************************
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "../include/EulerUnsteady2D_basic_package.h"
+#include "bench_grid.hpp"
+
+using EulerSolver2D::MainData2D;
+
+int main(int argc, char** argv) {
+
+   std::vector<long> sizes;
+   for (int i = 1; i < argc; i++) sizes.push_back(std::atol(argv[i]));
+   if (sizes.empty()) sizes = {10000, 100000, 1000000, 10000000};
+
+   std::cout << "      nelms     nnodes     nedges   construct_grid_data (s)" << std::endl;
+
+   for (long target : sizes) {
+
+      int n = int( std::sqrt(0.5*double(target)) ) + 1;
+      int nelms, nnodes, nedges;
+      double seconds;
+
+      // MainData2D and construct_grid_data are chatty: keep their log out
+      std::ostringstream sink;
+      std::streambuf* cout_buf = std::cout.rdbuf(sink.rdbuf());
+      {
+         MainData2D g;
+         generate_grid(g, n);
+
+         auto t0 = std::chrono::steady_clock::now();
+         g.construct_grid_data();
+         auto t1 = std::chrono::steady_clock::now();
+
+         seconds = std::chrono::duration<double>(t1-t0).count();
+         nelms   = g.nelms;
+         nnodes  = g.nnodes;
+         nedges  = g.nedges;
+      }
+      std::fflush(stdout); // the destructor says goodbye with printf
+      std::cout.rdbuf(cout_buf);
+
+      std::cout << std::endl;
+      std::cout.width(11); std::cout << nelms;
+      std::cout.width(11); std::cout << nnodes;
+      std::cout.width(11); std::cout << nedges;
+      std::cout << "   " << seconds << std::endl;
+   }
+
+   return 0;
+}
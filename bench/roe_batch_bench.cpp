@@ -0,0 +1,90 @@
+//*****************************************************************************
+//* Benchmark and check: batched Roe flux of the 1D solver.
+//*
+//* Built by "make bench" as run/bench_roe_batch.
+//*
+//* First runs Solver::check_roe_flux_batch (roe_flux, roe_flux_batch and
+//* roe_flux_batch_scalar must agree bit for bit) and exits with a non-zero
+//* status on a mismatch. Then times, on nfaces random faces,
+//*
+//*   roe_flux : one call per face, State in and out.
+//*   scalar   : roe_flux_batch_scalar, the same loop over a FaceBatch.
+//*   batch    : roe_flux_batch, the omp simd loop over a FaceBatch.
+//*
+//* Usage: run/bench_roe_batch [nfaces] [nrepeat]
+//*****************************************************************************
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "../include/EulerShockTube1D.h"
+
+using EulerSolver1D::FaceBatch;
+using EulerSolver1D::State;
+
+int main(int argc, char** argv) {
+
+   int n = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+   int nrepeat = (argc > 2) ? std::atoi(argv[2]) : 10;
+
+   EulerSolver1D::Solver solver;
+
+   std::cout << std::endl;
+   if (!solver.check_roe_flux_batch()) return EXIT_FAILURE;
+
+   FaceBatch faces;
+   faces.allocate(n);
+   unsigned int seed = 2024;
+   auto rnd = [&seed](float lo, float hi){
+      seed = 1103515245u*seed + 12345u;
+      return lo + (hi-lo)*float((seed >> 8) & 0xFFFF)/float(0xFFFF);
+   };
+   for (int i = 0; i < n; i++) {
+      faces.wL[0][i] = rnd(0.1f, 2.0f);  faces.wR[0][i] = rnd(0.1f, 2.0f);
+      faces.wL[1][i] = rnd(-1.0f, 1.0f); faces.wR[1][i] = rnd(-1.0f, 1.0f);
+      faces.wL[2][i] = rnd(0.1f, 2.0f);  faces.wR[2][i] = rnd(0.1f, 2.0f);
+   }
+
+   std::cout << " nfaces = " << n << " nrepeat = " << nrepeat << std::endl;
+   std::cout << "   flux        ns/face" << std::endl;
+
+   // roe_flux, one face at a time
+   State wl, wr, f;
+   float sum = 0.0f;  // keeps the calls alive
+   auto t0 = std::chrono::steady_clock::now();
+   for (int r = 0; r < nrepeat; r++) {
+      for (int i = 0; i < n; i++) {
+         for (int k = 0; k < 3; k++) { wl(k) = faces.wL[k][i]; wr(k) = faces.wR[k][i]; }
+         f = solver.roe_flux(wl, wr);
+         sum += f(0);
+      }
+   }
+   auto t1 = std::chrono::steady_clock::now();
+
+   solver.roe_flux_batch_scalar(faces);
+   auto t2 = std::chrono::steady_clock::now();
+   for (int r = 0; r < nrepeat; r++) solver.roe_flux_batch_scalar(faces);
+   auto t3 = std::chrono::steady_clock::now();
+
+   solver.roe_flux_batch(faces);
+   auto t4 = std::chrono::steady_clock::now();
+   for (int r = 0; r < nrepeat; r++) solver.roe_flux_batch(faces);
+   auto t5 = std::chrono::steady_clock::now();
+
+   const double scale = 1.0e9/(double(nrepeat)*n);
+   char line[128];
+   std::snprintf(line, sizeof(line), "   %-8s  %9.2f", "roe_flux",
+                 scale*std::chrono::duration<double>(t1-t0).count());
+   std::cout << line << std::endl;
+   std::snprintf(line, sizeof(line), "   %-8s  %9.2f", "scalar",
+                 scale*std::chrono::duration<double>(t3-t2).count());
+   std::cout << line << std::endl;
+   std::snprintf(line, sizeof(line), "   %-8s  %9.2f", "batch",
+                 scale*std::chrono::duration<double>(t5-t4).count());
+   std::cout << line << std::endl;
+   if (sum != sum) std::cout << " NaN in roe_flux" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,177 @@
+//*****************************************************************************
+//* Benchmark: tiled residual assembly, residual_assembly = "tiled".
+//*
+//* Built by "make bench" as run/bench_tiling.
+//*
+//* Times Solver::compute_residual on a generated grid (see bench_grid.hpp)
+//*
+//*   serial : the gradients of all the nodes into field.gradw, then the edge
+//*            loop over all the edges, adding to field.res.
+//*   tiled  : one tile of tile_size nodes at a time: the gradients of the
+//*            tile and its halo, and the fluxes of its edges, in buffers of
+//*            the tile (see MainData2D::tile_edges).
+//*
+//* for the linear and the quadratic (two-step) LSQ gradients, with the
+//* Rotated-RHLL flux and the Van Albada limiter. The residuals must be the
+//* same, bit for bit.
+//*
+//* Bytes moved per edge: a model, not a measurement. Each array the pass
+//* uses is counted once per pass (the nodes are numbered with locality, so
+//* the neighbors of a node are read from cache), and the node data of a tile
+//* once per tile. The halo of a tile and its cut edges are counted again for
+//* every tile that reads them.
+//*
+//* The nodes are renumbered by node_ordering (default morton), so that a tile
+//* is a compact patch of the grid.
+//*
+//* Usage: run/bench_tiling [nelms] [nrepeat] [node_ordering]
+//*****************************************************************************
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/EulerUnsteady2D.h"
+#include "bench_grid.hpp"
+
+using EulerSolver2D::MainData2D;
+using EulerSolver2D::AssemblyType;
+using EulerSolver2D::GradientType;
+
+// Bytes per stencil entry of the gradient (index(es) and two coefficients).
+static double stencil_bytes(const MainData2D& g, GradientType G, int i) {
+   if (G == GradientType::linear)
+      return (g.nghbr_ptr[i+1] - g.nghbr_ptr[i])*(4.0 + 16.0);
+   return (g.lsq5x5_ptr[i+1] - g.lsq5x5_ptr[i])*(8.0 + 16.0);
+}
+
+// Modeled bytes moved by one residual: {zero, gradients, edges} passes.
+static void model_serial(const MainData2D& g, GradientType G, double b[3]) {
+
+   const double nq = g.nq;
+   b[0] = g.nnodes*(nq + 1)*8.0;                               // res, wsn
+   b[1] = g.nnodes*(nq*8.0 + 4.0 + 2*nq*8.0);                  // w, ptr, gradw
+   for (int i = 0; i < g.nnodes; i++) b[1] += stencil_bytes(g, G, i);
+   b[2] = g.nedges*40.0                                        // n1, n2, dav, da, e
+        + g.nnodes*(nq*8.0 + 16.0 + 2*nq*8.0 + 2*(nq + 1)*8.0); // w, x, y, gradw, res+wsn r/w
+}
+
+static void model_tiled(const MainData2D& g, GradientType G, double b[3]) {
+
+   const double nq = g.nq;
+   b[0] = 0.0;
+   b[1] = 0.0;
+   for (int i = 0; i < g.nnodes; i++) b[1] += nq*8.0 + 4.0 + stencil_bytes(g, G, i);
+   for (int h : g.tile_halo)          b[1] += nq*8.0 + 4.0 + stencil_bytes(g, G, h);
+   const double nread = g.nnodes + double(g.tile_halo.size());  // nodes read by the tiles
+   b[2] = double(g.tile_edge.size())*(40.0 + 4.0 + 8.0)         // + tile_edge, tile_edge_local
+        + nread*16.0                                            // x, y (w: read above)
+        + g.nnodes*(nq + 1)*8.0;                                // res, wsn written once
+}
+
+int main(int argc, char** argv) {
+
+   long target = (argc > 1) ? std::atol(argv[1]) : 1000000;
+   int nrepeat = (argc > 2) ? std::atoi(argv[2]) : 10;
+   std::string ordering = (argc > 3) ? argv[3] : "morton";
+   int n = int( std::sqrt(0.5*double(target)) ) + 1;
+
+   // MainData2D and the LSQ setup are chatty: keep their log out
+   std::ostringstream sink;
+   std::streambuf* cout_buf = std::cout.rdbuf(sink.rdbuf());
+
+   MainData2D g;
+   EulerSolver2D::Solver solver;
+   generate_grid(g, n);
+   g.renumber_nodes(ordering);
+   g.construct_grid_data();
+   g.nq = 4;
+   g.maxit = 1;                     // no per-node LSQ debug output
+   g.gradient_weight_id = EulerSolver2D::GradientWeight::none;
+   g.flux_id    = EulerSolver2D::FluxType::rhll;
+   g.limiter_id = EulerSolver2D::LimiterType::vanalbada;
+   g.field.allocate(g.nnodes, g.nq);
+   solver.compute_lsq_coeff_nc(g);
+
+   std::cout.rdbuf(cout_buf);
+
+   // a smooth, nonlinear state: rho, u, v, p
+   for (int i = 0; i < g.nnodes; i++) {
+      real x = g.node[i].x, y = g.node[i].y;
+      real* w = g.field.w_at(i);
+      w[0] = 1.0 + 0.2*std::sin(3.0*x)*std::cos(2.0*y);
+      w[1] = 0.5 + 0.1*std::cos(2.0*x + y);
+      w[2] = 0.1*std::sin(x - 2.0*y);
+      w[3] = 1.0 + 0.2*std::cos(3.0*x)*std::sin(2.0*y);
+   }
+
+   std::cout << " nnodes = " << g.nnodes << " nedges = " << g.nedges
+             << " node_ordering = " << ordering << " nrepeat = " << nrepeat << std::endl;
+
+   const char* names[2] = {"linear", "quadratic2"};
+   const GradientType types[2] = {GradientType::linear, GradientType::quadratic2};
+   const int tile_sizes[4] = {256, 1024, 4096, 16384};
+
+   for (int t = 0; t < 2; t++) {
+
+      g.gradient_id = types[t];
+
+      g.assembly_id = AssemblyType::serial;
+      solver.compute_residual(g);                    // warm up
+      auto t0 = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrepeat; r++) solver.compute_residual(g);
+      auto t1 = std::chrono::steady_clock::now();
+      const std::vector<real> res_serial = g.field.res;
+      const double s_serial = std::chrono::duration<double>(t1-t0).count();
+
+      double bs[3];
+      model_serial(g, types[t], bs);
+      const double serial_bytes = (bs[0] + bs[1] + bs[2])/g.nedges;
+
+      std::cout << std::endl << " gradient_type = " << names[t] << std::endl;
+      std::cout << "   assembly  tile_size  ns/edge  halo %  cut edges %"
+                << "  bytes/edge (zero+grad+edge)     reduction  max diff" << std::endl;
+
+      char line[256];
+      std::snprintf(line, sizeof(line), "   %8s  %9s  %7.2f  %6s  %11s  %6.0f (%3.0f + %3.0f + %3.0f)  %10s  %8s",
+                    "serial", "-", 1.0e9*s_serial/(double(nrepeat)*g.nedges), "-", "-",
+                    serial_bytes, bs[0]/g.nedges, bs[1]/g.nedges, bs[2]/g.nedges, "-", "-");
+      std::cout << line << std::endl;
+
+      for (int size : tile_sizes) {
+
+         std::cout.rdbuf(sink.rdbuf());
+         g.tile_edges(size);
+         std::cout.rdbuf(cout_buf);
+
+         g.assembly_id = AssemblyType::tiled;
+         solver.compute_residual(g);
+         auto t2 = std::chrono::steady_clock::now();
+         for (int r = 0; r < nrepeat; r++) solver.compute_residual(g);
+         auto t3 = std::chrono::steady_clock::now();
+         const double s_tiled = std::chrono::duration<double>(t3-t2).count();
+
+         real diff = EulerSolver2D::zero;
+         for (size_t k = 0; k < res_serial.size(); k++)
+            diff = std::max(diff, std::abs(res_serial[k] - g.field.res[k]));
+
+         double bt[3];
+         model_tiled(g, types[t], bt);
+         const double tiled_bytes = (bt[0] + bt[1] + bt[2])/g.nedges;
+         const double ncut = double(g.tile_edge.size()) - g.nedges;
+
+         std::snprintf(line, sizeof(line), "   %8s  %9d  %7.2f  %6.1f  %11.2f  %6.0f (%3.0f + %3.0f + %3.0f)  %9.0f%%  %8.1e",
+                       "tiled", size, 1.0e9*s_tiled/(double(nrepeat)*g.nedges),
+                       100.0*double(g.tile_halo.size())/g.nnodes, 100.0*ncut/g.nedges,
+                       tiled_bytes, bt[0]/g.nedges, bt[1]/g.nedges, bt[2]/g.nedges,
+                       100.0*(1.0 - tiled_bytes/serial_bytes), diff);
+         std::cout << line << std::endl;
+      }
+   }
+
+   return 0;
+}
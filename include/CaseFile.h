@@ -0,0 +1,74 @@
+//=================================
+// include guard
+#ifndef __CASEFILE_INCLUDED__
+#define __CASEFILE_INCLUDED__
+
+//********************************************************************************
+//* Case files: runtime parameters for the solvers.
+//*
+//* A case file is a list of "key = value" lines. Everything after '#' is a
+//* comment. A line "[name]" starts a new case; the keys given before the
+//* first [name] line are shared by all the cases of the file, e.g.,
+//*
+//*      solver = euler2d
+//*      grid   = project.grid
+//*      bcmap  = project.bcmap
+//*
+//*      [cfl05]
+//*      CFL = 0.5
+//*
+//*      [cfl09]
+//*      CFL = 0.9
+//*
+//* is two cases on the same grid. A file without [name] lines is one case.
+//*
+//* On the command line (see driver.cpp), "key=value" (or "--key=value", and
+//* "--key" for key=true) arguments override the values of the case files that
+//* follow them, and each file adds its cases to the queue.
+//*
+//********************************************************************************
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CaseFile
+{
+
+class Case{
+
+public:
+
+    std::string name;                            // [name], or the file name
+    std::map<std::string,std::string> param;     // key -> value, as read
+
+    bool has(const std::string& key) const;
+
+    // value of key, or the default when the key is not given;
+    // a value that does not convert stops the program.
+    std::string get(const std::string& key, const std::string& default_value) const;
+    double      get_real(const std::string& key, double default_value) const;
+    int         get_int(const std::string& key, int default_value) const;
+    bool        get_bool(const std::string& key, bool default_value) const;
+
+    // stop the program if a key is not in the list (catches typos)
+    void check_keys(const std::vector<std::string>& known) const;
+};
+
+// Split "key = value" (blanks around both are removed).
+// Returns false if the line has no '=' or no key.
+bool parse_assignment(const std::string& line, std::string& key, std::string& value);
+
+// Read the cases of a file; each case starts from a copy of base.
+std::vector<Case> read_case_file(const std::string& filename, const Case& base);
+
+// Build the case queue from the command line:
+//   key=value  -> overrides the cases of the files that follow
+//   --key      -> key=true (e.g., --restart), --key=value as key=value
+//   filename   -> the cases of that file
+// Without any file, the queue is one case made of the key=value arguments.
+std::vector<Case> cases_from_args(int argc, char** argv);
+
+}
+
+
+#endif //__CASEFILE_INCLUDED__
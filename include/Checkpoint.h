@@ -0,0 +1,177 @@
+//=================================
+// include guard
+#ifndef __CHECKPOINT_INCLUDED__
+#define __CHECKPOINT_INCLUDED__
+
+//********************************************************************************
+//* Binary dumps: checkpoints of the solution and caches of grid data.
+//*
+//*  hash_bytes : 64-bit FNV-1a hash, used to tie a dump to its mesh.
+//*  Writer     : appends values and arrays to a byte buffer.
+//*  Reader     : reads them back, in the same order, from a byte buffer.
+//*  MappedFile : a file mapped read-only into memory (mmap), for a Reader
+//*               to read from without loading the whole file first.
+//*
+//* A dump is a header (8-char magic, version, ...) followed by the values in
+//* the order they were put. Arrays are stored as their length (int64) and
+//* their raw contents, in the byte order of the machine that wrote them.
+//* A Reader never reads past the end: a short or corrupt dump makes ok()
+//* false, and the caller falls back to computing the data.
+//*
+//* Files are written with SolutionWriter::write_file (temp file + rename), so
+//* a dump is either complete or absent, even if the run is killed.
+//*
+//* See MainData2D::write_checkpoint, MainData2D::write_grid_cache and
+//* EulerSolver1D::Solver::write_checkpoint.
+//********************************************************************************
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Checkpoint
+{
+
+const uint64_t hash_seed = 14695981039346656037ULL;
+
+// FNV-1a of nbytes bytes, continuing from h.
+uint64_t hash_bytes(const void* data, size_t nbytes, uint64_t h = hash_seed);
+
+template<class T>
+uint64_t hash_vector(const std::vector<T>& v, uint64_t h) {
+   return hash_bytes(v.data(), v.size()*sizeof(T), h);
+}
+
+// Whole file into bytes; false if it cannot be read.
+bool read_file(const std::string& filename, std::vector<char>& bytes);
+
+
+
+class Writer{
+
+public:
+
+    std::vector<char> bytes;
+
+    template<class T>
+    void put(const T& value) {
+       const char* p = reinterpret_cast<const char*>(&value);
+       bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+
+    template<class T>
+    void put_array(const T* a, int64_t n) {
+       put(n);
+       const char* p = reinterpret_cast<const char*>(a);
+       if (n > 0) bytes.insert(bytes.end(), p, p + n*sizeof(T));
+    }
+
+    template<class T>
+    void put_vector(const std::vector<T>& v) { put_array(v.data(), int64_t(v.size())); }
+
+    void put_magic(const char magic[8]) { bytes.insert(bytes.end(), magic, magic + 8); }
+};
+
+
+
+class Reader{
+
+public:
+
+    explicit Reader(const std::vector<char>& bytes_in) : data(bytes_in.data()), size(bytes_in.size()) {}
+    Reader(const char* data_in, size_t size_in) : data(data_in), size(size_in) {}
+
+    bool ok() const { return good; }
+
+    template<class T>
+    T get() {
+       T value{};
+       if (!have(sizeof(T))) return value;
+       std::memcpy(&value, data + pos, sizeof(T));
+       pos += sizeof(T);
+       return value;
+    }
+
+    // An array of exactly n values into a (n = -1: any length); returns the length.
+    template<class T>
+    int64_t get_array(T* a, int64_t n) {
+       const int64_t m = get<int64_t>();
+       if (!good || m < 0 || (n >= 0 && m != n) || size_t(m) > (size - pos)/sizeof(T)) {
+          good = false;
+          return 0;
+       }
+       if (m > 0) std::memcpy(a, data + pos, m*sizeof(T));
+       pos += m*sizeof(T);
+       return m;
+    }
+
+    template<class T>
+    void get_vector(std::vector<T>& v) {
+       const int64_t m = peek_length(sizeof(T));
+       if (!good) return;
+       v.resize(m);
+       get_array(v.data(), m);
+    }
+
+    // Byte position, and a jump to a position found earlier (e.g. stored in a header).
+    size_t position() const { return pos; }
+    void seek(size_t p) { if (p > size) good = false; else pos = p; }
+
+    bool check_magic(const char magic[8]) {
+       if (!have(8) || std::memcmp(data + pos, magic, 8) != 0) { good = false; return false; }
+       pos += 8;
+       return true;
+    }
+
+private:
+
+    bool have(size_t n) {
+       if (!good || pos + n > size) good = false;
+       return good;
+    }
+
+    // the length of the next array, checked against the bytes left
+    int64_t peek_length(size_t value_size) {
+       int64_t m = -1;
+       if (have(sizeof(int64_t))) std::memcpy(&m, data + pos, sizeof(int64_t));
+       if (m < 0 || (size - pos - sizeof(int64_t))/value_size < size_t(m)) good = false;
+       return m;
+    }
+
+    const char* data;
+    size_t size;
+    size_t pos  = 0;
+    bool   good = true;
+};
+
+
+
+// Read-only mapping of a whole file; the pages are read as they are used.
+// Falls back to reading the file into memory where mmap is not available.
+class MappedFile{
+
+public:
+
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool        ok()   const { return base != nullptr || (nbytes == 0 && opened); }
+    const char* data() const { return base; }
+    size_t      size() const { return nbytes; }
+
+private:
+
+    const char* base   = nullptr;
+    size_t      nbytes = 0;
+    bool        opened = false;
+    bool        mapped = false;
+    std::vector<char> copy;   // without mmap
+};
+
+}
+
+
+#endif //__CHECKPOINT_INCLUDED__
@@ -10,21 +10,57 @@
 #include "../include/array_template.hpp"
 #include "../include/arrayops.hpp"
 
+//======================================
+// fixed size (stack allocated) states
+#include "../include/statevec.hpp"
+
+//======================================
+// background I/O thread (snapshots)
+#include "../include/SolutionWriter.h"
+
+#include "../include/CaseFile.h"
+
+#include <string>
+#include <vector>
+
 
 namespace EulerSolver1D
 {
 
+// 1D Euler states: 3 components (rho, rho*u, rho*E) or (rho, u, p)
+typedef StateVec<float,3> State;
+
 
 
 
 // use an array of structs (may be inefficient//)
 struct cell_data{
     float xc;  // Cell-center coordinate
-    Array2D<float> u  = Array2D<float>(3,1);  // Conservative variables = [rho, rho*u, rho*E]
-    Array2D<float> u0 = Array2D<float>(3,1);  // Conservative variables at the previous time step
-    Array2D<float> w  = Array2D<float>(3,1);  // Primitive variables = [rho, u, p]
-    Array2D<float> dw = Array2D<float>(3,1);  // Slope (difference) of primitive variables
-    Array2D<float> res= Array2D<float>(3,1);  // Residual = f_{j+1/2) - f_{j-1/2)
+    State u;    // Conservative variables = [rho, rho*u, rho*E]
+    State u0;   // Conservative variables at the previous time step
+    State w;    // Primitive variables = [rho, u, p]
+    State dw;   // Slope (difference) of primitive variables
+    State res;  // Residual = f_{j+1/2) - f_{j-1/2)
+};
+
+
+
+// structure of arrays of face states, for batched flux evaluation:
+// component k of face i is wL[k][i], wR[k][i], flux[k][i].
+struct FaceBatch{
+    int nfaces = 0;
+    std::vector<float> wL[3];    // left  states (rho, u, p)
+    std::vector<float> wR[3];    // right states (rho, u, p)
+    std::vector<float> flux[3];  // numerical flux
+
+    void allocate(int n){
+        nfaces = n;
+        for (int k = 0; k < 3; ++k){
+            wL[k].assign(n, 0.0f);
+            wR[k].assign(n, 0.0f);
+            flux[k].assign(n, 0.0f);
+        }
+    }
 };
 
 
@@ -48,17 +84,44 @@ public:
     float minmod(float a, float b);
     
     // transforms:
-    void w2u_efficient( Array2D<float>& w, Array2D<float>& u );
-    void u2w_efficient( Array2D<float>& u, Array2D<float>& w );
-    Array2D<float> u2w( Array2D<float>& u);
-    Array2D<float> w2u( Array2D<float>& w);
+    void w2u_efficient( const State& w, State& u );
+    void u2w_efficient( const State& u, State& w );
+    State u2w( const State& u);
+    State w2u( const State& w);
     
     //flux:
-    Array2D<float> roe_flux(Array2D<float>&  wL, Array2D<float>&  wR);
-    Array2D<float> euler_physical_flux(Array2D<float>& w);
+    State roe_flux(const State&  wL, const State&  wR);
+    State euler_physical_flux(const State& w);
+
+    //batched flux: all faces in a FaceBatch at once
+    void roe_flux_batch(FaceBatch& faces);        // SIMD (omp simd) loop
+    void roe_flux_batch_scalar(FaceBatch& faces); // scalar fallback
+    bool check_roe_flux_batch();   // false on mismatch (run/bench_roe_batch)
 
     //print;
     void output();
+    void snapshot();
+    void write_solution(const std::string& filename);
+
+    //Snapshots during Euler1D: every snapshot_steps time steps and/or at the
+    //first step past each multiple of snapshot_dt (0 = off), to
+    //snapshot_prefix_0000.dat, ... (same columns as solution.dat).
+    int         snapshot_steps  = 0;
+    float       snapshot_dt     = 0.0;
+    std::string snapshot_prefix = "solution_snapshot";
+    int         nsnapshots      = 0;
+
+    //Checkpoints: every checkpoint_steps time steps and at the end (0 = off),
+    //to checkpoint_file; restart = true starts Euler1D from checkpoint_file.
+    void write_checkpoint(const std::string& filename);
+    bool read_checkpoint(const std::string& filename);
+    std::string checkpoint_file  = "solution.ckp";
+    int         checkpoint_steps = 0;
+    bool        restart          = false;
+
+    //Background I/O thread for output() and the snapshots; pending files
+    //are finished before the Solver goes away.
+    SolutionWriter::AsyncWriter writer;
 
     struct constants{
         const float  zero = 0.0;
@@ -86,11 +149,12 @@ public:
 
     //Local variables used for computing numerical fluxes.
     // init arrays here
-    Array2D<float>  dwl = Array2D<float>(3,1);  //Slopes between j and j-1, j and j+1
-    Array2D<float>  dwr = Array2D<float>(3,1);  //Slopes between j and j-1, j and j+1
-    Array2D<float>  wL = Array2D<float>(3,1);   //Extrapolated states at a face
-    Array2D<float>  wR = Array2D<float>(3,1);   //Extrapolated states at a face
-    Array2D<float>  flux = Array2D<float>(3,1); //Numerical flux
+    State  dwl;   //Slopes between j and j-1, j and j+1
+    State  dwr;   //Slopes between j and j-1, j and j+1
+    State  wL;    //Extrapolated states at a face
+    State  wR;    //Extrapolated states at a face
+    State  flux;  //Numerical flux
+    FaceBatch faces; //Interior faces j+1/2, j=1,ncells-1 (batched flux)
 
     cell_data* cell;
 
@@ -100,6 +164,7 @@ public:
 //=================================
 // the driver function
 void driverEuler1D();
+void driverEuler1D(const CaseFile::Case& c); //snapshot parameters from a case
 
 } //namespace Euler1D
 
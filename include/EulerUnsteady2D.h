@@ -164,6 +164,7 @@
 //======================================
 // 2D Euler approximate Riemann sovler data structs
 #include "../include/EulerUnsteady2D_basic_package.h"
+#include "../include/CaseFile.h"
 
 
 namespace EulerSolver2D
@@ -181,13 +182,19 @@ public:
     // destructor
     ~Solver();
 
-    void euler_solver_main(EulerSolver2D::MainData2D& E2Ddata);
+    // false if the run stopped on a non-physical state
+    bool euler_solver_main(EulerSolver2D::MainData2D& E2Ddata);
     void compute_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddata);
     void check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddata);
 
-    void compute_gradient_nc(EulerSolver2D::MainData2D& E2Ddata, int ivar, std::string grad_type_temp);
-    void lsq_gradients_nc(EulerSolver2D::MainData2D& E2Ddata, int inode, int ivar);
-    void lsq_gradients2_nc(EulerSolver2D::MainData2D& E2Ddata, int inode, int ivar);
+    void compute_gradient_nc(EulerSolver2D::MainData2D& E2Ddata, EulerSolver2D::GradientType grad_type);
+    template <EulerSolver2D::GradientType G>
+    void compute_gradient_kernel(EulerSolver2D::MainData2D& E2Ddata);
+    void lsq_gradients_nc(EulerSolver2D::MainData2D& E2Ddata, int inode);
+    void lsq_gradients2_nc(EulerSolver2D::MainData2D& E2Ddata, int inode);
+    // the same, into gradw[ivar*2+ix] (e.g. the buffer of a tile)
+    void lsq_gradients_nc(EulerSolver2D::MainData2D& E2Ddata, int inode, real* gradw);
+    void lsq_gradients2_nc(EulerSolver2D::MainData2D& E2Ddata, int inode, real* gradw);
 
     
     void lsq01_2x2_coeff_nc(EulerSolver2D::MainData2D& E2Ddata, int inode);
@@ -200,23 +207,85 @@ public:
 
     void initial_solution_shock_diffraction( EulerSolver2D::MainData2D& E2Ddata);
     
-    // primative to conserved variables
-    Array2D<real> w2u(const Array2D<real>& w, 
+    // primative to conserved variables (w[0..3] -> u[0..3])
+    void w2u(const real* w, real* u,
                         EulerSolver2D::MainData2D& E2Ddata);
-    // conservative to primitive variables
-    Array2D<real> u2w(const Array2D<real>& u, 
+    // conservative to primitive variables (u[0..3] -> w[0..3])
+    void u2w(const real* u, real* w,
                         EulerSolver2D::MainData2D& E2Ddata);
 
     void eliminate_normal_mass_flux(
                         EulerSolver2D::MainData2D& E2Ddata);
 
+    // residual, time step and RK update (node-centered, edge-based)
+    // compute_residual dispatches to the kernel specialized for the
+    // scheme options (see MainData2D::set_scheme_options).
+    void compute_residual(EulerSolver2D::MainData2D& E2Ddata);
+    template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L,
+              EulerSolver2D::GradientType G>
+    void compute_residual_kernel(EulerSolver2D::MainData2D& E2Ddata);
+    template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L,
+              EulerSolver2D::GradientType G>
+    void edge_flux(EulerSolver2D::MainData2D& E2Ddata, int i,
+                        real* flux, real& wsn);
+    template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L,
+              EulerSolver2D::GradientType G>
+    void edge_flux(EulerSolver2D::MainData2D& E2Ddata, int i,
+                        const real* g1, const real* g2, real* flux, real& wsn);
+    template <EulerSolver2D::FluxType F>
+    bool boundary_flux(EulerSolver2D::MainData2D& E2Ddata, EulerSolver2D::BCType bc,
+                        const real* w1, real nx, real ny, real* num_flux, real& wsn);
+    void compute_time_step(EulerSolver2D::MainData2D& E2Ddata, real& dt);
+    bool update_solution(EulerSolver2D::MainData2D& E2Ddata, real coeff, real dt);
+    void residual_norm(EulerSolver2D::MainData2D& E2Ddata, real res_norm[][3]);
+
+    // implicit mode (time_stepping = "implicit"): backward Euler with the
+    // Jacobian of the first-order residual (Rusanov flux), see implicit_update
+    void flux_jacobian(const real* w, real nx, real ny, double* a,
+                        EulerSolver2D::MainData2D& E2Ddata);
+    void compute_jacobian(EulerSolver2D::MainData2D& E2Ddata, real cfl);
+    bool implicit_update(EulerSolver2D::MainData2D& E2Ddata, real cfl, int& sweeps);
+    real change_fraction(const real* w, const double* du, EulerSolver2D::MainData2D& E2Ddata);
+    void slip_wall_jacobian_rows(EulerSolver2D::MainData2D& E2Ddata, real cfl);
+    void slip_wall_rhs_rows(EulerSolver2D::MainData2D& E2Ddata, std::vector<double>& b);
+    // linear_solver = "gmres": Jacobian-free Newton-Krylov (GMRES)
+    int  newton_krylov_solve(EulerSolver2D::MainData2D& E2Ddata, real cfl,
+                        const std::vector<double>& b, std::vector<double>& du);
+    void slip_wall_zero_normal(EulerSolver2D::MainData2D& E2Ddata, std::vector<double>& du);
+
+    // multigrid (multigrid_levels > 1): FAS on agglomerated coarse levels,
+    // first-order residual and Runge-Kutta smoothing on them
+    void setup_multigrid(EulerSolver2D::MainData2D& E2Ddata);
+    bool multigrid_correction(EulerSolver2D::MainData2D& E2Ddata);
+    bool multigrid_cycle(EulerSolver2D::MainData2D& E2Ddata, int l);
+    void coarse_residual(EulerSolver2D::MainData2D& E2Ddata, Multigrid::Level& L);
+    bool coarse_smooth(EulerSolver2D::MainData2D& E2Ddata, int l);
+    void restrict_to(EulerSolver2D::MainData2D& E2Ddata, int l, const real* u,
+                        const real* res, const real* forcing);
+
+    real va_slope_limiter(real da, real db, real h);
+    void wall_mirror_gradient(const real* g, const real* n, real* gm);
+
+    // numerical fluxes: w = primitive (rho,u,v,p), (nx,ny) = unit normal
+    void roe(const real* wL, const real* wR, real nx, real ny,
+                        real* num_flux, real& wsn,
+                        EulerSolver2D::MainData2D& E2Ddata);
+    void rotated_rhll(const real* wL, const real* wR, real nx, real ny,
+                        real* num_flux, real& wsn,
+                        EulerSolver2D::MainData2D& E2Ddata, const real* n1 = nullptr);
+    void rotated_rhll_smooth(const real* wL, const real* wR, real nx, real ny,
+                        real* num_flux, real& wsn,
+                        EulerSolver2D::MainData2D& E2Ddata);
+
 };
 
 
 
 //=================================
-// the driver function
+// the driver functions: the default case, or a queue of cases
+// (see CaseFile.h and program_2D_euler_rk2)
 void driverEuler2D();
+void driverEuler2D(const std::vector<CaseFile::Case>& cases);
 
 
 }//end namespace
@@ -72,6 +72,7 @@ classes:
 //======================================
 //stl
 #include <vector> 
+#include <cstdint>
 using std::vector;
 
 
@@ -83,12 +84,34 @@ using std::vector;
 #include "array_template.hpp"
 #include "arrayops.hpp"
 
+//======================================
+// fixed size (stack allocated) states
+#include "statevec.hpp"
+
 #include "vector1D.h"
 
 //======================================
 // math functions
 #include "MathGeometry.h"
 
+//======================================
+// binary output, background I/O thread
+#include "SolutionWriter.h"
+
+//======================================
+// implicit mode: block Jacobian, GMRES
+#include "SparseBlock.h"
+#include "Krylov.h"
+
+//======================================
+// steady mode: agglomeration multigrid
+#include "Multigrid.h"
+
+//======================================
+// multi-process runs: subdomains, halo exchange
+#include "Partition.h"
+#include "Halo.h"
+
 //======================================
 // string trimfunctions
 //#include "StringOps.h" 
@@ -195,14 +218,37 @@ namespace EulerSolver2D
 namespace EulerSolver2D{
 
 
+//----------------------------------------------------------
+// Scheme and boundary condition selectors.
+//
+// The options are given as strings (inviscid_flux, limiter_type, ...,
+// bc_type) and parsed once into these enums, see
+// MainData2D::set_scheme_options() and parse_bc_type().
+// The loops of the solver only compare enums.
+//----------------------------------------------------------
+enum class FluxType       { roe, rhll };
+enum class LimiterType    { none, vanalbada };
+enum class GradientType   { none, linear, quadratic2 };
+enum class GradientWeight { none, inverse_distance };
+enum class AssemblyType   { coloring, owner, serial, tiled };
+enum class TimeStepping   { global, local, implicit };
+enum class LinearSolver   { gs, umfpack, gmres };
+enum class Preconditioner { jacobian, block_jacobi };
+enum class MGCycle        { v, w };
+enum class BCType         { unknown, freestream, slip_wall, outflow_supersonic,
+                            outflow_back_pressure, dirichlet };
+
+BCType parse_bc_type(const std::string& bc_type);
+
+
 // use an array of structs (may be inefficient//)
 struct cell_data{
     real xc;  // Cell-center coordinate
-    Array2D<real> u   = Array2D<real>(4,1);  // Conservative variables = [rho, rho*u, rho*E]
-    Array2D<real> u0  = Array2D<real>(4,1);  // Conservative variables at the previous time step
-    Array2D<real> w   = Array2D<real>(4,1);  // Primitive variables = [rho, u, p]
-    Array2D<real> dw  = Array2D<real>(4,1);  // Slope (difference) of primitive variables
-    Array2D<real> res = Array2D<real>(4,1);  // Residual = f_{j+1/2) - f_{j-1/2)
+    StateVec<real,4> u;    // Conservative variables = [rho, rho*u, rho*E]
+    StateVec<real,4> u0;   // Conservative variables at the previous time step
+    StateVec<real,4> w;    // Primitive variables = [rho, u, p]
+    StateVec<real,4> dw;   // Slope (difference) of primitive variables
+    StateVec<real,4> res;  // Residual = f_{j+1/2) - f_{j-1/2)
 };
 
 //fwd declare
@@ -211,84 +257,91 @@ class elm_type;
 //----------------------------------------------------------
 // Data type for nodal quantities (used for node-centered schemes)
 // Note: Each node has the following data.
+//
+// Only geometry and topology live here. The solution fields
+// (u, w, gradw, res, dt, ...) are stored contiguously for all
+// nodes in NodeFields, owned by MainData2D (see below).
 //----------------------------------------------------------
 class node_type
 {
 
 public:
 
-    node_type(){}
-    ~node_type(){
-
-      delete nghbr;
-      delete lsq2x2_cx;
-      delete lsq2x2_cy;
-      delete lsq5x5_cx;
-      delete lsq5x5_cy;
-      delete dx;
-      delete dy;
-      delete dw;
-
-      delete u;
-      delete du;
-      delete gradu;
-      delete w;
-      delete gradw;
-      delete res;
-
-      delete r_temp;
-      delete u_temp;
-      delete w_temp;
-    }
+    node_type() {}
+    ~node_type(){}
     //  to be read from a grid file
     real x, y;                  //nodal coordinates
     //  to be constructed in the code
 
 
 
-    int nnghbrs;   //number of neighbors
-    //int,   dimension(:), pointer  :: nghbr     //list of neighbors
-    //vector<int> nghbr;        //list of neighbors
-    Array2D<int>*  nghbr;       //list of neighbors
+    int nnghbrs;   //number of neighbors (list: MainData2D::nghbr_idx)
 
-    int nelms;                  //number of elements
-    Vector1D<int> elm;          //dynamic vector of elements
-    //vector<int> elm;          //dynamic vector of elements
+    int nelms;     //number of elements (list: MainData2D::n2e_idx)
 
     real vol;                   //dual-cell volume
     int bmark;                  //Boundary mark
     int nbmarks;                //# of boundary marks
     //  to be computed in the code
     //Below are arrays always allocated.
-    Array2D<real>* uexact;      // conservative variables
     real ar;                    //      Control volume aspect ratio
-    Array2D<real>* lsq2x2_cx;   //    Linear LSQ coefficient for ux
-    Array2D<real>* lsq2x2_cy;   //    Linear LSQ coefficient for uy
-    Array2D<real>* lsq5x5_cx;   // Quadratic LSQ coefficient for ux
-    Array2D<real>* lsq5x5_cy;   // Quadratic LSQ coefficient for uy
-    Array2D<real>* dx;          // Extra data used by Quadratic LSQ
-    Array2D<real>* dy;          // Extra data used by Quadratic LSQ
-    //Array2D<real>* dw         // Extra data used by Quadratic LSQ
-    Array2D<real>* dw;          // Extra data used by Quadratic LSQ (2D)
+                                //  (LSQ coefficients: MainData2D::lsq2x2_cx, ...)
+
+};
+
+//----------------------------------------------------------
+// Nodal solution data, structure-of-arrays layout.
+//
+// One contiguous array per field for all nodes, stored node-major:
+// component ivar of node i lives at [i*nq + ivar], and the gradient
+// component ix (0=x, 1=y) at [(i*nq + ivar)*2 + ix].
+// Scalars per node (dt, phi, wsn) are indexed by the node number.
+//----------------------------------------------------------
+class NodeFields
+{
+
+public:
+
+    NodeFields() : nnodes(0), nq(0) {}
+
+    void allocate(int nnodes_in, int nq_in){
+      nnodes = nnodes_in;
+      nq     = nq_in;
+      u.assign(     nnodes*nq,   0.0);
+      u0.assign(    nnodes*nq,   0.0);
+      du.assign(    nnodes*nq,   0.0);
+      w.assign(     nnodes*nq,   0.0);
+      gradw.assign( nnodes*nq*2, 0.0);
+      res.assign(   nnodes*nq,   0.0);
+      dt.assign(    nnodes,      0.0);
+      phi.assign(   nnodes,      0.0);
+      wsn.assign(   nnodes,      0.0);
+    }
+
+    // pointers to the first component of node i
+    real* u_at(  int i) { return &u[  i*nq]; }
+    real* u0_at( int i) { return &u0[ i*nq]; }
+    real* du_at( int i) { return &du[ i*nq]; }
+    real* w_at(  int i) { return &w[  i*nq]; }
+    real* res_at(int i) { return &res[i*nq]; }
+    real& gradw_at(int i, int ivar, int ix) { return gradw[(i*nq + ivar)*2 + ix]; }
+
+    int nnodes;                 //number of nodes stored
+    int nq;                     //number of variables per node
 
     //consertvative solution data
-    Array2D<real>* u;           // conservative variables
-    Array2D<real>* du;          //change in conservative variables
-    Array2D<real>* gradu;       // gradient of u (2D) Array2D<real>* du;          //change in conservative variables
+    vector<real> u;             // conservative variables
+    vector<real> u0;            // conservative variables at the previous stage
+    vector<real> du;            // change in conservative variables
     //nonconservative
-    Array2D<real>* w;           //primitive variables(optional)
-    Array2D<real>* gradw;       //gradient of w (2D)
+    vector<real> w;             // primitive variables(optional)
+    vector<real> gradw;         // gradient of w (2D)
     //residual
-    Array2D<real>* res;         // residual (rhs)z
+    vector<real> res;           // residual (rhs)
     // Rieman data
-    real phi;                   //limiter function (0 <= phi <= 1)
-    real dt;                    //local time step
-    real wsn;                   //Half the max wave speed at face
-    Array2D<real>*  r_temp;     // For GCR implementation
-    Array2D<real>*  u_temp;     // For GCR implementation
-    Array2D<real>*  w_temp;     // For GCR implementation
-
-    //cell_data cell; //simpler to use the class structure instead of another structure
+    vector<real> dt;            // local time step
+    vector<real> phi;           // limiter function (0 <= phi <= 1)
+    vector<real> wsn;           // Half the max wave speed at face
 };
 
 //----------------------------------------------------------
@@ -298,9 +351,11 @@ public:
   class elm_type{
     public:
 
-      elm_type(){ tracked_index = 0;}
+      elm_type() : nghbr(nullptr), edge(nullptr),
+                   u(nullptr), uexact(nullptr), gradu(nullptr), res(nullptr),
+                   lsq2x2_cx(nullptr), lsq2x2_cy(nullptr)
+                   { tracked_index = 0;}
       ~elm_type(){
-        delete vtx;
         delete nghbr;
         delete edge;
         delete u;
@@ -312,8 +367,7 @@ public:
         delete lsq2x2_cy;
       }
       //  to be read from a grid file
-      int nvtx;                   //number of vertices
-      Array2D<int>*  vtx;         //list of vertices
+      int nvtx;                   //number of vertices (list: MainData2D::e2v)
       //  to be constructed in the code
       int nnghbrs;                //number of neighbors
       Array2D<int>*  nghbr;       //list of neighbors
@@ -330,8 +384,7 @@ public:
       real dt;                     //local time step
       real wsn;                    //??
       int bmark;                   //Boundary mark
-      int nvnghbrs;                //number of vertex neighbors
-      Vector1D<int> vnghbr;        //dynamic vector of elements
+      int nvnghbrs;                //number of vertex neighbors (list: MainData2D::vnghbr_idx)
       real ar;                     //Element volume aspect ratio
       Array2D<real>* lsq2x2_cx;    //Linear LSQ coefficient for ux
       Array2D<real>* lsq2x2_cy;    //Linear LSQ coefficient for uy
@@ -383,6 +436,7 @@ public:
       }
       //  to be read from a boundary grid file
       char bc_type[80];     //type of boundary condition
+      BCType bc = BCType::unknown; //bc_type parsed (read_grid)
       int nbnodes; //# of boundary nodes
       Array2D<int>* bnode;  //list of boundary nodes
       //  to be constructed in the code
@@ -396,6 +450,7 @@ public:
       Array2D<int>*  belm;  //list of elm adjacent to boundary face
       Array2D<int>*  kth_nghbr_of_1;
       Array2D<int>*  kth_nghbr_of_2;
+      int corner = -1;      //bnode index of the corner node (slip: zero y-momentum), -1: none
   };
 
 //----------------------------------------------------------
@@ -457,6 +512,15 @@ public:
 //********************************************************************************
 namespace EulerSolver2D{
 
+  // Header of the binary grid file (see read_grid_binary).
+  struct GridBinaryHeader{
+    char    magic[8];   // "EDU2DGRD"
+    int32_t nnodes;
+    int32_t ntria;
+    int32_t nquad;
+    int32_t nbound;
+  };
+
   class MainData2D{
     
 
@@ -468,15 +532,49 @@ namespace EulerSolver2D{
 
     // build the grid:
     void read_grid(std::string datafile_grid_in, std::string datafile_bcmap_in);
+    void read_grid_ascii(const std::string& datafile_grid_in);
+    void read_grid_binary(const std::string& datafile_grid_in);
+    bool is_binary_grid(const std::string& datafile_grid_in);
+    void write_grid_binary(const std::string& datafile);
+    void renumber_nodes(const std::string& ordering);
+    void node_bandwidth(long& bandwidth, long& profile, real& ave_span);
     void construct_grid_data();
+    void set_scheme_options();
     void check_grid_data();
     void check_skewness_nc();
     void compute_ar();
 
+    // threading of the edge loop (see compute_residual):
+    void color_edges();
+    void check_edge_coloring();
+    void partition_nodes(int nparts);
+    void tile_edges(int tile_size);
+    void compute_wall_normals();
+
+    // domain decomposition: this grid <- the subdomain s of the grid g, at
+    // once or through bytes (packed on rank 0, unpacked on the rank of s)
+    void extract_subdomain(const MainData2D& g, const Partition::Subdomain& s);
+    std::vector<char> pack_subdomain(const Partition::Subdomain& s) const;
+    void unpack_subdomain(const std::vector<char>& bytes);
+
 
     // output
     void write_tecplot_file(const std::string& datafile);
     void write_grid_file(const std::string& datafile);
+    void write_vtu_file(const std::string& datafile, real time);
+    void write_snapshot(real time);
+    std::shared_ptr<const SolutionWriter::VTUGrid> make_vtu_grid();
+
+    // checkpoint/restart
+    uint64_t mesh_hash();
+    void write_checkpoint(const std::string& datafile, real time, int step);
+    bool read_checkpoint(const std::string& datafile, real& time, int& step);
+
+    // grid data cache (construct_grid_data, check_grid_data, LSQ coefficients)
+    uint64_t lsq_hash();
+    void write_grid_cache(const std::string& datafile);
+    bool read_grid_cache(const std::string& datafile);
+    bool read_lsq_cache(const std::string& datafile);
     // logging
     void boot_diagnostic(const std::string& filename);
     void write_diagnostic(std::ostringstream& message,
@@ -491,6 +589,32 @@ namespace EulerSolver2D{
 
     std::string  diagnosticfile = "out.dat";
 
+    //Output - solution (VTK binary .vtu, see write_vtu_file)
+    std::string  datafile_solution = "project.vtu";
+    int          vtu_compression = 1;   //zlib level, 0 = none (needs -DCFD_ZLIB)
+
+    //Snapshots during euler_solver_main (see write_snapshot): every
+    //snapshot_steps time steps and/or at the first step past each multiple of
+    //snapshot_dt (0 = off), to snapshot_prefix_0000.vtu, ..., listed with their
+    //times in snapshot_prefix.pvd.
+    int          snapshot_steps  = 0;
+    real         snapshot_dt     = 0.0;
+    std::string  snapshot_prefix = "project_snapshot";
+    std::vector< std::pair<double,std::string> > snapshot_files;
+    std::shared_ptr<const SolutionWriter::VTUGrid> vtu_grid;  //built once per run
+
+    //Checkpoints (see write_checkpoint): every checkpoint_steps time steps and
+    //at the end of the run (0 = off), to checkpoint_file. restart = true starts
+    //euler_solver_main from checkpoint_file instead of the initial solution.
+    //(The grid data goes to a grid cache file, see write_grid_cache.)
+    std::string  checkpoint_file  = "project.ckp";
+    int          checkpoint_steps = 0;
+    bool         restart          = false;
+
+    //Background I/O thread for the solution files; pending files are
+    //finished before MainData2D goes away.
+    SolutionWriter::AsyncWriter writer;
+
     //  Parameters
 
     //Number of equtaions/variables in the target equtaion.
@@ -505,10 +629,97 @@ namespace EulerSolver2D{
     std::string inviscid_flux; //Numerial flux for the inviscid terms (Euler)
     std::string limiter_type;  //Choice of a limiter
 
+    //Node ordering applied after read_grid: "none" (file order),
+    //  "rcm" = Reverse Cuthill-McKee, "morton" = Morton (Z-order) curve on (x,y).
+    //  With "rcm" or "morton" the edges are also sorted by their min node.
+    std::string node_ordering;
+
+    //Residual assembly: "coloring" = threads over the edges of one color at a time
+    //                   "owner"    = threads own node blocks, halo buffers
+    //                   "serial"   = single thread, edges in order
+    //                   "tiled"    = threads over tiles of tile_size nodes, each
+    //                                with its own gradients and residuals
+    std::string residual_assembly;
+    int         tile_size = 1024;
+
+    //Time stepping: "global"   = the minimum local dt at all nodes (time accurate,
+    //                             march to t_final)
+    //               "local"    = each node with its own dt (steady mode: iterate
+    //                             until the residual has dropped by residual_tolerance)
+    //               "implicit" = steady mode with backward Euler at local time
+    //                             steps (see Solver::implicit_update)
+    std::string time_stepping = "global";
+
+    //Implicit mode: the CFL number grows from CFL_start as the residual drops
+    //(CFL_start/drop), up to CFL. The linear system of each iteration is solved
+    //by linear_solver = "gs" (symmetric block Gauss-Seidel, at most
+    //linear_sweeps sweeps or a linear_tolerance drop of the linear residual)
+    //or "umfpack" (sparse LU, needs -DCFD_UMFPACK), with the Jacobian of the
+    //first-order residual; or "gmres" (Jacobian-free Newton-Krylov: the exact
+    //Jacobian of the residual, by differences, see Solver::newton_krylov_solve),
+    //at most gmres_iterations iterations (restarted every gmres_restart) or a
+    //linear_tolerance drop, preconditioned by the first-order Jacobian:
+    //preconditioner = "jacobian" (preconditioner_sweeps Gauss-Seidel sweeps)
+    //or "block_jacobi" (its diagonal blocks only).
+    real        CFL_start            = 10.0;
+    std::string linear_solver        = "gs";
+    int         linear_sweeps        = 10;
+    real        linear_tolerance     = 0.1;
+    int         gmres_restart        = 30;
+    int         gmres_iterations     = 60;
+    std::string preconditioner       = "jacobian";
+    int         preconditioner_sweeps = 2;
+
+    //The options above, parsed once by set_scheme_options().
+    FluxType       flux_id            = FluxType::rhll;
+    bool           roe_einfeldt       = false;  //inviscid_flux = roe_einfeldt (flux_id = roe)
+    LimiterType    limiter_id         = LimiterType::vanalbada;
+    GradientType   gradient_id        = GradientType::linear;
+    GradientWeight gradient_weight_id = GradientWeight::none;
+    AssemblyType   assembly_id        = AssemblyType::coloring;
+    TimeStepping   time_stepping_id   = TimeStepping::global;
+    LinearSolver   linear_solver_id   = LinearSolver::gs;
+    Preconditioner preconditioner_id  = Preconditioner::jacobian;
+    MGCycle        multigrid_cycle_id = MGCycle::v;
+
+    //Multigrid (time_stepping = "local"): FAS with multigrid_levels levels
+    //(1 = off), the coarse ones agglomerated from the grid, and a "v" or "w"
+    //multigrid_cycle after each Runge-Kutta step (see Solver::multigrid_correction).
+    int         multigrid_levels = 1;
+    std::string multigrid_cycle  = "v";
+
+    //Steady mode (time_stepping = "local"): converged when the L1 norm of the
+    //residual of every variable is below residual_tolerance times the largest
+    //L1 norm of that variable so far. The history of the residual norms
+    //(L1, L2, Linf) is written to history_file through write_diagnostic.
+    real        residual_tolerance = 1.0e-6;
+    std::string history_file       = "log/history.dat";
+
+    //Steady modes with the Rotated-RHLL flux: the flux is blended with that of
+    //the face tangent as the velocity difference drops below rhll_smoothing
+    //times the sound speed, so that it is smooth (see Solver::rotated_rhll_smooth).
+    //Set by set_scheme_options; 0 (time accurate): the flux of the paper.
+    real        rhll_smoothing = 0.0;
+
     //Unsteady schemes (e.g., RK2)
     int time_step_max; //Maximum physical time steps
     real CFL;           //CFL number for a physical time step
     real t_final;       //Final time for unsteady computation
+    real time = 0.0;    //Time of the current solution (euler_solver_main)
+
+    //Work of a run (reset and reported by euler_solver_main): the residual
+    //evaluations (compute_residual), those of them in Jacobian-vector products
+    //(linear_solver = "gmres"), and the seconds spent in the residual, the
+    //Jacobian assembly, the linear solver or preconditioner, and the Krylov
+    //vector operations (GMRES less its products and preconditioner).
+    struct work_counters {
+       long   residual_evals = 0;
+       long   matvecs        = 0;
+       double residual_time  = 0.0;
+       double jacobian_time  = 0.0;
+       double linear_time    = 0.0;
+       double krylov_time    = 0.0;
+    } work;
 
     //Reference quantities
     real M_inf, rho_inf, u_inf, v_inf, p_inf;
@@ -517,26 +728,117 @@ namespace EulerSolver2D{
     real gamma = 1.4;
 
     //  Node data
-    int                              nnodes; //total number of nodes
-    node_type* node;   //array of nodes
+    int                              nnodes = 0; //total number of nodes
+    node_type* node = nullptr;   //array of nodes
+    NodeFields field;  //solution data at nodes (SoA)
 
     //  Element data (element=cell)
-    int                              ntria;   //total number of triangler elements
-    int                              nquad;   //total number of quadrilateral elements
-    int                              nelms;   //total number of elements
-    elm_type*  elm;     //array of elements
+    int                              ntria = 0;   //total number of triangler elements
+    int                              nquad = 0;   //total number of quadrilateral elements
+    int                              nelms = 0;   //total number of elements
+    elm_type*  elm = nullptr;     //array of elements
+
+    //  Connectivity in compressed sparse row (CSR) form: the entries of row i
+    //  are idx[ ptr[i] ... ptr[i+1]-1 ], e.g., the vertices of element i are
+    //  e2v[ e2v_ptr[i] ... e2v_ptr[i+1]-1 ]. Built by counting, then filling
+    //  (see read_grid and construct_grid_data).
+    std::vector<int>                 e2v_ptr;     //element -> vertices (ccw)
+    std::vector<int>                 e2v;
+    std::vector<int>                 n2e_ptr;     //node -> surrounding elements
+    std::vector<int>                 n2e_idx;
+    std::vector<int>                 nghbr_ptr;   //node -> edge-connected nodes
+    std::vector<int>                 nghbr_idx;
+    std::vector<int>                 vnghbr_ptr;  //element -> vertex neighbors
+    std::vector<int>                 vnghbr_idx;
+
+    //  LSQ gradient coefficients, flat (see compute_lsq_coeff_nc).
+    //  Linear: one (cx,cy) per neighbor, aligned with nghbr_idx.
+    //  Quadratic: stencil of node i is ii = lsq5x5_ptr[i] ... lsq5x5_ptr[i+1]-1,
+    //  entry ii is the neighbor lsq5x5_m[ii] of the neighbor lsq5x5_in[ii].
+    std::vector<real>                lsq2x2_cx;   //    Linear LSQ coefficient for ux
+    std::vector<real>                lsq2x2_cy;   //    Linear LSQ coefficient for uy
+    std::vector<int>                 lsq5x5_ptr;
+    std::vector<int>                 lsq5x5_in;
+    std::vector<int>                 lsq5x5_m;
+    std::vector<real>                lsq5x5_cx;   // Quadratic LSQ coefficient for ux
+    std::vector<real>                lsq5x5_cy;   // Quadratic LSQ coefficient for uy
+
+    //  Jacobian of the first-order residual for the implicit mode: 4x4 blocks,
+    //  the off-diagonal ones aligned with nghbr_idx (see compute_jacobian).
+    SparseBlock::BlockMatrix         jac;
+    Krylov::GMRES                    gmres;   // linear_solver = "gmres" (its basis is kept)
+
+    //  Multigrid levels: mg[0] = the grid (volumes), mg[1...] = coarse levels
+    //  (see Solver::setup_multigrid).
+    std::vector<Multigrid::Level>    mg;
 
     //  Edge data
-    int                              nedges;  //total number of edges
-    edge_type* edge;    //array of edges
+    int                              nedges = 0;  //total number of edges
+    edge_type* edge = nullptr;    //array of edges
+
+    //  Edge coloring: no two edges of the same color share a node.
+    //  Edges of color c: color_edge[ color_ptr[c] ... color_ptr[c+1]-1 ]
+    int                              ncolors = 0;
+    std::vector<int>                 color_ptr;
+    std::vector<int>                 color_edge;
+
+    //  Node partitions for the owner-computes assembly (nparts blocks of nodes,
+    //  at most owner_parts, whatever the number of threads).
+    //  Part p owns nodes part_node_ptr[p] ... part_node_ptr[p+1]-1, and computes
+    //  the edges part_edge[ part_edge_ptr[p] ... part_edge_ptr[p+1]-1 ] (n1 owned).
+    //  Contributions to nodes owned by another part go to the halo buffers;
+    //  part p adds the entries (halo_in[2*j], halo_in[2*j+1]) = (part q, entry m),
+    //  j = halo_in_ptr[p] ... halo_in_ptr[p+1]-1, in this order.
+    int                              owner_parts = 64;
+    int                              nparts = 0;
+    std::vector<int>                 node_part;
+    std::vector<int>                 part_node_ptr;
+    std::vector<int>                 part_edge_ptr;
+    std::vector<int>                 part_edge;
+    std::vector< std::vector<int> >  halo_node;  //per part: target nodes
+    std::vector< std::vector<real> > halo_res;   //per part: nq residuals + wsn
+    std::vector<int>                 halo_in_ptr;
+    std::vector<int>                 halo_in;
+
+    //  Tiles for the tiled assembly (ntiles blocks of about tile_size nodes).
+    //  Tile t owns nodes tile_node_ptr[t] ... tile_node_ptr[t+1]-1, and computes
+    //  the edges tile_edge[ tile_edge_ptr[t] ... tile_edge_ptr[t+1]-1 ] with an
+    //  end owned (cut edges are in both tiles), in the order of the edges.
+    //  The other ends are the halo of the tile: tile_halo[ tile_halo_ptr[t] ...
+    //  tile_halo_ptr[t+1]-1 ]. The two ends of tile edge k are the tile-local
+    //  nodes tile_edge_local[2*k] and [2*k+1]: the owned nodes 0 ... nown-1,
+    //  then the halo nodes.
+    int                              ntiles = 0;
+    int                              tile_max_nodes = 0;  //max owned + halo nodes
+    std::vector<int>                 tile_node_ptr;
+    std::vector<int>                 tile_halo_ptr;
+    std::vector<int>                 tile_halo;
+    std::vector<int>                 tile_edge_ptr;
+    std::vector<int>                 tile_edge;
+    std::vector<int>                 tile_edge_local;
+    std::vector< std::vector<real> > tile_work;  //per thread: gradients, residuals, wsn
 
     //  Boundary data
-    int                               nbound; //total number of boundary types
-    bgrid_type* bound;  //array of boundary segments
+    int                               nbound = 0; //total number of boundary types
+    bgrid_type* bound = nullptr;  //array of boundary segments
+
+    //  wall_normal[2*i], [2*i+1] = outward unit normal of the slip wall at
+    //  node i, zero off the slip walls (see compute_wall_normals): the limiter
+    //  of Solver::edge_flux takes the upwind differences of these nodes from
+    //  their mirror image. Built by construct_grid_data, read_grid_cache and
+    //  unpack_subdomain.
+    std::vector<real>                 wall_normal;
 
     //  Face data (cell-centered scheme only)
-    int                               nfaces; //total number of cell-faces
-    face_type*  face;   //array of cell-faces
+    int                               nfaces = 0; //total number of cell-faces
+    face_type*  face = nullptr;   //array of cell-faces
+
+    //  Domain decomposition (ranks > 1, see Partition.h and Halo.h): the
+    //  subdomain of this rank (local nodes 0 ... nodes_owned()-1 are owned, the
+    //  others ghosts) and its halo exchange. Empty for the whole grid.
+    Partition::Subdomain             sub;
+    Halo::Exchange                   halo;
+    int nodes_owned() const { return sub.global.empty() ? nnodes : sub.nowned; }
 
     //debug
     int maxit = 2;
@@ -0,0 +1,105 @@
+//=================================
+// include guard
+#ifndef __HALO_INCLUDED__
+#define __HALO_INCLUDED__
+
+//********************************************************************************
+//* The ranks (processes) of a decomposed run, and the halo exchange between
+//* their subdomains (see Partition.h).
+//*
+//*  start    : starts the ranks, first thing in main. Built with -DCFD_MPI
+//*             (see Makefile): the MPI processes (mpirun -np N run/Euler2D).
+//*             Otherwise: nranks > 1 forks nranks-1 processes of the program,
+//*             which share memory with it (the shared-memory fallback, to run
+//*             on one host without MPI). The other ranks write their output to
+//*             log/rank_<r>.log.
+//*  finish   : the end of the run (rank 0 waits for the forked processes).
+//*  sum, min, max, all : reductions over the ranks, in place, with the same
+//*             result on every rank.
+//*  scatter  : bytes from rank 0 to each rank (e.g., the subdomains, so that
+//*             only rank 0 holds the whole grid).
+//*  Exchange : the halo of a subdomain: the values of the ghost nodes from the
+//*             ranks that own them (update), and the values of the owned nodes
+//*             of all ranks to rank 0 (gather).
+//*
+//* All of these are collective: every rank calls them, in the same order.
+//* With one rank they do nothing.
+//*
+//*      Halo::start(argc, argv, nranks);
+//*      ...
+//*      halo.setup(sub, 8);              // sub: Partition::Subdomain of this rank
+//*      halo.update(w.data(), 4);        // 4 values per node: ghosts <- owners
+//*      Halo::sum(norms, 12);
+//*
+//* The forked processes must start before any thread (OpenMP included): a
+//* forked copy of a process with threads cannot use them.
+//********************************************************************************
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Partition.h"
+
+namespace Halo
+{
+
+void start(int& argc, char**& argv, int nranks);
+void finish();
+
+int  rank();
+int  size();
+std::string backend();      // "MPI", "shared memory" or "serial"
+
+// v[0 ... n-1] (shared memory: max_values at a time)
+const int max_values = 64;
+void sum(double* v, int n);
+void min(double* v, int n);
+void max(double* v, int n);
+bool all(bool ok);          // true if ok on every rank
+
+// mine <- parts[rank] of rank 0 (parts is read on rank 0 only)
+void scatter(const std::vector< std::vector<char> >& parts, std::vector<char>& mine);
+
+class Exchange{
+
+public:
+
+    Exchange() = default;
+    ~Exchange();
+
+    Exchange(const Exchange&) = delete;
+    Exchange& operator=(const Exchange&) = delete;
+
+    // The halo of subdomain s, for at most max_stride values per node.
+    void setup(const Partition::Subdomain& s, int max_stride);
+    bool active() const { return nranks > 1; }
+
+    // data[stride*i ... stride*i+stride-1] of the ghost nodes i <- their owners
+    void update(double* data, int stride);
+
+    // out[stride*g ... ] of every grid node g <- the rank that owns it (out is
+    // used on rank 0 only)
+    void gather(const double* data, int stride, double* out);
+
+private:
+
+    void release();
+
+    int rank = 0, nranks = 1, nowned = 0, max_stride = 0;
+    std::vector<int> nbr, send_ptr, send_idx, recv_ptr, recv_idx;
+    std::vector<int> owned_global;                 // grid numbers of the owned nodes
+
+    // MPI: message buffers; on rank 0, the owned nodes of all ranks
+    std::vector<double> sendbuf, recvbuf, gatherbuf;
+    std::vector<int>    all_global, all_count, all_displ;
+
+    // shared memory: one mapping with a region per rank (see Halo.cpp)
+    char*  arena       = nullptr;
+    size_t arena_bytes = 0;
+    std::vector<size_t> region;
+};
+
+}
+
+
+#endif //__HALO_INCLUDED__
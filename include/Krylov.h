@@ -0,0 +1,63 @@
+//=================================
+// include guard
+#ifndef __KRYLOV_INCLUDED__
+#define __KRYLOV_INCLUDED__
+
+//********************************************************************************
+//* Krylov solvers for A*x = b, with A and the preconditioner given as
+//* functions (y = A*x), so that A need not be stored: e.g., the Jacobian-free
+//* Jacobian-vector products of Solver::newton_krylov_solve.
+//*
+//*  GMRES : restarted GMRES(m), right-preconditioned: it solves A*M^{-1}*y = b
+//*          and x = M^{-1}*y, so the residual it minimizes is that of A*x = b.
+//*          The Krylov basis (m+1 vectors) is one contiguous array, kept
+//*          between calls.
+//*
+//* Typical use:
+//*
+//*      Krylov::GMRES gmres;
+//*      gmres.restart = 30;  gmres.max_iterations = 60;  gmres.tolerance = 0.1;
+//*      x.assign(n, 0.0);
+//*      int its = gmres.solve(A, M, b, x);   // until ||b - A*x|| <= tolerance*||b||
+//*
+//********************************************************************************
+#include <functional>
+#include <vector>
+
+namespace Krylov
+{
+
+// y = A*x, x and y: n contiguous values (y does not overlap x)
+using linear_map = std::function< void(const double* x, double* y) >;
+
+class GMRES{
+
+public:
+
+    int    restart        = 30;     // m: vectors in the basis before a restart
+    int    max_iterations = 60;     // A*x products, over all restarts
+    double tolerance      = 0.1;    // on ||b - A*x||_2 / ||b||_2
+
+    // x: initial guess in, solution out. A, M: the matrix and the
+    // preconditioner (y = M^{-1}*x). Returns the number of A*x products.
+    int solve(const linear_map& A, const linear_map& M,
+              const std::vector<double>& b, std::vector<double>& x);
+
+    // ||b - A*x||_2 / ||b||_2 at the end of the last solve (the GMRES estimate)
+    double residual() const { return rel_residual; }
+
+private:
+
+    std::vector<double> v;        // Krylov basis: v[k*n ... k*n+n-1] = v_k, k = 0..m
+    std::vector<double> h;        // Hessenberg matrix, (m+1) x m, column-major
+    std::vector<double> cs, sn;   // Givens rotations
+    std::vector<double> g;        // rotated right-hand side, ||r|| e_1
+    std::vector<double> y;        // least-squares solution
+    std::vector<double> w, z;     // work vectors of size n
+    double rel_residual = 0.0;
+};
+
+}
+
+
+#endif //__KRYLOV_INCLUDED__
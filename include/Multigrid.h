@@ -0,0 +1,64 @@
+//=================================
+// include guard
+#ifndef __MULTIGRID_INCLUDED__
+#define __MULTIGRID_INCLUDED__
+
+//********************************************************************************
+//* Coarse levels for agglomeration multigrid (see Solver::multigrid_cycle).
+//*
+//*  Level   : a grid of cells (median-dual volumes of the nodes on the finest
+//*            level, agglomerates of the cells of the level above on the
+//*            coarser ones), with its interior and boundary faces and the
+//*            solution arrays of the FAS cycle.
+//*  coarsen : agglomerates the cells of a level into the cells of the next.
+//*
+//* A face of a coarse level is the sum of the finer faces between the same two
+//* agglomerates: its directed area (ax,ay) is the sum of theirs, so the
+//* coarse control volumes stay closed. Boundary faces are summed per
+//* agglomerate and boundary segment.
+//*
+//*      Multigrid::Level fine;               // ncells, vol, faces of the grid
+//*      Multigrid::coarsen(fine, coarse);    // coarse.parent[i] = agglomerate of cell i
+//*
+//********************************************************************************
+#include <vector>
+
+namespace Multigrid
+{
+
+struct Level{
+
+    int ncells = 0;
+
+    // agglomerate (cell of this level) of each cell of the finer level;
+    // empty on the finest level
+    std::vector<int>    parent;
+
+    std::vector<double> vol;        // volume of each cell
+
+    // interior faces: cells e1 -> e2, directed area (eax,eay) pointing out of e1
+    std::vector<int>    e1, e2;
+    std::vector<double> eax, eay;
+
+    // boundary faces: cell, boundary segment (index of bound[]), outward directed area
+    std::vector<int>    bcell, bseg;
+    std::vector<double> bax, bay;
+
+    // FAS cycle, nq values per cell (wsn: one): conservative and primitive
+    // variables, u before the smoothing stage, u as restricted (ur), residual,
+    // forcing term, and the sum of the wave speeds times the face areas.
+    std::vector<double> u, u0, ur, w, res, forcing, wsn;
+
+    void allocate(int nq);
+};
+
+// coarse = agglomerates of the cells of fine: each cell, in order (those with
+// boundary faces first), that is not yet in an agglomerate starts one with its
+// free neighbors; an agglomerate of a single cell is then merged with its
+// smallest neighbor. Sets coarse.parent, ncells, vol and the faces.
+void coarsen(const Level& fine, Level& coarse);
+
+}
+
+
+#endif //__MULTIGRID_INCLUDED__
@@ -0,0 +1,72 @@
+//=================================
+// include guard
+#ifndef __PARTITION_INCLUDED__
+#define __PARTITION_INCLUDED__
+
+//********************************************************************************
+//* Domain decomposition of the nodes of a grid among the ranks (processes) of a
+//* run, see Halo.h for the communication between them.
+//*
+//*  rcb       : recursive coordinate bisection of the node coordinates.
+//*  metis     : METIS k-way partitioning of the node graph, if built with
+//*              -DCFD_METIS (see Makefile).
+//*  Subdomain : the nodes of one rank, its own ("owned") nodes and one layer of
+//*              ghost nodes (the neighbors of the owned nodes that other ranks
+//*              own), and which nodes it sends to / receives from each
+//*              neighboring rank.
+//*
+//* Both partitioners are deterministic. Rank 0 partitions the grid and sends
+//* each rank its subdomain (see MainData2D::pack_subdomain and Halo::scatter).
+//*
+//*      Partition::rcb(x, y, nranks, part);            // part[i] = rank of node i
+//*      Partition::subdomain(part, nranks, nghbr_ptr, nghbr_idx, rank, sub);
+//*
+//********************************************************************************
+#include <vector>
+
+namespace Partition
+{
+
+// true if metis is available (built with -DCFD_METIS)
+bool metis_available();
+
+// part[i] = the part (0 ... nparts-1) of the point (x[i],y[i]): the points are
+// cut at the median of the longer side of their bounding box, recursively,
+// into parts of sizes that differ by at most one point.
+void rcb(const std::vector<double>& x, const std::vector<double>& y, int nparts,
+         std::vector<int>& part);
+
+// part[i] = the part of node i, from the node graph (CSR: the neighbors of i
+// are idx[ptr[i] ... ptr[i+1]-1]), minimizing the edges cut. Stops the program
+// if built without METIS.
+void metis(const std::vector<int>& ptr, const std::vector<int>& idx, int nparts,
+           std::vector<int>& part);
+
+struct Subdomain{
+
+    int rank   = 0;
+    int nranks = 1;
+    int nowned = 0;             // local nodes 0 ... nowned-1 are owned, the others ghosts
+
+    std::vector<int> global;    // grid node number of each local node
+
+    // Neighboring ranks, and the local nodes exchanged with nbr[k]:
+    //   sent     : send_idx[ send_ptr[k] ... send_ptr[k+1]-1 ]  (owned nodes)
+    //   received : recv_idx[ recv_ptr[k] ... recv_ptr[k+1]-1 ]  (ghost nodes)
+    // both in the order of their grid node numbers, so that the lists of the
+    // sender and of the receiver match.
+    std::vector<int> nbr;
+    std::vector<int> send_ptr, send_idx;
+    std::vector<int> recv_ptr, recv_idx;
+};
+
+// The subdomain of rank: the owned nodes (part == rank) in grid order, then the
+// ghosts, grouped by the rank that owns them.
+void subdomain(const std::vector<int>& part, int nranks,
+               const std::vector<int>& ptr, const std::vector<int>& idx,
+               int rank, Subdomain& s);
+
+}
+
+
+#endif //__PARTITION_INCLUDED__
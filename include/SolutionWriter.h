@@ -0,0 +1,179 @@
+//=================================
+// include guard
+#ifndef __SOLUTIONWRITER_INCLUDED__
+#define __SOLUTIONWRITER_INCLUDED__
+
+//********************************************************************************
+//* Binary solution output.
+//*
+//*  VTUFile     : an unstructured grid with nodal fields, in the VTK XML format
+//*                (.vtu) with the arrays in raw binary ("appended" data),
+//*                zlib-compressed if built with -DCFD_ZLIB (see Makefile).
+//*                ParaView and VisIt read it directly.
+//*  AsyncWriter : writes byte buffers to files on a background I/O thread, so
+//*                the solver can keep going while the disk is busy.
+//*
+//* Typical use (see MainData2D::write_vtu_file):
+//*
+//*      SolutionWriter::VTUFile vtu;
+//*      vtu.set_grid(grid);                       // points and cells
+//*      vtu.add_point_data("density", 1, rho);
+//*      writer.write("solution.vtu", vtu.bytes());
+//*
+//* Snapshots during a run (see MainData2D::write_snapshot) go through the
+//* staging buffers of the writer instead: the solver only copies its state
+//* into a free staging buffer, and building the file (compression included)
+//* is done on the I/O thread.
+//*
+//*      int k;
+//*      std::vector<double>& buffer = writer.acquire_staging(k);
+//*      ... copy the state into buffer ...
+//*      writer.write_staged("snapshot_0001.vtu", k, encode);
+//*
+//* A file is written to "name.tmp" and renamed when complete, so a reader
+//* never sees a partial file.
+//*
+//********************************************************************************
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace SolutionWriter
+{
+
+// VTK cell types used here
+const uint8_t vtk_triangle = 5;
+const uint8_t vtk_quad     = 9;
+
+// The grid part of a .vtu file. It does not change during a run, so it is
+// built once and shared by the files (and the I/O thread).
+struct VTUGrid{
+
+    std::vector<double>  points;        // x,y,z of each point (3*npoints values)
+
+    // Cells in CSR form: the vertices of cell i are
+    // connectivity[ offsets[i-1] ... offsets[i]-1 ] (offsets[-1] = 0),
+    // 0-based point indices; types[i] = vtk_triangle, vtk_quad, ...
+    std::vector<int32_t> offsets;
+    std::vector<int32_t> connectivity;
+    std::vector<uint8_t> types;
+};
+
+class VTUFile{
+
+public:
+
+    void set_grid(std::shared_ptr<const VTUGrid> g);
+
+    // A nodal field with ncomp components per point (ncomp*npoints values).
+    void add_point_data(const std::string& name, int ncomp, std::vector<double> values);
+
+    // Simulation time, stored as the "TimeValue" field data.
+    void set_time(double t);
+
+    // zlib level of the appended data, 0 (none) to 9. Without -DCFD_ZLIB the
+    // data is never compressed.
+    void set_compression(int level);
+
+    // The whole file.
+    std::vector<char> bytes() const;
+
+private:
+
+    struct data_array {
+       std::string name;
+       int ncomp;
+       std::vector<double> values;
+    };
+
+    std::shared_ptr<const VTUGrid> grid;
+    std::vector<data_array> point_data;
+    bool   has_time = false;
+    double time     = 0.0;
+    int    compression = 0;
+};
+
+// A ParaView collection (.pvd) listing (time, file) pairs: a time series.
+std::vector<char> pvd_bytes(const std::vector< std::pair<double,std::string> >& files);
+
+// true if VTUFile can compress (built with -DCFD_ZLIB)
+bool zlib_available();
+
+// Write bytes to filename.tmp, then rename it to filename: the file appears
+// complete or not at all. Returns false (with a message) on error.
+bool write_file(const std::string& filename, const std::vector<char>& bytes);
+
+
+
+class AsyncWriter{
+
+public:
+
+    using encoder = std::function< std::vector<char>(const std::vector<double>&) >;
+
+    explicit AsyncWriter(int nstaging = 2);
+    ~AsyncWriter();                      // writes what is queued, then stops
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Queue the buffer for filename and return immediately.
+    // The I/O thread is started on the first call.
+    void write(const std::string& filename, std::vector<char> bytes);
+
+    // Staging buffers (2 by default: one is filled while the other is
+    // written). acquire_staging returns a free one, and its index k; it waits
+    // only if all of them are still queued or being written.
+    std::vector<double>& acquire_staging(int& k);
+
+    // Queue staging buffer k: encode(buffer) runs on the I/O thread, its
+    // bytes go to filename, and the buffer is free again.
+    void write_staged(const std::string& filename, int k, encoder encode);
+
+    // Block until every queued file is on disk.
+    void wait();
+
+    // Number of files written, the bytes in them, and the time the callers
+    // spent waiting for a free staging buffer.
+    long   files_written() const;
+    long   bytes_written() const;
+    double stall_seconds() const;
+
+private:
+
+    struct job {
+       std::string       filename;
+       std::vector<char> bytes;
+       int               staging;   // -1: bytes given
+       encoder           encode;
+    };
+
+    void run();
+    void queue_job(job j);
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable queued;    // a job, or stop
+    std::condition_variable idle;      // the queue is empty and nothing is being written
+    std::condition_variable released;  // a staging buffer is free
+    std::deque<job> queue;
+    std::vector< std::vector<double> > staging;
+    std::vector<bool> staging_busy;
+    bool   stop = false;
+    bool   busy = false;
+    long   nfiles = 0;
+    long   nbytes = 0;
+    double stall  = 0.0;
+};
+
+}
+
+
+#endif //__SOLUTIONWRITER_INCLUDED__
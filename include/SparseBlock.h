@@ -0,0 +1,110 @@
+//=================================
+// include guard
+#ifndef __SPARSEBLOCK_INCLUDED__
+#define __SPARSEBLOCK_INCLUDED__
+
+//********************************************************************************
+//* Sparse matrices of 4x4 blocks on the node graph, for implicit solvers.
+//*
+//*  BlockMatrix : one diagonal block per node, and one off-diagonal block per
+//*                neighbor, in the CSR order of the neighbor lists: the block
+//*                (i, nghbr_idx[k]) is off(k), k = nghbr_ptr[i] ... nghbr_ptr[i+1]-1.
+//*                Blocks are row-major: block[4*r+c] = entry (r,c).
+//*
+//* Linear solvers for A*x = b (x, b: 4 values per node):
+//*
+//*  solve_gs     : symmetric block Gauss-Seidel sweeps (forward, then
+//*                 backward), with the inverses of the diagonal blocks.
+//*  solve_block_jacobi : x_i = D_i^{-1} b_i (a preconditioner).
+//*  solve_direct : sparse LU with UMFPACK (SuiteSparse), if built with
+//*                 -DCFD_UMFPACK (see Makefile). The symbolic factorization
+//*                 depends on the pattern only, so it is done once.
+//*
+//* Typical use (see Solver::implicit_update):
+//*
+//*      jac.set_pattern(nnodes, nghbr_ptr, nghbr_idx);   // once per grid
+//*      jac.zero();
+//*      ... add to jac.diag(i) and jac.off(k) ...
+//*      jac.solve_gs(b, x, sweeps, tolerance);
+//*
+//********************************************************************************
+#include <vector>
+
+namespace SparseBlock
+{
+
+const int nb  = 4;        // block size
+const int nb2 = nb*nb;    // entries per block
+
+// true if solve_direct is available (built with -DCFD_UMFPACK)
+bool direct_available();
+
+class BlockMatrix{
+
+public:
+
+    BlockMatrix() = default;
+    ~BlockMatrix();
+
+    BlockMatrix(const BlockMatrix&) = delete;
+    BlockMatrix& operator=(const BlockMatrix&) = delete;
+
+    // The pattern: nrows block rows, off-diagonal blocks (i, idx[ptr[i]...ptr[i+1]-1]).
+    void set_pattern(int nrows, const std::vector<int>& ptr, const std::vector<int>& idx);
+    int  rows() const { return n; }
+
+    void zero();
+
+    double*       diag(int i)       { return &d[nb2*i]; }
+    const double* diag(int i) const { return &d[nb2*i]; }
+    double*       off(int k)        { return &o[nb2*k]; }
+    const double* off(int k)  const { return &o[nb2*k]; }
+    int           col(int k)  const { return (*idx)[k]; }
+    int           row_begin(int i) const { return (*ptr)[i]; }
+    int           row_end(int i)   const { return (*ptr)[i+1]; }
+
+    // y = A*x
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const;
+    void multiply(const double* x, double* y) const;
+
+    // Symmetric Gauss-Seidel from x (x = 0 for a cold start): at most
+    // max_sweeps sweeps, or until ||b - A*x||_2 <= tolerance*||b||_2
+    // (tolerance = 0: exactly max_sweeps sweeps, no residual check).
+    // Returns the number of sweeps; false in ok if a diagonal block is singular.
+    // The inverses of the diagonal blocks are computed on the first solve
+    // after zero(), so the blocks must be complete by then.
+    int solve_gs(const std::vector<double>& b, std::vector<double>& x,
+                 int max_sweeps, double tolerance, bool& ok);
+    int solve_gs(const double* b, double* x, int max_sweeps, double tolerance, bool& ok);
+
+    // x_i = D_i^{-1} b_i; false if a diagonal block is singular.
+    bool solve_block_jacobi(const double* b, double* x);
+
+    // x = A^{-1} b by sparse LU; false (with a message) if not available or singular.
+    bool solve_direct(const std::vector<double>& b, std::vector<double>& x);
+
+private:
+
+    int n = 0;
+    const std::vector<int>* ptr = nullptr;
+    const std::vector<int>* idx = nullptr;
+    std::vector<double> d;      // diagonal blocks
+    std::vector<double> o;      // off-diagonal blocks
+    std::vector<double> dinv;   // inverses of the diagonal blocks (solve_gs, solve_block_jacobi)
+    bool dinv_ready = false;
+    bool invert_diagonal();
+
+    // UMFPACK: the matrix as scalar CSR with sorted columns (given to UMFPACK
+    // as the CSC form of its transpose), and where each entry comes from.
+    std::vector<int>    ap, ai;
+    std::vector<double> ax;
+    std::vector<int>    ax_source;   // entry -> index in d (>= 0) or -1-index in o
+    void* symbolic = nullptr;
+    void  build_scalar_pattern();
+    void  free_factors();
+};
+
+}
+
+
+#endif //__SPARSEBLOCK_INCLUDED__
@@ -12,6 +12,8 @@
 #include <limits>
 #include <string.h>
 
+#include "bounds_check.hpp"
+
 
 
 
@@ -33,8 +35,10 @@ class Array2D; //fwd declaration
 
 
 
-// undefine to disable range checking
+// range checking: define CFD_BOUNDS_CHECK (make debug), see bounds_check.hpp
+#ifdef CFD_BOUNDS_CHECK
 #define RANGE_CHECK
+#endif
 
 
 class overdetermined : public std::domain_error{
@@ -77,8 +81,8 @@ template <class T>
 class Array2D{
 
     void check_indices(int i, int j) const{
-        assert(i >= 0 && i < nrows);
-        assert(j >= 0 && j < ncols);
+        CFD_BOUNDS_ASSERT(i >= 0 && i < nrows);
+        CFD_BOUNDS_ASSERT(j >= 0 && j < ncols);
     }
 
     void check_size(int other_nrows,int other_ncols) const { 
@@ -86,11 +90,11 @@ class Array2D{
         assert(ncols == other_ncols); 
     }
 
-    void check_index(int i) const { assert(i >= 0 && i < nrows); }
+    void check_index(int i) const { CFD_BOUNDS_ASSERT(i >= 0 && i < nrows); }
 
     void check_size(int i) const {
         //printf("\nchecl size i = %d, storage_size = %d\n",i,storage_size);
-        assert(i >= 0 && i < storage_size);
+        CFD_BOUNDS_ASSERT(i >= 0 && i < storage_size);
     }
 
     private:
@@ -127,6 +131,9 @@ class Array2D{
         //copy constructor 
         Array2D(const Array2D& A);
 
+        //move constructor (steals the buffer, no allocation)
+        Array2D(Array2D&& A) noexcept;
+
 
         // destructor
         ~Array2D ();
@@ -186,8 +193,15 @@ class Array2D{
         const T&  operator() (int i) const;  
         
         
-        Array2D operator = (const Array2D&);
-        Array2D operator = (const T a);
+        Array2D& operator = (const Array2D&);
+        Array2D& operator = (Array2D&&) noexcept;
+        Array2D& operator = (const T a);
+
+        // evaluate an expression template (see arrayops.hpp) in one pass
+        template <class E, class = typename E::array_expression_tag>
+        Array2D(const E& expr);
+        template <class E, class = typename E::array_expression_tag>
+        Array2D& operator = (const E& expr);
 
 
         // for linear algebra operations see: arrayops.hpp
@@ -206,15 +220,11 @@ Array2D<T>::~Array2D(){
     delete[] array;
 }
 
+// empty array: nothing allocated until assigned or built
 template <class T>
-Array2D<T>::Array2D(){
-    //nrows = 4;
-    //ncols = 4;
-    //cout << "build \n" << endl;
-    //build();
-    // cout << "initialize\n" << endl;
-
-    //memset(array, 0, nBytes);
+Array2D<T>::Array2D()
+    : nBytes(0), nrows(0), ncols(0), storage_size(0),
+      tracked_index(0), allocated(false), array(nullptr){
 }
 
 //
@@ -223,7 +233,9 @@ template <class T>
 Array2D<T>::Array2D(bool makeidentidy,  size_t m, size_t n){
     nrows = n;
     ncols = n;
+    tracked_index = 0;
     build();
+    allocated = true;
     if (makeidentidy) {
         assert(m == n);
         for(size_t i = 0; i < nrows; i++) {
@@ -269,7 +281,9 @@ Array2D<T>::Array2D(const Array2D& other)
 
     //cout << "copy constructor" << endl;
 
+    tracked_index = 0;
     array = new T[storage_size];
+    allocated = true;
 
     //printf("\narray copy constructor\n");
     int i = 0;
@@ -279,14 +293,29 @@ Array2D<T>::Array2D(const Array2D& other)
 }
 
 
+// move constructor:
+template <class T>
+Array2D<T>::Array2D(Array2D&& other) noexcept
+    : nBytes(other.nBytes), nrows(other.nrows), ncols(other.ncols),
+      storage_size(other.storage_size), tracked_index(other.tracked_index),
+      allocated(other.allocated), array(other.array){
+    other.array = nullptr;
+    other.allocated = false;
+    other.nrows = other.ncols = other.storage_size = other.nBytes = 0;
+}
+
+
 // resize copy constructor:
 template <class T>
 Array2D<T>::Array2D(const Array2D& other, int nrows, int ncols)
     : nrows(other.nrows+nrows), ncols(other.ncols+ncols){
-    storage_size = nrows*ncols;
+    // note: the arguments shadow the members, use this->
+    storage_size = this->nrows*this->ncols;
     nBytes = storage_size * sizeof(T);
 
+    tracked_index = 0;
     array = new T[storage_size];
+    allocated = true;
 
     //printf("\narray copy constructor\n");
     int i = 0;
@@ -323,9 +352,19 @@ const T& Array2D<T>::operator()(int i) const {
 
 
 template <class T>
-Array2D<T> Array2D<T>::operator=(const Array2D& that) {
-    /*not using this check  allows delayed allocation 
-    of this array type when using it within another class*/
+Array2D<T>& Array2D<T>::operator=(const Array2D& that) {
+    if (this == &that) return *this;
+
+    /* delayed allocation: an empty (default constructed)
+       array takes the size of the right hand side */
+    if (array == nullptr) {
+        nrows = that.nrows;
+        ncols = that.ncols;
+        storage_size = that.storage_size;
+        nBytes = that.nBytes;
+        array = new T[storage_size];
+        allocated = true;
+    }
 	assert(that.nrows == nrows);
 	assert(that.ncols == ncols);
 
@@ -335,8 +374,29 @@ Array2D<T> Array2D<T>::operator=(const Array2D& that) {
     }
     return *this;
 }
+// move assignment: take over the buffer of a temporary,
+// e.g. x = f(...), instead of copying it element by element.
 template <class T>
-Array2D<T> Array2D<T>::operator=(const T a) {
+Array2D<T>& Array2D<T>::operator=(Array2D&& that) noexcept {
+    if (this == &that) return *this;
+	assert(array == nullptr || (that.nrows == nrows && that.ncols == ncols));
+
+    delete[] array;
+    nBytes        = that.nBytes;
+    nrows         = that.nrows;
+    ncols         = that.ncols;
+    storage_size  = that.storage_size;
+    tracked_index = that.tracked_index;
+    allocated     = that.allocated;
+    array         = that.array;
+
+    that.array = nullptr;
+    that.allocated = false;
+    that.nrows = that.ncols = that.storage_size = that.nBytes = 0;
+    return *this;
+}
+template <class T>
+Array2D<T>& Array2D<T>::operator=(const T a) {
     int i;
     for(i=0; i < storage_size; i++) {
     	array[i] = a;
@@ -345,6 +405,45 @@ Array2D<T> Array2D<T>::operator=(const T a) {
 }
 
 
+// construct from an expression: allocate once, evaluate once.
+template <class T>
+template <class E, class>
+Array2D<T>::Array2D(const E& expr)
+    : nrows(expr.nrows), ncols(expr.ncols){
+    tracked_index = 0;
+    storage_size = nrows*ncols;
+    nBytes = storage_size * sizeof(T);
+    array = new T[storage_size];
+    allocated = true;
+    for(int i=0; i < storage_size; i++) {
+    	array[i] = expr[i];
+    }
+}
+
+// assign from an expression: a single fused loop, no temporaries.
+// (The operands are only read element i at step i, so aliasing
+//  such as u = half*(u0 + u) is safe.)
+template <class T>
+template <class E, class>
+Array2D<T>& Array2D<T>::operator=(const E& expr) {
+    if (array == nullptr) {
+        nrows = expr.nrows;
+        ncols = expr.ncols;
+        storage_size = nrows*ncols;
+        nBytes = storage_size * sizeof(T);
+        array = new T[storage_size];
+        allocated = true;
+    }
+	assert(expr.nrows == nrows);
+	assert(expr.ncols == ncols);
+
+    for(int i=0; i < storage_size; i++) {
+    	array[i] = expr[i];
+    }
+    return *this;
+}
+
+
 
 template <typename T>
 bool Array2D<T>::isSquare() const {
@@ -11,83 +11,135 @@
 // #include "array_template.hpp"
 
 #include <cmath>
+#include <type_traits>
 
-// addition of two Array2Ds
-template <class T>
-Array2D<T> 
-operator+(const Array2D<T>& a, const Array2D<T>& b) {
-	assert(a.nrows == b.nrows);
-	assert(a.ncols == b.ncols);
+//***********************************************************
+// Expression templates for elementwise arithmetic
+//
+// a + b, a - b, s*a, a*b (elementwise) and a/s do not compute
+// anything: they return a small node that remembers the operands.
+// The work is done when the node is assigned to an Array2D (or used
+// to construct one), in a single loop over the storage:
+//
+//      u = half*(u0 + u);   // one pass, no intermediate Array2D
+//
+// Array2D operands are held through a light view (pointer + shape),
+// nested expressions by value, so nodes are cheap to copy.
+//***********************************************************
 
-    Array2D<T> result(a.nrows,a.ncols);
+// view of an Array2D used as a leaf of an expression
+template <class T>
+struct ArrayLeaf {
+    typedef T value_type;
+    typedef void array_expression_tag;
+    const T* p;
+    int nrows, ncols;
+    ArrayLeaf(const Array2D<T>& a) : p(a.array), nrows(a.nrows), ncols(a.ncols) {}
+    T operator[](int i) const { return p[i]; }
+};
+
+// how an operand is stored inside an expression node
+template <class X>
+struct array_operand { typedef X type; };             // expression: by value
+template <class T>
+struct array_operand< Array2D<T> > { typedef ArrayLeaf<T> type; }; // Array2D: view
 
-    int size = a.storage_size;
-    for(size_t i=0; i < size; i++) {
-    	result.array[i] = a.array[i] + b.array[i];
+// is X an Array2D or an expression?
+template <class X, class = void>
+struct is_array_operand : std::false_type {};
+template <class T>
+struct is_array_operand< Array2D<T>, void > : std::true_type {};
+template <class X>
+struct is_array_operand< X, typename X::array_expression_tag > : std::true_type {};
+
+// elementwise operations
+struct ArrayOpAdd { template <class T> static T apply(T a, T b) { return a + b; } };
+struct ArrayOpSub { template <class T> static T apply(T a, T b) { return a - b; } };
+struct ArrayOpMul { template <class T> static T apply(T a, T b) { return a * b; } };
+struct ArrayOpDiv { template <class T> static T apply(T a, T b) { return a / b; } };
+
+// node: array (op) array
+template <class L, class R, class Op>
+struct ArrayBinaryExpr {
+    typedef typename L::value_type value_type;
+    typedef void array_expression_tag;
+    L l;
+    R r;
+    int nrows, ncols;
+    ArrayBinaryExpr(const L& l, const R& r) : l(l), r(r), nrows(l.nrows), ncols(l.ncols) {
+        assert(l.nrows == r.nrows);
+        assert(l.ncols == r.ncols);
     }
-    return result;
-}
+    value_type operator[](int i) const { return Op::apply(l[i], r[i]); }
+};
+
+// node: scalar (op) array   or   array (op) scalar
+template <class E, class Op, bool scalar_on_left>
+struct ArrayScalarExpr {
+    typedef typename E::value_type value_type;
+    typedef void array_expression_tag;
+    value_type s;
+    E e;
+    int nrows, ncols;
+    ArrayScalarExpr(const value_type& s, const E& e) : s(s), e(e), nrows(e.nrows), ncols(e.ncols) {}
+    value_type operator[](int i) const {
+        return scalar_on_left ? Op::apply(s, e[i]) : Op::apply(e[i], s);
+    }
+};
 
+template <class A, class B, class Op>
+using array_binary_t = typename std::enable_if<
+                            is_array_operand<A>::value && is_array_operand<B>::value,
+                            ArrayBinaryExpr< typename array_operand<A>::type,
+                                             typename array_operand<B>::type, Op > >::type;
 
+template <class A, class Op, bool scalar_on_left>
+using array_scalar_t = typename std::enable_if<
+                            is_array_operand<A>::value,
+                            ArrayScalarExpr< typename array_operand<A>::type,
+                                             Op, scalar_on_left > >::type;
 
-// subtraction of two Array2Ds
-template <class T>
-Array2D<T> 
-operator-(const Array2D<T>& a, const Array2D<T>& b) {
-	assert(a.nrows == b.nrows);
-	assert(a.ncols == b.ncols);
 
-    Array2D<T> result(a.nrows,a.ncols);
 
-    int size = a.storage_size;
-    for(size_t i=0; i < size; i++) {
-    	result.array[i] = a.array[i] - b.array[i];
-    }
-    return result;
+// addition of two Array2Ds
+template <class A, class B>
+array_binary_t<A,B,ArrayOpAdd>
+operator+(const A& a, const B& b) {
+    return array_binary_t<A,B,ArrayOpAdd>(a, b);
 }
 
 
 
-// multiplication of scalar and Array2D
-template<typename T>
-Array2D<T> 
-operator*(T const& s, Array2D<T> const& a)
-{
-    Array2D<T> result(a.nrows,a.ncols);
-    for (size_t k = 0; k<a.size(); ++k) {
-        result.array[k] = s*a.array[k];
-    }
-    return result;
+// subtraction of two Array2Ds
+template <class A, class B>
+array_binary_t<A,B,ArrayOpSub>
+operator-(const A& a, const B& b) {
+    return array_binary_t<A,B,ArrayOpSub>(a, b);
 }
 
 
-// multiplication of two Array2Ds
-template <class T>
-Array2D<T> 
-operator*(const Array2D<T>& a, const Array2D<T>& b) {
-	assert(a.nrows == b.nrows);
-	assert(a.ncols == b.ncols);
 
-    Array2D<T> result(a.nrows,a.ncols);
+// multiplication of scalar and Array2D
+template <class A>
+array_scalar_t<A,ArrayOpMul,true>
+operator*(typename array_operand<A>::type::value_type const& s, A const& a) {
+    return array_scalar_t<A,ArrayOpMul,true>(s, a);
+}
 
-    int size = a.storage_size;
-    for(size_t i=0; i < size; i++) {
-    	result.array[i] = a.array[i] * b.array[i];
-    }
-    return result;
+
+// multiplication of two Array2Ds
+template <class A, class B>
+array_binary_t<A,B,ArrayOpMul>
+operator*(const A& a, const B& b) {
+    return array_binary_t<A,B,ArrayOpMul>(a, b);
 }
 
 
 // division of an Array2D by a scalar
-template<typename T>
-Array2D<T> 
-operator/(Array2D<T> const& a , T const& s )
-{
-    Array2D<T> result(a.nrows,a.ncols);
-    for (size_t k = 0; k<a.size(); ++k) {
-        result.array[k] = a.array[k]/s;
-    }
-    return result;
+template <class A>
+array_scalar_t<A,ArrayOpDiv,false>
+operator/(A const& a, typename array_operand<A>::type::value_type const& s) {
+    return array_scalar_t<A,ArrayOpDiv,false>(s, a);
 }
 
 
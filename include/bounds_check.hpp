@@ -0,0 +1,27 @@
+//=================================
+// include guard
+#ifndef __BOUNDS_CHECK_INCLUDED__
+#define __BOUNDS_CHECK_INCLUDED__
+
+
+
+//=================================
+// Bounds checking of the element accessors of Array2D and StateVec.
+//
+// The checks sit on every element access in the flux, gradient and
+// LSQ loops, so they are a build configuration switch:
+//
+//   make          (release) : no checks, accessors are a plain load/store
+//   make debug              : -DCFD_BOUNDS_CHECK, every index is checked
+//
+#include <cassert>
+
+#ifdef CFD_BOUNDS_CHECK
+#define CFD_BOUNDS_ASSERT(cond) assert(cond)
+#else
+#define CFD_BOUNDS_ASSERT(cond) ((void)0)
+#endif
+
+
+
+#endif //__BOUNDS_CHECK_INCLUDED__
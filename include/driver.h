@@ -14,7 +14,7 @@
 
 //=================================
 // the actual function
-int main();
+int main(int argc, char** argv);
 
 
 #endif 
\ No newline at end of file
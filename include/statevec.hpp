@@ -0,0 +1,128 @@
+//=================================
+// include guard
+#ifndef __STATEVEC_TEMPLATE_INCLUDED__
+#define __STATEVEC_TEMPLATE_INCLUDED__
+
+
+
+//=================================
+// fixed size state vector
+//
+// A small, stack allocated vector of N components, e.g., the
+// 3 (1D) or 4 (2D) primitive/conservative variables at a point.
+// It supports the same element access, u(i), and the same
+// arithmetic as Array2D (see arrayops.hpp), but never touches
+// the heap, so it is cheap to create inside flux functions.
+//
+#include <cassert>
+#include <cstddef>
+
+#include "bounds_check.hpp"
+
+
+
+
+template <class T, int N>
+class StateVec{
+
+    void check_size(int i) const { CFD_BOUNDS_ASSERT(i >= 0 && i < N); }
+
+    public:
+
+        T array[N] = {};   // zero initialized, as Array2D::build()
+
+        StateVec() = default;
+
+        // fill with a single value
+        explicit StateVec(const T a){
+            for (int i = 0; i < N; i++) array[i] = a;
+        }
+
+        static constexpr int size() { return N; }
+
+        // Operators:
+        T& operator() (int i)             { check_size(i); return array[i]; }
+        const T& operator() (int i) const { check_size(i); return array[i]; }
+
+        T& operator[] (int i)             { check_size(i); return array[i]; }
+        const T& operator[] (int i) const { check_size(i); return array[i]; }
+
+        StateVec& operator = (const T a){
+            for (int i = 0; i < N; i++) array[i] = a;
+            return *this;
+        }
+
+        StateVec& operator += (const StateVec& b){
+            for (int i = 0; i < N; i++) array[i] += b.array[i];
+            return *this;
+        }
+
+        StateVec& operator -= (const StateVec& b){
+            for (int i = 0; i < N; i++) array[i] -= b.array[i];
+            return *this;
+        }
+
+        StateVec& operator *= (const T s){
+            for (int i = 0; i < N; i++) array[i] *= s;
+            return *this;
+        }
+
+        // raw access, e.g. to hand the state to pointer based routines
+        T* data()             { return array; }
+        const T* data() const { return array; }
+};
+
+
+
+// addition of two StateVecs
+template <class T, int N>
+inline StateVec<T,N>
+operator+(const StateVec<T,N>& a, const StateVec<T,N>& b) {
+    StateVec<T,N> result;
+    for (int i = 0; i < N; i++) result.array[i] = a.array[i] + b.array[i];
+    return result;
+}
+
+
+// subtraction of two StateVecs
+template <class T, int N>
+inline StateVec<T,N>
+operator-(const StateVec<T,N>& a, const StateVec<T,N>& b) {
+    StateVec<T,N> result;
+    for (int i = 0; i < N; i++) result.array[i] = a.array[i] - b.array[i];
+    return result;
+}
+
+
+// multiplication of scalar and StateVec
+template <class T, int N>
+inline StateVec<T,N>
+operator*(T const& s, StateVec<T,N> const& a) {
+    StateVec<T,N> result;
+    for (int i = 0; i < N; i++) result.array[i] = s*a.array[i];
+    return result;
+}
+
+
+// componentwise multiplication of two StateVecs
+template <class T, int N>
+inline StateVec<T,N>
+operator*(const StateVec<T,N>& a, const StateVec<T,N>& b) {
+    StateVec<T,N> result;
+    for (int i = 0; i < N; i++) result.array[i] = a.array[i] * b.array[i];
+    return result;
+}
+
+
+// division of a StateVec by a scalar
+template <class T, int N>
+inline StateVec<T,N>
+operator/(StateVec<T,N> const& a, T const& s) {
+    StateVec<T,N> result;
+    for (int i = 0; i < N; i++) result.array[i] = a.array[i]/s;
+    return result;
+}
+
+
+
+#endif //__STATEVEC_TEMPLATE_INCLUDED__
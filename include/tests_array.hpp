@@ -3,9 +3,4 @@
 #ifndef __TESTS_ARRAY_INCLUDED__
 #define __TESTS_ARRAY_INCLUDED__
 
-//=================================
-// the actual function
-int main();
-
-
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+//********************************************************************************
+//* Case files: runtime parameters for the solvers (see CaseFile.h).
+//********************************************************************************
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "../include/CaseFile.h"
+#include "../include/StringOps.h"
+
+
+
+bool CaseFile::Case::has(const std::string& key) const {
+   return param.find(key) != param.end();
+}
+
+
+
+std::string CaseFile::Case::get(const std::string& key,
+                                const std::string& default_value) const {
+   std::map<std::string,std::string>::const_iterator it = param.find(key);
+   if (it == param.end()) return default_value;
+   return it->second;
+}
+
+
+
+double CaseFile::Case::get_real(const std::string& key, double default_value) const {
+
+   if (!has(key)) return default_value;
+
+   const std::string value = get(key, "");
+   char* end;
+   double result = std::strtod(value.c_str(), &end);
+   if (value.empty() || *end != '\0') {
+      std::cout << " Case " << name << ": " << key << " = " << value
+                << " is not a number. \n";
+      std::exit(0); //stop
+   }
+   return result;
+}
+
+
+
+int CaseFile::Case::get_int(const std::string& key, int default_value) const {
+
+   if (!has(key)) return default_value;
+
+   const std::string value = get(key, "");
+   char* end;
+   long result = std::strtol(value.c_str(), &end, 10);
+   if (value.empty() || *end != '\0') {
+      std::cout << " Case " << name << ": " << key << " = " << value
+                << " is not an integer. \n";
+      std::exit(0); //stop
+   }
+   return int(result);
+}
+
+
+
+bool CaseFile::Case::get_bool(const std::string& key, bool default_value) const {
+
+   if (!has(key)) return default_value;
+
+   const std::string value = get(key, "");
+   if (value == "true"  || value == "yes" || value == "1") return true;
+   if (value == "false" || value == "no"  || value == "0") return false;
+
+   std::cout << " Case " << name << ": " << key << " = " << value
+             << " is not true/false. \n";
+   std::exit(0); //stop
+   return default_value;
+}
+
+
+
+void CaseFile::Case::check_keys(const std::vector<std::string>& known) const {
+
+   for (const auto& kv : param) {
+      bool found = false;
+      for (const std::string& k : known) {
+         if (kv.first == k) { found = true; break; }
+      }
+      if (!found) {
+         std::cout << " Case " << name << ": unknown parameter " << kv.first << "\n";
+         std::cout << " Known parameters:";
+         for (const std::string& k : known) std::cout << " " << k;
+         std::cout << "\n";
+         std::exit(0); //stop
+      }
+   }
+}
+
+
+
+bool CaseFile::parse_assignment(const std::string& line, std::string& key,
+                                std::string& value) {
+
+   const std::string::size_type eq = line.find('=');
+   if (eq == std::string::npos) return false;
+
+   key   = trim(line.substr(0, eq));
+   value = trim(line.substr(eq+1));
+   return !key.empty();
+}
+
+
+
+std::vector<CaseFile::Case> CaseFile::read_case_file(const std::string& filename,
+                                                     const Case& base) {
+
+   std::ifstream in(filename);
+   if (!in) {
+      std::cout << " Cannot open the case file " << filename << "\n";
+      std::exit(0); //stop
+   }
+
+   std::vector<Case> cases;
+   Case shared = base;        // keys before the first [name]
+   shared.name = filename;
+   Case* current = &shared;
+
+   std::string line, key, value;
+   int lineno = 0;
+
+   while (std::getline(in, line)) {
+      lineno++;
+
+      const std::string::size_type hash = line.find('#');
+      if (hash != std::string::npos) line = line.substr(0, hash);
+      line = trim(line);
+      if (line.empty()) continue;
+
+      // [name]: a new case, starting from the shared keys
+      if (line.front() == '[' && line.back() == ']') {
+         cases.push_back(shared);
+         cases.back().name = trim(line.substr(1, line.size()-2));
+         current = &cases.back();
+         continue;
+      }
+
+      if (!parse_assignment(line, key, value)) {
+         std::cout << " " << filename << ", line " << lineno
+                   << ": expected key = value, found: " << line << "\n";
+         std::exit(0); //stop
+      }
+
+      current->param[key] = value;
+   }
+
+   if (cases.empty()) cases.push_back(shared);
+
+   return cases;
+}
+
+
+
+std::vector<CaseFile::Case> CaseFile::cases_from_args(int argc, char** argv) {
+
+   std::vector<Case> cases;
+   Case overrides;
+   overrides.name = "command line";
+   bool any_file = false;
+   std::string key, value;
+
+   for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      // --key is key=true, --key=value is key=value
+      if (arg.compare(0, 2, "--") == 0) {
+         arg = arg.substr(2);
+         if (arg.find('=') == std::string::npos) arg += "=true";
+      }
+      if (parse_assignment(arg, key, value)) {
+         overrides.param[key] = value;
+      } else {
+         any_file = true;
+         std::vector<Case> file_cases = read_case_file(arg, Case());
+         for (Case& c : file_cases) {
+            for (const auto& kv : overrides.param) c.param[kv.first] = kv.second;
+            cases.push_back(c);
+         }
+      }
+   }
+
+   if (!any_file) cases.push_back(overrides);
+
+   return cases;
+}
@@ -0,0 +1,82 @@
+//********************************************************************************
+//* Binary dumps: checkpoints and grid data caches (see Checkpoint.h).
+//********************************************************************************
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHECKPOINT_MMAP
+#endif
+
+#include "../include/Checkpoint.h"
+
+
+
+uint64_t Checkpoint::hash_bytes(const void* data, size_t nbytes, uint64_t h) {
+
+   const unsigned char* p = static_cast<const unsigned char*>(data);
+   for (size_t i = 0; i < nbytes; i++) {
+      h ^= p[i];
+      h *= 1099511628211ULL;
+   }
+   return h;
+}
+
+
+
+bool Checkpoint::read_file(const std::string& filename, std::vector<char>& bytes) {
+
+   std::FILE* in = std::fopen(filename.c_str(), "rb");
+   if (!in) return false;
+
+   std::fseek(in, 0, SEEK_END);
+   const long n = std::ftell(in);
+   std::fseek(in, 0, SEEK_SET);
+
+   bytes.resize(n > 0 ? n : 0);
+   const bool ok = n >= 0 && std::fread(bytes.data(), 1, bytes.size(), in) == bytes.size();
+   std::fclose(in);
+   return ok;
+}
+
+
+
+Checkpoint::MappedFile::MappedFile(const std::string& filename) {
+
+#ifdef CHECKPOINT_MMAP
+   const int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd < 0) return;
+   struct stat st;
+   if (::fstat(fd, &st) == 0) {
+      opened = true;
+      nbytes = size_t(st.st_size);
+      if (nbytes > 0) {
+         void* p = ::mmap(nullptr, nbytes, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p != MAP_FAILED) {
+            ::madvise(p, nbytes, MADV_SEQUENTIAL);
+            base   = static_cast<const char*>(p);
+            mapped = true;
+         } else {
+            opened = false;
+            nbytes = 0;
+         }
+      }
+   }
+   ::close(fd);
+#else
+   opened = read_file(filename, copy);
+   nbytes = copy.size();
+   if (nbytes > 0) base = copy.data();
+#endif
+}
+
+
+
+Checkpoint::MappedFile::~MappedFile() {
+#ifdef CHECKPOINT_MMAP
+   if (mapped) ::munmap(const_cast<char*>(base), nbytes);
+#endif
+}
@@ -89,8 +89,11 @@
 #include <fstream>      // write to file
 #include <iomanip>    // std::setprecision - only works for output :(
 #include <math.h>       // sqrt 
+#include <cstdlib>      // std::exit
 //=================================
 #include <cstring> //needed for memset
+#include <cstdio>       // snprintf
+#include <sstream>
 #include <string.h>
 
 //======================================
@@ -106,6 +109,7 @@
 //======================================
 // 1D Euler approximate Riemann sovler
 #include "../include/EulerShockTube1D.h"
+#include "../include/Checkpoint.h"
 
 //======================================
 //using namespace std;
@@ -147,6 +151,9 @@ EulerSolver1D::Solver::Solver(){
 // [Note: Change these data (and tf) to solve different problems.]
     initialize(ncells, dx, xmin, gamma);
 
+// Face arrays for the batched flux at the interior faces.
+    faces.allocate(ncells-1);
+
 }
 
 
@@ -164,6 +171,19 @@ void EulerSolver1D::Solver::Euler1D(){
     printf("\nEuler1D\n");
     t = zero;      //Initialize the current time.
     nsteps = 0;    //Initialize the number of time steps.
+    if (restart){  //or continue from a checkpoint
+        if (!read_checkpoint(checkpoint_file)){
+            printf("\n Cannot restart from %s ... Stop.\n", checkpoint_file.c_str());
+            std::exit(0); //stop
+        }
+        printf("\n Restart from %s: t = %f after %d steps\n", checkpoint_file.c_str(), t, nsteps);
+    }
+    const bool snapshots = snapshot_steps > 0 || snapshot_dt > zero;
+    float next_snapshot_time = snapshot_dt;
+    if (snapshot_dt > zero){
+        while (next_snapshot_time <= t) next_snapshot_time += snapshot_dt;
+    }
+    if (snapshots) snapshot();   //the initial solution
     //50000 is large enough to reach tf=1.7.
     for ( int itime = 0; itime < 50000; ++itime ) {
     //for ( int itime = 0; itime < 1; ++itime ) {
@@ -227,10 +247,23 @@ void EulerSolver1D::Solver::Euler1D(){
             //
             // flux comparison
 
+            // Gather the face states into the face arrays (face i is j+1/2, j=i+1),
+            // compute all the fluxes at once, then scatter them to the cells.
             for (int j = 1; j < ncells; ++j){
                 wL = cell[j  ].w + half*cell[j  ].dw; //State extrapolated to j+1/2 from j
                 wR = cell[j+1].w - half*cell[j+1].dw; //State extrapolated to j+1/2 from j+1
-                flux = roe_flux(wL,wR);           //Numerical flux at j+1/2
+                for (int k = 0; k < 3; ++k){
+                    faces.wL[k][j-1] = wL(k);
+                    faces.wR[k][j-1] = wR(k);
+                }
+            }
+
+            roe_flux_batch(faces);                //Numerical fluxes at all j+1/2
+
+            for (int j = 1; j < ncells; ++j){
+                for (int k = 0; k < 3; ++k){
+                    flux(k) = faces.flux[k][j-1];
+                }
                 cell[j  ].res = cell[j  ].res + flux;   //Add it to the left cell.
                 cell[j+1].res = cell[j+1].res - flux;   //Subtract from the right cell.
             }
@@ -281,10 +314,26 @@ void EulerSolver1D::Solver::Euler1D(){
         //---------------------------------------------------
         // End of Runge-Kutta Stages
         //---------------------------------------------------
+
+        // Snapshot: copied to a staging buffer, written on the I/O thread.
+        bool snapshot_now = snapshot_steps > 0 && nsteps % snapshot_steps == 0;
+        if (snapshot_dt > zero && t >= next_snapshot_time){
+            snapshot_now = true;
+            while (next_snapshot_time <= t) next_snapshot_time += snapshot_dt;
+        }
+        if (snapshot_now) snapshot();
+
+        // Checkpoint: nsteps steps are done.
+        if (checkpoint_steps > 0 && nsteps % checkpoint_steps == 0) write_checkpoint(checkpoint_file);
     } 
     //--------------------------------------------------------------------------------
     // End of time stepping
     //--------------------------------------------------------------------------------
+    if (checkpoint_steps > 0) write_checkpoint(checkpoint_file);  //the solution at the end
+    if (snapshots){
+        printf("\n Snapshots: %d (solver waited %g s for the I/O thread)\n",
+               nsnapshots, writer.stall_seconds());
+    }
 
 }
 //********************************************************************************
@@ -375,16 +424,16 @@ float EulerSolver1D::Solver::timestep(float cfl, float dx, float gamma, int ncel
 //* ------------------------------------------------------------------------------
 //* 
 //********************************************************************************
-void EulerSolver1D::Solver::w2u_efficient( Array2D<float>& w, Array2D<float>& u ) {
+void EulerSolver1D::Solver::w2u_efficient( const State& w, State& u ) {
 
     u(0) = w(0);
     u(1) = w(0)*w(1);
     u(2) = ( w(2)/(gamma-one) ) + half*w(0)*w(1)*w(1);
     return;
 }
-Array2D<float> EulerSolver1D::Solver::w2u( Array2D<float>& w) {
+EulerSolver1D::State EulerSolver1D::Solver::w2u( const State& w) {
 
-    Array2D<float> u(3,1);
+    State u;
 
     u(0) = w(0);
     u(1) = w(0)*w(1);
@@ -402,7 +451,7 @@ Array2D<float> EulerSolver1D::Solver::w2u( Array2D<float>& w) {
 // ------------------------------------------------------------------------------
 // 
 //*******************************************************************************
-void EulerSolver1D::Solver::u2w_efficient( Array2D<float>& u, Array2D<float>& w ) {
+void EulerSolver1D::Solver::u2w_efficient( const State& u, State& w ) {
      
     
     w(0) = u(0);
@@ -410,9 +459,9 @@ void EulerSolver1D::Solver::u2w_efficient( Array2D<float>& u, Array2D<float>& w
     w(2) = (gamma-one)*( u(2) - half*w(0)*w(1)*w(1) );
     return;
 }
-Array2D<float>  EulerSolver1D::Solver::u2w( Array2D<float>& u ) {
+EulerSolver1D::State  EulerSolver1D::Solver::u2w( const State& u ) {
      
-    Array2D<float> w(3,1);
+    State w;
     
     w(0) = u(0);
     w(1) = u(1)/u(0);
@@ -438,10 +487,10 @@ Array2D<float>  EulerSolver1D::Solver::u2w( Array2D<float>& u ) {
 // 
 // Katate Masatsuka, December 2010. http://www.cfdbooks.com
 //*******************************************************************************
-Array2D<float> EulerSolver1D::Solver::roe_flux(Array2D<float>&  wL, Array2D<float>&  wR){
+EulerSolver1D::State EulerSolver1D::Solver::roe_flux(const State&  wL, const State&  wR){
 
     //  Input:   wL(3), wR(3) =   Input (conservative variables rho*[1, v, E])
-    Array2D<float> flux(3,1);  // Output (numerical flux across L and R states)
+    State flux;  // Output (numerical flux across L and R states)
 
     //Local parameters
     float    zero = 0.0;
@@ -450,13 +499,14 @@ Array2D<float> EulerSolver1D::Solver::roe_flux(Array2D<float>&  wL, Array2D<floa
     float    half = 0.5;
     float quarter = 0.25;
     //Local variables
-    Array2D<float> uL(3,1), uR(3,1);
+    State uL, uR;
     float rhoL, rhoR, vL, vR, pL, pR;   // Primitive variables.
     float aL, aR, HL, HR;               // Speeds of sound.
     float RT,rho,v,H,a;                 // Roe-averages
     float drho,du,dP;
     float Da;
-    Array2D<float> ws(3,1), R(3,3),dV(3,1);
+    State ws, dV;
+    float R[3][3];
     int j, k;
 
     DEBUG("\n w2u \n");
@@ -524,17 +574,17 @@ Array2D<float> EulerSolver1D::Solver::roe_flux(Array2D<float>&  wL, Array2D<floa
 
     DEBUG("\n Right Eigenvectors \n");
 //Right eigenvectors
-   R(0,0) = one;
-   R(1,0) = v - a;
-   R(2,0) = H - v*a;
+   R[0][0] = one;
+   R[1][0] = v - a;
+   R[2][0] = H - v*a;
 
-   R(0,1) = one;
-   R(1,1) = v;
-   R(2,1) = half*v*v;
+   R[0][1] = one;
+   R[1][1] = v;
+   R[2][1] = half*v*v;
 
-   R(0,2) = one;
-   R(1,2) = v + a;
-   R(2,2) = H + v*a;
+   R[0][2] = one;
+   R[1][2] = v + a;
+   R[2][2] = H + v*a;
 
     DEBUG("\n Average Flux \n");
 //Compute the average flux.
@@ -545,13 +595,216 @@ Array2D<float> EulerSolver1D::Solver::roe_flux(Array2D<float>&  wL, Array2D<floa
 //Add the matrix dissipation term to complete the Roe flux.
     for (j=0; j<3; ++j){
         for (k=0; k<3; ++k){
-            flux(j) = flux(j) - half*ws(k)*dV(k)*R(j,k) ;
+            flux(j) = flux(j) - half*ws(k)*dV(k)*R[j][k] ;
         }
    }
     return flux;
 } //end roe_flux
 //--------------------------------------------------------------------------------
 
+//*******************************************************************************
+// -- Batched Roe flux: the same flux as roe_flux, for all faces at once ---
+//
+// The face states are stored as structure of arrays (FaceBatch), so that the
+// loop over faces can be vectorized: each SIMD lane computes one face.
+// To be vectorizable the kernel works on scalars only (no State, no 3x3
+// eigenvector matrix) and the entropy fix is written as a select.
+//
+// The operations (and their order) are exactly those of roe_flux, so the
+// result is bitwise identical to roe_flux (see check_roe_flux_batch).
+//
+// roe_flux_batch        : loop with "#pragma omp simd" (compile with
+//                         -fopenmp-simd, and e.g. -mavx2 for AVX2 lanes).
+// roe_flux_batch_scalar : the same kernel, one face at a time.
+//*******************************************************************************
+static inline void roe_flux_kernel(
+          float rhoL, float vL, float pL,
+          float rhoR, float vR, float pR, const float gamma,
+          float& f0, float& f1, float& f2){
+
+    const float    zero = 0.0;
+    const float     one = 1.0;
+    const float    four = 4.0;
+    const float    half = 0.5;
+    const float quarter = 0.25;
+
+//Conservative total energies (w2u).
+    float EL = ( pL/(gamma-one) ) + half*rhoL*vL*vL;
+    float ER = ( pR/(gamma-one) ) + half*rhoR*vR*vR;
+
+//Speeds of sound and total enthalpies.
+    float aL = sqrt(gamma*pL/rhoL);
+    float HL = ( EL + pL ) / rhoL;
+    float aR = sqrt(gamma*pR/rhoR);
+    float HR = ( ER + pR ) / rhoR;
+
+//Roe averages.
+    float RT  = sqrt(rhoR/rhoL);
+    float rho = RT*rhoL;
+    float v   = (vL+RT*vR)/(one+RT);
+    float H   = (HL+RT*HR)/(one+RT);
+    float a   = sqrt( (gamma-one)*(H-half*v*v) );
+
+//Differences in primitive variables.
+    float drho = rhoR - rhoL;
+    float du   =   vR - vL;
+    float dP   =   pR - pL;
+
+//Wave strengths.
+    float dV0 =  half*(dP-rho*a*du)/(a*a);
+    float dV1 = -( dP/(a*a) - drho );
+    float dV2 =  half*(dP+rho*a*du)/(a*a);
+
+//Absolute values of the wave speeds.
+    float ws0 = fabsf(v-a);
+    float ws1 = fabsf(v  );
+    float ws2 = fabsf(v+a);
+
+//Entropy fix (same as roe_flux, as a select). The fixed speed is computed
+//for every face, so the division must not be by zero: when Da = 0 the fix
+//is never selected (ws >= 0), and Ds = 1 is used instead.
+    float Da, Ds, dtmp, wfix;
+    dtmp = four*((vR-aR)-(vL-aL));
+    Da   = (zero < dtmp) ? dtmp : zero;
+    Ds   = (zero < dtmp) ? dtmp : one;
+    wfix = ws0*ws0/Ds + quarter*Da;
+    ws0  = (ws0 < half*Da) ? wfix : ws0;
+    dtmp = four*((vR+aR)-(vL+aL));
+    Da   = (zero < dtmp) ? dtmp : zero;
+    Ds   = (zero < dtmp) ? dtmp : one;
+    wfix = ws2*ws2/Ds + quarter*Da;
+    ws2  = (ws2 < half*Da) ? wfix : ws2;
+
+//Average of the physical fluxes.
+    float a2L = gamma*pL/rhoL;
+    float a2R = gamma*pR/rhoR;
+    f0 = half*( rhoL*vL + rhoR*vR );
+    f1 = half*( (rhoL*vL*vL + pL) + (rhoR*vR*vR + pR) );
+    f2 = half*( rhoL*vL*( a2L/(gamma-one) + half*vL*vL )
+              + rhoR*vR*( a2R/(gamma-one) + half*vR*vR ) );
+
+//Dissipation term, with the right eigenvectors written out:
+//  R(:,0) = [1, v-a, H-v*a], R(:,1) = [1, v, v*v/2], R(:,2) = [1, v+a, H+v*a]
+    f0 = f0 - half*ws0*dV0*one;
+    f0 = f0 - half*ws1*dV1*one;
+    f0 = f0 - half*ws2*dV2*one;
+
+    f1 = f1 - half*ws0*dV0*(v - a);
+    f1 = f1 - half*ws1*dV1*v;
+    f1 = f1 - half*ws2*dV2*(v + a);
+
+    f2 = f2 - half*ws0*dV0*(H - v*a);
+    f2 = f2 - half*ws1*dV1*(half*v*v);
+    f2 = f2 - half*ws2*dV2*(H + v*a);
+}
+
+
+void EulerSolver1D::Solver::roe_flux_batch(FaceBatch& faces){
+
+    const int n = faces.nfaces;
+    const float* rhoL = faces.wL[0].data();
+    const float*   vL = faces.wL[1].data();
+    const float*   pL = faces.wL[2].data();
+    const float* rhoR = faces.wR[0].data();
+    const float*   vR = faces.wR[1].data();
+    const float*   pR = faces.wR[2].data();
+    float* f0 = faces.flux[0].data();
+    float* f1 = faces.flux[1].data();
+    float* f2 = faces.flux[2].data();
+    const float g = gamma;
+
+    #pragma omp simd
+    for (int i = 0; i < n; ++i){
+        roe_flux_kernel( rhoL[i], vL[i], pL[i], rhoR[i], vR[i], pR[i], g,
+                         f0[i], f1[i], f2[i] );
+    }
+}
+
+
+void EulerSolver1D::Solver::roe_flux_batch_scalar(FaceBatch& faces){
+
+    for (int i = 0; i < faces.nfaces; ++i){
+        roe_flux_kernel( faces.wL[0][i], faces.wL[1][i], faces.wL[2][i],
+                         faces.wR[0][i], faces.wR[1][i], faces.wR[2][i], gamma,
+                         faces.flux[0][i], faces.flux[1][i], faces.flux[2][i] );
+    }
+}
+//--------------------------------------------------------------------------------
+
+
+
+//*******************************************************************************
+//* Check the batched Roe flux against roe_flux.
+//*
+//* Random left/right states (smooth, shocks, near vacuum, sonic points, so that
+//* the entropy fix is active) are evaluated by roe_flux, roe_flux_batch and
+//* roe_flux_batch_scalar. The three must agree bit for bit.
+//*
+//* Returns false on a mismatch. Run by run/bench_roe_batch ("make bench").
+//*******************************************************************************
+bool EulerSolver1D::Solver::check_roe_flux_batch(){
+
+    const int n = 1003;  //not a multiple of the SIMD width: tests the remainder loop
+    FaceBatch batch, batch_scalar;
+    batch.allocate(n);
+    batch_scalar.allocate(n);
+
+    unsigned int seed = 12345;
+    auto rnd = [&seed](float lo, float hi){
+        seed = 1103515245u*seed + 12345u;
+        return lo + (hi-lo)*float((seed >> 8) & 0xFFFF)/float(0xFFFF);
+    };
+
+    for (int i = 0; i < n; ++i){
+        batch.wL[0][i] = rnd(0.01f, 2.0f);  batch.wR[0][i] = rnd(0.01f, 2.0f);
+        batch.wL[1][i] = rnd(-2.0f, 2.0f);  batch.wR[1][i] = rnd(-2.0f, 2.0f);
+        batch.wL[2][i] = rnd(0.01f, 2.0f);  batch.wR[2][i] = rnd(0.01f, 2.0f);
+        if (i%5 == 0){ //identical states (e.g., boundary faces)
+            for (int k = 0; k < 3; ++k) batch.wR[k][i] = batch.wL[k][i];
+        }
+    }
+    for (int k = 0; k < 3; ++k){
+        batch_scalar.wL[k] = batch.wL[k];
+        batch_scalar.wR[k] = batch.wR[k];
+    }
+
+    roe_flux_batch(batch);
+    roe_flux_batch_scalar(batch_scalar);
+
+    int nfail = 0;
+    State wl, wr, f;
+    for (int i = 0; i < n; ++i){
+        for (int k = 0; k < 3; ++k){
+            wl(k) = batch.wL[k][i];
+            wr(k) = batch.wR[k][i];
+        }
+        f = roe_flux(wl,wr);
+        for (int k = 0; k < 3; ++k){
+            if ( memcmp(&f(k), &batch.flux[k][i],        sizeof(float)) != 0 ||
+                 memcmp(&f(k), &batch_scalar.flux[k][i], sizeof(float)) != 0 ){
+                if (nfail < 10){
+                    std::cout << " face " << i << " component " << k
+                              << std::setprecision(9)
+                              << " roe_flux = " << f(k)
+                              << " batch = " << batch.flux[k][i]
+                              << " scalar = " << batch_scalar.flux[k][i] << std::endl;
+                }
+                nfail++;
+            }
+        }
+    }
+
+    if (nfail > 0){
+        std::cout << " check_roe_flux_batch: " << nfail
+                  << " mismatches." << std::endl;
+        return false;
+    }
+    std::cout << " check_roe_flux_batch: " << n
+              << " faces, bitwise identical to roe_flux." << std::endl;
+    return true;
+}
+//--------------------------------------------------------------------------------
+
 //*******************************************************************************
 // Physical flux of the Euler equations (inviscid part only).
 //
@@ -563,9 +816,9 @@ Array2D<float> EulerSolver1D::Solver::roe_flux(Array2D<float>&  wL, Array2D<floa
 //
 //*******************************************************************************
 //function euler_physical_flux(w) result(flux)
-Array2D<float> EulerSolver1D::Solver::euler_physical_flux(Array2D<float>& w){
+EulerSolver1D::State EulerSolver1D::Solver::euler_physical_flux(const State& w){
 
-    Array2D<float> flux(3,1); //Output
+    State flux; //Output
 
     //Local parameters
     const float half = 0.5;
@@ -599,27 +852,182 @@ Array2D<float> EulerSolver1D::Solver::euler_physical_flux(Array2D<float>& w){
 //********************************************************************************
     void EulerSolver1D::Solver::output(){
 
-    float entropy;
+    write_solution("solution.dat");
+
+}
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Write a snapshot of the solution during the run: snapshot_prefix_NNNN.dat,
+//* in the format of solution.dat.
+//********************************************************************************
+    void EulerSolver1D::Solver::snapshot(){
+
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%04d.dat", nsnapshots);
+    write_solution(snapshot_prefix + number);
+    nsnapshots++;
+
+}
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Copy xc and w of the cells into a staging buffer of the writer, and let the
+//* I/O thread format and write the file: the solver goes on right away.
+//********************************************************************************
+    void EulerSolver1D::Solver::write_solution(const std::string& filename){
 
-    ofstream outfile;
-    outfile.open ("solution.dat");
+    int k;
+    std::vector<double>& buffer = writer.acquire_staging(k);
+    buffer.resize(4*ncells);
     for (int i=1; i<ncells+1; ++i){
-        entropy = log( cell[i].w(2)* pow(cell[i].w(0) , (-gamma)) ) / (gamma-one);
-        outfile << std::setprecision(16) << cell[i].xc << '\t'
-                << std::setprecision(16) << cell[i].w(0) << '\t' 
-                << std::setprecision(16) << cell[i].w(1) << '\t'
-                << std::setprecision(16) << cell[i].w(2) << '\t'
-                << std::setprecision(16) << entropy <<  "\n";
+        buffer[4*(i-1)  ] = cell[i].xc;
+        buffer[4*(i-1)+1] = cell[i].w(0);
+        buffer[4*(i-1)+2] = cell[i].w(1);
+        buffer[4*(i-1)+3] = cell[i].w(2);
     }
-    outfile.close();
+
+    const float g = gamma;
+    const float o = one;
+    writer.write_staged(filename, k, [g, o](const std::vector<double>& b){
+
+        std::ostringstream outfile;
+        const float gamma = g, one = o;
+        for (size_t i=0; i+3<b.size(); i+=4){
+            float xc = float(b[i]), w0 = float(b[i+1]), w1 = float(b[i+2]), w2 = float(b[i+3]);
+            float entropy = log( w2* pow(w0 , (-gamma)) ) / (gamma-one);
+            outfile << std::setprecision(16) << xc << '\t'
+                    << std::setprecision(16) << w0 << '\t'
+                    << std::setprecision(16) << w1 << '\t'
+                    << std::setprecision(16) << w2 << '\t'
+                    << std::setprecision(16) << entropy <<  "\n";
+        }
+        const std::string s = outfile.str();
+        return std::vector<char>(s.begin(), s.end());
+    });
 
 }
 //--------------------------------------------------------------------------------
 
 
+//********************************************************************************
+//* Checkpoint/restart: the conservative variables of the cells, the time and
+//* the number of steps, tied to the grid (ncells, xmin, xmax). Taken between two
+//* time steps, where u is the whole state of the Runge-Kutta scheme.
+//*
+//*   magic "EDU1DCKP", version, grid hash, ncells, t, nsteps, RK stage (0),
+//*   u (3*ncells)
+//*
+//* Written by the I/O thread, to "name.tmp" and then renamed (see Checkpoint.h).
+//********************************************************************************
+namespace {
+
+const char checkpoint_magic_1d[8] = {'E','D','U','1','D','C','K','P'};
+const int32_t checkpoint_version_1d = 1;
+
+uint64_t grid_hash_1d(int ncells, float xmin, float xmax){
+    uint64_t h = Checkpoint::hash_seed;
+    h = Checkpoint::hash_bytes(&ncells, sizeof(ncells), h);
+    h = Checkpoint::hash_bytes(&xmin,   sizeof(xmin),   h);
+    h = Checkpoint::hash_bytes(&xmax,   sizeof(xmax),   h);
+    return h;
+}
+
+} // end anonymous namespace
+
+    void EulerSolver1D::Solver::write_checkpoint(const std::string& filename){
+
+    int k;
+    std::vector<double>& buffer = writer.acquire_staging(k);
+    buffer.resize(3*ncells);
+    for (int j=1; j<ncells+1; ++j){
+        for (int i=0; i<3; ++i) buffer[3*(j-1)+i] = cell[j].u(i);
+    }
+
+    const uint64_t hash = grid_hash_1d(ncells, xmin, xmax);
+    const int32_t  n = ncells, steps = nsteps;
+    const float    time = t;
+
+    writer.write_staged(filename, k, [hash, n, steps, time](const std::vector<double>& b){
+        std::vector<float> u(b.begin(), b.end());
+        Checkpoint::Writer out;
+        out.put_magic(checkpoint_magic_1d);
+        out.put(checkpoint_version_1d);
+        out.put(hash);
+        out.put(n);
+        out.put(time);
+        out.put(steps);
+        out.put(int32_t(0));   // RK stage: between two steps
+        out.put_vector(u);
+        return out.bytes;
+    });
+
+}
+//--------------------------------------------------------------------------------
+
+
+
+// Read a checkpoint into t, nsteps and the cells (u, w, ghost cells).
+    bool EulerSolver1D::Solver::read_checkpoint(const std::string& filename){
+
+    std::vector<char> bytes;
+    if (!Checkpoint::read_file(filename, bytes)) return false;
+
+    Checkpoint::Reader in(bytes);
+    in.check_magic(checkpoint_magic_1d);
+    const int32_t  version = in.get<int32_t>();
+    const uint64_t hash    = in.get<uint64_t>();
+    const int32_t  n       = in.get<int32_t>();
+    const float    time    = in.get<float>();
+    const int32_t  steps   = in.get<int32_t>();
+    in.get<int32_t>();     // RK stage
+    std::vector<float> u(3*ncells);
+    in.get_array(u.data(), int64_t(u.size()));
+
+    if (!in.ok() || version != checkpoint_version_1d ||
+        hash != grid_hash_1d(ncells, xmin, xmax) || n != ncells){
+        printf("\n %s is not a checkpoint of this grid\n", filename.c_str());
+        return false;
+    }
+
+    for (int j=1; j<ncells+1; ++j){
+        for (int i=0; i<3; ++i) cell[j].u(i) = u[3*(j-1)+i];
+        cell[j].w = u2w(cell[j].u);
+    }
+    cell[0].w        = cell[1].w;
+    cell[ncells+1].w = cell[ncells].w;
+
+    t      = time;
+    nsteps = steps;
+    return true;
+
+}
+//--------------------------------------------------------------------------------
+
+
+
 void EulerSolver1D::driverEuler1D(){
     Solver solver;
     solver.Euler1D();
     solver.output();
     return;
+}
+
+void EulerSolver1D::driverEuler1D(const CaseFile::Case& c){
+    c.check_keys({"solver", "snapshot_steps", "snapshot_dt", "snapshot_prefix",
+                  "checkpoint_steps", "checkpoint_file", "restart"});
+    Solver solver;
+    solver.snapshot_steps  = c.get_int("snapshot_steps", 0);
+    solver.snapshot_dt     = float( c.get_real("snapshot_dt", 0.0) );
+    solver.snapshot_prefix = c.get("snapshot_prefix", "solution_snapshot");
+    solver.checkpoint_steps = c.get_int("checkpoint_steps", 0);
+    solver.checkpoint_file  = c.get("checkpoint_file", "solution.ckp");
+    solver.restart          = c.get_bool("restart", false);
+    solver.Euler1D();
+    solver.output();
+    return;
 }
\ No newline at end of file
@@ -24,6 +24,26 @@
 // string trimfunctions
 #include "StringOps.h"
 
+//======================================
+// threads (residual assembly), see Makefile: OPENMP
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//======================================
+// work timers (MainData2D::work)
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // end anonymous namespace
+
 
 //using Eigen::Dynamic;
 using Eigen::MatrixXd;
@@ -49,165 +69,2512 @@ using Eigen::MatrixXd;
 
 
 
-// EulerSolver2D::MainData2D::~MainData2D() {
-//     delete[] node;
-//     }
+// EulerSolver2D::MainData2D::~MainData2D() {
+//     delete[] node;
+//     }
+
+EulerSolver2D::Solver::Solver(){}
+
+
+EulerSolver2D::Solver::~Solver(){
+   printf("destruct Solver");
+}
+
+
+//********************************************************************************
+//********************************************************************************
+//********************************************************************************
+//* Euler solver: Node-Centered Finite-Volume Method (Edge-Based)
+//*
+//* - Node-centered finite-volume method for unstructured grids(quad/tri/mixed)
+//* - Roe flux with an entropy fix and Rotated-RHLL flux
+//* - Reconstruction by unweighted least-squares method (2x2 system for gradients)
+//* - Van Albada slope limiter to the primitive variable gradients
+//* - 2-Stage Runge-Kutta time-stepping
+//*
+//********************************************************************************
+bool EulerSolver2D::Solver::euler_solver_main(EulerSolver2D::MainData2D& E2Ddata ){
+
+   // //Local variables
+   real res_norm[4][3];     //Residual norms(L1,L2,Linf)
+   real dt, time;           //Time step and actual time
+   int i_time_step;         //Number of time steps
+
+   // The temporary solution array needed for the Runge-Kutta method, u0,
+   // is allocated with the other nodal fields (E2Ddata.field.u0).
+   vector<real>& u  = E2Ddata.field.u;
+   vector<real>& u0 = E2Ddata.field.u0;
+   const int nsize  = E2Ddata.nnodes * E2Ddata.nq;
+
+   // These parameters are set in main. Here just print them on display.
+   cout << " \n";
+   cout << "Calling the Euler solver...";
+   cout << " \n";
+   cout << "                  M_inf = " <<  E2Ddata.M_inf << " \n";
+   cout << "                    CFL = " <<  E2Ddata.CFL << " \n";
+   cout << "             final time = " <<  E2Ddata.t_final << " \n";
+   cout << "          time_step_max = " <<  E2Ddata.time_step_max << " \n";
+   cout << "          inviscid_flux = " <<  trim(E2Ddata.inviscid_flux) << " \n";
+   cout << "           limiter_type = " <<  trim(E2Ddata.limiter_type) << " \n";
+   cout << "          time_stepping = " <<  trim(E2Ddata.time_stepping) << " \n";
+   if (E2Ddata.time_stepping_id != TimeStepping::global) {
+   cout << "     residual_tolerance = " <<  E2Ddata.residual_tolerance << " \n";
+   }
+   if (E2Ddata.time_stepping_id == TimeStepping::implicit) {
+   cout << "   CFL_start (implicit) = " <<  E2Ddata.CFL_start << " \n";
+   cout << "          linear_solver = " <<  trim(E2Ddata.linear_solver) << " \n";
+   }
+   if (E2Ddata.time_stepping_id == TimeStepping::implicit && E2Ddata.linear_solver_id == LinearSolver::gmres) {
+   cout << "         preconditioner = " <<  trim(E2Ddata.preconditioner) << " \n";
+   }
+   cout << " \n";
+
+   //--------------------------------------------------------------------------------
+   // First, make sure that normal mass flux is zero at all solid boundary nodes.
+   // NOTE: Necessary because initial solution may generate the normal component.
+   //--------------------------------------------------------------------------------
+
+   //    (A restart continues from a checkpoint, where this was already done.)
+   //--------------------------------------------------------------------------------
+
+   time = zero;
+   int first_step = 1;
+
+   if (E2Ddata.restart) {
+      int steps_done;
+      if ( !E2Ddata.read_checkpoint(E2Ddata.checkpoint_file, time, steps_done) ) {
+         cout << " Cannot restart from " << E2Ddata.checkpoint_file << " ... Stop. \n";
+         std::exit(0); //stop
+      }
+      for (int i = 0; i < E2Ddata.nnodes; i++) {
+         u2w( E2Ddata.field.u_at(i), E2Ddata.field.w_at(i), E2Ddata );
+      }
+      first_step = steps_done + 1;
+      cout << " Restart from " << E2Ddata.checkpoint_file << ": t = " << time
+           << " after " << steps_done << " steps \n";
+   } else {
+      eliminate_normal_mass_flux(E2Ddata);
+   }
+
+   //--------------------------------------------------------------------------------
+   // Time-stepping toward the final time
+   //--------------------------------------------------------------------------------
+   E2Ddata.time = time;
+
+   // Snapshots (every snapshot_steps steps and/or every snapshot_dt in time):
+   // the first one is the initial (or restart) solution.
+   const bool snapshots = E2Ddata.snapshot_steps > 0 || E2Ddata.snapshot_dt > zero;
+   real next_snapshot_time = E2Ddata.snapshot_dt;
+   if (E2Ddata.snapshot_dt > zero) {
+      while (next_snapshot_time <= time) next_snapshot_time += E2Ddata.snapshot_dt;
+   }
+   E2Ddata.snapshot_files.clear();
+   if (snapshots) E2Ddata.write_snapshot(time);
+
+   // Checkpoints (every checkpoint_steps steps, and at the end)
+   const bool checkpoints = E2Ddata.checkpoint_steps > 0;
+
+   // Steady mode: local time steps (no physical time, t_final is not used),
+   // until the residual norms have dropped by residual_tolerance. The history
+   // goes to history_file, 50 iterations at a time.
+   // Implicit: backward Euler, the CFL number growing from CFL_start as the
+   // residual drops (cfl = CFL_start/drop, at most CFL, which also caps CFL_start).
+   E2Ddata.work = MainData2D::work_counters();
+
+   // Multigrid (steady, local time steps): the coarse levels.
+   const bool multigrid = (E2Ddata.multigrid_levels > 1);
+   if (multigrid) setup_multigrid(E2Ddata);
+   const bool steady   = (E2Ddata.time_stepping_id != TimeStepping::global);
+   const bool implicit = (E2Ddata.time_stepping_id == TimeStepping::implicit);
+   real cfl    = std::min(E2Ddata.CFL_start, E2Ddata.CFL);   //implicit: CFL number of the iteration
+   int  sweeps = 0;                   //implicit: Gauss-Seidel sweeps (GMRES iterations) of the iteration
+   const char* sweeps_label = (E2Ddata.linear_solver_id == LinearSolver::gmres) ? " gmres=" : " sweeps=";
+   real res_max[4] = {zero, zero, zero, zero};   //Largest L1 norms so far
+   real res_drop   = one;                        //max over variables of L1/res_max
+   bool converged  = false;
+   std::ostringstream history;
+   if (steady) {
+      E2Ddata.boot_diagnostic(E2Ddata.history_file);
+      history << "# iteration, then L1 L2 Linf of the residual of each variable"
+              << " (density, x-momentum, y-momentum, energy), and the drop\n";
+   }
+
+   //time_step : loop time_step_max
+   for (i_time_step = first_step; i_time_step <= E2Ddata.time_step_max; i_time_step++) {
+
+      //------------------------------------------------------
+      // Two-stage Runge-Kutta scheme: u^n is saved as u0.
+      //  1. u^*     = u^n - (dt/vol)*Res(u^n)
+      //  2. u^{n+1} = 1/2*(u^n + u^*) - 1/2*(dt/vol)*Res(u^*)
+      //------------------------------------------------------
+
+      //-----------------------------
+      //- 1st Stage of Runge-Kutta:
+      //-----------------------------
+
+      //    Compute Res(u^n)
+      compute_residual(E2Ddata);
+
+      //    Compute residual norms (undivided residual)
+      residual_norm(E2Ddata, res_norm);
+
+      //    Steady mode: the drop of the residual norms, and their history.
+      if (steady) {
+         res_drop  = zero;
+         converged = true;
+         for (int k = 0; k < E2Ddata.nq; k++) {
+            const real r = res_norm[k][0];
+            if (r > res_max[k]) res_max[k] = r;
+            if (res_max[k] > zero && !(r/res_max[k] <= res_drop)) res_drop = r/res_max[k];
+            if ( !(r <= E2Ddata.residual_tolerance*res_max[k]) ) converged = false;   //NaN too
+         }
+
+         history << i_time_step;
+         for (int k = 0; k < E2Ddata.nq; k++) {
+            history << " " << res_norm[k][0] << " " << res_norm[k][1] << " " << res_norm[k][2];
+         }
+         history << " " << res_drop << "\n";
+         if (i_time_step%50 == 0 || converged) {
+            E2Ddata.write_diagnostic(history, E2Ddata.history_file);
+            history.str("");
+         }
+      }
+
+      //    Display the residual norm.
+      if (i_time_step==1) {
+         cout << "Density    X-momentum  Y-momentum   Energy \n";
+      }
+      if ( (i_time_step-1)%50 == 0 || converged ) {
+         if (steady) {
+            cout << "iteration=" << i_time_step << " L1(res)="
+                 << res_norm[0][0] << " " << res_norm[1][0] << " "
+                 << res_norm[2][0] << " " << res_norm[3][0] << " drop=" << res_drop;
+            if (implicit) cout << " CFL=" << cfl << sweeps_label << sweeps;
+            cout << " \n";
+         } else {
+            cout << "t=" << time << "    steps=" << i_time_step << " L1(res)="
+                 << res_norm[0][0] << " " << res_norm[1][0] << " "
+                 << res_norm[2][0] << " " << res_norm[3][0] << " \n";
+         }
+      }
+
+      //    Stop if the final time is reached (steady: if converged).
+      if (steady) {
+         if (converged) break; //exit time_step
+      } else if ( std::abs(time - E2Ddata.t_final) < 1.0e-15 ) {
+         break; //exit time_step
+      }
+
+      //    Implicit: one backward Euler step, instead of the Runge-Kutta stages.
+      if (implicit) {
+         cfl = E2Ddata.CFL_start/std::max(res_drop, real(1.0e-30));
+         cfl = std::min(E2Ddata.CFL, std::max(E2Ddata.CFL_start, cfl));
+         if ( !implicit_update(E2Ddata, cfl, sweeps) ) return false;
+      } else {
+
+      //    Save off the previous solution (to be used in the 2nd stage).
+      for (int k = 0; k < nsize; k++) u0[k] = u[k];
+
+      //    Compute the time step (global time step, and field.dt at nodes)
+      compute_time_step(E2Ddata, dt);
+
+      //    Adjust dt so as to finish exactly at the final time
+      if (!steady && time + dt > E2Ddata.t_final) dt = E2Ddata.t_final - time;
+
+      //    Update the solution
+      //    1st Stage => u^* = u^n - dt/dx*Res(u^n)
+      if ( !update_solution(E2Ddata, one, dt) ) return false;
+
+      //-----------------------------
+      //- 2nd Stage of Runge-Kutta:
+      //-----------------------------
+
+      //    Compute Res(u^*)
+      compute_residual(E2Ddata);
+
+      //    Compute 1/2*(u^n + u^*)
+      for (int k = 0; k < nsize; k++) u[k] = half*( u[k] + u0[k] );
+
+      //    2nd Stage => u^{n+1} = 1/2*(u^n + u^*) - 1/2*dt/dx*Res(u^*)
+      if ( !update_solution(E2Ddata, half, dt) ) return false;
+
+      //    Multigrid: a cycle on the coarse levels, and their correction.
+      if ( multigrid && !multigrid_correction(E2Ddata) ) return false;
+
+      }
+
+      if (!steady) time = time + dt;
+      E2Ddata.time = time;
+
+      //    Snapshot: copied to a staging buffer, written on the I/O thread.
+      bool snapshot_now = E2Ddata.snapshot_steps > 0 && i_time_step % E2Ddata.snapshot_steps == 0;
+      if (E2Ddata.snapshot_dt > zero && time >= next_snapshot_time) {
+         snapshot_now = true;
+         while (next_snapshot_time <= time) next_snapshot_time += E2Ddata.snapshot_dt;
+      }
+      if (snapshot_now) E2Ddata.write_snapshot(steady ? real(i_time_step) : time);
+
+      //    Checkpoint: i_time_step steps are done.
+      if (checkpoints && i_time_step % E2Ddata.checkpoint_steps == 0) {
+         E2Ddata.write_checkpoint(E2Ddata.checkpoint_file, time, i_time_step);
+      }
+
+   } //end loop time_step
+
+   //    The last checkpoint: the solution at the end (a restart from it stops at once).
+   if (checkpoints) E2Ddata.write_checkpoint(E2Ddata.checkpoint_file, time, i_time_step-1);
+
+   cout << " \n";
+   if (steady) {
+      if (!history.str().empty()) E2Ddata.write_diagnostic(history, E2Ddata.history_file);
+      cout << " Steady state: " << (converged ? "converged" : "not converged")
+           << " after " << i_time_step-1 << " iterations, residual drop = " << res_drop
+           << " (history -> " << E2Ddata.history_file << ") \n";
+      const MainData2D::work_counters& w = E2Ddata.work;
+      cout << " Residual evaluations: " << w.residual_evals;
+      if (w.matvecs > 0) cout << " (" << w.matvecs << " in Jacobian-vector products)";
+      cout << " \n Time (s): residual " << w.residual_time;
+      if (implicit) {
+         cout << ", Jacobian " << w.jacobian_time << ", linear solver " << w.linear_time;
+         if (E2Ddata.linear_solver_id == LinearSolver::gmres) cout << ", Krylov " << w.krylov_time;
+      }
+      cout << " \n";
+   } else {
+   cout << " End of time-stepping: t = " << time << " steps = " << i_time_step << " \n";
+   }
+   if (snapshots) {
+      cout << " Snapshots: " << E2Ddata.snapshot_files.size() << " -> "
+           << E2Ddata.snapshot_prefix << ".pvd"
+           << " (solver waited " << E2Ddata.writer.stall_seconds() << " s for the I/O thread)\n";
+   }
+   cout << " \n";
+
+   return true;
+
+}
+//********************************************************************************
+// End of program
+//********************************************************************************
+
+
+
+
+//********************************************************************************
+//* Prepararion for Tangency condition (slip wall):
+//*
+//* Eliminate normal mass flux component at all solid-boundary nodes at the
+//* beginning. The normal component will never be changed in the solver: the
+//* residuals will be constrained to have zero normal component.
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::eliminate_normal_mass_flux( EulerSolver2D::MainData2D& E2Ddata ) {
+
+   int i, j, inode;
+   real normal_mass_flux;
+   Array2D<real> n12(2,1);
+
+   //  bc_loop : loop nbound
+   for (size_t i = 0; i < E2Ddata.nbound; i++) {
+
+      // only_slip_wall : if (trim(bound(i)%bc_type) == "slip_wall") then
+      if ( E2Ddata.bound[i].bc == BCType::slip_wall ) {
+
+         cout << " Eliminating the normal momentum on slip wall boundary " << i << " \n";
+
+         // bnodes_slip_wall : loop bound(i)%nbnodes
+         for (size_t j = 0; j < E2Ddata.bound[i].nbnodes; j++ ) {
+
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            // THIS IS A SPECIAL TREATMENT FOR SHOCK DIFFRACTION PROBLEM.
+            //
+            // NOTE: This is a corner point between the inflow boundary and
+            //       the lower-left wall. Enforce zero y-momentum, which is
+            //       not ensured by the standard BCs.
+            //       This special treatment is necessary because the domain
+            //       is rectangular (the left boundary is a straight ine) and
+            //       the midpoint node on the left boundary is actually a corner.
+            //
+            //       Our computational domain:
+            //
+            //                 ---------------
+            //          Inflow |             |
+            //                 |             |  o: Corner node
+            //          .......o             |
+            //            Wall |             |  This node is a corner.
+            //                 |             |
+            //                 ---------------
+            //
+            //       This is to simulate the actual domain shown below:
+            //      
+            //         -----------------------
+            // Inflow  |                     |
+            //         |                     |  o: Corner node
+            //         --------o             |
+            //            Wall |             |
+            //                 |             |
+            //                 ---------------
+            //      In effect, we're simulating this flow by a simplified
+            //      rectangular domain (easier to generate the grid).
+            //      So, an appropriate slip BC at the corner node needs to be applied,
+            //      which is "zero y-momentum", and that's all.
+            //
+            if (int(j) == E2Ddata.bound[i].corner) {
+               inode                       = (*E2Ddata.bound[i].bnode)(j);
+               E2Ddata.field.u_at(inode)[2] = zero;                                 // Make sure zero y-momentum.
+               u2w( E2Ddata.field.u_at(inode), E2Ddata.field.w_at(inode), E2Ddata );// Update primitive variables
+               
+               continue; // cycle bnodes_slip_wall // That's all we neeed. Go to the next.
+
+            }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+            inode = (*E2Ddata.bound[i].bnode)(j);
+            n12(0) = (*E2Ddata.bound[i].bnx)(j);
+            n12(1) = (*E2Ddata.bound[i].bny)(j);
+
+            real* u = E2Ddata.field.u_at(inode);
+
+            normal_mass_flux = u[1]*n12(0) + u[2]*n12(1);
+
+            u[1] = u[1] - normal_mass_flux * n12(0);
+            u[2] = u[2] - normal_mass_flux * n12(1);
+
+            u2w( u, E2Ddata.field.w_at(inode), E2Ddata );
+
+         }//end loop bnodes_slip_wall
+
+         cout << " Finished eliminating the normal momentum on slip wall boundary " << i << " \n";
+
+      }//end if only_slip_wall
+
+   }//end loop bc_loop
+
+ } // end eliminate_normal_mass_flux
+
+//--------------------------------------------------------------------------------
+
+
+
+
+//********************************************************************************
+//* Numerical flux across the dual face of the i-th edge (interior edges).
+//*
+//* The left and right states are reconstructed at the edge midpoint from the
+//* nodal gradients (with or without the Van Albada limiter), and the Roe or the
+//* Rotated-RHLL flux is evaluated. With no gradient (first order), the states
+//* are the nodal values and the gradients are not read.
+//*
+//* At a slip-wall node, the limiter takes the upwind differences from the
+//* mirror image of the solution across the wall (see wall_mirror_gradient).
+//* The states are the nodal values (first order) on an edge where a
+//* reconstructed density or pressure is not positive.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: i = edge number
+//*         F = FluxType::roe or FluxType::rhll (Rotated-RHLL)
+//*         L = LimiterType::vanalbada or LimiterType::none
+//*         G = GradientType::none (first order), or linear/quadratic2
+//*         g1, g2 = gradients at n1 and n2, g[ivar*2+ix] (default: field.gradw)
+//*
+//* Output: flux(0:3) = numerical flux times the magnitude of the directed area
+//*         wsn       = max wave speed times the magnitude of the directed area
+//* ------------------------------------------------------------------------------
+//*
+//* Note: Reads the solution only, so it can be called from several threads.
+//*       The flux, the limiter and the gradient are template parameters, so each
+//*       combination is compiled (and inlined) separately.
+//*
+//********************************************************************************
+template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L, EulerSolver2D::GradientType G>
+inline void EulerSolver2D::Solver::edge_flux(EulerSolver2D::MainData2D& E2Ddata, int i,
+                                             real* flux, real& wsn) {
+
+   const int nq = E2Ddata.nq;
+   const real* gradw = E2Ddata.field.gradw.data();
+   edge_flux<F,L,G>(E2Ddata, i, gradw + E2Ddata.edge[i].n1*nq*2,
+                                gradw + E2Ddata.edge[i].n2*nq*2, flux, wsn);
+
+} // end edge_flux
+
+
+
+template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L, EulerSolver2D::GradientType G>
+inline void EulerSolver2D::Solver::edge_flux(EulerSolver2D::MainData2D& E2Ddata, int i,
+                                             const real* g1, const real* g2,
+                                             real* flux, real& wsn) {
+
+   real nx, ny, mag_n12;          //Unit directed-area vector and its magnitude
+   real dx, dy, mag_e12;          //Edge vector and its magnitude
+   real dwp, dwm;
+   real wL[4], wR[4];             //Left and right states (primitive)
+
+   NodeFields& f = E2Ddata.field;
+
+   // Left and right nodes of the i-th edge
+
+   const int n1 = E2Ddata.edge[i].n1;  // Left node of the edge
+   const int n2 = E2Ddata.edge[i].n2;  // Right node of the edge
+   nx = E2Ddata.edge[i].dav(0);  // This is the directed area vector (unit vector)
+   ny = E2Ddata.edge[i].dav(1);
+   mag_n12 = E2Ddata.edge[i].da; // Magnitude of the directed area vector
+   dx = E2Ddata.node[n2].x - E2Ddata.node[n1].x;
+   dy = E2Ddata.node[n2].y - E2Ddata.node[n1].y;
+   mag_e12 = E2Ddata.edge[i].e;  // Magnitude of the edge vector
+
+   const real* w1 = f.w_at(n1);
+   const real* w2 = f.w_at(n2);
+
+   //  Solution gradient projected along the edge
+   //
+   //  NOTE: The gradient is multiplied by the distance.
+   //        So, it is equivalent to the solution difference.
+
+   //  (0) First order: no reconstruction
+
+   if constexpr ( G == GradientType::none ) {
+
+      for (int k = 0; k < 4; k++) {
+         wL[k] = w1[k];
+         wR[k] = w2[k];
+      }
+
+   //  (1) No limiter (good for smooth solutions)
+
+   } else if constexpr ( L == LimiterType::none ) {
+
+      //  Simple linear extrapolation
+      for (int k = 0; k < 4; k++) {
+         wL[k] = w1[k] + half*( g1[2*k]*dx + g1[2*k+1]*dy );
+         wR[k] = w2[k] - half*( g2[2*k]*dx + g2[2*k+1]*dy );
+      }
+
+   //  (2) Van Albada limiter
+
+   } else {
+
+      //  At a slip-wall node the gradient is one-sided in the normal direction,
+      //  and dwm below is not an upwind difference for the edges into the
+      //  domain: a node below all its neighbors (the wall under the corner of
+      //  the shock diffraction) would extrapolate up on each of them, and its
+      //  density would be drained below zero. Take dwm from the mirror image.
+      real gm1[8], gm2[8];
+      const real* wn = E2Ddata.wall_normal.data();
+      if (wn[2*n1] != zero || wn[2*n1+1] != zero) { wall_mirror_gradient(g1, wn+2*n1, gm1); g1 = gm1; }
+      if (wn[2*n2] != zero || wn[2*n2+1] != zero) { wall_mirror_gradient(g2, wn+2*n2, gm2); g2 = gm2; }
+
+      //  In 1D: dwp = w_{j+1}-w_j, dwm = w_j-w_{j-1} => limited_slope = limiter(dwm,dwp)
+      //
+      //  We can do the same in 2D as follows.
+      //  In 2D:    dwp = w_{neighbor}-w_j, dwm = 2*(grad_w_j*edge)-dwp
+      //        => limited_slope = limiter(dwm,dwp)
+      //
+      // NOTE: On a regular grid, grad_w_j*edge will be the central-difference,
+      //       so that the difference (dwm) will be the upwind difference.
+      //
+      // NOTE: Higher-order if the gradient is quadratically exact.
+      for (int k = 0; k < 4; k++) {
+
+         // Left state
+         dwp = w2[k] - w1[k];
+         dwm = two*( g1[2*k]*dx + g1[2*k+1]*dy ) - dwp;
+         wL[k] = w1[k] + half*va_slope_limiter(dwm, dwp, mag_e12);
+
+         // Right state
+         dwp = w1[k] - w2[k];
+         dwm = -two*( g2[2*k]*dx + g2[2*k+1]*dy ) - dwp;
+         wR[k] = w2[k] + half*va_slope_limiter(dwm, dwp, mag_e12);
+      }
+
+   }
+
+   //  (3) Back to first order for non-positive states
+
+   if constexpr ( G != GradientType::none ) {
+
+      if ( !( wL[0] > zero && wL[3] > zero && wR[0] > zero && wR[3] > zero ) ) {
+         for (int k = 0; k < 4; k++) {
+            wL[k] = w1[k];
+            wR[k] = w2[k];
+         }
+      }
+
+   }
+
+   //  Compute the numerical flux for given wL and wR.
+
+   if constexpr ( F == FluxType::roe ) {
+      roe(wL, wR, nx, ny, flux, wsn, E2Ddata);
+   } else {
+      rotated_rhll(wL, wR, nx, ny, flux, wsn, E2Ddata);
+   }
+
+   for (int k = 0; k < 4; k++) flux[k] *= mag_n12;
+   wsn *= mag_n12;
+
+} // end edge_flux
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* This subroutine computes the residual for a node-centered finite-volume method
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: the current solution, field.w (and field.u)
+//*
+//* Output: field.res = the residual computed by the current solution.
+//*         field.wsn = sum of the max wave speed times face length (for dt)
+//* ------------------------------------------------------------------------------
+//*
+//* Note: dU/dt + dF/dx + dG/dy = 0. Residuals are first computed as
+//*       the integral of (dF/dx + dG/dy), and at the end negative sign is added
+//*       so that we have dU/dt = Res at every node.
+//*       (Here the sign is kept as the integral of the flux, and the update
+//*        is u = u - (dt/vol)*res, as in the 1D solver.)
+//*
+//* Note: All work arrays in the edge loop are on the stack; no heap
+//*       allocation takes place per edge or per face.
+//*
+//* Note: The scheme options (flux, limiter, gradient) are template parameters
+//*       of compute_residual_kernel, one instantiation per combination.
+//*       compute_residual picks the one set by MainData2D::set_scheme_options
+//*       from a table, once per call.
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::compute_residual(EulerSolver2D::MainData2D& E2Ddata) {
+
+   typedef void (Solver::*kernel_type)(EulerSolver2D::MainData2D&);
+
+   //  [flux][limiter][gradient], in the order of the enums.
+   static const kernel_type kernel[2][2][3] = {
+      { { &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::none,      GradientType::none>,
+          &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::none,      GradientType::linear>,
+          &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::none,      GradientType::quadratic2> },
+        { &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::vanalbada, GradientType::none>,
+          &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::vanalbada, GradientType::linear>,
+          &Solver::compute_residual_kernel<FluxType::roe,  LimiterType::vanalbada, GradientType::quadratic2> } },
+      { { &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::none,      GradientType::none>,
+          &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::none,      GradientType::linear>,
+          &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::none,      GradientType::quadratic2> },
+        { &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::vanalbada, GradientType::none>,
+          &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::vanalbada, GradientType::linear>,
+          &Solver::compute_residual_kernel<FluxType::rhll, LimiterType::vanalbada, GradientType::quadratic2> } }
+   };
+
+   const int iflux = static_cast<int>(E2Ddata.flux_id);
+   const int ilim  = static_cast<int>(E2Ddata.limiter_id);
+   const int igrad = static_cast<int>(E2Ddata.gradient_id);
+
+   const auto t0 = std::chrono::steady_clock::now();
+   (this->*kernel[iflux][ilim][igrad])(E2Ddata);
+   E2Ddata.work.residual_time += seconds_since(t0);
+   E2Ddata.work.residual_evals++;
+
+} // end compute_residual
+
+
+
+template <EulerSolver2D::FluxType F, EulerSolver2D::LimiterType L, EulerSolver2D::GradientType G>
+void EulerSolver2D::Solver::compute_residual_kernel(EulerSolver2D::MainData2D& E2Ddata) {
+
+   //Local variables
+   int  inode;
+   real nx, ny, mag_n12;          //Unit directed-area vector and its magnitude
+   real wsn;
+   real num_flux[4];              //Numerical flux
+   real normal_res;
+
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+
+//-------------------------------------------------------------------------
+// Gradient Reconstruction for second-order accuracy
+
+   //  "tiled": each tile computes the gradients it needs, and writes the
+   //  residuals of its nodes (so, only the ghosts are initialized). On a
+   //  decomposed grid, the stencils of the ghosts are not complete: the
+   //  gradients are computed (and exchanged) first, as in the other modes.
+   const bool tiled = (E2Ddata.assembly_id == AssemblyType::tiled);
+   const bool tile_gradients = tiled && G != GradientType::none && !E2Ddata.halo.active();
+   const int  nfirst = tiled ? E2Ddata.nodes_owned() : 0;
+
+   //  Initialization
+   for (int k = nfirst*nq; k < E2Ddata.nnodes*nq; k++) f.res[k] = zero;
+   for (int i = nfirst;    i < E2Ddata.nnodes;    i++) f.wsn[i] = zero;
+
+   //  Decomposed grid: the solution at the ghost nodes, from their owners.
+   E2Ddata.halo.update(f.w.data(), nq);
+
+   //  Compute gradients of the primitive variables at nodes (all nq at once).
+   if (!tile_gradients) compute_gradient_kernel<G>(E2Ddata);
+
+//-------------------------------------------------------------------------
+// Residual computation: interior fluxes
+//
+// Each edge flux is added to n1 and subtracted from n2. With threads, two
+// edges sharing a node must not scatter at the same time:
+//
+//  "coloring": loop over the colors; the edges of one color share no node,
+//              so they are split among the threads with no race. The result
+//              does not depend on the number of threads.
+//  "owner"   : the nodes are split into owner_parts blocks (a number that
+//              does not depend on the threads), and the threads loop over
+//              the blocks; a block computes the edges of its nodes, and its
+//              contributions to the nodes of other blocks go to a halo
+//              buffer, added by their owner at the end in a fixed order.
+//              The result does not depend on the number of threads.
+//  "tiled"   : threads over tiles of nearby nodes (see tile_edges); a tile
+//              computes the gradients at its nodes and its halo, and the
+//              fluxes of its edges, into buffers of its own, and writes the
+//              residuals of its nodes once. The data of a tile stay in cache
+//              from the gradients to the fluxes, and field.gradw is neither
+//              written nor read (it is not updated in this mode).
+//  "serial"  : one thread, edges in order.
+
+   if (E2Ddata.assembly_id == AssemblyType::coloring) {
+
+      if (E2Ddata.ncolors == 0) E2Ddata.color_edges();
+
+      #pragma omp parallel
+      {
+         real flux[4], ws;
+         for (int c = 0; c < E2Ddata.ncolors; c++) {
+
+            #pragma omp for schedule(static)
+            for (int k = E2Ddata.color_ptr[c]; k < E2Ddata.color_ptr[c+1]; k++) {
+
+               const int i  = E2Ddata.color_edge[k];
+               const int n1 = E2Ddata.edge[i].n1;
+               const int n2 = E2Ddata.edge[i].n2;
+               edge_flux<F,L,G>(E2Ddata, i, flux, ws);
+
+               real* r1 = f.res_at(n1);
+               real* r2 = f.res_at(n2);
+               for (int kv = 0; kv < 4; kv++) {
+                  r1[kv] += flux[kv];
+                  r2[kv] -= flux[kv];
+               }
+               f.wsn[n1] += ws;
+               f.wsn[n2] += ws;
+            }
+            // (implicit barrier: the next color starts when this one is done)
+         }
+      }
+
+   } else if (E2Ddata.assembly_id == AssemblyType::owner) {
+
+      if (E2Ddata.nparts == 0) E2Ddata.partition_nodes(E2Ddata.owner_parts);
+
+      #pragma omp parallel
+      {
+         real flux[4], ws;
+
+         // Edges of the nodes owned by part p.
+         #pragma omp for schedule(static)
+         for (int p = 0; p < E2Ddata.nparts; p++) {
+
+            real* hres = E2Ddata.halo_res[p].data();
+            int   m    = 0;   // next entry of the halo buffer of p
+
+            for (int k = E2Ddata.part_edge_ptr[p]; k < E2Ddata.part_edge_ptr[p+1]; k++) {
+
+               const int i  = E2Ddata.part_edge[k];
+               const int n1 = E2Ddata.edge[i].n1;   // owned by p
+               const int n2 = E2Ddata.edge[i].n2;
+               edge_flux<F,L,G>(E2Ddata, i, flux, ws);
+
+               real* r1 = f.res_at(n1);
+               for (int kv = 0; kv < 4; kv++) r1[kv] += flux[kv];
+               f.wsn[n1] += ws;
+
+               if (E2Ddata.node_part[n2] == p) {
+                  real* r2 = f.res_at(n2);
+                  for (int kv = 0; kv < 4; kv++) r2[kv] -= flux[kv];
+                  f.wsn[n2] += ws;
+               } else {
+                  for (int kv = 0; kv < 4; kv++) hres[5*m+kv] = -flux[kv];
+                  hres[5*m+4] = ws;
+                  m++;
+               }
+            }
+         }
+         // (implicit barrier: all the halo buffers are complete)
+
+         // Add the contributions of the other parts to the nodes owned by p,
+         // in the order of halo_in (by part, then by edge).
+         #pragma omp for schedule(static)
+         for (int p = 0; p < E2Ddata.nparts; p++) {
+            for (int j = E2Ddata.halo_in_ptr[p]; j < E2Ddata.halo_in_ptr[p+1]; j++) {
+               const int   q    = E2Ddata.halo_in[2*j  ];
+               const int   m    = E2Ddata.halo_in[2*j+1];
+               const int   n2   = E2Ddata.halo_node[q][m];
+               const real* qres = &E2Ddata.halo_res[q][5*m];
+               real* r2 = f.res_at(n2);
+               for (int kv = 0; kv < 4; kv++) r2[kv] += qres[kv];
+               f.wsn[n2] += qres[4];
+            }
+         }
+      }
+
+   } else if (tiled) {
+
+      if (E2Ddata.ntiles == 0) E2Ddata.tile_edges(E2Ddata.tile_size);
+
+      int nthreads = 1;
+#ifdef _OPENMP
+      nthreads = omp_get_max_threads();
+#endif
+      if (int(E2Ddata.tile_work.size()) < nthreads) E2Ddata.tile_work.resize(nthreads);
+
+      #pragma omp parallel
+      {
+         int p = 0;
+#ifdef _OPENMP
+         p = omp_get_thread_num();
+#endif
+         //  Tile buffers: gradients of the owned and halo nodes, then the
+         //  residuals and wsn of the owned nodes.
+         const int nmax = E2Ddata.tile_max_nodes;
+         std::vector<real>& work = E2Ddata.tile_work[p];
+         work.resize(size_t(nmax)*(2*nq + nq + 1));
+         real* tgrad = work.data();
+         real* tres  = tgrad + nmax*2*nq;
+         real* twsn  = tres  + nmax*nq;
+
+         real flux[4], ws;
+
+         #pragma omp for schedule(dynamic)
+         for (int t = 0; t < E2Ddata.ntiles; t++) {
+
+            const int begin = E2Ddata.tile_node_ptr[t];
+            const int nown  = E2Ddata.tile_node_ptr[t+1] - begin;
+            const int* halo = E2Ddata.tile_halo.data() + E2Ddata.tile_halo_ptr[t];
+            const int nhalo = E2Ddata.tile_halo_ptr[t+1] - E2Ddata.tile_halo_ptr[t];
+
+            //  Gradients at the owned nodes, then at the halo.
+            if constexpr (G == GradientType::linear) {
+               if (tile_gradients) {
+                  for (int l = 0; l < nown;  l++) lsq_gradients_nc(E2Ddata, begin+l, tgrad + l*2*nq);
+                  for (int l = 0; l < nhalo; l++) lsq_gradients_nc(E2Ddata, halo[l], tgrad + (nown+l)*2*nq);
+               }
+            } else if constexpr (G == GradientType::quadratic2) {
+               if (tile_gradients) {
+                  for (int l = 0; l < nown;  l++) lsq_gradients2_nc(E2Ddata, begin+l, tgrad + l*2*nq);
+                  for (int l = 0; l < nhalo; l++) lsq_gradients2_nc(E2Ddata, halo[l], tgrad + (nown+l)*2*nq);
+               }
+            }
+
+            for (int k = 0; k < nown*nq; k++) tres[k] = zero;
+            for (int l = 0; l < nown;    l++) twsn[l] = zero;
+
+            //  Edges of the tile: the fluxes to its own nodes only.
+            for (int k = E2Ddata.tile_edge_ptr[t]; k < E2Ddata.tile_edge_ptr[t+1]; k++) {
+
+               const int i  = E2Ddata.tile_edge[k];
+               const int l1 = E2Ddata.tile_edge_local[2*k  ];
+               const int l2 = E2Ddata.tile_edge_local[2*k+1];
+               if (tile_gradients) {
+                  edge_flux<F,L,G>(E2Ddata, i, tgrad + l1*2*nq, tgrad + l2*2*nq, flux, ws);
+               } else {
+                  edge_flux<F,L,G>(E2Ddata, i, flux, ws);
+               }
+
+               if (l1 < nown) {
+                  for (int kv = 0; kv < 4; kv++) tres[l1*nq+kv] += flux[kv];
+                  twsn[l1] += ws;
+               }
+               if (l2 < nown) {
+                  for (int kv = 0; kv < 4; kv++) tres[l2*nq+kv] -= flux[kv];
+                  twsn[l2] += ws;
+               }
+            }
+
+            for (int k = 0; k < nown*nq; k++) f.res[begin*nq+k] = tres[k];
+            for (int l = 0; l < nown;    l++) f.wsn[begin+l]    = twsn[l];
+         }
+      }
+
+   } else {
+
+      real flux[4], ws;
+
+      //edge_loop : loop nedges
+      for (int i = 0; i < E2Ddata.nedges; i++) {
+
+         const int n1 = E2Ddata.edge[i].n1;  // Left node of the edge
+         const int n2 = E2Ddata.edge[i].n2;  // Right node of the edge
+         edge_flux<F,L,G>(E2Ddata, i, flux, ws);
+
+         //  Add the flux multiplied by the magnitude of the directed area vector to node1,
+         //  and accumulate the max wave speed quantity for use in the time step calculation.
+         real* r1 = f.res_at(n1);
+         real* r2 = f.res_at(n2);
+         for (int k = 0; k < 4; k++) {
+            r1[k] += flux[k];
+            r2[k] -= flux[k];
+         }
+         f.wsn[n1] += ws;
+         f.wsn[n2] += ws;
+
+      }//end loop edge_loop
+
+   }
+
+//-------------------------------------------------------------------------
+// Close with the boundary flux
+//
+// Each boundary face [n1,n2] is split into two halves: the half adjacent to n1
+// closes the dual volume of n1, and the other half closes that of n2.
+//
+//      o-------------o-------------o   -> outward normal (bfnx,bfny)
+//     n1     |      face j     |   n2
+//            |<- half of bfn ->|
+
+   //bc_loop : loop nbound
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      const BCType bc = bound.bc;
+
+      //bfaces : loop nbfaces
+      for (int j = 0; j < bound.nbfaces; j++) {
+
+         nx      = (*bound.bfnx)(j);
+         ny      = (*bound.bfny)(j);
+         mag_n12 = half*(*bound.bfn)(j);
+
+         //bnodes : the two end nodes of the face
+         for (int ii = 0; ii < 2; ii++) {
+
+            inode = (*bound.bnode)(j+ii);
+            const real* w1 = f.w_at(inode);
+
+            if ( !boundary_flux<F>(E2Ddata, bc, w1, nx, ny, num_flux, wsn) ) {
+               cout << " Boundary condition = " << trim(bound.bc_type) << " not implemented. \n";
+               cout << " ... Stop. \n";
+               std::exit(0); //stop
+            }
+
+            real* rb = f.res_at(inode);
+            for (int k = 0; k < 4; k++) rb[k] += num_flux[k] * mag_n12;
+            f.wsn[inode] += wsn * mag_n12;
+
+         }//end loop bnodes
+
+      }//end loop bfaces
+
+   }//end loop bc_loop
+
+//-------------------------------------------------------------------------
+// Tangency condition on slip walls:
+// Remove the normal component of the momentum residual so that the
+// zero normal mass flux set by eliminate_normal_mass_flux is preserved.
+
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      if ( bound.bc != BCType::slip_wall ) continue;
+
+      for (int j = 0; j < bound.nbnodes; j++) {
+
+         inode = (*bound.bnode)(j);
+         real* rb = f.res_at(inode);
+
+         // Special treatment for the corner node of the shock diffraction
+         // problem: zero y-momentum (see eliminate_normal_mass_flux).
+         if (j == bound.corner) {
+            rb[2] = zero;
+            continue;
+         }
+
+         nx = (*bound.bnx)(j);
+         ny = (*bound.bny)(j);
+         normal_res = rb[1]*nx + rb[2]*ny;
+         rb[1] = rb[1] - normal_res*nx;
+         rb[2] = rb[2] - normal_res*ny;
+      }
+
+   }
+
+} // end compute_residual_kernel
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Numerical flux through a boundary face, unit normal (nx,ny) pointing out,
+//* of a node (or coarse cell, see coarse_residual) with the interior state w1.
+//*
+//* The boundary state wb:
+//*   freestream            : the free stream values
+//*   slip_wall             : w1 with the normal velocity reflected; the flux is
+//*                           the pressure flux only (zero mass flux)
+//*   outflow_supersonic    : w1 (everything is going out)
+//*   outflow_back_pressure : w1 with p = p_inf
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: bc, w1 = primitive variables (rho,u,v,p), (nx,ny)
+//*
+//* Output: num_flux(0:3), wsn = max wave speed
+//*         returns false if bc is not implemented
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+template <EulerSolver2D::FluxType F>
+bool EulerSolver2D::Solver::boundary_flux(EulerSolver2D::MainData2D& E2Ddata, BCType bc,
+                                          const real* w1, real nx, real ny,
+                                          real* num_flux, real& wsn) {
+
+   real wb[4];
+
+   if (bc == BCType::freestream) {
+
+      wb[0] = E2Ddata.rho_inf;
+      wb[1] = E2Ddata.u_inf;
+      wb[2] = E2Ddata.v_inf;
+      wb[3] = E2Ddata.p_inf;
+
+   } else if (bc == BCType::slip_wall) {
+
+      real vn = w1[1]*nx + w1[2]*ny;
+      wb[0] = w1[0];
+      wb[1] = w1[1] - vn*nx;
+      wb[2] = w1[2] - vn*ny;
+      wb[3] = w1[3];
+
+      real a = std::sqrt(E2Ddata.gamma*wb[3]/wb[0]);
+      num_flux[0] = zero;
+      num_flux[1] = wb[3]*nx;
+      num_flux[2] = wb[3]*ny;
+      num_flux[3] = zero;
+      wsn = std::abs(vn) + a;
+      return true;
+
+   } else if (bc == BCType::outflow_supersonic) {
+
+      for (int k = 0; k < 4; k++) wb[k] = w1[k];
+
+   } else if (bc == BCType::outflow_back_pressure) {
+
+      for (int k = 0; k < 4; k++) wb[k] = w1[k];
+      wb[3] = E2Ddata.p_inf;
+
+   } else {
+
+      return false;
+
+   }
+
+   if constexpr ( F == FluxType::roe ) {
+      roe(w1, wb, nx, ny, num_flux, wsn, E2Ddata);
+   } else {
+      rotated_rhll(w1, wb, nx, ny, num_flux, wsn, E2Ddata);
+   }
+   return true;
+
+} // end boundary_flux
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* This subroutine computes the explicit time-step: the minimum dt over nodes.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: field.wsn, node[:].vol, CFL
+//*
+//* Output: field.dt = local time step at each node,
+//*         dt       = global time step
+//* ------------------------------------------------------------------------------
+//*
+//* NOTE: The global time step (the minimum local time step) is used for
+//*       time-accurate runs; the local time steps field.dt are used in the
+//*       steady mode (time_stepping = "local", see update_solution).
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::compute_time_step(EulerSolver2D::MainData2D& E2Ddata, real& dt) {
+
+   real dt_min = 1.0e+05;
+   NodeFields& f = E2Ddata.field;
+
+   //nodes : loop nnodes (the owned nodes of a decomposed grid)
+   for (int i = 0; i < E2Ddata.nodes_owned(); i++) {
+
+      // Local time step: dt = volume/sum(max_wave_speed*face_area).
+      f.dt[i] = E2Ddata.CFL*E2Ddata.node[i].vol / f.wsn[i];
+
+      // Keep the minimum dt
+      dt_min = std::min(dt_min, f.dt[i]);
+
+   }
+
+   // Global time-step (the minimum over all ranks)
+   Halo::min(&dt_min, 1);
+   dt = dt_min;
+
+} // end compute_time_step
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* This subroutine updates the solution.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:  coeff = coefficient for RK time-stepping
+//*             dt = global time step
+//*          field.dt  = local time steps (used instead of dt if time_stepping = "local")
+//*          field.res = the residual
+//*
+//* Output:  field.u, field.w = updated conservative and primitive variables
+//*          returns false if a non-physical state (rho or p <= 0) is found
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+bool EulerSolver2D::Solver::update_solution(EulerSolver2D::MainData2D& E2Ddata,
+                                            real coeff, real dt) {
+
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+   const bool local = (E2Ddata.time_stepping_id == TimeStepping::local);
+   bool ok = true;
+
+   //nodes : loop nnodes (the owned nodes of a decomposed grid)
+   for (int i = 0; i < E2Ddata.nodes_owned(); i++) {
+
+      real* u   = f.u_at(i);
+      real* w   = f.w_at(i);
+      real* res = f.res_at(i);
+      real  dtv = coeff*(local ? f.dt[i] : dt)/E2Ddata.node[i].vol;
+
+      for (int k = 0; k < nq; k++) u[k] = u[k] - dtv * res[k];
+
+      u2w(u, w, E2Ddata);
+
+      //  Check for non-physical states (NaN included)
+      if ( !(w[0] > zero && w[3] > zero) ) {
+         cout << " Negative density or pressure at node "
+              << (E2Ddata.sub.global.empty() ? i : E2Ddata.sub.global[i])
+              << " (x,y) = (" << E2Ddata.node[i].x << "," << E2Ddata.node[i].y << ")"
+              << " rho = " << w[0] << " p = " << w[3] << " \n";
+         cout << " ... Stop. \n";
+         ok = false;
+         break;
+      }
+
+   }
+
+   //  Several ranks: all stop together.
+   if ( !Halo::all(ok) ) {
+      if (ok) cout << " Non-physical state on another rank (see log/rank_<r>.log) ... Stop. \n";
+      return false;
+   }
+
+   return true;
+
+} // end update_solution
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Jacobian of the normal Euler flux, dFn/du (u = conservative variables),
+//* Fn = F*nx + G*ny, at the primitive state w.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: w = primitive variables (rho,u,v,p), (nx,ny) = unit normal
+//*
+//* Output: a(0:15) = dFn/du, row-major (a[4*r+c] = dFn_r/du_c)
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::flux_jacobian(const real* w, real nx, real ny, double* a,
+                                          EulerSolver2D::MainData2D& E2Ddata) {
+
+   const real gm1 = E2Ddata.gamma - one;
+   const real u   = w[1];
+   const real v   = w[2];
+   const real q2  = u*u + v*v;
+   const real vn  = u*nx + v*ny;
+   const real H   = E2Ddata.gamma*w[3]/(gm1*w[0]) + half*q2;   // total enthalpy
+   const real phi = half*gm1*q2;
+
+   a[ 0] = zero;            a[ 1] = nx;                  a[ 2] = ny;                  a[ 3] = zero;
+   a[ 4] = phi*nx - u*vn;   a[ 5] = vn + (one-gm1)*u*nx; a[ 6] = u*ny - gm1*v*nx;     a[ 7] = gm1*nx;
+   a[ 8] = phi*ny - v*vn;   a[ 9] = v*nx - gm1*u*ny;     a[10] = vn + (one-gm1)*v*ny; a[11] = gm1*ny;
+   a[12] = (phi - H)*vn;    a[13] = H*nx - gm1*u*vn;     a[14] = H*ny - gm1*v*vn;     a[15] = E2Ddata.gamma*vn;
+
+} // end flux_jacobian
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* This subroutine computes the Jacobian of the first-order residual,
+//* plus the pseudo-time term vol/dt = wsn/cfl on the diagonal.
+//*
+//* Interior edge [n1,n2], Rusanov flux with the max wave speed lambda frozen:
+//*
+//*   Fn(u1,u2) = 1/2*( Fn(u1) + Fn(u2) ) - 1/2*lambda*(u2 - u1)
+//*   dFn/du1   = 1/2*( A(u1) + lambda*I ),   dFn/du2 = 1/2*( A(u2) - lambda*I )
+//*
+//* added to the row of n1 and subtracted from the row of n2 (times the
+//* magnitude of the directed area). The off-diagonal blocks are found with
+//* edge.kth_nghbr_of_1 and kth_nghbr_of_2.
+//*
+//* Boundary faces (w_b is a function of the interior state, frozen):
+//*   slip_wall          : pressure flux only, dFn/du = n*dp/du
+//*   outflow_supersonic : Fn(u), dFn/du = A(u)
+//*   others             : Rusanov with the boundary state frozen, 1/2*(A(u)+lambda*I)
+//*
+//* ------------------------------------------------------------------------------
+//*  Input: field.w, field.wsn (compute_residual), cfl
+//*
+//* Output: E2Ddata.jac
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::compute_jacobian(EulerSolver2D::MainData2D& E2Ddata, real cfl) {
+
+   const int nb2 = SparseBlock::nb2;
+   SparseBlock::BlockMatrix& jac = E2Ddata.jac;
+   NodeFields& f = E2Ddata.field;
+   double a1[nb2], a2[nb2];
+
+   if (jac.rows() != E2Ddata.nnodes) jac.set_pattern(E2Ddata.nnodes, E2Ddata.nghbr_ptr, E2Ddata.nghbr_idx);
+   jac.zero();
+
+   //  Interior edges
+
+   for (int i = 0; i < E2Ddata.nedges; i++) {
+
+      const edge_type& e = E2Ddata.edge[i];
+      const int  n1  = e.n1;
+      const int  n2  = e.n2;
+      const real nx  = e.dav(0);
+      const real ny  = e.dav(1);
+      const real mag = e.da;
+      const real* w1 = f.w_at(n1);
+      const real* w2 = f.w_at(n2);
+
+      flux_jacobian(w1, nx, ny, a1, E2Ddata);
+      flux_jacobian(w2, nx, ny, a2, E2Ddata);
+      const real lambda = std::max( std::abs(w1[1]*nx + w1[2]*ny) + std::sqrt(E2Ddata.gamma*w1[3]/w1[0]),
+                                    std::abs(w2[1]*nx + w2[2]*ny) + std::sqrt(E2Ddata.gamma*w2[3]/w2[0]) );
+
+      double* d1  = jac.diag(n1);
+      double* d2  = jac.diag(n2);
+      double* o12 = jac.off( E2Ddata.nghbr_ptr[n1] + e.kth_nghbr_of_1 );
+      double* o21 = jac.off( E2Ddata.nghbr_ptr[n2] + e.kth_nghbr_of_2 );
+
+      for (int r = 0; r < 4; r++) {
+         for (int c = 0; c < 4; c++) {
+            const int  rc = 4*r + c;
+            const real dl = half*( a1[rc] + (r == c ? lambda : zero) )*mag;   // dFn/du1
+            const real dr = half*( a2[rc] - (r == c ? lambda : zero) )*mag;   // dFn/du2
+            d1[rc]  += dl;
+            o12[rc] += dr;
+            d2[rc]  -= dr;
+            o21[rc] -= dl;
+         }
+      }
+   }
+
+   //  Boundary faces: each half face closes the dual volume of its end node.
+
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      const BCType bc = bound.bc;
+
+      for (int j = 0; j < bound.nbfaces; j++) {
+
+         const real nx  = (*bound.bfnx)(j);
+         const real ny  = (*bound.bfny)(j);
+         const real mag = half*(*bound.bfn)(j);
+
+         for (int ii = 0; ii < 2; ii++) {
+
+            const int inode = (*bound.bnode)(j+ii);
+            const real* w1 = f.w_at(inode);
+            double* d1 = jac.diag(inode);
+
+            if (bc == BCType::slip_wall) {
+
+               //  Fn = (0, p*nx, p*ny, 0), p = (gamma-1)*(rho*E - 1/2*rho*q^2)
+               const real gm1 = E2Ddata.gamma - one;
+               const real dp[4] = { half*gm1*(w1[1]*w1[1] + w1[2]*w1[2]),
+                                    -gm1*w1[1], -gm1*w1[2], gm1 };
+               for (int c = 0; c < 4; c++) {
+                  d1[4+c] += nx*dp[c]*mag;
+                  d1[8+c] += ny*dp[c]*mag;
+               }
+
+            } else {
+
+               flux_jacobian(w1, nx, ny, a1, E2Ddata);
+               real lambda = zero;
+               if (bc != BCType::outflow_supersonic) {
+                  lambda = std::abs(w1[1]*nx + w1[2]*ny) + std::sqrt(E2Ddata.gamma*w1[3]/w1[0]);
+               }
+               const real s = (bc == BCType::outflow_supersonic) ? one : half;
+               for (int r = 0; r < 4; r++) {
+                  for (int c = 0; c < 4; c++) {
+                     d1[4*r+c] += s*( a1[4*r+c] + (r == c ? lambda : zero) )*mag;
+                  }
+               }
+
+            }
+
+         }//end loop bnodes
+      }//end loop bfaces
+   }//end loop bc_loop
+
+   //  Pseudo-time term: vol/dt = vol/(cfl*vol/wsn) = wsn/cfl
+
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+      double* d = jac.diag(i);
+      for (int r = 0; r < 4; r++) d[5*r] += f.wsn[i]/cfl;
+   }
+
+} // end compute_jacobian
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* The fraction alpha (0 < alpha <= 1) of a change du of the conservative
+//* variables at the primitive state w such that rho and p change by at most
+//* max_change = 20%: the updates of the implicit mode and the multigrid
+//* corrections are u + alpha*du.
+//********************************************************************************
+real EulerSolver2D::Solver::change_fraction(const real* w, const double* du,
+                                            EulerSolver2D::MainData2D& E2Ddata) {
+
+   const real max_change = 0.2;
+   const real gm1  = E2Ddata.gamma - one;
+   const real drho = du[0];
+   const real dp   = gm1*( du[3] - w[1]*du[1] - w[2]*du[2] + half*(w[1]*w[1] + w[2]*w[2])*du[0] );
+
+   real alpha = one;
+   if (std::abs(drho) > max_change*w[0]) alpha = std::min(alpha, max_change*w[0]/std::abs(drho));
+   if (std::abs(dp)   > max_change*w[3]) alpha = std::min(alpha, max_change*w[3]/std::abs(dp)  );
+   return alpha;
+
+} // end change_fraction
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Implicit update (time_stepping = "implicit"): one backward Euler step with
+//* the local time steps dt = cfl*vol/wsn, linearized about u:
+//*
+//*   ( vol/dt*I + dRes/du ) du = -Res(u),   u <- u + alpha*du
+//*
+//* Res is the residual of compute_residual (second order). With gs and
+//* umfpack, dRes/du is the Jacobian of the first-order residual
+//* (compute_jacobian), which is easier to invert and good enough for a steady
+//* solution (defect correction). With gmres, it is the Jacobian of Res itself,
+//* applied without being stored (newton_krylov_solve), and the first-order
+//* Jacobian is the preconditioner.
+//*
+//* On slip walls, the momentum rows are rotated as the residual is in
+//* compute_residual_kernel (see slip_wall_jacobian_rows).
+//*
+//* alpha = 1, except at nodes where du would change rho or p by more than 20%
+//* (change_fraction).
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:  field.res, field.w, field.wsn (compute_residual), cfl
+//*
+//* Output:  field.u, field.w = updated solution
+//*          sweeps = Gauss-Seidel sweeps used (GMRES iterations; 0 with umfpack)
+//*          returns false if the residual is not finite, the linear solver
+//*          failed, or a non-physical state (rho or p <= 0) is found
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+bool EulerSolver2D::Solver::implicit_update(EulerSolver2D::MainData2D& E2Ddata,
+                                            real cfl, int& sweeps) {
+
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+   SparseBlock::BlockMatrix& jac = E2Ddata.jac;
+
+   //  A residual or a wave speed that is not finite comes from a state that is
+   //  not physical (e.g., near vacuum): report it here, not as a singular
+   //  Jacobian later.
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+      const real* res = f.res_at(i);
+      if ( std::isfinite(res[0]) && std::isfinite(res[1]) && std::isfinite(res[2]) &&
+           std::isfinite(res[3]) && std::isfinite(f.wsn[i]) ) continue;
+      const real* w = f.w_at(i);
+      cout << " Non-finite residual at node " << i
+           << " (x,y) = (" << E2Ddata.node[i].x << "," << E2Ddata.node[i].y << ")"
+           << " rho = " << w[0] << " p = " << w[3] << " \n";
+      cout << " ... Stop. \n";
+      return false;
+   }
+
+   auto t0 = std::chrono::steady_clock::now();
+   compute_jacobian(E2Ddata, cfl);
+   slip_wall_jacobian_rows(E2Ddata, cfl);
+   E2Ddata.work.jacobian_time += seconds_since(t0);
+
+   std::vector<double> b(size_t(E2Ddata.nnodes)*nq), du;
+   for (size_t k = 0; k < b.size(); k++) b[k] = -f.res[k];
+
+   //  Solve for du
+
+   sweeps = 0;
+   if (E2Ddata.linear_solver_id == LinearSolver::gmres) {
+
+      sweeps = newton_krylov_solve(E2Ddata, cfl, b, du);
+      if (sweeps < 0) return false;
+
+   } else {
+
+      t0 = std::chrono::steady_clock::now();
+      slip_wall_rhs_rows(E2Ddata, b);
+      if (E2Ddata.linear_solver_id == LinearSolver::umfpack) {
+         if ( !jac.solve_direct(b, du) ) return false;
+      } else {
+         bool ok;
+         du.assign(b.size(), 0.0);
+         sweeps = jac.solve_gs(b, du, E2Ddata.linear_sweeps, E2Ddata.linear_tolerance, ok);
+         if (!ok) {
+            cout << " Singular diagonal block in the Jacobian ... Stop. \n";
+            return false;
+         }
+      }
+      E2Ddata.work.linear_time += seconds_since(t0);
+
+   }
+
+   //  Update the solution, scaled down where rho or p would change too much
+   //  (the linearization is poor there, e.g., at a strong shock in the first
+   //  iterations).
+
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+
+      real* u = f.u_at(i);
+      real* w = f.w_at(i);
+      const double* dui = &du[nq*i];
+
+      const real alpha = change_fraction(w, dui, E2Ddata);
+      for (int k = 0; k < nq; k++) u[k] = u[k] + alpha*dui[k];
+
+      u2w(u, w, E2Ddata);
+
+      //  Check for non-physical states (NaN included)
+      if ( !(w[0] > zero && w[3] > zero) ) {
+         cout << " Negative density or pressure at node " << i
+              << " (x,y) = (" << E2Ddata.node[i].x << "," << E2Ddata.node[i].y << ")"
+              << " rho = " << w[0] << " p = " << w[3] << " \n";
+         cout << " ... Stop. \n";
+         return false;
+      }
+
+   }
+
+   return true;
+
+} // end implicit_update
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Slip walls in the implicit system: the residual has no normal momentum
+//* component there (compute_residual_kernel), so the momentum rows of a wall
+//* node are rotated to the normal (n) and tangential (t) directions:
+//*
+//*   normal row     : wsn/cfl * (n . du_m) = n . b_m   (du_m = momentum part)
+//*   tangential row : t . (momentum rows),  t = (-ny, nx)
+//*
+//* i.e., the normal momentum changes only by the pseudo-time term (and not at
+//* all when n . b_m = 0, as for b = -Res). At the corner node of the shock
+//* diffraction the y-momentum row is wsn/cfl * du_y = b_y instead.
+//*
+//* slip_wall_jacobian_rows : the rows of E2Ddata.jac
+//* slip_wall_rhs_rows      : the same combination of the entries of b
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::slip_wall_jacobian_rows(EulerSolver2D::MainData2D& E2Ddata, real cfl) {
+
+   SparseBlock::BlockMatrix& jac = E2Ddata.jac;
+
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      if ( bound.bc != BCType::slip_wall ) continue;
+
+      for (int j = 0; j < bound.nbnodes; j++) {
+
+         const int  inode = (*bound.bnode)(j);
+         const real s     = E2Ddata.field.wsn[inode]/cfl;
+
+         if (j == bound.corner) {
+            for (int c = 0; c < 4; c++) jac.diag(inode)[8+c] = (c == 2) ? s : zero;
+            for (int k = jac.row_begin(inode); k < jac.row_end(inode); k++) {
+               for (int c = 0; c < 4; c++) jac.off(k)[8+c] = zero;
+            }
+            continue;
+         }
+
+         const real nx = (*bound.bnx)(j);
+         const real ny = (*bound.bny)(j);
+         for (int k = jac.row_begin(inode)-1; k < jac.row_end(inode); k++) {
+            const bool diagonal = (k < jac.row_begin(inode));
+            double* blk = diagonal ? jac.diag(inode) : jac.off(k);
+            for (int c = 0; c < 4; c++) {
+               const double t1 = blk[4+c], t2 = blk[8+c];
+               blk[4+c] = diagonal ? (c == 1 ? s*nx : (c == 2 ? s*ny : zero)) : zero;
+               blk[8+c] = -ny*t1 + nx*t2;
+            }
+         }
+      }
+   }
+
+} // end slip_wall_jacobian_rows
+
+
+
+void EulerSolver2D::Solver::slip_wall_rhs_rows(EulerSolver2D::MainData2D& E2Ddata,
+                                               std::vector<double>& b) {
+
+   const int nq = E2Ddata.nq;
+
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      if ( bound.bc != BCType::slip_wall ) continue;
+
+      for (int j = 0; j < bound.nbnodes; j++) {
+
+         if (j == bound.corner) continue;
+
+         double* bi = &b[nq*(*bound.bnode)(j)];
+         const real nx = (*bound.bnx)(j);
+         const real ny = (*bound.bny)(j);
+         const double t1 = bi[1], t2 = bi[2];
+         bi[1] =  nx*t1 + ny*t2;
+         bi[2] = -ny*t1 + nx*t2;
+      }
+   }
+
+} // end slip_wall_rhs_rows
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Jacobian-free Newton-Krylov (linear_solver = "gmres"): the linear system of
+//* implicit_update,
+//*
+//*   ( wsn/cfl*I + dRes/du ) du = b,
+//*
+//* with the Jacobian of the full (second-order) residual, never formed: its
+//* products with a vector v are differences of residuals (Frechet derivative),
+//*
+//*   dRes/du*v ~ ( Res(u + eps*v) - Res(u) )/eps,  eps = sqrt((1+|u|)*macheps)/|v|,
+//*
+//* one compute_residual each. The system is solved by restarted GMRES
+//* (Krylov::GMRES), right-preconditioned with the first-order Jacobian in
+//* E2Ddata.jac (slip-wall rows rotated): preconditioner_sweeps symmetric
+//* Gauss-Seidel sweeps ("jacobian"), or its diagonal blocks ("block_jacobi").
+//*
+//* The residual keeps zero normal momentum on slip walls, so the products do
+//* too except for the pseudo-time term, and the normal momentum of du comes
+//* out (nearly) zero; it is set to zero exactly at the end.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:  field.u, field.w, field.res, field.wsn at u, E2Ddata.jac, b, cfl
+//*
+//* Output:  du
+//*          returns the number of GMRES iterations (Jacobian-vector products),
+//*          or -1 if the preconditioner has a singular diagonal block
+//*          field.w, field.res, field.wsn are those at u again
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+int EulerSolver2D::Solver::newton_krylov_solve(EulerSolver2D::MainData2D& E2Ddata, real cfl,
+                                               const std::vector<double>& b, std::vector<double>& du) {
+
+   const int    nq = E2Ddata.nq;
+   const size_t n  = b.size();
+   NodeFields& f = E2Ddata.field;
+   SparseBlock::BlockMatrix& jac = E2Ddata.jac;
+   MainData2D::work_counters& work = E2Ddata.work;
+
+   //  The state at u, restored at the end.
+   const std::vector<real> w0 = f.w, res0 = f.res, wsn0 = f.wsn;
+
+   double unorm = 0.0;
+   for (size_t k = 0; k < n; k++) unorm += f.u[k]*f.u[k];
+   const double eps_u = std::sqrt( (one + std::sqrt(unorm))*std::numeric_limits<double>::epsilon() );
+
+   //  y = ( wsn/cfl*I + dRes/du ) v
+
+   Krylov::linear_map A = [&](const double* v, double* y) {
+
+      double vnorm = 0.0;
+      for (size_t k = 0; k < n; k++) vnorm += v[k]*v[k];
+      vnorm = std::sqrt(vnorm);
+      if (vnorm == 0.0) { std::fill(y, y + n, 0.0); return; }
+      const double eps = eps_u/vnorm;
+
+      real up[4];
+      for (int i = 0; i < E2Ddata.nnodes; i++) {
+         const real* u = f.u_at(i);
+         for (int k = 0; k < nq; k++) up[k] = u[k] + eps*v[nq*i+k];
+         u2w(up, f.w_at(i), E2Ddata);
+      }
+      compute_residual(E2Ddata);
+      work.matvecs++;
+
+      for (int i = 0; i < E2Ddata.nnodes; i++) {
+         const real dtau = wsn0[i]/cfl;
+         for (int k = 0; k < nq; k++) {
+            const size_t ik = size_t(nq)*i + k;
+            y[ik] = (f.res[ik] - res0[ik])/eps + dtau*v[ik];
+         }
+      }
+   };
+
+   //  z = P^{-1} x, P = the first-order Jacobian
+
+   bool ok = true;
+   double precond_time = 0.0;
+   std::vector<double> r(n);
+
+   Krylov::linear_map M = [&](const double* x, double* z) {
+
+      const auto t0 = std::chrono::steady_clock::now();
+      std::copy(x, x + n, r.begin());
+      slip_wall_rhs_rows(E2Ddata, r);
+      if (E2Ddata.preconditioner_id == Preconditioner::jacobian) {
+         bool ok_gs;
+         std::fill(z, z + n, 0.0);
+         jac.solve_gs(r.data(), z, E2Ddata.preconditioner_sweeps, 0.0, ok_gs);
+         ok = ok && ok_gs;
+      } else {
+         ok = jac.solve_block_jacobi(r.data(), z) && ok;
+      }
+      precond_time += seconds_since(t0);
+   };
+
+   Krylov::GMRES& gmres = E2Ddata.gmres;
+   gmres.restart        = E2Ddata.gmres_restart;
+   gmres.max_iterations = E2Ddata.gmres_iterations;
+   gmres.tolerance      = E2Ddata.linear_tolerance;
+
+   const double residual_time0 = work.residual_time;
+   const auto t0 = std::chrono::steady_clock::now();
+   du.assign(n, 0.0);
+   const int its = gmres.solve(A, M, b, du);
+   work.linear_time += precond_time;
+   work.krylov_time += seconds_since(t0) - precond_time - (work.residual_time - residual_time0);
+
+   f.w   = w0;
+   f.res = res0;
+   f.wsn = wsn0;
+
+   if (!ok) {
+      cout << " Singular diagonal block in the preconditioner ... Stop. \n";
+      return -1;
+   }
+
+   slip_wall_zero_normal(E2Ddata, du);
+
+   return its;
+
+} // end newton_krylov_solve
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Remove the normal momentum component of a change du at the slip-wall nodes
+//* (at the corner node of the shock diffraction: the y-momentum), so that the
+//* tangency set by eliminate_normal_mass_flux is kept.
+//********************************************************************************
+void EulerSolver2D::Solver::slip_wall_zero_normal(EulerSolver2D::MainData2D& E2Ddata,
+                                                  std::vector<double>& du) {
+
+   const int nq = E2Ddata.nq;
+
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+
+      bgrid_type& bound = E2Ddata.bound[ib];
+      if ( bound.bc != BCType::slip_wall ) continue;
+
+      for (int j = 0; j < bound.nbnodes; j++) {
+         double* dui = &du[nq*(*bound.bnode)(j)];
+         if (j == bound.corner) { dui[2] = zero; continue; }
+         const real nx = (*bound.bnx)(j);
+         const real ny = (*bound.bny)(j);
+         const double dun = dui[1]*nx + dui[2]*ny;
+         dui[1] -= dun*nx;
+         dui[2] -= dun*ny;
+      }
+   }
+
+} // end slip_wall_zero_normal
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Agglomeration multigrid (multigrid_levels > 1, time_stepping = "local"):
+//* the full approximation scheme (FAS) on coarse levels made by agglomerating
+//* the median-dual volumes of the nodes (Multigrid::coarsen).
+//*
+//* After each Runge-Kutta step on the grid (level 0), multigrid_correction
+//* runs one V or W cycle on levels 1, 2, ...; on level l:
+//*
+//*   u_l   = sum(vol*u_{l-1})/vol_l                (restriction, also kept as ur_l)
+//*   P_l   = sum(Res_{l-1} + P_{l-1}) - Res_l(u_l) (forcing term; P_0 = 0)
+//*   smooth: Runge-Kutta steps on Res_l(u_l) + P_l = 0, local time steps
+//*   cycle on level l+1 (twice for W), then u_l += u_{l+1} - ur_{l+1}
+//*   (injection: every cell of an agglomerate gets its correction, scaled
+//*   down where it would change rho or p by more than 20%), smooth
+//*
+//* and the correction of level 1 goes to the nodes of the grid. So the coarse
+//* levels drive the grid residual to zero, and the converged solution is that
+//* of the grid. Res_l (l >= 1) is first order: the flux of the scheme at the
+//* cell states through the summed faces (coarse_residual).
+//*
+//* setup_multigrid builds the levels: mg[0] holds the volumes of the grid
+//* (and its faces, until level 1 is built), mg[1...] the coarse levels.
+//********************************************************************************
+void EulerSolver2D::Solver::setup_multigrid(EulerSolver2D::MainData2D& E2Ddata) {
+
+   std::vector<Multigrid::Level>& mg = E2Ddata.mg;
+   mg.clear();
+   mg.resize(1);
+
+   //  Level 0: the dual volumes of the nodes, their faces (edges), and the
+   //  half boundary faces of the boundary nodes.
+
+   Multigrid::Level& grid = mg[0];
+   grid.ncells = E2Ddata.nnodes;
+   grid.vol.resize(E2Ddata.nnodes);
+   for (int i = 0; i < E2Ddata.nnodes; i++) grid.vol[i] = E2Ddata.node[i].vol;
+
+   for (int i = 0; i < E2Ddata.nedges; i++) {
+      const edge_type& e = E2Ddata.edge[i];
+      grid.e1.push_back(e.n1);
+      grid.e2.push_back(e.n2);
+      grid.eax.push_back(e.dav(0)*e.da);
+      grid.eay.push_back(e.dav(1)*e.da);
+   }
+   for (int ib = 0; ib < E2Ddata.nbound; ib++) {
+      bgrid_type& bound = E2Ddata.bound[ib];
+      for (int j = 0; j < bound.nbfaces; j++) {
+         const real mag = half*(*bound.bfn)(j);
+         for (int ii = 0; ii < 2; ii++) {
+            grid.bcell.push_back((*bound.bnode)(j+ii));
+            grid.bseg.push_back(ib);
+            grid.bax.push_back((*bound.bfnx)(j)*mag);
+            grid.bay.push_back((*bound.bfny)(j)*mag);
+         }
+      }
+   }
+
+   //  Coarse levels, until multigrid_levels or no more coarsening
+
+   cout << " Multigrid levels (cells): " << grid.ncells;
+   while ( int(mg.size()) < E2Ddata.multigrid_levels ) {
+      Multigrid::Level coarse;
+      Multigrid::coarsen(mg.back(), coarse);
+      if (coarse.ncells < 2 || coarse.ncells == mg.back().ncells) break;
+      coarse.allocate(E2Ddata.nq);
+      cout << " " << coarse.ncells;
+      mg.push_back(std::move(coarse));
+   }
+   cout << " (" << (E2Ddata.multigrid_cycle_id == MGCycle::w ? "W" : "V") << " cycle) \n";
+
+   //  The faces of the grid are those of the edges (compute_residual).
+   std::vector<int>().swap(grid.e1);      std::vector<int>().swap(grid.e2);
+   std::vector<double>().swap(grid.eax);  std::vector<double>().swap(grid.eay);
+   std::vector<int>().swap(grid.bcell);   std::vector<int>().swap(grid.bseg);
+   std::vector<double>().swap(grid.bax);  std::vector<double>().swap(grid.bay);
+
+} // end setup_multigrid
+
+
+
+//********************************************************************************
+//* Multigrid on the solution just updated on the grid: restrict to level 1,
+//* cycle, and add the correction to the nodes (zero normal momentum change
+//* on slip walls).
+//*
+//* Output: field.u, field.w; false if a non-physical state is found
+//********************************************************************************
+bool EulerSolver2D::Solver::multigrid_correction(EulerSolver2D::MainData2D& E2Ddata) {
+
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+   std::vector<Multigrid::Level>& mg = E2Ddata.mg;
+   if (mg.size() < 2) return true;
+
+   compute_residual(E2Ddata);
+   restrict_to(E2Ddata, 1, f.u.data(), f.res.data(), nullptr);
+
+   if ( !multigrid_cycle(E2Ddata, 1) ) return false;
+
+   //  Correction from level 1
+
+   const Multigrid::Level& C = mg[1];
+   std::vector<double> du(size_t(nq)*E2Ddata.nnodes);
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+      const int p = C.parent[i];
+      for (int k = 0; k < nq; k++) du[nq*i+k] = C.u[nq*p+k] - C.ur[nq*p+k];
+   }
+   slip_wall_zero_normal(E2Ddata, du);
+
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+
+      real* u = f.u_at(i);
+      real* w = f.w_at(i);
+      const real alpha = change_fraction(w, &du[nq*i], E2Ddata);
+      for (int k = 0; k < nq; k++) u[k] = u[k] + alpha*du[nq*i+k];
+
+      u2w(u, w, E2Ddata);
+
+      //  Check for non-physical states (NaN included)
+      if ( !(w[0] > zero && w[3] > zero) ) {
+         cout << " Negative density or pressure after the multigrid correction at node " << i
+              << " (x,y) = (" << E2Ddata.node[i].x << "," << E2Ddata.node[i].y << ")"
+              << " rho = " << w[0] << " p = " << w[3] << " \n";
+         cout << " ... Stop. \n";
+         return false;
+      }
+
+   }
+
+   return true;
+
+} // end multigrid_correction
+
+
+
+//********************************************************************************
+//* One cycle on level l >= 1 (the restricted solution and the forcing term are
+//* set): smooth, cycle on level l+1 (twice for W) and correct, smooth.
+//********************************************************************************
+bool EulerSolver2D::Solver::multigrid_cycle(EulerSolver2D::MainData2D& E2Ddata, int l) {
+
+   const int nq = E2Ddata.nq;
+   std::vector<Multigrid::Level>& mg = E2Ddata.mg;
+   Multigrid::Level& L = mg[l];
+
+   if ( !coarse_smooth(E2Ddata, l) ) return false;
+   if ( l+1 >= int(mg.size()) ) return true;
+
+   coarse_residual(E2Ddata, L);
+   restrict_to(E2Ddata, l+1, L.u.data(), L.res.data(), L.forcing.data());
+
+   const int ncycles = (E2Ddata.multigrid_cycle_id == MGCycle::w) ? 2 : 1;
+   for (int c = 0; c < ncycles; c++) {
+      if ( !multigrid_cycle(E2Ddata, l+1) ) return false;
+   }
+
+   const Multigrid::Level& C = mg[l+1];
+   double du[4];
+   for (int i = 0; i < L.ncells; i++) {
+      const int p = C.parent[i];
+      for (int k = 0; k < nq; k++) du[k] = C.u[nq*p+k] - C.ur[nq*p+k];
+      const real alpha = change_fraction(&L.w[nq*i], du, E2Ddata);
+      for (int k = 0; k < nq; k++) L.u[nq*i+k] += alpha*du[k];
+      u2w(&L.u[nq*i], &L.w[nq*i], E2Ddata);
+   }
+
+   return coarse_smooth(E2Ddata, l);
+
+} // end multigrid_cycle
+
+
+
+//********************************************************************************
+//* Restriction from level l-1 to level l: u (nq per cell of level l-1), its
+//* residual res and forcing term (nullptr: none, the grid):
+//*
+//*   u_l = ur_l = sum(vol*u)/vol_l,   forcing_l = sum(res + forcing) - Res_l(u_l)
+//********************************************************************************
+void EulerSolver2D::Solver::restrict_to(EulerSolver2D::MainData2D& E2Ddata, int l, const real* u,
+                                        const real* res, const real* forcing) {
+
+   const int nq = E2Ddata.nq;
+   const Multigrid::Level& F = E2Ddata.mg[l-1];
+   Multigrid::Level& C = E2Ddata.mg[l];
+
+   std::fill(C.u.begin(), C.u.end(), zero);
+   std::fill(C.forcing.begin(), C.forcing.end(), zero);
+   for (int i = 0; i < F.ncells; i++) {
+      const int p = C.parent[i];
+      for (int k = 0; k < nq; k++) {
+         C.u[nq*p+k]       += F.vol[i]*u[nq*i+k];
+         C.forcing[nq*p+k] += res[nq*i+k] + (forcing ? forcing[nq*i+k] : zero);
+      }
+   }
+   for (int c = 0; c < C.ncells; c++) {
+      for (int k = 0; k < nq; k++) C.u[nq*c+k] /= C.vol[c];
+      u2w(&C.u[nq*c], &C.w[nq*c], E2Ddata);
+   }
+   C.ur = C.u;
+
+   coarse_residual(E2Ddata, C);
+   for (size_t k = 0; k < C.forcing.size(); k++) C.forcing[k] -= C.res[k];
+
+} // end restrict_to
+
+
+
+//********************************************************************************
+//* First-order residual of a coarse level: the numerical flux of the scheme
+//* (inviscid_flux) at the two cell states through each face, and the boundary
+//* fluxes (boundary_flux) at the cell state.
+//*
+//* Output: L.res, L.wsn
+//********************************************************************************
+void EulerSolver2D::Solver::coarse_residual(EulerSolver2D::MainData2D& E2Ddata, Multigrid::Level& L) {
+
+   const int nq = E2Ddata.nq;
+   const bool roe_flux = (E2Ddata.flux_id == FluxType::roe);
+   real num_flux[4], wsn;
+
+   std::fill(L.res.begin(), L.res.end(), zero);
+   std::fill(L.wsn.begin(), L.wsn.end(), zero);
+
+   for (size_t k = 0; k < L.e1.size(); k++) {
+
+      const int  c1  = L.e1[k];
+      const int  c2  = L.e2[k];
+      const real mag = std::sqrt(L.eax[k]*L.eax[k] + L.eay[k]*L.eay[k]);
+      const real nx  = L.eax[k]/mag;
+      const real ny  = L.eay[k]/mag;
+
+      if (roe_flux) roe(         &L.w[nq*c1], &L.w[nq*c2], nx, ny, num_flux, wsn, E2Ddata);
+      else          rotated_rhll(&L.w[nq*c1], &L.w[nq*c2], nx, ny, num_flux, wsn, E2Ddata);
+
+      for (int m = 0; m < 4; m++) {
+         L.res[nq*c1+m] += num_flux[m]*mag;
+         L.res[nq*c2+m] -= num_flux[m]*mag;
+      }
+      L.wsn[c1] += wsn*mag;
+      L.wsn[c2] += wsn*mag;
+   }
+
+   for (size_t k = 0; k < L.bcell.size(); k++) {
+
+      const int  c   = L.bcell[k];
+      const real mag = std::sqrt(L.bax[k]*L.bax[k] + L.bay[k]*L.bay[k]);
+      const real nx  = L.bax[k]/mag;
+      const real ny  = L.bay[k]/mag;
+      const BCType bc = E2Ddata.bound[L.bseg[k]].bc;
+
+      if (roe_flux) boundary_flux<FluxType::roe >(E2Ddata, bc, &L.w[nq*c], nx, ny, num_flux, wsn);
+      else          boundary_flux<FluxType::rhll>(E2Ddata, bc, &L.w[nq*c], nx, ny, num_flux, wsn);
+
+      for (int m = 0; m < 4; m++) L.res[nq*c+m] += num_flux[m]*mag;
+      L.wsn[c] += wsn*mag;
+   }
+
+} // end coarse_residual
+
+
+
+//********************************************************************************
+//* Smoothing on level l: one two-stage Runge-Kutta step (as on the grid) on
+//* Res_l(u) + forcing = 0, with the local time steps dt = CFL*vol/wsn.
+//*
+//* Output: L.u, L.w; false if a non-physical state is found
+//********************************************************************************
+bool EulerSolver2D::Solver::coarse_smooth(EulerSolver2D::MainData2D& E2Ddata, int l) {
+
+   const int nq = E2Ddata.nq;
+   Multigrid::Level& L = E2Ddata.mg[l];
+
+   L.u0 = L.u;
+
+   for (int stage = 0; stage < 2; stage++) {
+
+      coarse_residual(E2Ddata, L);
+
+      for (int c = 0; c < L.ncells; c++) {
+
+         real* u  = &L.u[nq*c];
+         real* w  = &L.w[nq*c];
+         const real* u0 = &L.u0[nq*c];
+         const real dtv = E2Ddata.CFL/L.wsn[c];   // dt/vol
+
+         for (int k = 0; k < nq; k++) {
+            const real r = L.res[nq*c+k] + L.forcing[nq*c+k];
+            if (stage == 0) u[k] = u0[k] - dtv*r;
+            else            u[k] = half*(u0[k] + u[k]) - half*dtv*r;
+         }
 
-EulerSolver2D::Solver::Solver(){}
+         u2w(u, w, E2Ddata);
+
+         if ( !(w[0] > zero && w[3] > zero) ) {
+            cout << " Negative density or pressure on multigrid level " << l << " in cell " << c
+                 << " rho = " << w[0] << " p = " << w[3] << " \n";
+            cout << " ... Stop. \n";
+            return false;
+         }
+      }
+   }
 
+   return true;
+
+} // end coarse_smooth
+//--------------------------------------------------------------------------------
 
-EulerSolver2D::Solver::~Solver(){
-   printf("destruct Solver");
-}
 
 
 //********************************************************************************
-//********************************************************************************
-//********************************************************************************
-//* Euler solver: Node-Centered Finite-Volume Method (Edge-Based)
+//* This subroutine computes the residual norms: L1, L2, L_infty
 //*
-//* - Node-centered finite-volume method for unstructured grids(quad/tri/mixed)
-//* - Roe flux with an entropy fix and Rotated-RHLL flux
-//* - Reconstruction by unweighted least-squares method (2x2 system for gradients)
-//* - Van Albada slope limiter to the primitive variable gradients
-//* - 2-Stage Runge-Kutta time-stepping
+//* ------------------------------------------------------------------------------
+//*  Input:  field.res = the residuals
+//*
+//* Output:  res_norm = residual norms (L1, L2, Linf) for each variable
+//* ------------------------------------------------------------------------------
+//*
+//* NOTE: The convergence of the steady mode is monitored by the norms relative
+//*       to their largest values so far (see euler_solver_main).
 //*
 //********************************************************************************
-void EulerSolver2D::Solver::euler_solver_main(EulerSolver2D::MainData2D& E2Ddata ){
+void EulerSolver2D::Solver::residual_norm(EulerSolver2D::MainData2D& E2Ddata,
+                                          real res_norm[][3]) {
 
-   // //Local variables
-   Array2D<real> res_norm(4,3); //Residual norms(L1,L2,Linf)
-   Array2D<real>*  u0;       //Saved solution
-   real dt, time;    //Time step and actual time
-   int i_time_step; //Number of time steps
-   int i;
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
 
-   // // Allocate the temporary solution array needed for the Runge-Kutta method.
-   // allocate(u0(nnodes,4));
+   for (int k = 0; k < nq; k++) {
+      res_norm[k][0] = zero; //L1
+      res_norm[k][1] = zero; //L2
+      res_norm[k][2] = -one; //Linf
+   }
 
-   // These parameters are set in main. Here just print them on display.
-   cout << " \n";
-   cout << "Calling the Euler solver...";
-   cout << " \n";
-   cout << "                  M_inf = " <<  E2Ddata.M_inf << " \n";
-   cout << "                    CFL = " <<  E2Ddata.CFL << " \n";
-   cout << "             final time = " <<  E2Ddata.t_final << " \n";
-   cout << "          time_step_max = " <<  E2Ddata.time_step_max << " \n";
-   cout << "          inviscid_flux = " <<  trim(E2Ddata.inviscid_flux) << " \n";
-   cout << "           limiter_type = " <<  trim(E2Ddata.limiter_type) << " \n";
-   cout << " \n";
+   const int nowned = E2Ddata.nodes_owned();
+   for (int i = 0; i < nowned; i++) {
+      const real* res = f.res_at(i);
+      for (int k = 0; k < nq; k++) {
+         real residual = std::abs(res[k]);
+         res_norm[k][0] = res_norm[k][0] + residual;
+         res_norm[k][1] = res_norm[k][1] + residual*residual;
+         res_norm[k][2] = std::max(res_norm[k][2], residual);
+      }
+   }
 
-   //--------------------------------------------------------------------------------
-   // First, make sure that normal mass flux is zero at all solid boundary nodes.
-   // NOTE: Necessary because initial solution may generate the normal component.
-   //--------------------------------------------------------------------------------
+   //  Decomposed grid: the sums and the maxima of all ranks, over all the nodes.
+   real nodes = real(nowned);
+   if (E2Ddata.halo.active()) {
+      std::vector<double> sums(2*nq+1), maxs(nq);
+      for (int k = 0; k < nq; k++) {
+         sums[2*k] = res_norm[k][0];  sums[2*k+1] = res_norm[k][1];  maxs[k] = res_norm[k][2];
+      }
+      sums[2*nq] = nodes;
+      Halo::sum(sums.data(), 2*nq+1);
+      Halo::max(maxs.data(), nq);
+      for (int k = 0; k < nq; k++) {
+         res_norm[k][0] = sums[2*k];  res_norm[k][1] = sums[2*k+1];  res_norm[k][2] = maxs[k];
+      }
+      nodes = sums[2*nq];
+   }
 
-    eliminate_normal_mass_flux(E2Ddata);
+   for (int k = 0; k < nq; k++) {
+      res_norm[k][0] = res_norm[k][0]/nodes;
+      res_norm[k][1] = std::sqrt(res_norm[k][1]/nodes);
+   }
+
+} // end residual_norm
+//--------------------------------------------------------------------------------
 
-   //--------------------------------------------------------------------------------
-   // Time-stepping toward the final time
-   //--------------------------------------------------------------------------------
 
 
-}
 //********************************************************************************
-// End of program
+//* -- vanAlbada Slope Limiter Function--
+//*
+//* 'A comparative study of computational methods in cosmic gas dynamics',
+//* Van Albada, G D, B. Van Leer and W. W. Roberts, Astronomy and Astrophysics,
+//* 108, p76, 1982
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:   da, db     : two differences
+//*           h          : edge length, used to scale the small parameter
+//*
+//* Output:   va_slope_limiter : limited difference
+//* ------------------------------------------------------------------------------
+//*
 //********************************************************************************
+real EulerSolver2D::Solver::va_slope_limiter(real da, real db, real h) {
+
+   real eps2 = (0.3*h)*(0.3*h)*(0.3*h);
+   real sgn  = (da*db >= zero) ? one : -one;
 
+   return half*( sgn + one ) *
+          ( (db*db + eps2)*da + (da*da + eps2)*db ) / (da*da + db*db + two*eps2);
+
+} // end va_slope_limiter
+//--------------------------------------------------------------------------------
 
 
 
 //********************************************************************************
-//* Prepararion for Tangency condition (slip wall):
+//* The gradients at a slip-wall node seen by the limiter.
 //*
-//* Eliminate normal mass flux component at all solid-boundary nodes at the
-//* beginning. The normal component will never be changed in the solver: the
-//* residuals will be constrained to have zero normal component.
+//* The neighbors of a wall node are all on one side of the wall, so the
+//* derivative normal to the wall is a one-sided difference, and the limiter
+//* of edge_flux (dwm = 2*grad*edge - dwp) would compare the difference along
+//* an edge into the domain with itself. The solution is extended across the
+//* wall by its mirror image, in which the density, the pressure and the
+//* tangential velocity are even, and the normal velocity is odd. The central
+//* normal derivative of the even ones is then zero; the normal velocity keeps
+//* its gradient.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:   g  : gradients of (rho,u,v,p), g[ivar*2+ix]
+//*           n  : outward unit normal of the wall
+//*
+//* Output:   gm : g without the normal derivatives of rho, p and the
+//*                tangential velocity
+//* ------------------------------------------------------------------------------
 //*
 //********************************************************************************
-void EulerSolver2D::Solver::eliminate_normal_mass_flux( EulerSolver2D::MainData2D& E2Ddata ) {
+void EulerSolver2D::Solver::wall_mirror_gradient(const real* g, const real* n, real* gm) {
 
-   int i, j, inode;
-   real normal_mass_flux;
-   Array2D<real> n12(2,1);
+   const real nx = n[0], ny = n[1];
+   const real tx = -ny,  ty = nx;
 
-   //  bc_loop : loop nbound
-   for (size_t i = 0; i < E2Ddata.nbound; i++) {
+   //  Density and pressure
+   for (int k = 0; k < 4; k += 3) {
+      const real gn = g[2*k]*nx + g[2*k+1]*ny;
+      gm[2*k  ] = g[2*k  ] - gn*nx;
+      gm[2*k+1] = g[2*k+1] - gn*ny;
+   }
 
-      // only_slip_wall : if (trim(bound(i)%bc_type) == "slip_wall") then
-      if ( trim(E2Ddata.bound[i].bc_type) == "slip_wall" ) {
+   //  Velocity: the normal derivative of the tangential velocity, tx*u + ty*v.
+   const real gtn = tx*( g[2]*nx + g[3]*ny ) + ty*( g[4]*nx + g[5]*ny );
+   gm[2] = g[2] - tx*gtn*nx;
+   gm[3] = g[3] - tx*gtn*ny;
+   gm[4] = g[4] - ty*gtn*nx;
+   gm[5] = g[5] - ty*gtn*ny;
 
-         cout << " Eliminating the normal momentum on slip wall boundary " << i << " \n";
+} // end wall_mirror_gradient
+//--------------------------------------------------------------------------------
 
-         // bnodes_slip_wall : loop bound(i)%nbnodes
-         for (size_t j = 0; j < E2Ddata.bound[i].nbnodes; j++ ) {
 
-            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            // THIS IS A SPECIAL TREATMENT FOR SHOCK DIFFRACTION PROBLEM.
-            //
-            // NOTE: This is a corner point between the inflow boundary and
-            //       the lower-left wall. Enforce zero y-momentum, which is
-            //       not ensured by the standard BCs.
-            //       This special treatment is necessary because the domain
-            //       is rectangular (the left boundary is a straight ine) and
-            //       the midpoint node on the left boundary is actually a corner.
-            //
-            //       Our computational domain:
-            //
-            //                 ---------------
-            //          Inflow |             |
-            //                 |             |  o: Corner node
-            //          .......o             |
-            //            Wall |             |  This node is a corner.
-            //                 |             |
-            //                 ---------------
-            //
-            //       This is to simulate the actual domain shown below:
-            //      
-            //         -----------------------
-            // Inflow  |                     |
-            //         |                     |  o: Corner node
-            //         --------o             |
-            //            Wall |             |
-            //                 |             |
-            //                 ---------------
-            //      In effect, we're simulating this flow by a simplified
-            //      rectangular domain (easier to generate the grid).
-            //      So, an appropriate slip BC at the corner node needs to be applied,
-            //      which is "zero y-momentum", and that's all.
-            //
-            if (i==1 and j==0) {
-               inode                       = (*E2Ddata.bound[i].bnode)(j);
-               (*E2Ddata.node[inode].u)(1) = zero;                                  // Make sure zero y-momentum.
-               (*E2Ddata.node[inode].w)    = u2w( (*E2Ddata.node[inode].u) , E2Ddata );// Update primitive variables
-               
-               continue; // cycle bnodes_slip_wall // That's all we neeed. Go to the next.
 
-            }
+//********************************************************************************
+//* -- Roe's Flux Function with entropy fix---
+//*
+//* P. L. Roe, Approximate Riemann Solvers, Parameter Vectors and Difference
+//* Schemes, Journal of Computational Physics, 43, pp. 357-372.
+//*
+//* With MainData2D::roe_einfeldt (inviscid_flux = roe_einfeldt), the wave
+//* speeds of the nonlinear fields are bounded by Einfeldt's.
+//*
+//* NOTE: 3D version of this subroutine is available for download at
+//*       http://cfdbooks.com/cfdcodes.html
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:   wL(0:3) =  left state (rhoL, uL, vL, pL)
+//*           wR(0:3) = right state (rhoR, uR, vR, pR)
+//*           nx, ny  = Normal vector (unit vector)
+//*
+//* Output:   num_flux(0:3) = numerical flux
+//*           wsn           = max wave speed (for time step)
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::roe(const real* wL, const real* wR, real nx, real ny,
+                                real* num_flux, real& wsn,
+                                EulerSolver2D::MainData2D& E2Ddata) {
+
+   const real gamma = E2Ddata.gamma;
+
+   real mx, my;                                   //Tangent vector
+   real rhoL, uL, vL, unL, utL, pL, aL, HL;       //Primitive variables (L)
+   real rhoR, uR, vR, unR, utR, pR, aR, HR;       //Primitive variables (R)
+   real RT, rho, u, v, H, a, un, ut;              //Roe-averages
+   real drho, dun, dut, dp, dV[4];                //Wave strengths
+   real ws[4], dws[4], Rv[4][4];                  //Wave speeds, right eigenvectors
+   real fL[4], fR[4], diss[4];                    //Fluxes and dissipation
+
+   //Tangent vector (Do you like it? Actually, Roe flux can be implemented
+   // without any tangent vector. See "I do like CFD, VOL.1" for details.)
+   mx = -ny;
+   my =  nx;
+
+   //Primitive and other variables.
+   //  Left state
+   rhoL = wL[0];
+     uL = wL[1];
+     vL = wL[2];
+    unL = uL*nx+vL*ny;
+    utL = uL*mx+vL*my;
+     pL = wL[3];
+     aL = std::sqrt(gamma*pL/rhoL);
+     HL = aL*aL/(gamma-one) + half*(uL*uL+vL*vL);
+   //  Right state
+   rhoR = wR[0];
+     uR = wR[1];
+     vR = wR[2];
+    unR = uR*nx+vR*ny;
+    utR = uR*mx+vR*my;
+     pR = wR[3];
+     aR = std::sqrt(gamma*pR/rhoR);
+     HR = aR*aR/(gamma-one) + half*(uR*uR+vR*vR);
+
+   //First compute the Roe Averages
+     RT = std::sqrt(rhoR/rhoL);
+    rho = RT*rhoL;
+      u = (uL+RT*uR)/(one+RT);
+      v = (vL+RT*vR)/(one+RT);
+      H = (HL+RT* HR)/(one+RT);
+      a = std::sqrt( (gamma-one)*(H-half*(u*u+v*v)) );
+     un = u*nx+v*ny;
+     ut = u*mx+v*my;
+
+   //Wave Strengths
+   drho = rhoR - rhoL;
+     dp =   pR - pL;
+    dun =  unR - unL;
+    dut =  utR - utL;
+
+   dV[0] = (dp - rho*a*dun )/(two*a*a);
+   dV[1] = rho*dut;
+   dV[2] = drho - dp/(a*a);
+   dV[3] = (dp + rho*a*dun )/(two*a*a);
+
+   //Wave Speed
+   ws[0] = std::abs(un-a);
+   ws[1] = std::abs(un);
+   ws[2] = std::abs(un);
+   ws[3] = std::abs(un+a);
+
+   //inviscid_flux = roe_einfeldt: Einfeldt's bounds, SIAM J. Numer. Anal. 25
+   // (1988), pp294-318: the nonlinear waves at least as fast as in the left
+   // and right states. The plain Roe flux can give a negative pressure in a
+   // strong expansion (first order, below the corner of the shock
+   // diffraction); these bounds keep it positive, at the price of more
+   // dissipation in the acoustic waves.
+   if (E2Ddata.roe_einfeldt) {
+      ws[0] = std::max( ws[0], std::abs( std::min(unL-aL, un-a) ) );
+      ws[3] = std::max( ws[3], std::abs( std::max(unR+aR, un+a) ) );
+   }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+   //Harten's Entropy Fix JCP(1983), 49, pp357-393:
+   // only for the nonlinear fields.
+   dws[0] = fifth;
+   if ( ws[0] < dws[0] ) ws[0] = half * ( ws[0]*ws[0]/dws[0]+dws[0] );
+   dws[3] = fifth;
+   if ( ws[3] < dws[3] ) ws[3] = half * ( ws[3]*ws[3]/dws[3]+dws[3] );
+
+   //Right Eigenvectors
+   Rv[0][0] = one;
+   Rv[1][0] = u - a*nx;
+   Rv[2][0] = v - a*ny;
+   Rv[3][0] = H - un*a;
+
+   Rv[0][1] = zero;
+   Rv[1][1] = mx;
+   Rv[2][1] = my;
+   Rv[3][1] = ut;
+
+   Rv[0][2] = one;
+   Rv[1][2] = u;
+   Rv[2][2] = v;
+   Rv[3][2] = half*(u*u+v*v);
+
+   Rv[0][3] = one;
+   Rv[1][3] = u + a*nx;
+   Rv[2][3] = v + a*ny;
+   Rv[3][3] = H + un*a;
+
+   //Dissipation Term
+   for (int k = 0; k < 4; k++) {
+      diss[k] = zero;
+      for (int j = 0; j < 4; j++) diss[k] += ws[j]*dV[j]*Rv[k][j];
+   }
 
-            inode = (*E2Ddata.bound[i].bnode)(j);
-            n12(0) = (*E2Ddata.bound[i].bnx)(j);
-            n12(1) = (*E2Ddata.bound[i].bny)(j);
+   //Compute the flux.
+   fL[0] = rhoL*unL;
+   fL[1] = rhoL*unL * uL + pL*nx;
+   fL[2] = rhoL*unL * vL + pL*ny;
+   fL[3] = rhoL*unL * HL;
 
-            normal_mass_flux = (*E2Ddata.node[inode].u)(0)*n12(0) + (*E2Ddata.node[inode].u)(1)*n12(0); //tlm fixed
+   fR[0] = rhoR*unR;
+   fR[1] = rhoR*unR * uR + pR*nx;
+   fR[2] = rhoR*unR * vR + pR*ny;
+   fR[3] = rhoR*unR * HR;
 
-            (*E2Ddata.node[inode].u)(1) = (*E2Ddata.node[inode].u)(1) - normal_mass_flux * n12(0);
-            (*E2Ddata.node[inode].u)(2) = (*E2Ddata.node[inode].u)(2) - normal_mass_flux * n12(1);
+   for (int k = 0; k < 4; k++) num_flux[k] = half * (fL[k] + fR[k] - diss[k]);
 
-            (*E2Ddata.node[inode].w)    = u2w( (*E2Ddata.node[inode].u) , E2Ddata );
+   //Max wave speed normal to the face:
+   wsn = std::abs(un) + a;
 
-         }//end loop bnodes_slip_wall
+} // end roe
+//--------------------------------------------------------------------------------
 
-         cout << " Finished eliminating the normal momentum on slip wall boundary " << i << " \n";
 
-      }//end if only_slip_wall
 
-   }//end loop bc_loop
+//********************************************************************************
+//* -- Rotated-Roe-HLL Flux Function ---
+//*
+//* H. Nishikawa and K. Kitamura, Very Simple, Carbuncle-Free, Boundary-Layer
+//* Resolving, Rotated-Hybrid Riemann Solvers,
+//* Journal of Computational Physics, 227, pp. 2560-2581, 2008.
+//*
+//* Robust Riemann solver for nonlinear instability (carbuncle).
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:   wL(0:3) =  left state (rhoL, uL, vL, pL)
+//*           wR(0:3) = right state (rhoR, uR, vR, pR)
+//*           nx, ny  = Normal vector (unit vector)
+//*           n1      = the rotated direction n1 (optional; default: the
+//*                     direction of the velocity difference)
+//*
+//* Output:   num_flux(0:3) = numerical flux
+//*           wsn           = max wave speed (for time step)
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::rotated_rhll(const real* wL, const real* wR, real nx, real ny,
+                                         real* num_flux, real& wsn,
+                                         EulerSolver2D::MainData2D& E2Ddata, const real* n1) {
 
- } // end eliminate_normal_mass_flux
+   const real gamma = E2Ddata.gamma;
+   const real eps   = 1.0e-12;
+
+   //Steady mode: a smooth function of the states (see rhll_smoothing).
+   if ( !n1 && E2Ddata.rhll_smoothing > zero ) {
+      rotated_rhll_smooth(wL, wR, nx, ny, num_flux, wsn, E2Ddata);
+      return;
+   }
+
+   real nx1, ny1, nx2, ny2, alpha1, alpha2, abs_dq, temp; //Rotated directions
+   real rhoL, uL, vL, pL, aL, HL, unL, vnL, vtL;          //Primitive variables (L)
+   real rhoR, uR, vR, pR, aR, HR, unR, vnR, vtR;          //Primitive variables (R)
+   real RT, rho, u, v, H, a, vn, vt;                      //Roe-averages
+   real drho, dvn, dvt, dp, dV[4];                        //Wave strengths
+   real ws[4], abs_ws[4], dws[4], Rv[4][4];               //Wave speeds, right eigenvectors
+   real SRp, SLm;                                         //HLL wave speeds
+   real fL[4], fR[4], diss[4];                            //Fluxes and dissipation
+
+   //Primitive and other variables.
+   //  Left state
+   rhoL = wL[0];
+     uL = wL[1];
+     vL = wL[2];
+     pL = wL[3];
+     aL = std::sqrt(gamma*pL/rhoL);
+     HL = aL*aL/(gamma-one) + half*(uL*uL+vL*vL);
+   //  Right state
+   rhoR = wR[0];
+     uR = wR[1];
+     vR = wR[2];
+     pR = wR[3];
+     aR = std::sqrt(gamma*pR/rhoR);
+     HR = aR*aR/(gamma-one) + half*(uR*uR+vR*vR);
+
+   //Compute the physical fluxes in the face-normal direction.
+   unL = uL*nx + vL*ny;
+   unR = uR*nx + vR*ny;
+
+   fL[0] = rhoL*unL;
+   fL[1] = rhoL*unL * uL + pL*nx;
+   fL[2] = rhoL*unL * vL + pL*ny;
+   fL[3] = rhoL*unL * HL;
+
+   fR[0] = rhoR*unR;
+   fR[1] = rhoR*unR * uR + pR*nx;
+   fR[2] = rhoR*unR * vR + pR*ny;
+   fR[3] = rhoR*unR * HR;
+
+   //Define n1 and n2, and compute alpha1 and alpha2: (4.2) in the original paper.
+   // (NB: n1 jumps where the velocity difference changes direction, which
+   //      stalls a steady calculation. For time-accurate calculation, this
+   //      is fine. See rotated_rhll_smooth.)
+   abs_dq = std::sqrt( (uR-uL)*(uR-uL) + (vR-vL)*(vR-vL) );
+
+   if ( n1 ) {
+      nx1 = n1[0];
+      ny1 = n1[1];
+   } else if ( abs_dq > eps ) {
+      nx1 = (uR-uL)/abs_dq;
+      ny1 = (vR-vL)/abs_dq;
+   } else {
+      nx1 = -ny;
+      ny1 =  nx;
+   }
+   alpha1 = nx * nx1 + ny * ny1;
+   //   To make alpha1 always positive.
+   temp   = (alpha1 >= zero) ? one : -one;
+   nx1    = temp * nx1;
+   ny1    = temp * ny1;
+   alpha1 = temp * alpha1;
+
+   // Take n2 as perpendicular to n1.
+   nx2    = -ny1;
+   ny2    =  nx1;
+   alpha2 = nx * nx2 + ny * ny2;
+   //   To make alpha2 always positive.
+   temp   = (alpha2 >= zero) ? one : -one;
+   nx2    = temp * nx2;
+   ny2    = temp * ny2;
+   alpha2 = temp * alpha2;
+
+   //Now we are going to compute the Roe flux with n2 as the normal
+   //and n1 as the tagent vector, with modified wave speeds (5.12)
+
+   //Compute the Roe Averages
+     RT = std::sqrt(rhoR/rhoL);
+    rho = RT*rhoL;
+      u = (uL + RT*uR)/(one + RT);
+      v = (vL + RT*vR)/(one + RT);
+      H = (HL + RT*HR)/(one + RT);
+      a = std::sqrt( (gamma-one)*(H-half*(u*u+v*v)) );
+     vn = u*nx2+v*ny2;
+     vt = u*nx1+v*ny1;
+
+   //Wave Strengths (remember that n2 is the normal and n1 is the tangent.)
+    vnL = uL*nx2 + vL*ny2;
+    vnR = uR*nx2 + vR*ny2;
+    vtL = uL*nx1 + vL*ny1;
+    vtR = uR*nx1 + vR*ny1;
+
+   drho = rhoR - rhoL;
+     dp =   pR - pL;
+    dvn =  vnR - vnL;
+    dvt =  vtR - vtL;
+
+   dV[0] = (dp - rho*a*dvn )/(two*a*a);
+   dV[1] =  rho*dvt/a;
+   dV[2] =  drho - dp/(a*a);
+   dV[3] = (dp + rho*a*dvn )/(two*a*a);
+
+   //Wave Speeds for Roe flux part.
+   ws[0] = vn-a;
+   ws[1] = vn;
+   ws[2] = vn;
+   ws[3] = vn+a;
+   for (int k = 0; k < 4; k++) abs_ws[k] = std::abs(ws[k]);
+
+   //Harten's Entropy Fix JCP(1983), 49, pp357-393:
+   //only for the nonlinear fields.
+   dws[0] = fifth;
+   if (abs_ws[0]<dws[0]) abs_ws[0] = half*(abs_ws[0]*abs_ws[0]/dws[0]+dws[0]);
+   dws[3] = fifth;
+   if (abs_ws[3]<dws[3]) abs_ws[3] = half*(abs_ws[3]*abs_ws[3]/dws[3]+dws[3]);
+
+   //HLL wave speeds, evaluated with [nx1,ny1] (=tangent wrt n2).
+   SRp = std::max( zero, std::max(vtR + aR, vt + a) );
+   SLm = std::min( zero, std::min(vtL - aL, vt - a) );
+
+   //Modified wave speeds for the Rotated-RHLL flux: (5.12) in the original paper.
+   for (int k = 0; k < 4; k++) {
+      ws[k] = alpha2*abs_ws[k] - ( alpha2*(SRp+SLm)*ws[k] + two*alpha1*SRp*SLm )/ (SRp-SLm);
+   }
+
+   //Right Eigenvectors: with n2 as normal and n1 as tangent.
+   Rv[0][0] = one;
+   Rv[1][0] = u - a*nx2;
+   Rv[2][0] = v - a*ny2;
+   Rv[3][0] = H - vn*a;
+
+   Rv[0][1] = zero;
+   Rv[1][1] = a*nx1;
+   Rv[2][1] = a*ny1;
+   Rv[3][1] = a*vt;
+
+   Rv[0][2] = one;
+   Rv[1][2] = u;
+   Rv[2][2] = v;
+   Rv[3][2] = half*(u*u+v*v);
+
+   Rv[0][3] = one;
+   Rv[1][3] = u + a*nx2;
+   Rv[2][3] = v + a*ny2;
+   Rv[3][3] = H + vn*a;
+
+   //Dissipation Term: Roe dissipation with the modified wave speeds.
+   for (int k = 0; k < 4; k++) {
+      diss[k] = zero;
+      for (int j = 0; j < 4; j++) diss[k] += ws[j]*dV[j]*Rv[k][j];
+   }
+
+   //Compute the Rotated-RHLL flux. (It looks like the HLL flux with Roe dissipation.)
+   for (int k = 0; k < 4; k++) {
+      num_flux[k] = (SRp*fL[k] - SLm*fR[k])/(SRp-SLm) - half*diss[k];
+   }
+
+   //Normal max wave speed in the normal direction.
+   wsn = std::abs(u*nx + v*ny) + a;
+
+} // end rotated_rhll
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Rotated-RHLL flux as a smooth function of the states (steady mode).
+//*
+//* The rotated direction n1 is the direction of the velocity difference dq
+//* across the face, and it jumps where dq changes direction: near a steady
+//* state, dq is small at some edges and its direction changes from one
+//* iteration to the next, so the iterations stall (the two Runge-Kutta
+//* stages end up undoing each other). Here the flux is the blend
+//*
+//*   F = w*F(n1 = dq/|dq|) + (1-w)*F(n1 = face tangent),
+//*   w = |dq|^2/(|dq|^2 + delta^2), delta = rhll_smoothing * mean sound speed,
+//*
+//* which is continuous in dq (F does not change when n1 flips sign), and
+//* is the rotated flux where |dq| >> delta, e.g., across a shock.
+//*
+//* ------------------------------------------------------------------------------
+//*  Input:   wL(0:3), wR(0:3), nx, ny as in rotated_rhll
+//*
+//* Output:   num_flux(0:3) = numerical flux
+//*           wsn           = max wave speed (for time step)
+//* ------------------------------------------------------------------------------
+//*
+//********************************************************************************
+void EulerSolver2D::Solver::rotated_rhll_smooth(const real* wL, const real* wR, real nx, real ny,
+                                                real* num_flux, real& wsn,
+                                                EulerSolver2D::MainData2D& E2Ddata) {
+
+   const real gamma = E2Ddata.gamma;
+   const real du    = wR[1] - wL[1];
+   const real dv    = wR[2] - wL[2];
+   const real dq2   = du*du + dv*dv;
+   const real a     = half*( std::sqrt(gamma*wL[3]/wL[0]) + std::sqrt(gamma*wR[3]/wR[0]) );
+   const real delta = E2Ddata.rhll_smoothing * a;
+   const real w     = dq2/(dq2 + delta*delta);
+
+   real tangent[2] = {-ny, nx};
+   real flux_t[4], wsn_t;
+
+   rotated_rhll(wL, wR, nx, ny, flux_t, wsn_t, E2Ddata, tangent);
+
+   if (w > zero) {
+      const real abs_dq = std::sqrt(dq2);
+      real n1[2] = {du/abs_dq, dv/abs_dq};
+      rotated_rhll(wL, wR, nx, ny, num_flux, wsn, E2Ddata, n1);
+      for (int k = 0; k < 4; k++) num_flux[k] = w*num_flux[k] + (one-w)*flux_t[k];
+      wsn = w*wsn + (one-w)*wsn_t;
+   } else {
+      for (int k = 0; k < 4; k++) num_flux[k] = flux_t[k];
+      wsn = wsn_t;
+   }
 
+} // end rotated_rhll_smooth
 //--------------------------------------------------------------------------------
 
 
@@ -267,11 +2634,12 @@ void EulerSolver2D::Solver::initial_solution_shock_diffraction(
 
       // Set the initial solution: set the pre-shock state inside the domain.
 
-      E2Ddata.node[i].w[0] = rho0;
-      E2Ddata.node[i].w[0] = u0;
-      E2Ddata.node[i].w[0] = v0;
-      E2Ddata.node[i].w[0] = p0;
-      (*E2Ddata.node[i].u) = w2u( (*E2Ddata.node[i].w), E2Ddata);
+      real* w = E2Ddata.field.w_at(i);
+      w[0] = rho0;
+      w[1] = u0;
+      w[2] = v0;
+      w[3] = p0;
+      w2u( w, E2Ddata.field.u_at(i), E2Ddata);
 
    }
  }  // end function initial_solution_shock_diffraction
@@ -288,16 +2656,13 @@ void EulerSolver2D::Solver::initial_solution_shock_diffraction(
 //* ------------------------------------------------------------------------------
 //* 
 //********************************************************************************
-Array2D<real>  EulerSolver2D::Solver::w2u(const Array2D<real>& w,
+void  EulerSolver2D::Solver::w2u(const real* w, real* u,
                                              EulerSolver2D::MainData2D& E2Ddata) {
-   Array2D<real> u(4,1);
 
-   u(0) = w(0);
-   u(1) = w(0)*w(1);
-   u(2) = w(0)*w(2);
-   u(3) = w(3)/(E2Ddata.gamma-one)+half*w(1)*(w(2)*w(2)+w(3)*w(3));
-
-   return u;
+   u[0] = w[0];
+   u[1] = w[0]*w[1];
+   u[2] = w[0]*w[2];
+   u[3] = w[3]/(E2Ddata.gamma-one)+half*w[0]*(w[1]*w[1]+w[2]*w[2]);
 
 } // end function w2u
 //--------------------------------------------------------------------------------
@@ -311,17 +2676,13 @@ Array2D<real>  EulerSolver2D::Solver::w2u(const Array2D<real>& w,
 //* ------------------------------------------------------------------------------
 //* 
 //********************************************************************************
-Array2D<real>  EulerSolver2D::Solver::u2w(const Array2D<real>& u,
+void  EulerSolver2D::Solver::u2w(const real* u, real* w,
                                              EulerSolver2D::MainData2D& E2Ddata) {
 
-   Array2D<real> w(4,1);
-
-   w(0) = u(0);
-   w(1) = u(1)/u(0);
-   w(2) = u(2)/u(0);
-   w(3) = (E2Ddata.gamma-one)*( u(3) - half*w(0)*(w(1)*w(1)+w(2)*w(2)) );
-
-   return w;
+   w[0] = u[0];
+   w[1] = u[1]/u[0];
+   w[2] = u[2]/u[0];
+   w[3] = (E2Ddata.gamma-one)*( u[3] - half*w[0]*(w[1]*w[1]+w[2]*w[2]) );
 
 }//end function u2w
 //--------------------------------------------------------------------------------
@@ -330,7 +2691,7 @@ Array2D<real>  EulerSolver2D::Solver::u2w(const Array2D<real>& u,
 
 void EulerSolver2D::Solver::compute_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddata) {
 
-      int i, in, ell, ii, k;
+      int in, ii;
 
       cout << " \n";
       cout << " " "Constructing LSQ coefficients...\n";
@@ -339,15 +2700,13 @@ void EulerSolver2D::Solver::compute_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Dd
 
       cout << "---(1) Constructing Linear LSQ coefficients...\n";
 
+      // one coefficient per neighbor, aligned with nghbr_idx
+      E2Ddata.lsq2x2_cx.assign( E2Ddata.nghbr_idx.size(), zero );
+      E2Ddata.lsq2x2_cy.assign( E2Ddata.nghbr_idx.size(), zero );
+
       // nnodes
       for (size_t i = 0; i < E2Ddata.nnodes; i++) {
-
-         //my_alloc_p2_ptr(node[i].lsq2x2_cx,node[i].nnghbrs)
-         E2Ddata.node[i].lsq2x2_cx = new Array2D<real>( E2Ddata.node[i].nnghbrs, 1 );
-         //my_alloc_p2_ptr(node[i].lsq2x2_cy,node[i].nnghbrs)
-         E2Ddata.node[i].lsq2x2_cy = new Array2D<real>( E2Ddata.node[i].nnghbrs, 1 );
          lsq01_2x2_coeff_nc(E2Ddata, i);
-
       }
 
 
@@ -355,35 +2714,42 @@ void EulerSolver2D::Solver::compute_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Dd
 
    cout << "---(2) Constructing Quadratic LSQ coefficients...\n";
 
+   // The stencil of node i is the neighbors of its neighbors: entry ii is the
+   // pair (in,m), m = ell-th neighbor of the k-th neighbor in of node i.
+   E2Ddata.lsq5x5_ptr.resize(E2Ddata.nnodes+1);
+   E2Ddata.lsq5x5_ptr[0] = 0;
+
    //loop nnodes
    for (size_t i = 0; i < E2Ddata.nnodes; i++) {
 
       ii = 0;
       //loop node[i].nnghbrs;
       for (size_t k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
-         in = (*E2Ddata.node[i].nghbr)(k);
-         //loop E2Ddata.node[in].nnghbrs;
-         for (size_t ell = 0; ell < E2Ddata.node[in].nnghbrs; ell++) {
-            ii = ii + 1;
-         }//nghbr_nghbr
+         in = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[i] + k ];
+         ii = ii + E2Ddata.node[in].nnghbrs;
       }//nghbr
 
-   //   call my_alloc_p2_ptr(node(i)%lsq5x5_cx, ii)
-      E2Ddata.node[i].lsq5x5_cx = new Array2D<real>(ii,1);
-   //   call my_alloc_p2_ptr(node(i)%lsq5x5_cy, ii)
-      E2Ddata.node[i].lsq5x5_cy = new Array2D<real>(ii,1);
-   //   call my_alloc_p2_ptr(node(i)%dx,node(i)%nnghbrs)
-      //E2Ddata.node[i].dx = new Array2D<real>(E2Ddata.node[i].nnghbrs+1,1);
-      E2Ddata.node[i].dx = new Array2D<real>(E2Ddata.node[i].nnghbrs,1);
-   //   call my_alloc_p2_ptr(node(i)%dy,node(i)%nnghbrs)
-      //E2Ddata.node[i].dy = new Array2D<real>(E2Ddata.node[i].nnghbrs+1,1);
-      E2Ddata.node[i].dy = new Array2D<real>(E2Ddata.node[i].nnghbrs,1);
-   //   call my_alloc_p2_matrix_ptr(node(i)%dw, nq,node(i)%nnghbrs)
-      //E2Ddata.node[i].dw = new Array2D<real>(E2Ddata.nq, E2Ddata.node[i].nnghbrs+1);
-      E2Ddata.node[i].dw = new Array2D<real>(E2Ddata.nq, E2Ddata.node[i].nnghbrs);
+      E2Ddata.lsq5x5_ptr[i+1] = E2Ddata.lsq5x5_ptr[i] + ii;
 
    }//end do
 
+   E2Ddata.lsq5x5_in.resize( E2Ddata.lsq5x5_ptr[E2Ddata.nnodes] );
+   E2Ddata.lsq5x5_m.resize(  E2Ddata.lsq5x5_ptr[E2Ddata.nnodes] );
+   E2Ddata.lsq5x5_cx.assign( E2Ddata.lsq5x5_ptr[E2Ddata.nnodes], zero );
+   E2Ddata.lsq5x5_cy.assign( E2Ddata.lsq5x5_ptr[E2Ddata.nnodes], zero );
+
+   for (int i = 0; i < E2Ddata.nnodes; i++) {
+      ii = E2Ddata.lsq5x5_ptr[i];
+      for (int k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
+         in = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[i] + k ];
+         for (int ell = 0; ell < E2Ddata.node[in].nnghbrs; ell++) {
+            E2Ddata.lsq5x5_in[ii] = in;
+            E2Ddata.lsq5x5_m[ii]  = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[in] + ell ];
+            ii = ii + 1;
+         }
+      }
+   }
+
    lsq02_5x5_coeff2_nc(E2Ddata);
 
 } //  end compute_lsq_coeff_nc
@@ -402,7 +2768,6 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
    // use edu2d_my_main_data, only : nnodes, node
 
    int       i, ix, iy, ivar;
-   std::string grad_type_temp;
    real error_max_wx, error_max_wy, x, y;
    real x_max_wx, y_max_wx, x_max_wy, y_max_wy, wx, wxe, wy, wye;
    real a0, a1, a2, a3, a4, a5;
@@ -429,16 +2794,13 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
    for (size_t i = 0; i < E2Ddata.nnodes; i++) {
       x = E2Ddata.node[i].x;
       y = E2Ddata.node[i].y;
-      (*E2Ddata.node[i].w)(ivar) = one*x + two*y;
+      E2Ddata.field.w_at(i)[ivar] = one*x + two*y;
    }
 
 //  (2). Compute the gradient by linear LSQ
 
    cout << "- Computing linear LSQ gradients..\n";
-   grad_type_temp = "linear";
-   //cout << " grad_type_temp =  " << grad_type_temp << endl;
-   compute_gradient_nc(E2Ddata, ivar, grad_type_temp);
-   cout << " ivar = " << ivar << endl;
+   compute_gradient_nc(E2Ddata, GradientType::linear);
 
 //  (3). Compute the relative errors (L_infinity)
 
@@ -449,10 +2811,10 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
 
    //loop nnodes
    for (size_t i = 0; i < E2Ddata.nnodes; i++) {
-      //cout << " (*E2Ddata.node[i].gradw)(ivar,ix) = " << (*E2Ddata.node[i].gradw)(ivar,ix) << endl;
-      //cout << " (*E2Ddata.node[i].gradw)(ivar,iy) = " << (*E2Ddata.node[i].gradw)(ivar,iy) << endl;
-      error_max_wx = max( std::abs( (*E2Ddata.node[i].gradw)(ivar,ix) - one )/one, error_max_wx );
-      error_max_wy = max( std::abs( (*E2Ddata.node[i].gradw)(ivar,iy) - two )/two, error_max_wy );
+      //cout << " E2Ddata.field.gradw_at(i,ivar,ix) = " << E2Ddata.field.gradw_at(i,ivar,ix) << endl;
+      //cout << " E2Ddata.field.gradw_at(i,ivar,iy) = " << E2Ddata.field.gradw_at(i,ivar,iy) << endl;
+      error_max_wx = max( std::abs( E2Ddata.field.gradw_at(i,ivar,ix) - one )/one, error_max_wx );
+      error_max_wy = max( std::abs( E2Ddata.field.gradw_at(i,ivar,iy) - two )/two, error_max_wy );
    }
 
    cout << " Max relative error in wx =  " << error_max_wx << "\n";
@@ -484,14 +2846,13 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
    for (size_t i = 0; i < E2Ddata.nnodes; i++) {
       x = E2Ddata.node[i].x;
       y = E2Ddata.node[i].y;
-      (*E2Ddata.node[i].w)(ivar) = a0 + a1*x + a2*y + a3*x*x + a4*x*y + a5*y*y;
+      E2Ddata.field.w_at(i)[ivar] = a0 + a1*x + a2*y + a3*x*x + a4*x*y + a5*y*y;
    }
 
 //  (2). Compute the gradient by linear LSQ
 
    cout << "- Computing quadratic LSQ gradients..\n";
-   grad_type_temp = "quadratic2";
-   compute_gradient_nc(E2Ddata,ivar,grad_type_temp);
+   compute_gradient_nc(E2Ddata, GradientType::quadratic2);
 
 //  (3). Compute the relative errors (L_infinity)
 
@@ -506,9 +2867,9 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
       x = E2Ddata.node[i].x;
       y = E2Ddata.node[i].y;
 
-      if ( std::abs( (*E2Ddata.node[i].gradw)(ivar,ix) - 
+      if ( std::abs( E2Ddata.field.gradw_at(i,ivar,ix) - 
             (a1+2.0*a3*x+a4*y) )/(a1+2.0*a3*x+a4*y) > error_max_wx )  {
-         wx  = (*E2Ddata.node[i].gradw)(ivar,ix);
+         wx  = E2Ddata.field.gradw_at(i,ivar,ix);
          wxe = a1 + 2.0*a3*x + a4*y;
          error_max_wx = std::abs( wx - wxe )/wxe;
          x_max_wx = x;
@@ -516,9 +2877,9 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
          intmax_x = i;
       }
 
-      if ( std::abs( (*E2Ddata.node[i].gradw)(ivar,iy) - 
+      if ( std::abs( E2Ddata.field.gradw_at(i,ivar,iy) - 
             (a2+2.0*a5*y+a4*x) )/(a2+2.0*a5*y+a4*x) > error_max_wy )  {
-         wy  = (*E2Ddata.node[i].gradw)(ivar,iy);
+         wy  = E2Ddata.field.gradw_at(i,ivar,iy);
          wye = a2 + 2.0*a5*y + a4*x;
          error_max_wy = std::abs( wy - wye )/wye;
          x_max_wy = x;
@@ -548,153 +2909,135 @@ void EulerSolver2D::Solver::check_lsq_coeff_nc(EulerSolver2D::MainData2D& E2Ddat
 
 
 //********************************************************************************
-//* This subroutine computes gradients at nodes for the variable u(ivar),
-//* where ivar = 1,2,3, ..., or nq.
+//* This subroutine computes gradients at nodes for all the variables w(1:nq).
+//*
+//* The gradient type is a template parameter of compute_gradient_kernel, and
+//* each node makes a single pass over its stencil for all nq variables, with
+//* the precomputed flat LSQ coefficients (see compute_lsq_coeff_nc).
+//* compute_gradient_nc picks the kernel for a gradient type given at run time.
 //*
 //* ------------------------------------------------------------------------------
-//*  Input: node[:).u(ivar)
+//*  Input: node[:).w(1:nq)
 //*
-//* Output: node[i].gradu(ivar,1:2) = ( du(ivar)/dx, du(ivar)/dy )
+//* Output: node[i].gradw(1:nq,1:2) = ( dw/dx, dw/dy )
 //* ------------------------------------------------------------------------------
 //********************************************************************************
 void EulerSolver2D::Solver::compute_gradient_nc(
                               EulerSolver2D::MainData2D& E2Ddata,
-                              int ivar, std::string grad_type) {
-
-   //use edu2d_my_main_data, only : node, nnodes
+                              EulerSolver2D::GradientType grad_type) {
 
-   //integer, intent(in) :: ivar
-   //std::string grad_type
+   switch (grad_type) {
+      case GradientType::none:       compute_gradient_kernel<GradientType::none>(E2Ddata);       break;
+      case GradientType::linear:     compute_gradient_kernel<GradientType::linear>(E2Ddata);     break;
+      case GradientType::quadratic2: compute_gradient_kernel<GradientType::quadratic2>(E2Ddata); break;
+   }
 
-   int in;
+} // end compute_gradient_nc
 
-   cout << "computing gradient nc type " << grad_type << endl;
 
-   if (trim(grad_type) == "none") {
-      cout << "trim(grad_type) == none, return " << endl;
-      return;
-   }
-   //   else {
-   //      cout << "trim(grad_type) == " << trim(grad_type) << " full =  " << grad_type << endl;
-   //   }
 
-   //-------------------------------------------------
-   //  Two-step quadratic LSQ 5x5 system
-   //  Note: See Nishikawa, JCP2014v273pp287-309 for details, which is available at
-   //        http://www.hiroakinishikawa.com/My_papers/nishikawa_jcp2014v273pp287-309_preprint.pdf.
+template <EulerSolver2D::GradientType G>
+void EulerSolver2D::Solver::compute_gradient_kernel(EulerSolver2D::MainData2D& E2Ddata) {
 
-   if (trim(grad_type) == "quadratic2") {
+   //  Decomposed grid: the gradients at the owned nodes (their stencils are
+   //  complete), then those of the ghosts from their owners.
+   const int nnodes = E2Ddata.nodes_owned();
 
-   //  Perform Step 1 as below (before actually compute the gradient).
+   //-------------------------------------------------
+   // No gradient (first-order)
+   if constexpr (G == GradientType::none) {
 
-      //do i = 1, nnodes
-      for (size_t i = 0; i < E2Ddata.nnodes; i++) {
-         //nghbr0 : do k = 1, node[i].nnghbrs;
-         for (size_t k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
-            in      = (*E2Ddata.node[i].nghbr)(k);
-            (*E2Ddata.node[i].dx)(k)      = E2Ddata.node[in].x       - E2Ddata.node[i].x;
-            (*E2Ddata.node[i].dy)(k)      = E2Ddata.node[in].y       - E2Ddata.node[i].y;
-            (*E2Ddata.node[i].dw)(ivar,k) = (*E2Ddata.node[in].w)(ivar) - (*E2Ddata.node[i].w)(ivar);
-         } //end loop nghbr0 nnghbrs
-      }//end loop nnodes
+      return;
 
    }
    //-------------------------------------------------
+   // Linear LSQ 2x2 system
+   else if constexpr (G == GradientType::linear) {
 
-   //------------------------------------------------------------
-   //------------------------------------------------------------
-   //-- Compute LSQ Gradients at all nodes.
-   cout << "Compute LSQ Gradients at all nodes. " << endl;
-   //------------------------------------------------------------
-   //------------------------------------------------------------
-
-   //nodes : loop nnodes
-   for (size_t i = 0; i < E2Ddata.nnodes; i++) {
-
-      //-------------------------------------------------
-      // Linear LSQ 2x2 system
-      if (trim(grad_type) == "linear") {
-
-         lsq_gradients_nc(E2Ddata, i, ivar);
-      }
-      //-------------------------------------------------
-      // Two-step quadratic LSQ 5x5 system
-      //  Note: See Nishikawa, JCP2014v273pp287-309 for details, which is available at
-      //        http://www.hiroakinishikawa.com/My_papers/nishikawa_jcp2014v273pp287-309_preprint.pdf.
-      else if (trim(grad_type) == "quadratic2") {
-
-         //cout << "(trim(grad_type) == quadratic2) " << endl;
-         lsq_gradients2_nc(E2Ddata, i, ivar);
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < nnodes; i++) {
+         lsq_gradients_nc(E2Ddata, i);
       }
-      //-------------------------------------------------
-      else {
 
-         cout << " Invalid input value -> " << trim(grad_type);
-         std::exit(0); //stop
+   }
+   //-------------------------------------------------
+   //  Two-step quadratic LSQ 5x5 system
+   //  Note: See Nishikawa, JCP2014v273pp287-309 for details, which is available at
+   //        http://www.hiroakinishikawa.com/My_papers/nishikawa_jcp2014v273pp287-309_preprint.pdf.
+   else {
 
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < nnodes; i++) {
+         lsq_gradients2_nc(E2Ddata, i);
       }
-      //-------------------------------------------------
 
-   } //end loop nodes
+   }
+   //-------------------------------------------------
 
-} // end compute_gradient_nc
+   if constexpr (G != GradientType::none) {
+      E2Ddata.halo.update(E2Ddata.field.gradw.data(), 2*E2Ddata.nq);
+   }
+
+} // end compute_gradient_kernel
 
 
 
 
 
 //********************************************************************************
-//* Compute the gradient, (wx,wy), for the variable u by Linear LSQ.
+//* Compute the gradients, (wx,wy), of all the variables by Linear LSQ.
 //*
 //* ------------------------------------------------------------------------------
 //*  Input:            inode = Node number at which the gradient is computed.
-//*                     ivar =   Variable for which the gradient is computed.
-//*          node[:).w(ivar) = Solution at nearby nodes.
+//*          node[:).w(1:nq) = Solution at nearby nodes.
 //*
-//* Output:  node[inode].gradu = gradient of the requested variable
+//* Output:  node[inode].gradw = gradients of all the variables
+//*          (or gradw[ivar*2+ix], if given)
 //* ------------------------------------------------------------------------------
 //*
 //********************************************************************************
 void EulerSolver2D::Solver::lsq_gradients_nc(
-   EulerSolver2D::MainData2D& E2Ddata, int inode, int ivar) {
+   EulerSolver2D::MainData2D& E2Ddata, int inode) {
 
-   //  use edu2d_my_main_data           , only : node
-   //  use edu2d_constants              , only : p2, zero
+   lsq_gradients_nc(E2Ddata, inode, &E2Ddata.field.gradw[inode*E2Ddata.nq*2]);
 
-   //  implicit none
+}
 
-   //  integer, intent(in) :: inode, ivar
 
-   //Local variables
-   int in, inghbr;
-   int ix, iy;
-   real da, ax, ay;
 
-   ix = 0;
-   iy = 1;
-   ax = zero;
-   ay = zero;
+void EulerSolver2D::Solver::lsq_gradients_nc(
+   EulerSolver2D::MainData2D& E2Ddata, int inode, real* gradw) {
 
-//   Loop over neighbors
+   //Local variables
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+   int inghbr;
+   real da, ax[4], ay[4];
 
-   // loop in = 1, E2Ddata.node[inode].nnghbrs
-   for (size_t in = 0; in < E2Ddata.node[inode].nnghbrs; in ++) {
-      inghbr = (*E2Ddata.node[inode].nghbr)(in);
+   for (int ivar = 0; ivar < nq; ivar++) { ax[ivar] = zero; ay[ivar] = zero; }
 
-      da = (*E2Ddata.node[inghbr].w)(ivar) - (*E2Ddata.node[inode].w)(ivar);
+   const real* wi = f.w_at(inode);
 
-      ax = ax + (*E2Ddata.node[inode].lsq2x2_cx)(in)*da;
-      ay = ay + (*E2Ddata.node[inode].lsq2x2_cy)(in)*da;
+//   Loop over neighbors
+
+   for (int j = E2Ddata.nghbr_ptr[inode]; j < E2Ddata.nghbr_ptr[inode+1]; j++) {
+      inghbr = E2Ddata.nghbr_idx[j];
+      const real  cx = E2Ddata.lsq2x2_cx[j];
+      const real  cy = E2Ddata.lsq2x2_cy[j];
+      const real* wn = f.w_at(inghbr);
 
-      // cout << " (*E2Ddata.node[inode].lsq2x2_cx)(in) = "
-      //          << (*E2Ddata.node[inode].lsq2x2_cx)(in) << endl;
-      // cout << " (*E2Ddata.node[inode].lsq2x2_cy)(in) = "
-      //          << (*E2Ddata.node[inode].lsq2x2_cy)(in) << endl;
+      for (int ivar = 0; ivar < nq; ivar++) {
+         da = wn[ivar] - wi[ivar];
+         ax[ivar] = ax[ivar] + cx*da;
+         ay[ivar] = ay[ivar] + cy*da;
+      }
 
    }
 
-   (*E2Ddata.node[inode].gradw)(ivar,ix) = ax;  //<-- du(ivar)/dx
-   (*E2Ddata.node[inode].gradw)(ivar,iy) = ay;  //<-- du(ivar)/dy
+   for (int ivar = 0; ivar < nq; ivar++) {
+      gradw[ivar*2  ] = ax[ivar];  //<-- dw(ivar)/dx
+      gradw[ivar*2+1] = ay[ivar];  //<-- dw(ivar)/dy
+   }
 
 }// end lsq_gradients_nc
 //--------------------------------------------------------------------------------
@@ -702,69 +3045,73 @@ void EulerSolver2D::Solver::lsq_gradients_nc(
 
 
 //********************************************************************************
-//* Compute the gradient, (wx,wy), for the variable u by Quadratic LSQ.
+//* Compute the gradients, (wx,wy), of all the variables by Quadratic LSQ.
+//*
+//* The stencil entry ii of node inode is the pair (in,m), where m is a
+//* neighbor of the neighbor in (lsq5x5_in, lsq5x5_m). The Step-1 difference
+//* w(m)-w(in) is formed on the fly, so no per-node dw array is needed.
 //*
 //* ------------------------------------------------------------------------------
 //*  Input:            inode = Node number at which the gradient is computed.
-//*                     ivar =   Variable for which the gradient is computed.
-//*          node[:).w(ivar) = Solution at nearby nodes.
+//*          node[:).w(1:nq) = Solution at nearby nodes.
 //*
-//* Output:  node[inode].gradu = gradient of the requested variable
+//* Output:  node[inode].gradw = gradients of all the variables
+//*          (or gradw[ivar*2+ix], if given)
 //* ------------------------------------------------------------------------------
 //*
 //********************************************************************************
 void EulerSolver2D::Solver::lsq_gradients2_nc(
-   EulerSolver2D::MainData2D& E2Ddata, int inode, int ivar) {
-
-   //Local variables
-   int  in;
-   int  ix, iy, ii, ell, k;
-   real da, ax, ay;
-
-   ix = 0;
-   iy = 1;
-   ax = zero;
-   ay = zero;
+   EulerSolver2D::MainData2D& E2Ddata, int inode) {
 
-//   Loop over neighbors
+   lsq_gradients2_nc(E2Ddata, inode, &E2Ddata.field.gradw[inode*E2Ddata.nq*2]);
 
-   ii = -1;
+}
 
-   //nghbr : loop node[inode].nnghbrs
-   for (size_t k = 0; k < E2Ddata.node[inode].nnghbrs; k++) {
-      //in = node[inode].nghbr(k)
-      in = (*E2Ddata.node[inode].nghbr)(k);
 
-      //nghbr_nghbr : do ell = 1, node[in].nnghbrs
-      for (size_t ell = 0; ell < E2Ddata.node[in].nnghbrs; ell++ ) {
 
-         da = (*E2Ddata.node[in].w)(ivar) - (*E2Ddata.node[inode].w)(ivar) +\
-                                          (*E2Ddata.node[in].dw)(ivar,ell);
+void EulerSolver2D::Solver::lsq_gradients2_nc(
+   EulerSolver2D::MainData2D& E2Ddata, int inode, real* gradw) {
 
-         if ( (*E2Ddata.node[in].nghbr)(ell) == inode ) {
-            da = (*E2Ddata.node[in].w)(ivar) - (*E2Ddata.node[inode].w)(ivar);
+   //Local variables
+   const int nq = E2Ddata.nq;
+   NodeFields& f = E2Ddata.field;
+   int  in, m;
+   real da, ax[4], ay[4];
+
+   for (int ivar = 0; ivar < nq; ivar++) { ax[ivar] = zero; ay[ivar] = zero; }
+
+   const real* wi = f.w_at(inode);
+
+//   Loop over neighbors of neighbors
+
+   for (int ii = E2Ddata.lsq5x5_ptr[inode]; ii < E2Ddata.lsq5x5_ptr[inode+1]; ii++) {
+      in = E2Ddata.lsq5x5_in[ii];
+      m  = E2Ddata.lsq5x5_m[ii];
+      const real  cx = E2Ddata.lsq5x5_cx[ii];
+      const real  cy = E2Ddata.lsq5x5_cy[ii];
+      const real* wn = f.w_at(in);
+      const real* wm = f.w_at(m);
+
+      if ( m == inode ) {
+         for (int ivar = 0; ivar < nq; ivar++) {
+            da = wn[ivar] - wi[ivar];
+            ax[ivar] = ax[ivar] + cx*da;
+            ay[ivar] = ay[ivar] + cy*da;
          }
-
-         ii = ii + 1;
-
-         ax = ax + (*E2Ddata.node[inode].lsq5x5_cx)(ii) * da;
-         ay = ay + (*E2Ddata.node[inode].lsq5x5_cy)(ii) * da;
-
-         // if (inode<E2Ddata.maxit-1) {
-         //    cout << "(*E2Ddata.node[inode].lsq5x5_cx)(ii) = " << (*E2Ddata.node[inode].lsq5x5_cx)(ii) << endl;
-         //    cout << "(*E2Ddata.node[inode].lsq5x5_cy)(ii) = " << (*E2Ddata.node[inode].lsq5x5_cy)(ii) << endl;
-         // }
-         if (inode<E2Ddata.maxit-0) {
-            cout << " = " << ax << endl;
-            cout << " = " << ay << endl;
+      } else {
+         for (int ivar = 0; ivar < nq; ivar++) {
+            da = wn[ivar] - wi[ivar] + ( wm[ivar] - wn[ivar] );
+            ax[ivar] = ax[ivar] + cx*da;
+            ay[ivar] = ay[ivar] + cy*da;
          }
+      }
 
-      } // end loop nghbr_nghbr
-
-   } // end loop nghbr
+   } // end loop nghbr_nghbr
 
-   (*E2Ddata.node[inode].gradw)(ivar,ix) = ax;  //<-- dw(ivar)/dx;
-   (*E2Ddata.node[inode].gradw)(ivar,iy) = ay;  //<-- dw(ivar)/dy;
+   for (int ivar = 0; ivar < nq; ivar++) {
+      gradw[ivar*2  ] = ax[ivar];  //<-- dw(ivar)/dx;
+      gradw[ivar*2+1] = ay[ivar];  //<-- dw(ivar)/dy;
+   }
 
 } //end lsq_gradients2_nc
 //--------------------------------------------------------------------------------
@@ -780,8 +3127,8 @@ void EulerSolver2D::Solver::lsq_gradients2_nc(
 //* ------------------------------------------------------------------------------
 //*  Input:  inode = node number at which the gradient is computed.
 //*
-//* Output:  node[inode].lsq2x2_cx(:)
-//*          node[inode].lsq2x2_cx(:)
+//* Output:  lsq2x2_cx(nghbr_ptr(inode):nghbr_ptr(inode+1)-1)
+//*          lsq2x2_cy(nghbr_ptr(inode):nghbr_ptr(inode+1)-1)
 //* ------------------------------------------------------------------------------
 //*
 //********************************************************************************
@@ -809,7 +3156,7 @@ void EulerSolver2D::Solver::lsq01_2x2_coeff_nc(
 
 //  Loop over the neighbor nodes:  node[inode].nnghbrs
    for (size_t k = 0; k < E2Ddata.node[inode].nnghbrs; k++) {
-      inghbr = (*E2Ddata.node[inode].nghbr)(k);
+      inghbr = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[inode] + k ];
 
       if (inghbr == inode) {
          cout << "ERROR: nodes must differ//" << endl;
@@ -851,7 +3198,7 @@ void EulerSolver2D::Solver::lsq01_2x2_coeff_nc(
 
    //nghbr : loop node[inode].nnghbrs
    for (size_t k = 0; k < E2Ddata.node[inode].nnghbrs; k++) {
-      inghbr = (*E2Ddata.node[inode].nghbr)(k);
+      inghbr = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[inode] + k ];
 
       dx = E2Ddata.node[inghbr].x - E2Ddata.node[inode].x;
       dy = E2Ddata.node[inghbr].y - E2Ddata.node[inode].y;
@@ -859,11 +3206,11 @@ void EulerSolver2D::Solver::lsq01_2x2_coeff_nc(
       w2dvar = lsq_weight(E2Ddata, dx, dy);
       w2dvar = w2dvar * w2dvar;
 
-      (*E2Ddata.node[inode].lsq2x2_cx)(k)  = \
+      E2Ddata.lsq2x2_cx[ E2Ddata.nghbr_ptr[inode] + k ]  = \
                                    local_lsq_inverse(ix,0)*w2dvar*dx \
                                  + local_lsq_inverse(ix,1)*w2dvar*dy;
 
-      (*E2Ddata.node[inode].lsq2x2_cy)(k)  = \
+      E2Ddata.lsq2x2_cy[ E2Ddata.nghbr_ptr[inode] + k ]  = \
                                    local_lsq_inverse(iy,0)*w2dvar*dx \
                                  + local_lsq_inverse(iy,1)*w2dvar*dy;
 
@@ -886,8 +3233,8 @@ void EulerSolver2D::Solver::lsq01_2x2_coeff_nc(
 //* ------------------------------------------------------------------------------
 //*  Input:
 //*
-//* Output:  node[:).lsq5x5_cx(ii)
-//*          node[:).lsq5x5_cx(ii)
+//* Output:  lsq5x5_cx(ii), ii = lsq5x5_ptr(i):lsq5x5_ptr(i+1)-1
+//*          lsq5x5_cy(ii)
 //*
 //* Note: This subroutine computes the LSQ coefficeints at all nodes.
 //* ------------------------------------------------------------------------------
@@ -918,20 +3265,23 @@ void EulerSolver2D::Solver::lsq02_5x5_coeff2_nc(
    cout << "gradient_weight  = " << trim(E2Ddata.gradient_weight) << endl;
    
    
-   // Step 1
+   // Step 1: edge vectors to the neighbors, aligned with nghbr_idx
+
+   std::vector<real> ndx( E2Ddata.nghbr_idx.size() );
+   std::vector<real> ndy( E2Ddata.nghbr_idx.size() );
 
    //   node1 : loop nnodes
    //    nghbr : loop node[i].nnghbrs
    for (size_t i = 0; i < E2Ddata.nnodes; i++) {
       for (size_t k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
-         in      = (*E2Ddata.node[i].nghbr)(k);
+         in      = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[i] + k ];
          // if (in >= E2Ddata.node[i].nnghbrs) {
          //    cout << "ERROR: in >= nnghbrs " << in << " " << E2Ddata.node[i].nnghbrs << endl;
          //    std::exit(0);
          // }
          //cout << " i = " << i << " k = " << k << endl;
-         (*E2Ddata.node[i].dx)(k)   = E2Ddata.node[in].x - E2Ddata.node[i].x;
-         (*E2Ddata.node[i].dy)(k)   = E2Ddata.node[in].y - E2Ddata.node[i].y;
+         ndx[ E2Ddata.nghbr_ptr[i] + k ] = E2Ddata.node[in].x - E2Ddata.node[i].x;
+         ndy[ E2Ddata.nghbr_ptr[i] + k ] = E2Ddata.node[in].y - E2Ddata.node[i].y;
 
 
       }//    end loop nghbr
@@ -950,21 +3300,21 @@ void EulerSolver2D::Solver::lsq02_5x5_coeff2_nc(
       //nghbr2 loop k ,E2Ddata.node[i].nnghbrs
       for (size_t k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
 
-         in = (*E2Ddata.node[i].nghbr)(k);
+         in = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[i] + k ];
 
          //nghbr_nghbr : do ell = 1, E2Ddata.node[in].nnghbrs
          for (size_t ell = 0; ell < E2Ddata.node[in].nnghbrs; ell++) {
 
-            dx = E2Ddata.node[in].x - E2Ddata.node[i].x + (*E2Ddata.node[in].dx)(ell);
-            dy = E2Ddata.node[in].y - E2Ddata.node[i].y + (*E2Ddata.node[in].dy)(ell);
+            dx = E2Ddata.node[in].x - E2Ddata.node[i].x + ndx[ E2Ddata.nghbr_ptr[in] + ell ];
+            dy = E2Ddata.node[in].y - E2Ddata.node[i].y + ndy[ E2Ddata.nghbr_ptr[in] + ell ];
 
-            if ( (*E2Ddata.node[in].nghbr)(ell) == i ) {
+            if ( E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[in] + ell ] == int(i) ) {
                
                dx = E2Ddata.node[in].x - E2Ddata.node[i].x;
                dy = E2Ddata.node[in].y - E2Ddata.node[i].y;
                if (i < E2Ddata.maxit-1 & ell < E2Ddata.maxit-1) {
-                  cout << " --------------E2Ddata.node[in].nghbr)(ell) == i " << endl;
-                  cout << " (*E2Ddata.node[in].nghbr)(ell) = " << (*E2Ddata.node[in].nghbr)(ell) << " i = " << i << endl;
+                  cout << " --------------nghbr_idx[ nghbr_ptr[in] + ell ] == i " << endl;
+                  cout << " E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[in] + ell ] = " << E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[in] + ell ] << " i = " << i << endl;
                   cout << " dx = " << dx << endl;
                   cout << " dy = " << dy << endl;
                   cout << "  "<< endl;
@@ -1113,19 +3463,19 @@ void EulerSolver2D::Solver::lsq02_5x5_coeff2_nc(
 
       //  Now compute the coefficients for neighbors.
 
-      ii = -1;
+      ii = E2Ddata.lsq5x5_ptr[i] - 1;
 
       //nghbr3 : do k = 1, E2Ddata.node[i].nnghbrs
       for (size_t k = 0; k < E2Ddata.node[i].nnghbrs; k++) {
-         in = (*E2Ddata.node[i].nghbr)(k);
+         in = E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[i] + k ];
 
          //nghbr_nghbr2 : do ell = 1, E2Ddata.node[in].nnghbrs
          for (size_t ell = 0; ell < E2Ddata.node[in].nnghbrs; ell++) {
 
-            dx = E2Ddata.node[in].x - E2Ddata.node[i].x + (*E2Ddata.node[in].dx)(ell);
-            dy = E2Ddata.node[in].y - E2Ddata.node[i].y + (*E2Ddata.node[in].dy)(ell);
+            dx = E2Ddata.node[in].x - E2Ddata.node[i].x + ndx[ E2Ddata.nghbr_ptr[in] + ell ];
+            dy = E2Ddata.node[in].y - E2Ddata.node[i].y + ndy[ E2Ddata.nghbr_ptr[in] + ell ];
 
-            if ( (*E2Ddata.node[in].nghbr)(ell) == i )  {
+            if ( E2Ddata.nghbr_idx[ E2Ddata.nghbr_ptr[in] + ell ] == int(i) )  {
                dx = E2Ddata.node[in].x - E2Ddata.node[i].x;
                dy = E2Ddata.node[in].y - E2Ddata.node[i].y;
             }
@@ -1139,13 +3489,13 @@ void EulerSolver2D::Solver::lsq02_5x5_coeff2_nc(
 
  //  Multiply the inverse LSQ matrix to get the coefficients: cx(:) and cy(:):
 
-            (*E2Ddata.node[i].lsq5x5_cx)(ii)  =   ainv(ix,0)*w2*dx  \
+            E2Ddata.lsq5x5_cx[ii]  =   ainv(ix,0)*w2*dx  \
                                                 + ainv(ix,1)*w2*dy             \
                                                 + ainv(ix,2)*w2*dx*dx * half   \
                                                 + ainv(ix,3)*w2*dx*dy          \
                                                 + ainv(ix,4)*w2*dy*dy * half;
 
-            (*E2Ddata.node[i].lsq5x5_cy)(ii)  =   ainv(iy,0)*w2*dx  \
+            E2Ddata.lsq5x5_cy[ii]  =   ainv(iy,0)*w2*dx  \
                                                 + ainv(iy,1)*w2*dy             \
                                                 + ainv(iy,2)*w2*dx*dx * half   \
                                                 + ainv(iy,3)*w2*dx*dy          \
@@ -1179,11 +3529,11 @@ real EulerSolver2D::Solver::lsq_weight(
    //Local
    real distance;
 
-   if (trim(E2Ddata.gradient_weight) == "none") {
+   if (E2Ddata.gradient_weight_id == GradientWeight::none) {
 
       lsq_weight = one;
    }
-   else if (trim(E2Ddata.gradient_weight) == "inverse_distance") {
+   else if (E2Ddata.gradient_weight_id == GradientWeight::inverse_distance) {
 
       // cout << "INVERSE DISTANCE  = " << endl;
       // std::exit(0);
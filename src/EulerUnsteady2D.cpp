@@ -170,6 +170,11 @@
 //=================================
 #include <cstring> //needed for memset
 #include <string.h>
+#include <memory>       // std::unique_ptr (grid kept across cases)
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
 
 //======================================
 // my simple array class template (type)
@@ -185,6 +190,7 @@
 // 2D Eiuler approximate Riemann sovler
 #include "EulerUnsteady2D.h"
 #include "EulerUnsteady2D_basic_package.h"
+#include "CaseFile.h"
 
 //======================================
 //using namespace std;
@@ -252,87 +258,390 @@ EulerSolver2D::MainData2D::~MainData2D() {
 // // End of program
 // //********************************************************************************
 
-//namespace EulerSolver2D{
-void program_2D_euler_rk2(){
+//********************************************************************************
+//* Parameters of a 2D case (see CaseFile.h), with their default values:
+//*
+//*   grid = project.grid, bcmap = project.bcmap, node_ordering = none (or rcm, morton)
+//*   CFL = 0.95, t_final = 0.18, time_step_max = 5000, gamma = 1.4
+//*   inviscid_flux = rhll (or roe, roe_einfeldt), limiter_type = vanalbada,
+//*   residual_assembly = coloring
+//*   tile_size = 1024 (residual_assembly = tiled: nodes per tile)
+//*   gradient_type = linear, gradient_weight = none, gradient_weight_p = 1
+//*   time_stepping = global ("local": steady mode, local time steps until the
+//*                   residual norms drop by residual_tolerance = 1e-6, first
+//*                   order only: gradient_type = none on the shock diffraction
+//*                   case, and a smooth Rotated-RHLL flux; history
+//*                   of the norms in history_file = log/history.dat, or
+//*                   log/history_<n>.dat for case n of a queue; "implicit":
+//*                   the same with backward Euler, CFL from CFL_start = 10 up
+//*                   to CFL, linear_solver = umfpack if built with -DCFD_UMFPACK,
+//*                   else gs, with linear_sweeps = 10, linear_tolerance = 0.1;
+//*                   or gmres (Newton-Krylov), with gmres_restart = 30,
+//*                   gmres_iterations = 60, preconditioner = jacobian
+//*                   (or block_jacobi), preconditioner_sweeps = 2)
+//*   multigrid_levels = 1 (time_stepping = local: FAS agglomeration multigrid
+//*                   with this many levels, 1 = off), multigrid_cycle = v (or w)
+//*   check_lsq = true (check_lsq_coeff_nc when the LSQ coefficients are built)
+//*   solution_file = project.vtu (project_<n>.vtu for case n of a queue;
+//*                   "none" = no solution file)
+//*   vtu_compression = 1 (zlib level of the .vtu files, 0 = none)
+//*   snapshot_steps = 0, snapshot_dt = 0 (snapshots every N steps / every dt, 0 = off)
+//*   snapshot_prefix = project_snapshot (project_<n>_snapshot for case n of a queue)
+//*   checkpoint_steps = 0 (checkpoints every N steps and at the end, 0 = off)
+//*   checkpoint_file = project.ckp (project_<n>.ckp for case n of a queue)
+//*   restart = false (start from checkpoint_file)
+//*   grid_cache = none (checkpoint_file.topo if checkpoint_steps > 0 or restart):
+//*             file of the grid data and LSQ coefficients; they are read from it
+//*             instead of being built if it matches the grid (and the weight),
+//*             and it is written otherwise
+//*   ranks = 1 (of the first case, see Halo.h; the mpirun ranks if built with
+//*             MPI): the explicit schemes run on that many subdomains of the
+//*             grid, made by partitioner = rcb (or metis, see Partition.h),
+//*             and the solution is gathered on rank 0 for the output
+//********************************************************************************
+namespace {
+
+const std::vector<std::string> case_keys_2d = {
+   "solver", "grid", "bcmap", "node_ordering",
+   "CFL", "t_final", "time_step_max", "gamma",
+   "inviscid_flux", "limiter_type", "residual_assembly", "tile_size",
+   "gradient_type", "gradient_weight", "gradient_weight_p",
+   "time_stepping", "residual_tolerance", "history_file",
+   "CFL_start", "linear_solver", "linear_sweeps", "linear_tolerance",
+   "gmres_restart", "gmres_iterations", "preconditioner", "preconditioner_sweeps",
+   "multigrid_levels", "multigrid_cycle",
+   "check_lsq", "solution_file", "vtu_compression",
+   "snapshot_steps", "snapshot_dt", "snapshot_prefix",
+   "checkpoint_steps", "checkpoint_file", "restart", "grid_cache",
+   "ranks", "partitioner" };
+
+
+
+//********************************************************************************
+//* The parameters of case icase (of ncases) -> E2Ddata (see the list above).
+//********************************************************************************
+void read_case_parameters(EulerSolver2D::MainData2D& E2Ddata, const CaseFile::Case& c,
+                          size_t icase, size_t ncases) {
+
+                E2Ddata.M_inf  = 0.0;        // Freestream Mach number to be set in the function
+                                             //    -> "initial_solution_shock_diffraction"
+                                             //    (Specify M_inf here for other problems.)
+                E2Ddata.gamma = c.get_real("gamma", 1.4);          // Ratio of specific heats
+                  E2Ddata.CFL = c.get_real("CFL", 0.95);           // CFL number
+              E2Ddata.t_final = c.get_real("t_final", 0.18);       // Final time to stop the calculation.
+        E2Ddata.time_step_max = c.get_int("time_step_max", 5000);  // Max time steps (just a big enough number)
+        E2Ddata.inviscid_flux = c.get("inviscid_flux", "rhll");    // = Rotated-RHLL      , "roe"  = Roe flux, "roe_einfeldt"
+         E2Ddata.limiter_type = c.get("limiter_type", "vanalbada"); // = Van Albada limiter, "none" = No limiter
+    E2Ddata.residual_assembly = c.get("residual_assembly", "coloring"); // threaded edge loop: "coloring", "owner", "serial" or "tiled"
+            E2Ddata.tile_size = c.get_int("tile_size", 1024);  // tiled: nodes per tile
+    E2Ddata.gradient_type     = c.get("gradient_type", "linear"); // or "quadratic2 for a quadratic LSQ.
+    E2Ddata.gradient_weight   = c.get("gradient_weight", "none"); // or "inverse_distance"
+    E2Ddata.gradient_weight_p = c.get_real("gradient_weight_p", EulerSolver2D::one); // or any other real value
+    E2Ddata.time_stepping     = c.get("time_stepping", "global"); // or "local" for a steady solution
+   E2Ddata.residual_tolerance = c.get_real("residual_tolerance", 1.0e-6); // steady: stop at this drop
+         E2Ddata.history_file = c.get("history_file",
+       (ncases == 1) ? "log/history.dat" : "log/history_" + std::to_string(icase+1) + ".dat");
+            E2Ddata.CFL_start = c.get_real("CFL_start", 10.0);      // implicit: first CFL number
+        E2Ddata.linear_solver = c.get("linear_solver",             // implicit: "umfpack", "gs" or "gmres"
+                                      SparseBlock::direct_available() ? "umfpack" : "gs");
+        E2Ddata.linear_sweeps = c.get_int("linear_sweeps", 10);
+     E2Ddata.linear_tolerance = c.get_real("linear_tolerance", 0.1);
+        E2Ddata.gmres_restart = c.get_int("gmres_restart", 30);
+     E2Ddata.gmres_iterations = c.get_int("gmres_iterations", 60);
+       E2Ddata.preconditioner = c.get("preconditioner", "jacobian"); // gmres: or "block_jacobi"
+E2Ddata.preconditioner_sweeps = c.get_int("preconditioner_sweeps", 2);
+     E2Ddata.multigrid_levels = c.get_int("multigrid_levels", 1);    // local: 1 = no multigrid
+      E2Ddata.multigrid_cycle = c.get("multigrid_cycle", "v");       // or "w"
+
+   // Output: snapshots during the run, and the final solution (step (7)).
+    E2Ddata.vtu_compression = c.get_int("vtu_compression", 1);
+     E2Ddata.snapshot_steps = c.get_int("snapshot_steps", 0);
+        E2Ddata.snapshot_dt = c.get_real("snapshot_dt", EulerSolver2D::zero);
+    E2Ddata.snapshot_prefix = c.get("snapshot_prefix",
+       (ncases == 1) ? "project_snapshot" : "project_" + std::to_string(icase+1) + "_snapshot");
+
+} // end read_case_parameters
+
+
+
+//********************************************************************************
+//* Several ranks: the subdomain of this rank of the grid (after the LSQ
+//* coefficients), ready for the solver, with the parameters of case icase.
+//* Rank 0 holds the grid: it partitions it, and sends each rank its subdomain
+//* (MainData2D::pack_subdomain, Halo::scatter). The grid is empty on the other
+//* ranks, which hold their subdomain only.
+//********************************************************************************
+std::unique_ptr<EulerSolver2D::MainData2D> decompose(const EulerSolver2D::MainData2D& grid,
+                                                    const CaseFile::Case& c,
+                                                    size_t icase, size_t ncases) {
+
+   const int nranks = Halo::size();
+   const std::string partitioner = c.get("partitioner", "rcb");
+
+   if (partitioner != "rcb" && partitioner != "metis") {
+      cout << " Invalid input for partitioner = " << partitioner << " \n";
+      cout << " Choose rcb or metis, and try again. \n";
+      std::exit(0); //stop
+   }
+
+   //  Rank 0: the subdomains of all the ranks, packed.
+   std::vector< std::vector<char> > packed;
+   if (Halo::rank() == 0) {
+
+      std::vector<int> part;
+      if (partitioner == "rcb") {
+         std::vector<double> x(grid.nnodes), y(grid.nnodes);
+         for (int i = 0; i < grid.nnodes; i++) { x[i] = grid.node[i].x; y[i] = grid.node[i].y; }
+         Partition::rcb(x, y, nranks, part);
+      } else {
+         Partition::metis(grid.nghbr_ptr, grid.nghbr_idx, nranks, part);
+      }
+
+      packed.resize(nranks);
+      for (int r = 0; r < nranks; r++) {
+         Partition::Subdomain s;
+         Partition::subdomain(part, nranks, grid.nghbr_ptr, grid.nghbr_idx, r, s);
+         packed[r] = grid.pack_subdomain(s);
+      }
+   }
+
+   std::vector<char> mine;
+   Halo::scatter(packed, mine);
+   packed.clear();
+
+   std::unique_ptr<EulerSolver2D::MainData2D> data(new EulerSolver2D::MainData2D);
+   EulerSolver2D::MainData2D& E2Ddata = *data;
+   E2Ddata.unpack_subdomain(mine);
+   const Partition::Subdomain& sub = E2Ddata.sub;
+   read_case_parameters(E2Ddata, c, icase, ncases);
+   E2Ddata.set_scheme_options();
+   E2Ddata.field.allocate(E2Ddata.nnodes, E2Ddata.nq);
+   E2Ddata.halo.setup(E2Ddata.sub, 2*E2Ddata.nq);   // w, or the gradients of w
+
+   const int nghosts = int(sub.global.size()) - sub.nowned;
+   double owned_min = sub.nowned, owned_max = sub.nowned, ghosts = nghosts;
+   Halo::min(&owned_min, 1);
+   Halo::max(&owned_max, 1);
+   Halo::sum(&ghosts, 1);
+   cout << " Domain decomposition: " << nranks << " ranks (" << Halo::backend()
+        << "), partitioner = " << partitioner << "\n";
+   cout << "   owned nodes per rank = " << owned_min << " ... " << owned_max
+        << ", ghost nodes = " << ghosts << "\n";
+   cout << "   rank " << Halo::rank() << ": owned nodes = " << sub.nowned << ", ghosts = " << nghosts
+        << ", edges = " << E2Ddata.nedges << ", neighboring ranks = " << sub.nbr.size() << "\n";
+
+   return data;
+
+} // end decompose
+
+} // end anonymous namespace
+
+
+
+//********************************************************************************
+//* Run a queue of 2D cases in one process.
+//*
+//* The grid (read_grid, renumber_nodes, construct_grid_data, edge coloring) is
+//* kept from one case to the next as long as grid, bcmap and node_ordering do
+//* not change, and the LSQ coefficients as long as the gradient weight does not
+//* change. Only the solution is set up again for each case.
+//********************************************************************************
+void program_2D_euler_rk2(const std::vector<CaseFile::Case>& cases){
    // procedural fortran ends up in this function
-   int i;
 
    // euler solver 2D:
    EulerSolver2D::Solver E2Dsolver;
 
-   //Set file names, Inout data files
-   std::string  datafile_grid_in  = "project.grid";  //Grid file
-   std::string  datafile_bcmap_in = "project.bcmap"; //Boundary condition file
-   std::string  datafile_tec      = "project_tecplot.dat";  //Tecplot file for viewing the result.
+   // euler main data, kept across the cases that share the grid:
+   std::unique_ptr<EulerSolver2D::MainData2D> data;
+   std::string grid_key, lsq_key;
+   std::set<std::string> cache_written;      //grid cache files (and LSQ keys) of the current grid
+   std::vector<std::string> summary;
+
+   for (size_t icase = 0; icase < cases.size(); icase++) {
 
+   const CaseFile::Case& c = cases[icase];
+   c.check_keys(case_keys_2d);
+
+   cout << "\n";
+   cout << "---------------------------------------------------------\n";
+   cout << " Case " << icase+1 << " of " << cases.size() << ": " << c.name << "\n";
+   cout << "---------------------------------------------------------\n";
+
+   //Set file names, Inout data files
+   std::string  datafile_grid_in  = c.get("grid",  "project.grid");  //Grid file
+   std::string  datafile_bcmap_in = c.get("bcmap", "project.bcmap"); //Boundary condition file
+   std::string  node_ordering     = c.get("node_ordering", "none");
+
+   // Checkpoints, and restart from the last one (see MainData2D::write_checkpoint)
+   const std::string checkpoint_file = c.get("checkpoint_file",
+      (cases.size() == 1) ? "project.ckp" : "project_" + std::to_string(icase+1) + ".ckp");
+   const int  checkpoint_steps       = c.get_int("checkpoint_steps", 0);
+   const bool restart                = c.get_bool("restart", false);
+
+   // Grid cache file (see MainData2D::write_grid_cache): on by default next to
+   // the checkpoints, so that a restart does not build the grid data again.
+   const std::string grid_cache = c.get("grid_cache",
+      (checkpoint_steps > 0 || restart) ? checkpoint_file + ".topo" : "none");
+   const bool use_cache = (grid_cache != "none");
+   bool grid_from_cache = false;
 
 //--------------------------------------------------------------------------------
-// Input Parameters
+// (1)-(3) Grid: read, renumber, construct and check, unless the previous case
+//         used the same one. Several ranks: on rank 0 only; the others get
+//         their subdomains from it in (4.5), and their grid stays empty.
 
-   // euler main data:
-   //typedef EulerSolver2D::EulerSolver2D 2Ddata;
-   EulerSolver2D::MainData2D E2Ddata;
-   //2Ddata = new EulerSolver2D();
+   const std::string new_grid_key = datafile_grid_in + "|" + datafile_bcmap_in + "|" + node_ordering;
+
+   if ( !data || new_grid_key != grid_key ) {
+
+      data.reset(new EulerSolver2D::MainData2D);
+      EulerSolver2D::MainData2D& E2Ddata = *data;
+      grid_key = new_grid_key;
+      lsq_key.clear();
+      cache_written.clear();
 
-                E2Ddata.M_inf  = 0.0;        // Freestream Mach number to be set in the function
-                                             //    -> "initial_solution_shock_diffraction"
-                                             //    (Specify M_inf here for other problems.)
-                E2Ddata.gamma = 1.4;         // Ratio of specific heats
-                  E2Ddata.CFL = 0.95;        // CFL number
-              E2Ddata.t_final = 0.18;        // Final time to stop the calculation.
-        E2Ddata.time_step_max = 5000;        // Max time steps (just a big enough number)
-        E2Ddata.inviscid_flux = "rhll";      // = Rotated-RHLL      , "roe"  = Roe flux
-         E2Ddata.limiter_type = "vanalbada"; // = Van Albada limiter, "none" = No limiter
                    E2Ddata.nq = 4;           // The number of equtaions/variables in the target equtaion.
-    E2Ddata.gradient_type     = "linear";    // or "quadratic2 for a quadratic LSQ.
-    E2Ddata.gradient_weight   = "none";      // or "inverse_distance"
-    E2Ddata.gradient_weight_p =  EulerSolver2D::one;  // or any other real value
+        E2Ddata.node_ordering = node_ordering; // node renumbering: "rcm", "morton" or "none" (file order)
+
+      if (Halo::rank() == 0) {
+
+// (1) Read grid files
+      E2Ddata.read_grid(datafile_grid_in, datafile_bcmap_in);
+
+// (1.5) Renumber the nodes for memory locality (optional)
+      E2Ddata.renumber_nodes(E2Ddata.node_ordering);
+
+// (2)-(3) Read the grid data from the grid cache, if it is there and made for
+//         this grid. Otherwise:
+      grid_from_cache = use_cache && E2Ddata.read_grid_cache(grid_cache);
+      if ( !grid_from_cache ) {
+
+// (2) Construct grid data
+      E2Ddata.construct_grid_data();
+
+// (3) Check the grid data (It is always good to check them before use//)
+      E2Ddata.check_grid_data();
+
+      }
+
+      E2Ddata.write_tecplot_file(E2Ddata.datafile_tria_tec);
+      E2Ddata.write_grid_file(E2Ddata.datafile_tria);
+
+      }
+
+   } else {
+      cout << " Reusing the grid of the previous case: " << datafile_grid_in << "\n";
+   }
+
+   EulerSolver2D::MainData2D& E2Ddata = *data;
+
+   E2Ddata.checkpoint_file  = checkpoint_file;
+   E2Ddata.checkpoint_steps = checkpoint_steps;
+   E2Ddata.restart          = restart;
+
 //--------------------------------------------------------------------------------
-// Solve the Euler equations and write the output datafile.
-//
-// // (1) Read grid files
-   E2Ddata.read_grid(datafile_grid_in, datafile_bcmap_in);
+// Input Parameters
+
+   read_case_parameters(E2Ddata, c, icase, cases.size());
+   if (E2Ddata.vtu_compression > 0 && !SolutionWriter::zlib_available()) {
+      cout << " Built without -DCFD_ZLIB: the .vtu files are not compressed.\n";
+   }
+
+   // Parse the string options above into enums, once.
+   E2Ddata.set_scheme_options();
 
    std::cout << "Allocate arrays" << std::endl;
    std::cout << "there are " << E2Ddata.nnodes << " nodes " << std::endl;
 
-   for (size_t i = 0; i < E2Ddata.nnodes; i++) {
-   
-      E2Ddata.node[i].u     = new Array2D<real>(E2Ddata.nq,1);
-      E2Ddata.node[i].du    = new Array2D<real>(E2Ddata.nq,1);
-      E2Ddata.node[i].w     = new Array2D<real>(E2Ddata.nq,1);
-      E2Ddata.node[i].gradw = new Array2D<real>(E2Ddata.nq,2); //<- 2: x and y components.
-      E2Ddata.node[i].res   = new Array2D<real>(E2Ddata.nq,1);
-   }
+   // u, du, w, gradw(x and y components), res, dt, ... for all nodes at once
+   // (zeroed, also when the grid is reused).
+   E2Ddata.field.allocate(E2Ddata.nnodes, E2Ddata.nq);
 
    std::cout << "E2Ddata.nq, = " << E2Ddata.nq << std::endl;
-// (2) Construct grid data
-   E2Ddata.construct_grid_data();
-
-// (3) Check the grid data (It is always good to check them before use//)
-   E2Ddata.check_grid_data();
    cout << "now in program_2D_euler_rk2" << endl;
 
-   E2Ddata.write_tecplot_file(E2Ddata.datafile_tria_tec);
-   E2Ddata.write_grid_file(E2Ddata.datafile_tria);
-// (4) Prepare LSQ gradients
-   E2Dsolver.compute_lsq_coeff_nc(E2Ddata);
-   E2Dsolver.check_lsq_coeff_nc(E2Ddata);
+// (4) Prepare LSQ gradients (they depend on the grid and the weight only)
+   std::ostringstream new_lsq_key;
+   new_lsq_key << E2Ddata.gradient_weight << "|" << std::setprecision(17) << E2Ddata.gradient_weight_p;
+
+   bool lsq_from_cache = false;
+   if ( Halo::rank() != 0 ) {
+      // (no grid: the subdomain of this rank comes with its coefficients)
+   } else if ( new_lsq_key.str() != lsq_key ) {
+      lsq_from_cache = use_cache && E2Ddata.read_lsq_cache(grid_cache);
+      if ( !lsq_from_cache ) {
+         E2Dsolver.compute_lsq_coeff_nc(E2Ddata);
+         if ( c.get_bool("check_lsq", true) ) E2Dsolver.check_lsq_coeff_nc(E2Ddata);
+      }
+      lsq_key = new_lsq_key.str();
+   } else {
+      cout << " Reusing the LSQ coefficients of the previous case\n";
+   }
+
+   // Save the grid data and the LSQ coefficients for the next run, unless they
+   // came from the cache (once per grid, file and weight).
+   const std::string cache_entry = grid_cache + "|" + lsq_key;
+   if (use_cache && !(grid_from_cache && lsq_from_cache) && cache_written.count(cache_entry) == 0
+       && Halo::rank() == 0) {
+      E2Ddata.write_grid_cache(grid_cache);
+      cout << " Grid data and LSQ coefficients -> " << grid_cache << "\n";
+   }
+   if (use_cache) cache_written.insert(cache_entry);
+
+// (4.5) Several ranks: each one solves on its subdomain of the grid, and the
+//       solution is gathered on rank 0 at the end.
+   std::unique_ptr<EulerSolver2D::MainData2D> subdomain;
+   if (Halo::size() > 1) subdomain = decompose(E2Ddata, c, icase, cases.size());
+   EulerSolver2D::MainData2D& S = subdomain ? *subdomain : E2Ddata;
 
 // (5) Set initial solution for a shock diffraction problem
 //     (Re-write or replace it by your own subroutine for other problems.)
-   E2Dsolver.initial_solution_shock_diffraction(E2Ddata);
+   E2Dsolver.initial_solution_shock_diffraction(S);
 
 // (6) Compute the solution (March in time to the final time)
-   E2Dsolver.euler_solver_main(E2Ddata);
+//     A case that stops on a non-physical state does not stop the queue.
+   const bool ok = E2Dsolver.euler_solver_main(S);
+   summary.push_back( c.name + (ok ? " : done" : " : stopped (non-physical state)") );
+
+   if (subdomain) {
+      S.halo.gather(S.field.u.data(), S.nq, E2Ddata.field.u.data());
+      S.halo.gather(S.field.w.data(), S.nq, E2Ddata.field.w.data());
+      E2Ddata.M_inf = S.M_inf;
+      E2Ddata.time  = S.time;
+   }
+
+// (7) Write out the solution at nodes (VTK binary, on the I/O thread: the next
+//     case starts while the file is written).
+   const std::string default_solution_file =
+      (cases.size() == 1) ? "project.vtu" : "project_" + std::to_string(icase+1) + ".vtu";
+   E2Ddata.datafile_solution = c.get("solution_file", default_solution_file);
+   if (E2Ddata.datafile_solution != "none" && Halo::rank() == 0) {
+      E2Ddata.write_vtu_file(E2Ddata.datafile_solution, E2Ddata.time);
+      cout << " Solution at t = " << E2Ddata.time << " -> " << E2Ddata.datafile_solution << "\n";
+   }
 
-// // (7) Write out the tecplot data file (Solutions at nodes)
-//       write_tecplot_file(datafile_tec);
+   } // end loop cases
+
+   if (cases.size() > 1) {
+      cout << "\n Cases:\n";
+      for (size_t icase = 0; icase < summary.size(); icase++) {
+         cout << "   " << icase+1 << ". " << summary[icase] << "\n";
+      }
+      cout << "\n";
+   }
 
 }
 
 void EulerSolver2D::driverEuler2D(){
-    program_2D_euler_rk2();
+    std::vector<CaseFile::Case> cases(1);   // one case, default parameters
+    cases[0].name = "default";
+    program_2D_euler_rk2(cases);
+    return;
+}
+
+void EulerSolver2D::driverEuler2D(const std::vector<CaseFile::Case>& cases){
+    program_2D_euler_rk2(cases);
     //solver.output();
     return;
 }
@@ -69,6 +69,21 @@
 // line based parsing, including streams
 #include <sstream>
 #include <string>
+#include <algorithm>    // sort
+#include <queue>
+#include <unordered_map> // element sides -> edges
+#include <cstring>      // memcpy, memcmp
+#include <cstdio>       // snprintf
+
+//======================================
+// memory-mapped grid files
+#if defined(__unix__) || defined(__APPLE__)
+#define CFD_HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 //======================================
 // mesh-y math-y functions
@@ -77,6 +92,7 @@
 //======================================
 // string trimfunctions
 #include "StringOps.h" 
+#include "../include/Checkpoint.h"
 
 using std::cout;
 using std::endl;
@@ -250,6 +266,71 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
 
    //--------------------------------------------------------------------------------
    // 1. Read grid file>: datafile_grid_in
+   //    (ASCII, or the binary format written by write_grid_binary, which is
+   //     detected from its magic number and memory-mapped)
+
+   std::string line;
+
+   if ( is_binary_grid(datafile_grid_in) ) {
+      read_grid_binary(datafile_grid_in);
+   } else {
+      read_grid_ascii(datafile_grid_in);
+   }
+
+   // End of Read grid file>: datafile_grid_in
+   //--------------------------------------------------------------------------------
+
+   //--------------------------------------------------------------------------------
+   // 2. Read the boundary condition data file
+
+   std::cout << "" << std::endl;
+   std::cout << "Reading the boundary condition file...." << datafile_bcmap_in << std::endl;
+   std::cout << "" << std::endl;
+
+   // // Open the input file.
+   std::ifstream outfile;
+   outfile.open (datafile_bcmap_in);
+
+   std::getline(outfile, line);
+
+   // READ: Read the boundary condition type
+   for (size_t i = 0; i < nbound; i++) {
+      std::getline(outfile, line);
+      std::istringstream in(line);
+      in >> dummy_int >> bound[i].bc_type;
+      bound[i].bc = parse_bc_type(bound[i].bc_type);
+   }
+
+   //  The corner node of the shock diffraction problem: the first node of
+   //  boundary 1 (see eliminate_normal_mass_flux).
+   if (nbound > 1) bound[1].corner = 0;
+
+   //  Print the data
+   std::cout << " Boundary conditions:" << std::endl;
+   for (size_t i = 0; i < nbound; i++) {
+      std::cout << " boundary" << i << "  bc_type = " << bound[i].bc_type << std::endl;
+   }
+
+   std::cout << "" << std::endl;
+
+   // close(2)
+   outfile.close(); // close datafile_bcmap_in
+
+   // End of Read the boundary condition data file
+   //--------------------------------------------------------------------------------
+   return;
+
+ } // end function read_grid
+
+
+
+//********************************************************************************
+//* Read the ASCII grid file (format described above read_grid).
+//********************************************************************************
+void EulerSolver2D::MainData2D::read_grid_ascii(const std::string& datafile_grid_in)
+{
+   //--------------------------------------------------------------------------------
+   // 1. Read grid file>: datafile_grid_in (ASCII)
 
    cout << "Reading the grid file...." << datafile_grid_in << endl;
 
@@ -280,6 +361,13 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
    //std::cout << "    for " << nelms << " elements " << std::endl;
    elm = new elm_type[nelms];
 
+   // Element vertices (CSR): element i has e2v[ e2v_ptr[i] ... e2v_ptr[i+1]-1 ],
+   // triangles first, then quads.
+   e2v_ptr.resize(nelms+1);
+   e2v_ptr[0] = 0;
+   for (int i = 0; i < nelms; i++) e2v_ptr[i+1] = e2v_ptr[i] + (i < ntria ? 3 : 4);
+   e2v.assign(e2v_ptr[nelms], -1);
+
 
    // // READ: Read the nodal coordinates
    cout << "reading nodal coords" << endl;
@@ -320,7 +408,6 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
          std::getline(infile, line);
          std::istringstream in(line);
          elm[i].nvtx = 3;
-         elm[i].vtx = new Array2D<int>(3,1);
 
          //std::string type;
          //in >> type;                  //and read the first whitespace-separated token
@@ -329,17 +416,16 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
          int x, y, z;
          in >> x >> y >> z;       //now read the whitespace-separated ints
          // Fix indices for 0 indexed code//
-         (*elm[i].vtx)(0) = x-1;
-         (*elm[i].vtx)(1) = y-1;
-         (*elm[i].vtx)(2) = z-1;
-         //cout << (*elm[i].vtx).ncols << endl;
+         e2v[ e2v_ptr[i] ] = x-1;
+         e2v[ e2v_ptr[i] + 1 ] = y-1;
+         e2v[ e2v_ptr[i] + 2 ] = z-1;
          
-         // if (i<20) cout << "\nInput = " << (*elm[i].vtx)(0) <<
-         //                                 "  " << (*elm[i].vtx)(1) << 
-         //                                 "  " << (*elm[i].vtx)(2) ;
-         // if (i>ntria-20) cout << "\nInput = " << (*elm[i].vtx)(0) <<
-         //                                 "  " << (*elm[i].vtx)(1) << 
-         //                                 "  " << (*elm[i].vtx)(2) ;
+         // if (i<20) cout << "\nInput = " << e2v[ e2v_ptr[i] ] <<
+         //                                 "  " << e2v[ e2v_ptr[i] + 1 ] << 
+         //                                 "  " << e2v[ e2v_ptr[i] + 2 ] ;
+         // if (i>ntria-20) cout << "\nInput = " << e2v[ e2v_ptr[i] ] <<
+         //                                 "  " << e2v[ e2v_ptr[i] + 1 ] << 
+         //                                 "  " << e2v[ e2v_ptr[i] + 2 ] ;
                
       }
    }
@@ -360,18 +446,17 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
          std::getline(infile, line);
          std::istringstream in(line);
          elm[ntria+i].nvtx = 4;
-         elm[ntria+i].vtx = new Array2D<int>(4,1);
 
          int x1,x2,x3,x4;
          in >> x1 >> x2 >> x3 >> x4;       //now read the whitespace-separated ...ints
          // Fix indices for 0 indexed code//
-         (*elm[ntria+i-1].vtx)(0) = x1-1;
-         (*elm[ntria+i-1].vtx)(1) = x2-1;
-         (*elm[ntria+i-1].vtx)(2) = x3-1;
-         (*elm[ntria+i-1].vtx)(3) = x4-1;
+         e2v[ e2v_ptr[ntria+i] ] = x1-1;
+         e2v[ e2v_ptr[ntria+i] + 1 ] = x2-1;
+         e2v[ e2v_ptr[ntria+i] + 2 ] = x3-1;
+         e2v[ e2v_ptr[ntria+i] + 3 ] = x4-1;
          // if (i<20) cout << "\nx, y, z = " << x1 <<"  " << x2 << "  " << x3 << x4;
-         // if (i<20) cout << "\nelm x, elm y, elm z = " << (*elm[i].vtx)(0,0) <<"  " << (*elm[i].vtx)(1,0) << "  " << (*elm[i].vtx)(2,0)<< "  " << (*elm[i].vtx)(3,0);
-         // if (i<20) cout << "\nelm x, elm y, elm z = " << (*elm[i].vtx)(0) <<"  " << (*elm[i].vtx)(1) << "  " << (*elm[i].vtx)(2) << "  " << (*elm[i].vtx)(3);
+         // if (i<20) cout << "\nelm x, elm y, elm z = " << e2v[ e2v_ptr[i] ] <<"  " << e2v[ e2v_ptr[i] + 1 ] << "  " << e2v[ e2v_ptr[i] + 2 ]<< "  " << e2v[ e2v_ptr[i] + 3 ];
+         // if (i<20) cout << "\nelm x, elm y, elm z = " << e2v[ e2v_ptr[i] ] <<"  " << e2v[ e2v_ptr[i] + 1 ] << "  " << e2v[ e2v_ptr[i] + 2 ] << "  " << e2v[ e2v_ptr[i] + 3 ];
       }
    }
    else{
@@ -450,43 +535,220 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
    // End of Read grid file>: datafile_grid_in
    //--------------------------------------------------------------------------------
 
-   //--------------------------------------------------------------------------------
-   // 2. Read the boundary condition data file
+ } // end function read_grid_ascii
 
-   std::cout << "" << std::endl;
-   std::cout << "Reading the boundary condition file...." << datafile_bcmap_in << std::endl;
-   std::cout << "" << std::endl;
 
-   // // Open the input file.
-   std::ifstream outfile;
-   outfile.open (datafile_bcmap_in);
 
-   std::getline(outfile, line);
+//********************************************************************************
+//* Binary grid file
+//*
+//* Same data as the ASCII file, in contiguous blocks (native byte order):
+//*
+//*   GridBinaryHeader             : magic "EDU2DGRD", nnodes, ntria, nquad, nbound
+//*   double  xy[2*nnodes]         : x0 y0 x1 y1 ...
+//*   int32   tria[3*ntria]        : vertices, 0-based
+//*   int32   quad[4*nquad]        : vertices, 0-based
+//*   int32   nbnodes[nbound]      : number of nodes in each boundary segment
+//*   int32   bnode[sum(nbnodes)]  : boundary nodes, 0-based, segment after segment
+//*
+//* The file is memory-mapped and the blocks are copied straight into the node,
+//* element and boundary arrays: no text parsing, one pass over the data.
+//* Write one with write_grid_binary (e.g., run/grid2bin).
+//********************************************************************************
 
-   // READ: Read the boundary condition type
-   for (size_t i = 0; i < nbound; i++) {
-      std::getline(outfile, line);
-      std::istringstream in(line);
-      in >> dummy_int >> bound[i].bc_type;
+namespace {
+
+// Read-only view of a whole file: mmap where available, else read into memory.
+class MappedFile {
+  public:
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(const std::string& filename) {
+#ifdef CFD_HAVE_MMAP
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0) return;
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+         void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p != MAP_FAILED) {
+            data = static_cast<const char*>(p);
+            size = st.st_size;
+            mapped = true;
+         }
+      }
+      close(fd);
+#endif
+      if (!data) {
+         std::ifstream in(filename, std::ios::binary | std::ios::ate);
+         if (!in) return;
+         size = in.tellg();
+         buffer.resize(size);
+         in.seekg(0);
+         in.read(buffer.data(), size);
+         data = buffer.data();
+      }
+    }
+
+    ~MappedFile() {
+#ifdef CFD_HAVE_MMAP
+      if (mapped) munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+  private:
+    bool mapped = false;
+    std::vector<char> buffer;
+};
+
+const char grid_magic[8] = {'E','D','U','2','D','G','R','D'};
+
+} // end anonymous namespace
+
+
+bool EulerSolver2D::MainData2D::is_binary_grid(const std::string& datafile_grid_in) {
+
+   std::ifstream in(datafile_grid_in, std::ios::binary);
+   char magic[8];
+   if ( !in.read(magic, 8) ) return false;
+   return std::memcmp(magic, grid_magic, 8) == 0;
+}
+
+
+void EulerSolver2D::MainData2D::read_grid_binary(const std::string& datafile_grid_in) {
+
+   cout << "Reading the binary grid file...." << datafile_grid_in << endl;
+
+   MappedFile file(datafile_grid_in);
+
+   GridBinaryHeader header;
+   if (file.size < sizeof(header)) {
+      cout << " read_grid_binary: " << datafile_grid_in << " is too short. Stop." << endl;
+      std::exit(0);
+   }
+   std::memcpy(&header, file.data, sizeof(header));
+   if (header.nnodes < 0 || header.ntria < 0 || header.nquad < 0 || header.nbound < 0) {
+      cout << " read_grid_binary: corrupt header in " << datafile_grid_in << ". Stop." << endl;
+      std::exit(0);
    }
 
-   //  Print the data
-   std::cout << " Boundary conditions:" << std::endl;
-   for (size_t i = 0; i < nbound; i++) {
-      std::cout << " boundary" << i << "  bc_type = " << bound[i].bc_type << std::endl;
+   nnodes = header.nnodes;
+   ntria  = header.ntria;
+   nquad  = header.nquad;
+   nbound = header.nbound;
+   nelms  = ntria + nquad;
+
+   // Locate the blocks and check that the file holds all of them.
+   const char* p = file.data + sizeof(header);
+   const double*  xy      = reinterpret_cast<const double*>(p);   p += sizeof(double)*2*nnodes;
+   const int32_t* tria    = reinterpret_cast<const int32_t*>(p);  p += sizeof(int32_t)*3*ntria;
+   const int32_t* quad    = reinterpret_cast<const int32_t*>(p);  p += sizeof(int32_t)*4*nquad;
+   const int32_t* nbnodes = reinterpret_cast<const int32_t*>(p);  p += sizeof(int32_t)*nbound;
+   const int32_t* bnode   = reinterpret_cast<const int32_t*>(p);
+   size_t nbnodes_total = 0;
+   if (p <= file.data + file.size) {
+      for (int i = 0; i < nbound; i++) nbnodes_total += nbnodes[i];
+      p += sizeof(int32_t)*nbnodes_total;
+   }
+   if (p != file.data + file.size) {
+      cout << " read_grid_binary: size of " << datafile_grid_in
+           << " does not match its header. Stop." << endl;
+      std::exit(0);
    }
 
-   std::cout << "" << std::endl;
+   // Nodes
+   node = new node_type[nnodes];
+   for (int i = 0; i < nnodes; i++) {
+      node[i].x = xy[2*i  ];
+      node[i].y = xy[2*i+1];
+   }
 
-   // close(2)
-   outfile.close(); // close datafile_bcmap_in
+   // Elements
+   elm = new elm_type[nelms];
 
-   // End of Read the boundary condition data file
-   //--------------------------------------------------------------------------------
-   return;
+   // Element vertices (CSR): element i has e2v[ e2v_ptr[i] ... e2v_ptr[i+1]-1 ],
+   // triangles first, then quads.
+   e2v_ptr.resize(nelms+1);
+   e2v_ptr[0] = 0;
+   for (int i = 0; i < nelms; i++) e2v_ptr[i+1] = e2v_ptr[i] + (i < ntria ? 3 : 4);
+   e2v.assign(e2v_ptr[nelms], -1);
 
- } // end function read_grid
+   for (int i = 0; i < ntria; i++) {
+      elm[i].nvtx = 3;
+      for (int k = 0; k < 3; k++) e2v[ e2v_ptr[i] + k ] = tria[3*i+k];
+   }
+   for (int i = 0; i < nquad; i++) {
+      elm[ntria+i].nvtx = 4;
+      for (int k = 0; k < 4; k++) e2v[ e2v_ptr[ntria+i] + k ] = quad[4*i+k];
+   }
+
+   // Boundary nodes
+   bound = new bgrid_type[nbound];
+   for (int i = 0; i < nbound; i++) {
+      bound[i].nbnodes = nbnodes[i];
+      bound[i].bnode   = new Array2D<int>(bound[i].nbnodes, 1);
+      for (int j = 0; j < bound[i].nbnodes; j++) (*bound[i].bnode)(j) = bnode[j];
+      bnode += bound[i].nbnodes;
+   }
+
+   cout << " " << endl;
+   cout << " Total numbers:" << endl;
+   cout << "       nodes = " << nnodes << endl;
+   cout << "   triangles = " << ntria << endl;
+   cout << "       nquad = " << nquad << endl;
+   cout << "       nelms = " << nelms << endl;
+   cout << "    segments = " << nbound << endl;
+
+} // end function read_grid_binary
+
+
+void EulerSolver2D::MainData2D::write_grid_binary(const std::string& datafile) {
+
+   GridBinaryHeader header;
+   std::memcpy(header.magic, grid_magic, 8);
+   header.nnodes = nnodes;
+   header.ntria  = ntria;
+   header.nquad  = nquad;
+   header.nbound = nbound;
+
+   std::ofstream out(datafile, std::ios::binary);
+   out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+   std::vector<double> xy(2*nnodes);
+   for (int i = 0; i < nnodes; i++) {
+      xy[2*i  ] = node[i].x;
+      xy[2*i+1] = node[i].y;
+   }
+   out.write(reinterpret_cast<const char*>(xy.data()), sizeof(double)*xy.size());
+
+   std::vector<int32_t> v;
+   for (int i = 0; i < ntria; i++) {
+      for (int k = 0; k < 3; k++) v.push_back( e2v[ e2v_ptr[i] + k ] );
+   }
+   for (int i = 0; i < nquad; i++) {
+      for (int k = 0; k < 4; k++) v.push_back( e2v[ e2v_ptr[ntria+i] + k ] );
+   }
+   for (int i = 0; i < nbound; i++) v.push_back( bound[i].nbnodes );
+   for (int i = 0; i < nbound; i++) {
+      for (int j = 0; j < bound[i].nbnodes; j++) v.push_back( (*bound[i].bnode)(j) );
+   }
+   out.write(reinterpret_cast<const char*>(v.data()), sizeof(int32_t)*v.size());
+
+   cout << " Wrote binary grid file " << datafile << endl;
+
+} // end function write_grid_binary
+
+
+
+namespace {
+
+// Hash key of an element side (edge): the sorted vertex pair in 64 bits.
+inline std::uint64_t side_key(int v1, int v2) {
+   if (v1 > v2) std::swap(v1, v2);
+   return ( std::uint64_t(std::uint32_t(v1)) << 32 ) | std::uint32_t(v2);
+}
 
+} // end anonymous namespace
 
 
 //********************************************************************************
@@ -532,6 +794,9 @@ void EulerSolver2D::MainData2D::read_grid(std::string datafile_grid_in,
 //*    bound(:).bfn    = Magnitude of (bfnx,bfny)
 //*    bound(:).belm   = Element to which the boundary face belongs
 //*
+//* The element neighbors, the edges and belm are found with a hash map of the
+//* element sides (sorted vertex pair -> edge), in time linear in the grid size.
+//*
 //********************************************************************************
 
 void EulerSolver2D::MainData2D::construct_grid_data(){
@@ -542,7 +807,6 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
    real xj, yj, xm1, ym1, xm2, ym2, dsL,dsR,dx,dy;
    bool found;
    int vL, vR, n1, n2, e1, e2;
-   int vt1, vt2, ielm;
    int ave_nghbr, min_nghbr, max_nghbr, imin, imax;
    int iedge;
 
@@ -569,14 +833,15 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
 //--------------------------------------------------------------------------------
 // Loop over elements and construct the fololowing data.
 //
-// 1. Surrounding elements: node(:).nelms, node(:).elm(:)
+// 1. Surrounding elements: node(:).nelms, n2e_ptr(:), n2e_idx(:)
 //
 //    Example: Node i is surrounded by the eleemnts, 23, 101, 13, 41.
 //             node[i].nelms = 4
-//             node[i].elm(1) = 23
-//             node[i].elm(2) = 13
-//             node[i].elm(3) = 41
-//             node[i].elm(4) = 101
+//             n2e_idx[ n2e_ptr[i]     ] = 13
+//             n2e_idx[ n2e_ptr[i] + 1 ] = 23
+//             n2e_idx[ n2e_ptr[i] + 2 ] = 41
+//             n2e_idx[ n2e_ptr[i] + 3 ] = 101
+//             (in element order; n2e_ptr[i+1] = n2e_ptr[i] + 4)
 //
 //        o-------o-------------o
 //       /        |   .         |
@@ -599,42 +864,36 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
 
 //   elements : do i = 1, nelms
 
-   // for ( int i = 0; i < nelms; ++i ) {
-   //    v1 = (*elm[i].vtx)(0,0);
-   //    v2 = (*elm[i].vtx)(1,0);
-   //    v3 = (*elm[i].vtx)(2,0);
-   //    node[v1].nelms = node[v1].nelms + 1;
-   //    node[v2].nelms = node[v2].nelms + 1;
-   //    node[v3].nelms = node[v3].nelms + 1;
+   // Count the elements around each node, then fill the CSR rows
+   // (two passes, in element order).
+   for ( int i = 0; i < nelms; ++i ) {
+      for (int k = 0; k < elm[i].nvtx; k++) {
+         v1 = e2v[ e2v_ptr[i] + k ];
+         node[v1].nelms = node[v1].nelms + 1;
+      }
+   }
 
-   // }
-   // for ( int i = 0; i < nelms; ++i ) {
-   //    v1 = (*elm[i].vtx)(0,0);
-   //    v2 = (*elm[i].vtx)(1,0);
-   //    v3 = (*elm[i].vtx)(2,0);
-   //    node[v1].elm = new Array2D<int>(node[v1].nelms, 1);
-   //    node[v2].elm = new Array2D<int>(node[v2].nelms, 1);
-   //    node[v3].elm = new Array2D<int>(node[v3].nelms, 1);
-   // }
+   n2e_ptr.resize(nnodes+1);
+   n2e_ptr[0] = 0;
+   for (int i = 0; i < nnodes; i++) {
+      n2e_ptr[i+1] = n2e_ptr[i] + node[i].nelms;
+      node[i].nelms = 0;
+   }
+   n2e_idx.resize(n2e_ptr[nnodes]);
 
-   //dummy allocations:
-   // node[v1].elm = new Array2D<int>(1, 1);
-   // node[v2].elm = new Array2D<int>(1, 1);
-   // node[v3].elm = new Array2D<int>(1, 1);
    for ( int i = 0; i < nelms; ++i ) {
-      v1 = (*elm[i].vtx)(0,0);
-      v2 = (*elm[i].vtx)(1,0);
-      v3 = (*elm[i].vtx)(2,0);
-      // node[v1].elm = new Array2D<int>(1, 1);
-      // node[v2].elm = new Array2D<int>(1, 1);
-      // node[v3].elm = new Array2D<int>(1, 1);
+      for (int k = 0; k < elm[i].nvtx; k++) {
+         v1 = e2v[ e2v_ptr[i] + k ];
+         n2e_idx[ n2e_ptr[v1] + node[v1].nelms ] = i;
+         node[v1].nelms = node[v1].nelms + 1;
+      }
    }
 
    for ( int i = 0; i < nelms; ++i ) {
 
-      v1 = (*elm[i].vtx)(0,0);
-      v2 = (*elm[i].vtx)(1,0);
-      v3 = (*elm[i].vtx)(2,0);
+      v1 = e2v[ e2v_ptr[i] ];
+      v2 = e2v[ e2v_ptr[i] + 1 ];
+      v3 = e2v[ e2v_ptr[i] + 2 ];
 
       x1 = node[v1].x;
       x2 = node[v2].x;
@@ -644,30 +903,6 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
       y2 = node[v2].y;
       y3 = node[v3].y;
 
-   // Distribute the element index to nodes.
-
-      /*
-      * DESIGN CHOICE HERE -- use std<vector>
-      * should use std::containers
-      */
-
-      // save and reallocate:
-      node[v1].nelms = node[v1].nelms + 1;
-      node[v1].elm.append(i);
-
-
-
-      // save and reallocate:
-      node[v2].nelms = node[v2].nelms + 1;
-      node[v2].elm.append(i);
-
-
-
-      // save and reallocate:
-      node[v3].nelms = node[v3].nelms + 1;
-      node[v3].elm.append(i);
-
-
       // Compute the cell center and cell volume.
       //tri_or_quad : if (elm(i).nvtx==3) then
       if (elm[i].nvtx==3) {
@@ -680,10 +915,8 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
       }
       else if (elm[i].nvtx==4) {
 
-         cout << "need to fix reallocator for 4th node \n";
-         std::exit(0);
    //   this is a quad. Get the 4th vertex.
-         v4 = (*elm[i].vtx)(4,0);
+         v4 = e2v[ e2v_ptr[i] + 3 ];
          x4 = node[v4].x;
          y4 = node[v4].y;
    //   Centroid: median dual
@@ -745,10 +978,6 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
             std::exit(0);
          }
 
-      //  Distribution of element number to the 4th node of the quadrilateral
-         node[v4].nelms = node[v3].nelms + 1;
-         node[v4].elm.append(i);
-
       }//    endif tri_or_quad
       else {
          cout << "ERROR: not a tri or quad" << endl;
@@ -767,9 +996,9 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
    for ( int i = 0; i < nelms; ++i ) {
       
 //TLM here 2/23/2020 6::11
-      v1 = (*elm[i].vtx)(0);
-      v2 = (*elm[i].vtx)(1);
-      v3 = (*elm[i].vtx)(2);
+      v1 = e2v[ e2v_ptr[i] ];
+      v2 = e2v[ e2v_ptr[i] + 1 ];
+      v3 = e2v[ e2v_ptr[i] + 2 ];
 
    //    tri_or_quadv : 
       if (elm[i].nvtx==3) {
@@ -779,7 +1008,7 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
          node[v3].vol = node[v3].vol + third*elm[i].vol;
 
       }  else if (elm[i].nvtx==4) {
-            v4 = (*elm[i].vtx)(4,0);
+            v4 = e2v[ e2v_ptr[i] + 3 ];
 
             x1 = node[v1].x;
             x2 = node[v2].x;
@@ -894,104 +1123,11 @@ void EulerSolver2D::MainData2D::construct_grid_data(){
       (*elm[   i].nghbr) = -1;
 
    }
-int nbrprint = 2;
-// Begin constructing the element-neighbor data
-   cout << "Begin constructing the element-neighbor data \n" << endl;
-   //elements2 : do i = 1, nelms
-   for (size_t i = 0; i < nelms; i++) {
-
-      //elm_vertex : do k = 1, elm(i).nvtx
-      for (size_t k = 0; k < elm[i].nvtx; k++) {
-         //   Get the face of the element i:
-         //
-         //             vL      vR
-         //              o------o
-         //             /       |
-         //            /        |
-         //           o---------o
-         //
-         //TLM warning:  fixed step out of bounds
-         if (k  < elm[i].nvtx-1) vL = (*elm[i].vtx)(k+1); //k+1 - 1.. nope, K goes from 0
-         if (k == elm[i].nvtx-1) vL = (*elm[i].vtx)(0); //1-1
-         vR = (*elm[i].vtx)(k);
-
-         //   Loop over the surrounding elements of the node vR,
-         //   and find the element neighbor from them.
-         found = false;
-         //elms_around_vR
-         for (size_t j = 0; j < node[vR].nelms; j++) {
-            jelm = node[vR].elm(j);
-            
-            // if (i < nbrprint) cout <<  " i = " << i <<  " j = " << j << endl;
-            // if (i < nbrprint) cout << "vR = " << vR << " " << "   jelm = " << node[vR].elm(j) << endl;
-            //if (i < nbrprint) cout << "vR , jelm = "<< vR << "   " << jelm << endl;
-
-            //edge_matching
-            for (size_t ii = 0; ii < elm[jelm].nvtx; ii++) {
-               
-               v1 = (*elm[jelm].vtx)(ii);
-               //cout << ii << endl;
-               if (ii  > 0) { 
-                  v2 = (*elm[jelm].vtx)(ii-1); 
-               }
-               if (ii == 0) { 
-                  v2 = (*elm[jelm].vtx)(elm[jelm].nvtx-1); 
-               } //TLM fix: array bounds overrun fixed here
-               
-               // if (i < nbrprint)  cout << " v = " << vR 
-               //                         << "  " << v1 
-               //                         << "  " << vL 
-               //                         << "  " << v2 << endl;
-               
-               if (v1==vR and v2==vL) {
-                  found = true;
-                  
-                  im = ii+1;
-                  if (im > (elm[jelm].nvtx-1)) { 
-                     im = im - (elm[jelm].nvtx-0); 
-                  }
-                  // if (i < nbrprint)  cout << "found v1==VR, v2==VL " << v1 << " " << vR << "   " << v2 << " " <<  vL << endl;
-                  break; //exit edge_matching  |
-               } //endif       
-
-            } //end do     edge_matching   <---V
-
-      //if (found) exit elms_around_vR
-      if (found) {break;}
-
-      } //end do elms_around_vR
-
-      // Q: why is this k+2 when we already loop all the way to nvtx?
-      in = k + 2; 
-      if (in > elm[i].nvtx-1) { in = in - elm[i].nvtx-0; } // A: simple fix here: in > elm[i].nvtx had to be ammended and not [0,1,2](3) => 2 len=3
-      // i.e. if n > 2, then c = 3; so subtract 3 (i.e. nvtx) to get back to zero
-      if (found) {
-         (*elm[   i].nghbr)(in) = jelm;
-         (*elm[jelm].nghbr)(im) = i;
-      }
-      else {
-         (*elm[   i].nghbr)(in) = -1; //boundary
-      }
-
-
-      // if (i < nbrprint) {
-      //    cout << " elm nghbrs...\n";
-      //    print((*elm[   i].nghbr));
-      //    cout << " ------------------\n";
-      // }
-
-      }//    end do elm_vertex
-
-   }//   end do elements2
-
-cout << "DONE constructing the element-neighbor data " << endl;
-
 //--------------------------------------------------------------------------------
-// Edge-data for node-centered (edge-based) scheme.
+// Element neighbors and edge data in a single pass over the element sides.
 //
-// Loop over elements 3
-// Construct edge data: edge(:).n1, n2, e1, e2.
-// Edge points from node n1 to node n2.
+// Edge-data for node-centered (edge-based) scheme:
+// edge(:).n1, n2, e1, e2. Edge points from node n1 to node n2.
 //
 //      n2
 //       o------------o
@@ -1000,177 +1136,117 @@ cout << "DONE constructing the element-neighbor data " << endl;
 //   .  e1  \    .
 //  .        \ .         Directed area is positive: n1 -> n2
 // o----------o         e1: left element
-//             n1       e2: right element (e2 > e1 or e2 = 0)
-
-// First count the number of edges.
+//             n1       e2: right element (e2 > e1 or e2 = -1)
 //
-// NOTE: Count edges only if the neighbor element number is
-//       greater than the current element (i) to avoid double
-//       count. -1 element number indicates that it is outside
-//       the domain (boundary face).
+// Each element side (vL,vR) is looked up in a hash map keyed by the sorted
+// vertex pair. The first element that has the side creates the edge, with
+// n1 -> n2 in its own vertex order; the second one closes it (e2), and the
+// two elements become neighbors. Interior sides are removed from the map once
+// matched, so at the end it holds exactly the boundary sides (used for belm
+// below). The edges come out in the same order as the element-by-element
+// construction: an edge belongs to the lower-numbered of its two elements.
 
-   //   elements0 : do i = 1, nelms
-   for (size_t i = 0; i < nelms; i++) {
+   cout << "Begin constructing the element-neighbor data \n" << endl;
 
-      v1 = (*elm[i].vtx)(0);
-      v2 = (*elm[i].vtx)(1);
-      v3 = (*elm[i].vtx)(2);
+   std::unordered_map<std::uint64_t, int> side_edge; // sorted (v1,v2) -> edge
+   side_edge.reserve( nnodes );
 
-//    tri_quad0 : if (elm[i].nvtx==3) then
-      if (elm[i].nvtx==3) {
+   std::vector<int> en1, en2, ee1, ee2;   // edge nodes and elements
+   std::vector<int> eside1;               // local side of the edge in e1
+   en1.reserve( nnodes + nelms );
+   en2.reserve( nnodes + nelms );
+   ee1.reserve( nnodes + nelms );
+   ee2.reserve( nnodes + nelms );
+   eside1.reserve( nnodes + nelms );
 
-         if ( (*elm[i].nghbr)(2) > i  or (*elm[i].nghbr)(2) == -1 ) {
-            nedges = nedges + 1;
-         }
+   //elements2 : do i = 1, nelms
+   for (int i = 0; i < nelms; i++) {
 
-         if ( (*elm[i].nghbr)(0) > i or (*elm[i].nghbr)(0) == -1 ) {
-            nedges = nedges + 1;
-         }
+      //elm_sides : do k = 1, elm(i).nvtx
+      for (int k = 0; k < elm[i].nvtx; k++) {
 
-         if ( (*elm[i].nghbr)(1) > i or (*elm[i].nghbr)(1) == -1 ) {
-            nedges = nedges + 1;
+         //  Side k of the element i goes from vertex k to k+1, and the
+         //  neighbor across it is stored at k+2:
+         //
+         //             vR      vL
+         //              o------o
+         //             /       |
+         //            /        |
+         //           o---------o
+         //
+         vR = e2v[ e2v_ptr[i] + k ];
+         vL = e2v[ e2v_ptr[i] + (k+1) % elm[i].nvtx ];
+         in = (k+2) % elm[i].nvtx;
+
+         std::uint64_t key = side_key(vR, vL);
+         auto it = side_edge.find(key);
+
+         if (it == side_edge.end()) {
+         // New edge: boundary until the other element (if any) shows up.
+            side_edge.emplace(key, int(en1.size()));
+            en1.push_back(vR);
+            en2.push_back(vL);
+            ee1.push_back(i);
+            ee2.push_back(-1);
+            eside1.push_back(k);
+         }
+         else {
+            iedge = it->second;
+            jelm  = ee1[iedge];
+            if (ee2[iedge] != -1 || en1[iedge] != vL) {
+               cout << " construct_grid_data: side (" << vR << "," << vL
+                    << ") of element " << i << " is shared by more than two elements"
+                    << " or has inconsistent orientation. Stop." << endl;
+               std::exit(0);
+            }
+            ee2[iedge] = i;
+            im = (eside1[iedge]+2) % elm[jelm].nvtx;
+            (*elm[   i].nghbr)(in) = jelm;
+            (*elm[jelm].nghbr)(im) = i;
+            side_edge.erase(it);
          }
-      }
-      
-      else if (elm[i].nvtx==4) {
-
-      v4 = (*elm[i].vtx)(3);
-
-      if ( (*elm[i].nghbr)(2) > i or (*elm[i].nghbr)(2) == -1 ) {
-         nedges = nedges + 1;
-      }
-
-      if ( (*elm[i].nghbr)(3) > i or (*elm[i].nghbr)(3) == -1 ) {
-         nedges = nedges + 1;
-      }
-
-      if ( (*elm[i].nghbr)(0) > i or (*elm[i].nghbr)(0) == -1 ) {
-         nedges = nedges + 1;
-      }
 
-      if ( (*elm[i].nghbr)(1) > i or (*elm[i].nghbr)(1) == -1 ) {
-       nedges = nedges + 1;
-      }
+      }//    end do elm_sides
 
-      }//    endif tri_quad0
+   }//   end do elements2
 
-   }//   end do elements0
+   cout << "DONE constructing the element-neighbor data " << endl;
 
-// Allocate the edge array.
+// Allocate the edge array and copy the edge data.
+   nedges = int(en1.size());
    edge = new edge_type[nedges];
-   for (size_t i = 0; i < nedges; i++) {
-      edge[i].e1 = -1;
-      edge[i].e2 = -1;
+   for (int i = 0; i < nedges; i++) {
+      edge[i].n1 = en1[i];
+      edge[i].n2 = en2[i];
+      edge[i].e1 = ee1[i];
+      edge[i].e2 = ee2[i];
    }
-   nedges = -1; //TLM fence post fix//
-
-// Construct the edge data:
-//  two end nodes (n1, n2), and left and right elements (e1, e2)
 
    int maxprint = 1;
 
-   //elements3 : do i = 1, nelms
-   for (size_t i = 0; i < nelms; i++) {
-
-      v1 = (*elm[i].vtx)(0);
-      v2 = (*elm[i].vtx)(1);
-      v3 = (*elm[i].vtx)(2);
-
-   
-   // Triangular element
-      //tri_quad2 : 
-      if (elm[i].nvtx==3) {
-
-         // if (i<maxprint) {
-         //    cout << "printing edge vars to be set \n";
-         //    cout << "v1 = " << v1 << "\n";
-         //    cout << "v2 = " << v2 << "\n";
-         //    cout << "(*elm[i].nghbr)(0) = " << (*elm[i].nghbr)(0) << "\n";
-         //    cout << "(*elm[i].nghbr)(1) = " << (*elm[i].nghbr)(1) << "\n";
-         //    cout << "(*elm[i].nghbr)(2) = " << (*elm[i].nghbr)(2) << "\n";
-         // }
-
-         if ( (*elm[i].nghbr)(2) > i  or (*elm[i].nghbr)(2)==-1 ) {
-
-            // if (i<maxprint) cout << "set edge 1\n";
-            nedges = nedges + 1;
-            edge[nedges].n1 = v1;
-            edge[nedges].n2 = v2;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(2);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -1");
-         }
-
-         if ( (*elm[i].nghbr)(0) > i or (*elm[i].nghbr)(0)==-1 ) {
-            // if (i<maxprint) cout << "set edge 2\n";
-            nedges = nedges + 1;
-            edge[nedges].n1 = v2;
-            edge[nedges].n2 = v3;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(0);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -2" );
-         }
-
-         if ( (*elm[i].nghbr)(1) > i or (*elm[i].nghbr)(1)==-1 ) {
-            // if (i<maxprint) cout << "set edge 3\n";
-            nedges = nedges + 1;
-            edge[nedges].n1 = v3;
-            edge[nedges].n2 = v1;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(1);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -3");
-         }
-
-         // else {
-         //    cout << "ERROR: missed edge case! \n";
-         // }
-
+// Sort the edges by their min node (then max node), so that the edge loop
+// walks through the node arrays in order. Only done when the nodes have been
+// renumbered for locality (see renumber_nodes); n1 -> n2 orientation is kept.
+   if ( trim(node_ordering) == "rcm" || trim(node_ordering) == "morton" ) {
+
+      std::vector<int> order(nedges);
+      for (int i = 0; i < nedges; i++) order[i] = i;
+      std::sort(order.begin(), order.end(), [this](int a, int b) {
+         int amin = std::min(edge[a].n1, edge[a].n2), amax = std::max(edge[a].n1, edge[a].n2);
+         int bmin = std::min(edge[b].n1, edge[b].n2), bmax = std::max(edge[b].n1, edge[b].n2);
+         return (amin < bmin) || (amin == bmin && amax < bmax);
+      });
+
+      std::vector<int> en1(nedges), en2(nedges), ee1(nedges), ee2(nedges);
+      for (int i = 0; i < nedges; i++) {
+         en1[i] = edge[order[i]].n1;  en2[i] = edge[order[i]].n2;
+         ee1[i] = edge[order[i]].e1;  ee2[i] = edge[order[i]].e2;
       }
-   //  Quadrilateral element
-      else if (elm[i].nvtx==4) {
-
-         v4 = (*elm[i].vtx)(3);
-
-         if ( (*elm[i].nghbr)(2) > i or (*elm[i].nghbr)(2) == -1 ) {
-            nedges = nedges + 1;
-            edge[nedges].n1 = v1;
-            edge[nedges].n2 = v2;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(2);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -q1");
-         }
-
-         if ( (*elm[i].nghbr)(3) > i or (*elm[i].nghbr)(3) == -1 ) {
-            nedges = nedges + 1;
-            edge[nedges].n1 = v2;
-            edge[nedges].n2 = v3;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(3);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -q2");
-         }
-
-         if ( (*elm[i].nghbr)(0) > i or (*elm[i].nghbr)(0) == -1 ) {
-            nedges = nedges + 1;
-            edge[nedges].n1 = v3;
-            edge[nedges].n2 = v4;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(0);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -q3");
-         }
-
-         if ( (*elm[i].nghbr)(1) > i or (*elm[i].nghbr)(1) == -1 ) {
-            nedges = nedges + 1;
-            edge[nedges].n1 = v4;
-            edge[nedges].n2 = v1;
-            edge[nedges].e1 = i;
-            edge[nedges].e2 = (*elm[i].nghbr)(1);
-            // assert(v1 //= v2 && "v1 should not be equal to v2 -q4");
-         }
-
-      }//    endif tri_quad2
-
-   }//   end do elements3
-   nedges += 1;
+      for (int i = 0; i < nedges; i++) {
+         edge[i].n1 = en1[i];  edge[i].n2 = en2[i];
+         edge[i].e1 = ee1[i];  edge[i].e2 = ee2[i];
+      }
+   }
 
 // Loop over edges
 // Construct edge vector and directed area vector.
@@ -1285,52 +1361,36 @@ cout << "DONE constructing the element-neighbor data " << endl;
       node[i].nnghbrs = 0;
    }
 
-   //dummy allocations are bad!:
+// Count the neighbors, then loop over edges and distribute the node numbers
+// to the CSR rows: the neighbors of node i are
+// nghbr_idx[ nghbr_ptr[i] ... nghbr_ptr[i+1]-1 ], in edge order.
+
    for (size_t i = 0; i < nedges; i++) {
-      n1 = edge[i].n1;
-      n2 = edge[i].n2;
-      //node[n1].nghbr = new Array2D<int>(1, 1);
-      //node[n2].nghbr = new Array2D<int>(1, 1);
+      node[edge[i].n1].nnghbrs = node[edge[i].n1].nnghbrs + 1;
+      node[edge[i].n2].nnghbrs = node[edge[i].n2].nnghbrs + 1;
    }
 
-// Loop over edges and distribute the node numbers:
+   nghbr_ptr.resize(nnodes+1);
+   nghbr_ptr[0] = 0;
+   for (size_t i = 0; i < nnodes; i++) {
+      nghbr_ptr[i+1] = nghbr_ptr[i] + node[i].nnghbrs;
+      node[i].nnghbrs = 0;
+   }
+   nghbr_idx.resize(nghbr_ptr[nnodes]);
 
    //edges4 : do i = 1, nedges
    for (size_t i = 0; i < nedges; i++) {
 
       n1 = edge[i].n1;
       n2 = edge[i].n2;
-      
 
-      // (1) Add n1 to the neighbor list of n2
+      // (1) Add n2 to the neighbor list of n1
+      nghbr_idx[ nghbr_ptr[n1] + node[n1].nnghbrs ] = n2;
       node[n1].nnghbrs = node[n1].nnghbrs + 1;
-      if (node[n1].nnghbrs == 1) {
-         node[n1].nghbr = new Array2D<int>(1, 1);
-      }
-      else{
-         Array2D<int> save7 = (*node[n1].nghbr);
-         node[n1].nghbr = new Array2D<int>(node[n1].nnghbrs, 1);
-            for (size_t ra = 0; ra < save7.storage_size; ra++) {
-               (*node[n1].nghbr).array[ra] = save7.array[ra];
-            }
-      }
-      (*node[n1].nghbr)( node[n1].nnghbrs - 1 ) = n2; // more fence post trickery
-
 
-      // (2) Add n2 to the neighbor list of n1
+      // (2) Add n1 to the neighbor list of n2
+      nghbr_idx[ nghbr_ptr[n2] + node[n2].nnghbrs ] = n1;
       node[n2].nnghbrs = node[n2].nnghbrs + 1;
-      if (node[n2].nnghbrs == 1) {
-         node[n2].nghbr = new Array2D<int>(1, 1);
-      }
-      else{
-         Array2D<int> save8 = (*node[n2].nghbr);
-         node[n2].nghbr = new Array2D<int>(node[n2].nnghbrs, 1);
-            for (size_t ra = 0; ra < save8.storage_size; ra++) {
-               (*node[n2].nghbr).array[ra] = save8.array[ra];
-            }
-      }
-      (*node[n2].nghbr)( node[n2].nnghbrs - 1 ) = n1;
-
 
    } //end do edges4
 
@@ -1501,8 +1561,8 @@ cout << "DONE constructing the element-neighbor data " << endl;
 //
 //   That is,  we have
 //
-//    n2 = (*node[n1].nghbr)(edge[i].kth_nghbr_of_1)
-//    n1 = (*node[n2].nghbr)(edge[i].kth_nghbr_of_2)
+//    n2 = nghbr_idx[ nghbr_ptr[n1] + edge[i].kth_nghbr_of_1 ]
+//    n1 = nghbr_idx[ nghbr_ptr[n2] + edge[i].kth_nghbr_of_2 ]
 //
 //   We make use of this data structure to access off-diagonal entries in Jacobian matrix.
 //
@@ -1518,7 +1578,7 @@ cout << "DONE constructing the element-neighbor data " << endl;
       //do k = 1, node[n2].nnghbrs
       for (size_t k = 0; k < node[n2].nnghbrs; k++) {
 
-         if ( n1 == (*node[n2].nghbr)(k) ) {
+         if ( n1 == nghbr_idx[ nghbr_ptr[n2] + k ] ) {
          edge[i].kth_nghbr_of_2 = k;
          }
 
@@ -1527,7 +1587,7 @@ cout << "DONE constructing the element-neighbor data " << endl;
       //do k = 1, node[n1].nnghbrs
       for (size_t k = 0; k < node[n1].nnghbrs; k++) {
 
-         if ( n2 == (*node[n1].nghbr)(k) ) {
+         if ( n2 == nghbr_idx[ nghbr_ptr[n1] + k ] ) {
          edge[i].kth_nghbr_of_1 = k;
          }
 
@@ -1640,13 +1700,13 @@ cout << "DONE constructing the element-neighbor data " << endl;
 
 
          for (size_t k = 0; k < node[n2].nnghbrs; k++) {
-            if ( n1 == (*node[n2].nghbr)(k) ) {
+            if ( n1 == nghbr_idx[ nghbr_ptr[n2] + k ] ) {
                (*bound[i].kth_nghbr_of_2)(j) = k;
             }
          }
 
          for (size_t k = 0; k < node[n1].nnghbrs; k++) {
-            if ( n2 == (*node[n1].nghbr)(k) ) {
+            if ( n2 == nghbr_idx[ nghbr_ptr[n1] + k ] ) {
                (*bound[i].kth_nghbr_of_1)(j) = k;
             }
          }
@@ -1672,6 +1732,10 @@ cout << "DONE constructing the element-neighbor data " << endl;
 // elmb(j) is the element number of the element having the j-th boundary face.
 //
 
+//  The boundary faces are the element sides left unmatched in side_edge,
+//  and the element is the one that created that edge, with v1 -> v2 in
+//  its own vertex order.
+
 //   do i = 1, nbound
 //    do j = 1, bound[i].nbfaces
    for (size_t i = 0; i < nbound; i++) {
@@ -1681,52 +1745,11 @@ cout << "DONE constructing the element-neighbor data " << endl;
          v1 = (*bound[i].bnode)(j) ;
          v2 = (*bound[i].bnode)(j+1);
 
-         found = false;
-
-      //   Find the element having the bface from the elements
-      //   around the node v1.
-
-         //do k = 1, node[v1).nelms
-         for (size_t k = 0; k < node[v1].nelms; k ++) {
-            //k = node[v1].nelms-1;
-
-            ielm = node[v1].elm(k);
-
-            //cout << "v1, k, ielm  " << v1 << "    " << k << "    " << ielm << endl;
-            //do ii = 1, elm[ielm].nvtx;
-            for (size_t ii = 0; ii < elm[ielm].nvtx; ii++) {
-
-
-               in = ii;
-               im = ii+1;
-               if (im > elm[ielm].nvtx-1 ) { im = im - (elm[ielm].nvtx-0); }//return to 0? (cannot use im = 0; }//)
-              
-               vt1 = (*elm[ielm].vtx)(in); //(in); //TLM these are bad
-               vt2 = (*elm[ielm].vtx)(im); //TLM these are bad
-
-
-               // if (j < 2) cout << " v = " << vt1 << "  " << v1 << "  " << vt2 << "  " << v2 << endl;
-               // if (j < 2) cout << "    " << ielm << "    " << im << "    " << in << endl;
-               if (vt1 == v1 and vt2 == v2) {
-                  found = true;
-                  //if (j < 2) cout << "found// " << endl;;//" " << in << " " << im << endl;
-                  //if (j < 2) cout << "    " << ielm << "    " << im << "    " << in << endl;
-                  // if (j < 2) cout << " v = " << vt1 << "  " << v1 << "  " << vt2 << "  " << v2 << endl;
-                  //cout << "break 1" << endl;
-                  break; //continue; //exit
-               }
-               // cout << "break 2" << endl;
-               //if (found) {break;} //exit  //extra break needed to account for exit behavior//
-            } //end do
-            //cout << "break 3" << endl;
-            if (found) {break;} //exit
-         }//end do
-            // cout << "break 3" << endl;
-            // if (found) {break;} //exit
+         auto it = side_edge.find( side_key(v1, v2) );
+         found = ( it != side_edge.end() && en1[it->second] == v1 );
 
          if (found) {
-            //cout << " GOOD: Boundary-adjacent element found" << endl;
-            (*bound[i].belm)(j) = ielm;
+            (*bound[i].belm)(j) = ee1[it->second];
          }
          else {
             cout << " Boundary-adjacent element not found. Error..." << endl;
@@ -1956,10 +1979,22 @@ cout << "Generating CC scheme data......" << endl;
 //--------------------------------------------------------------------------------
 // Collect vertex-neighbors
 //
-//  
+//  The vertex neighbors of element i are
+//  vnghbr_idx[ vnghbr_ptr[i] ... vnghbr_ptr[i+1]-1 ]. The rows are filled in
+//  element order, so the CSR arrays are appended to in a single pass.
+//  vnghbr_of[e] == i marks the element e as already added to the list of i.
+//
+   std::vector<int> vnghbr_of(nelms, -1);
+
+   vnghbr_ptr.resize(nelms+1);
+   vnghbr_ptr[0] = 0;
+   vnghbr_idx.clear();
+   vnghbr_idx.reserve( 12*size_t(nelms) );
+
    //elements7 : do i = 1, nelms
    for (size_t i = 0; i < nelms; i++) {
 
+      vnghbr_of[i] = i;
 
       // (1)Add face-neighbors
       //do k = 1, elm(i).nnghbrs
@@ -1967,58 +2002,31 @@ cout << "Generating CC scheme data......" << endl;
          if ( (*elm[i].nghbr)(k) > -1 ) {
             elm[i].nvnghbrs = elm[i].nvnghbrs + 1;
 
-            elm[i].vnghbr.append( (*elm[i].nghbr)(k) );
+            vnghbr_idx.push_back( (*elm[i].nghbr)(k) );
+            vnghbr_of[ (*elm[i].nghbr)(k) ] = i;
          }
       }
 
-
-
       // (2)Add vertex-neighbors
       //do k = 1, elm[i].nvtx
       for (size_t k = 0; k < elm[i].nvtx; k++) {
-         v1 = (*elm[i].vtx)(k);
+         v1 = e2v[ e2v_ptr[i] + k ];
 
          //velms : doj = 1, node[v1).nelms
          for (size_t j = 0; j < node[v1].nelms; j++) {
 
-            //if (i<10*maxprint) cout << " good start HIGH after break" << endl;
-            e1 = node[v1].elm(j);
-            if (e1 == i)  {
-               //if (i<10*maxprint) cout << " e1 == i = " << i << " " << e1 <<  endl;
-               continue; //velms;
-            }
-
-      //    Check if the element is already added.
-            found = false;
-            //do ii = 1, elm[i].nvnghbrs
-            for (size_t ii = 0; ii < elm[i].nvnghbrs; ii++) {
-               //if (i<10*maxprint) cout << " checking  elm " << i << "  vnghbr(  " << ii << "  ) = " <<(*elm[i].vnghbr)(ii) << endl;
-               //if ( e1 == (*elm[i].vnghbr)(ii) ) {
-               if ( e1 == elm[i].vnghbr(ii) ) {
-                  found = true;
-                  // if (i<10*maxprint) cout << "Found element match e1 = " << e1 << " " << (*elm[i].vnghbr)(ii) << endl;
-                  // if (i<10*maxprint) cout << " break" << endl;
-                  break;
-               }
-               //if (i<10*maxprint) cout << " skip after break" << endl;
-            }
-            //if (i<10*maxprint) cout << " good start LOW after break" << endl;
+            e1 = n2e_idx[ n2e_ptr[v1] + j ];
 
-   //       Add the element, e1, if not added yet.
-            if (not found) {
-               
-               // if (i<10*maxprint) cout << "NO element match e1 = " << e1 << endl;
-               
+   //       Add the element, e1, if not added yet (or i itself).
+            if (vnghbr_of[e1] != int(i)) {
                elm[i].nvnghbrs = elm[i].nvnghbrs + 1;
-               elm[i].vnghbr.append( e1 );
+               vnghbr_idx.push_back( e1 );
+               vnghbr_of[e1] = i;
             }
          }//velms loop
 
       }//end elm[i].nvtx loop
-      // cout << "--- elm[798].vnghbr" << endl;
-      // print( (*elm[798].vnghbr) );
-      // cout << "--- elm[804].vnghbr" << endl;
-      // print( (*elm[804].vnghbr) );
+      vnghbr_ptr[i+1] = int( vnghbr_idx.size() );
 
       ave_nghbr = ave_nghbr + elm[i].nvnghbrs;
       if (elm[i].nvnghbrs < min_nghbr) imin = i;
@@ -2047,7 +2055,7 @@ cout << "Generating CC scheme data......" << endl;
    //bc_loop : do i = 1, nbound
    for ( int i = 0; i < nbound; ++i ) {
       //cout << bound[i].bc_type << endl;
-      if ( trim( bound[i].bc_type ) == "dirichlet") {
+      if ( bound[i].bc == BCType::dirichlet ) {
          cout << "Found dirichlet condition " << endl;
          //do j = 1, bound[i].nbfaces
          for (size_t i = 0; i < bound[i].nbfaces; i++) {
@@ -2061,9 +2069,14 @@ cout << "Generating CC scheme data......" << endl;
    }// end do bc_loop
 
 //--------------------------------------------------------------------------------
+// Slip-wall normals at the nodes (for the limiter).
 
+   compute_wall_normals();
 
+//--------------------------------------------------------------------------------
+// Color the edges for the threaded residual assembly.
 
+   color_edges();
 
 } //  end function construct_grid_data
 
@@ -2072,6 +2085,982 @@ cout << "Generating CC scheme data......" << endl;
 
 
 
+//********************************************************************************
+//* Parse the scheme options, given as strings, into the enums used by the
+//* solver (flux_id, limiter_id, gradient_id, gradient_weight_id, assembly_id).
+//* Called once, after the options are set and before the solver runs, so that
+//* no string is compared inside the node/edge/boundary loops.
+//*
+//* An invalid option stops the program.
+//********************************************************************************
+void EulerSolver2D::MainData2D::set_scheme_options() {
+
+   const std::string flux     = trim(inviscid_flux);
+   const std::string limiter  = trim(limiter_type);
+   const std::string grad     = trim(gradient_type);
+   const std::string weight   = trim(gradient_weight);
+   const std::string assembly = trim(residual_assembly);
+   const std::string stepping = trim(time_stepping);
+   const std::string linsolver = trim(linear_solver);
+   const std::string precond  = trim(preconditioner);
+   const std::string mgcycle  = trim(multigrid_cycle);
+
+   //  roe_einfeldt: the Roe flux with Einfeldt's wave speeds (see Solver::roe).
+   roe_einfeldt = (flux == "roe_einfeldt");
+   if      (flux == "roe" || roe_einfeldt) flux_id = FluxType::roe;
+   else if (flux == "rhll")                flux_id = FluxType::rhll;
+   else {
+      cout << " Invalid input for inviscid_flux = " << flux << " \n";
+      cout << " Choose roe, roe_einfeldt or rhll, and try again. \n";
+      std::exit(0); //stop
+   }
+
+   // Any limiter name other than "none" has meant Van Albada.
+   if (limiter == "none") limiter_id = LimiterType::none;
+   else                   limiter_id = LimiterType::vanalbada;
+
+   if      (grad == "none")       gradient_id = GradientType::none;
+   else if (grad == "linear")     gradient_id = GradientType::linear;
+   else if (grad == "quadratic2") gradient_id = GradientType::quadratic2;
+   else {
+      cout << " Invalid input value -> " << grad << " \n";
+      std::exit(0); //stop
+   }
+
+   if      (weight == "none")             gradient_weight_id = GradientWeight::none;
+   else if (weight == "inverse_distance") gradient_weight_id = GradientWeight::inverse_distance;
+   else {
+      cout << " Invalid input value -> " << weight << " \n";
+      std::exit(0); //stop
+   }
+
+   if      (assembly == "coloring") assembly_id = AssemblyType::coloring;
+   else if (assembly == "owner")    assembly_id = AssemblyType::owner;
+   else if (assembly == "serial")   assembly_id = AssemblyType::serial;
+   else if (assembly == "tiled")    assembly_id = AssemblyType::tiled;
+   else {
+      cout << " Invalid input for residual_assembly = " << assembly << " \n";
+      cout << " Choose coloring, owner, serial or tiled, and try again. \n";
+      std::exit(0); //stop
+   }
+
+   if (tile_size < 1) {
+      cout << " Invalid input for tile_size = " << tile_size << " (at least 1 node) \n";
+      std::exit(0); //stop
+   }
+
+   if      (stepping == "global")   time_stepping_id = TimeStepping::global;
+   else if (stepping == "local")    time_stepping_id = TimeStepping::local;
+   else if (stepping == "implicit") time_stepping_id = TimeStepping::implicit;
+   else {
+      cout << " Invalid input for time_stepping = " << stepping << " \n";
+      cout << " Choose global, local or implicit, and try again. \n";
+      std::exit(0); //stop
+   }
+
+   //Steady modes: smooth Rotated-RHLL flux (blended below 10% of the sound speed).
+   rhll_smoothing = (time_stepping_id == TimeStepping::global) ? 0.0 : 0.1;
+
+   if      (linsolver == "gs")      linear_solver_id = LinearSolver::gs;
+   else if (linsolver == "umfpack") linear_solver_id = LinearSolver::umfpack;
+   else if (linsolver == "gmres")   linear_solver_id = LinearSolver::gmres;
+   else {
+      cout << " Invalid input for linear_solver = " << linsolver << " \n";
+      cout << " Choose gs, umfpack or gmres, and try again. \n";
+      std::exit(0); //stop
+   }
+   if (linear_solver_id == LinearSolver::umfpack && !SparseBlock::direct_available()) {
+      cout << " linear_solver = umfpack: built without -DCFD_UMFPACK (see Makefile). \n";
+      std::exit(0); //stop
+   }
+
+   if      (precond == "jacobian")     preconditioner_id = Preconditioner::jacobian;
+   else if (precond == "block_jacobi") preconditioner_id = Preconditioner::block_jacobi;
+   else {
+      cout << " Invalid input for preconditioner = " << precond << " \n";
+      cout << " Choose jacobian or block_jacobi, and try again. \n";
+      std::exit(0); //stop
+   }
+
+   if      (mgcycle == "v") multigrid_cycle_id = MGCycle::v;
+   else if (mgcycle == "w") multigrid_cycle_id = MGCycle::w;
+   else {
+      cout << " Invalid input for multigrid_cycle = " << mgcycle << " \n";
+      cout << " Choose v or w, and try again. \n";
+      std::exit(0); //stop
+   }
+   if (multigrid_levels > 1 && time_stepping_id != TimeStepping::local) {
+      cout << " multigrid_levels = " << multigrid_levels << ": multigrid needs time_stepping = local. \n";
+      std::exit(0); //stop
+   }
+
+   // Several ranks: the explicit schemes on the subdomains, with one layer of
+   // ghosts; the rest works on the whole grid only.
+   if (Halo::size() > 1) {
+      std::string whole_grid;
+      if      (time_stepping_id == TimeStepping::implicit) whole_grid = "time_stepping = implicit";
+      else if (multigrid_levels > 1)                       whole_grid = "multigrid_levels > 1";
+      else if (gradient_id == GradientType::quadratic2)    whole_grid = "gradient_type = quadratic2";
+      else if (snapshot_steps > 0 || snapshot_dt > zero)   whole_grid = "snapshots";
+      else if (checkpoint_steps > 0 || restart)            whole_grid = "checkpoints and restart";
+      if (!whole_grid.empty()) {
+         cout << " " << whole_grid << ": not available with ranks = " << Halo::size()
+              << " (the solver runs on subdomains). \n";
+         std::exit(0); //stop
+      }
+   }
+
+} // end set_scheme_options
+
+
+
+//********************************************************************************
+//* Boundary condition name (bc_type in the .bcmap file) -> BCType.
+//* Unknown names give BCType::unknown; the solver stops when it meets one.
+//********************************************************************************
+EulerSolver2D::BCType EulerSolver2D::parse_bc_type(const std::string& bc_type) {
+
+   const std::string bc = trim(bc_type);
+
+   if (bc == "freestream")            return BCType::freestream;
+   if (bc == "slip_wall")             return BCType::slip_wall;
+   if (bc == "outflow_supersonic")    return BCType::outflow_supersonic;
+   if (bc == "outflow_back_pressure") return BCType::outflow_back_pressure;
+   if (bc == "dirichlet")             return BCType::dirichlet;
+
+   return BCType::unknown;
+
+} // end parse_bc_type
+
+
+
+//********************************************************************************
+//* Renumber the nodes for memory locality (called after read_grid and before
+//* construct_grid_data, so that all the connectivity built later, i.e., the
+//* node neighbors, the edges and the LSQ stencils, uses the new numbers).
+//*
+//*  ordering = "none"   : keep the file order
+//*             "rcm"    : Reverse Cuthill-McKee (reduces the bandwidth)
+//*             "morton" : Morton (Z-order) space-filling curve on (x,y)
+//*
+//* The permutation is applied to node[].x,y, elm[].vtx and bound[].bnode.
+//* The bandwidth and the profile of the node adjacency are reported before
+//* and after.
+//********************************************************************************
+void EulerSolver2D::MainData2D::renumber_nodes(const std::string& ordering_in) {
+
+   const std::string ordering = trim(ordering_in);
+   if (ordering == "none") return;
+
+   long bw0, pf0, bw1, pf1;
+   real span0, span1;
+   node_bandwidth(bw0, pf0, span0);
+
+   std::vector<int> old_of_new; // old_of_new[inew] = iold
+   old_of_new.reserve(nnodes);
+
+   if (ordering == "rcm") {
+
+      // Node adjacency from the element sides (CSR, sorted, no duplicates).
+      std::vector< std::vector<int> > adj(nnodes);
+      for (int i = 0; i < nelms; i++) {
+         int nv = elm[i].nvtx;
+         for (int k = 0; k < nv; k++) {
+            int a = e2v[ e2v_ptr[i] + k ];
+            int b = e2v[ e2v_ptr[i] + (k+1)%nv ];
+            adj[a].push_back(b);
+            adj[b].push_back(a);
+         }
+      }
+      for (int i = 0; i < nnodes; i++) {
+         std::sort(adj[i].begin(), adj[i].end());
+         adj[i].erase( std::unique(adj[i].begin(), adj[i].end()), adj[i].end() );
+      }
+
+      std::vector<int>  level(nnodes, -1);
+      std::vector<bool> done(nnodes, false);
+
+      // Breadth-first search from root; returns the last node reached
+      // (a node in the last level set, used to find a pseudo-peripheral root).
+      auto bfs_last = [&](int root) {
+         std::vector<int> visited;
+         std::queue<int> q;
+         q.push(root);
+         level[root] = 0;
+         visited.push_back(root);
+         int last = root;
+         while (!q.empty()) {
+            int n = q.front(); q.pop();
+            if (level[n] > level[last] ||
+               (level[n] == level[last] && adj[n].size() < adj[last].size())) last = n;
+            for (int m : adj[n]) {
+               if (level[m] < 0) { level[m] = level[n]+1; q.push(m); visited.push_back(m); }
+            }
+         }
+         for (int n : visited) level[n] = -1;
+         return last;
+      };
+
+      for (int start = 0; start < nnodes; start++) {
+
+         if (done[start]) continue; // (one pass per connected component)
+
+         // Pseudo-peripheral root: from the first node not yet numbered, move
+         // twice to a farthest node (of min degree in the last level set).
+         int root = start;
+         root = bfs_last(root);
+         root = bfs_last(root);
+
+         // Cuthill-McKee: BFS, neighbors visited in order of increasing degree.
+         std::queue<int> q;
+         q.push(root);
+         done[root] = true;
+         while (!q.empty()) {
+            int n = q.front(); q.pop();
+            old_of_new.push_back(n);
+            std::vector<int> next;
+            for (int m : adj[n]) if (!done[m]) { done[m] = true; next.push_back(m); }
+            std::stable_sort(next.begin(), next.end(), [&adj](int a, int b) {
+               return adj[a].size() < adj[b].size();
+            });
+            for (int m : next) q.push(m);
+         }
+      }
+
+      // Reverse.
+      std::reverse(old_of_new.begin(), old_of_new.end());
+
+   } else if (ordering == "morton") {
+
+      real xmin = node[0].x, xmax = node[0].x, ymin = node[0].y, ymax = node[0].y;
+      for (int i = 0; i < nnodes; i++) {
+         xmin = std::min(xmin, node[i].x);  xmax = std::max(xmax, node[i].x);
+         ymin = std::min(ymin, node[i].y);  ymax = std::max(ymax, node[i].y);
+      }
+      real scale = std::max(xmax-xmin, ymax-ymin);
+      if (scale <= zero) scale = one;
+
+      // 16 bits per direction, interleaved: key = ...y1x1y0x0
+      auto spread = [](unsigned int v) {
+         v = (v | (v << 8)) & 0x00FF00FFu;
+         v = (v | (v << 4)) & 0x0F0F0F0Fu;
+         v = (v | (v << 2)) & 0x33333333u;
+         v = (v | (v << 1)) & 0x55555555u;
+         return v;
+      };
+      std::vector<unsigned int> key(nnodes);
+      for (int i = 0; i < nnodes; i++) {
+         unsigned int ix = (unsigned int)( 65535.0*(node[i].x-xmin)/scale );
+         unsigned int iy = (unsigned int)( 65535.0*(node[i].y-ymin)/scale );
+         key[i] = spread(ix) | (spread(iy) << 1);
+      }
+      for (int i = 0; i < nnodes; i++) old_of_new.push_back(i);
+      std::stable_sort(old_of_new.begin(), old_of_new.end(),
+                       [&key](int a, int b) { return key[a] < key[b]; });
+
+   } else {
+
+      cout << " Invalid input for node_ordering = " << ordering << " \n";
+      cout << " Choose none, rcm or morton, and try again. \n";
+      std::exit(0); //stop
+
+   }
+
+   if ((int)old_of_new.size() != nnodes) {
+      cout << " renumber_nodes: permutation has " << old_of_new.size()
+           << " nodes, expected " << nnodes << " ... Stop. \n";
+      std::exit(0); //stop
+   }
+
+   std::vector<int> new_of_old(nnodes);
+   for (int i = 0; i < nnodes; i++) new_of_old[ old_of_new[i] ] = i;
+
+   // Apply the permutation: node coordinates, element vertices, boundary nodes.
+   std::vector<real> xtemp(nnodes), ytemp(nnodes);
+   for (int i = 0; i < nnodes; i++) {
+      xtemp[i] = node[ old_of_new[i] ].x;
+      ytemp[i] = node[ old_of_new[i] ].y;
+   }
+   for (int i = 0; i < nnodes; i++) {
+      node[i].x = xtemp[i];
+      node[i].y = ytemp[i];
+   }
+
+   for (int i = 0; i < nelms; i++) {
+      for (int k = 0; k < elm[i].nvtx; k++) {
+         e2v[ e2v_ptr[i] + k ] = new_of_old[ e2v[ e2v_ptr[i] + k ] ];
+      }
+   }
+
+   for (int ib = 0; ib < nbound; ib++) {
+      for (int j = 0; j < bound[ib].nbnodes; j++) {
+         (*bound[ib].bnode)(j) = new_of_old[ (*bound[ib].bnode)(j) ];
+      }
+   }
+
+   node_bandwidth(bw1, pf1, span1);
+
+   cout << " " << endl;
+   cout << " Node renumbering: " << ordering << endl;
+   cout << "   bandwidth = " << bw0 << " -> " << bw1 << endl;
+   cout << "   profile   = " << pf0 << " -> " << pf1 << endl;
+   cout << "   ave |n1-n2| over the element sides = " << span0 << " -> " << span1 << endl;
+   cout << " " << endl;
+
+} // end renumber_nodes
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* Bandwidth and profile of the node adjacency (element sides):
+//*
+//*   bandwidth = max |i-j|              over the sides (i,j)
+//*   profile   = sum_i ( i - min_j j )  over the neighbors j < i of i
+//*   ave_span  = average |i-j|          over the sides (counted per element)
+//*
+//* Smaller numbers mean the neighbors of a node are close to it in memory.
+//********************************************************************************
+void EulerSolver2D::MainData2D::node_bandwidth(long& bandwidth, long& profile, real& ave_span) {
+
+   std::vector<int> min_nghbr(nnodes);
+   for (int i = 0; i < nnodes; i++) min_nghbr[i] = i;
+
+   bandwidth = 0;
+   long nsides = 0;
+   double sum_span = 0.0;
+
+   for (int i = 0; i < nelms; i++) {
+      int nv = elm[i].nvtx;
+      for (int k = 0; k < nv; k++) {
+         int a = e2v[ e2v_ptr[i] + k ];
+         int b = e2v[ e2v_ptr[i] + (k+1)%nv ];
+         bandwidth = std::max(bandwidth, (long)std::abs(a-b));
+         sum_span += std::abs(a-b);
+         nsides++;
+         min_nghbr[a] = std::min(min_nghbr[a], b);
+         min_nghbr[b] = std::min(min_nghbr[b], a);
+      }
+   }
+
+   profile = 0;
+   for (int i = 0; i < nnodes; i++) profile += i - min_nghbr[i];
+
+   ave_span = (nsides > 0) ? sum_span/nsides : zero;
+
+} // end node_bandwidth
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* Greedy edge coloring.
+//*
+//* Edges are visited in order and each one gets the smallest color that is not
+//* used by an already-colored edge sharing one of its two nodes. Then all edges
+//* of one color can scatter to their nodes at the same time without a race:
+//*
+//*      o-----o-----o         No two edges of the same color
+//*      |  1  |  2  |         touch the same node, e.g., the
+//*      0     3     0         node in the middle sees colors
+//*      |  2  |  1  |         0, 1, 2, 3 once each.
+//*      o-----o-----o
+//*
+//* The number of colors is at most 2*(max node degree)-1, typically close to
+//* the max degree (6-8 for triangles).
+//*
+//* Output: ncolors, color_ptr(0:ncolors), color_edge(0:nedges-1)
+//********************************************************************************
+void EulerSolver2D::MainData2D::color_edges() {
+
+   std::vector<int> edge_color(nedges, -1);
+
+   // Edges around each node (CSR): node_edge[ node_edge_ptr[i] ... ]
+   std::vector<int> node_edge_ptr(nnodes+1, 0);
+   std::vector<int> node_edge(2*nedges);
+   for (int i = 0; i < nedges; i++) {
+      node_edge_ptr[edge[i].n1+1]++;
+      node_edge_ptr[edge[i].n2+1]++;
+   }
+   for (int i = 0; i < nnodes; i++) node_edge_ptr[i+1] += node_edge_ptr[i];
+   std::vector<int> fill(node_edge_ptr.begin(), node_edge_ptr.end()-1);
+   for (int i = 0; i < nedges; i++) {
+      node_edge[ fill[edge[i].n1]++ ] = i;
+      node_edge[ fill[edge[i].n2]++ ] = i;
+   }
+
+   // Mark the colors taken by the neighbors with the edge number (no reset needed).
+   std::vector<int> taken;
+   ncolors = 0;
+
+   for (int i = 0; i < nedges; i++) {
+
+      const int nodes[2] = { edge[i].n1, edge[i].n2 };
+      for (int ii = 0; ii < 2; ii++) {
+         for (int k = node_edge_ptr[nodes[ii]]; k < node_edge_ptr[nodes[ii]+1]; k++) {
+            int c = edge_color[ node_edge[k] ];
+            if (c >= 0) taken[c] = i;
+         }
+      }
+
+      int c = 0;
+      while (c < ncolors && taken[c] == i) c++;
+      if (c == ncolors) {
+         ncolors++;
+         taken.push_back(-1);
+      }
+      edge_color[i] = c;
+   }
+
+   // Sort the edges by color (counting sort keeps the edge order within a color).
+   color_ptr.assign(ncolors+1, 0);
+   for (int i = 0; i < nedges; i++) color_ptr[ edge_color[i]+1 ]++;
+   for (int c = 0; c < ncolors; c++) color_ptr[c+1] += color_ptr[c];
+   color_edge.resize(nedges);
+   fill.assign(color_ptr.begin(), color_ptr.end()-1);
+   for (int i = 0; i < nedges; i++) color_edge[ fill[edge_color[i]]++ ] = i;
+
+   cout << " " << endl;
+   cout << " Edge coloring: ncolors = " << ncolors << " for nedges = " << nedges << endl;
+   cout << " " << endl;
+
+   check_edge_coloring();
+
+} // end color_edges
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* Check the edge coloring: every edge appears exactly once, and no node is
+//* touched twice by the edges of one color.
+//********************************************************************************
+void EulerSolver2D::MainData2D::check_edge_coloring() {
+
+   std::vector<int> seen_edge(nedges, 0);
+   std::vector<int> seen_node(nnodes, -1);
+
+   for (int c = 0; c < ncolors; c++) {
+      for (int k = color_ptr[c]; k < color_ptr[c+1]; k++) {
+         int i = color_edge[k];
+         seen_edge[i]++;
+         const int nodes[2] = { edge[i].n1, edge[i].n2 };
+         for (int ii = 0; ii < 2; ii++) {
+            if (seen_node[nodes[ii]] == c) {
+               cout << " check_edge_coloring: node " << nodes[ii]
+                    << " is shared by two edges of color " << c << endl;
+               cout << " ... Stop. " << endl;
+               std::exit(0);
+            }
+            seen_node[nodes[ii]] = c;
+         }
+      }
+   }
+
+   for (int i = 0; i < nedges; i++) {
+      if (seen_edge[i] != 1) {
+         cout << " check_edge_coloring: edge " << i << " colored "
+              << seen_edge[i] << " times " << endl;
+         cout << " ... Stop. " << endl;
+         std::exit(0);
+      }
+   }
+
+} // end check_edge_coloring
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* Owner-computes partition for the threaded residual assembly.
+//*
+//* The nodes are split into nparts contiguous blocks of about the same number of
+//* edges (at most nparts_in, and at least 256 nodes per block). An edge is
+//* computed by the part owning its node n1; the contribution to n2 goes directly
+//* into the residual if n2 is owned by the same part, otherwise into the halo
+//* buffer of the part, which the owner of n2 adds afterwards. The halo entries
+//* and the order in which an owner adds them (halo_in: by part, then by edge)
+//* are fixed here, so the sums do not depend on the threads.
+//*
+//* (Contiguous blocks work well when the nodes are numbered with locality,
+//*  so that most edges are inside a block.)
+//********************************************************************************
+void EulerSolver2D::MainData2D::partition_nodes(int nparts_in) {
+
+   nparts = std::max(1, std::min(nparts_in, nnodes/256));
+
+   // Balance the number of edges per part (edges are computed by n1's owner).
+   std::vector<int> edges_of_node(nnodes, 0);
+   for (int i = 0; i < nedges; i++) edges_of_node[edge[i].n1]++;
+
+   part_node_ptr.assign(nparts+1, nnodes);
+   part_node_ptr[0] = 0;
+   int p = 1, count = 0;
+   for (int i = 0; i < nnodes && p < nparts; i++) {
+      count += edges_of_node[i];
+      if ( count >= (long long)p*nedges/nparts ) part_node_ptr[p++] = i+1;
+   }
+
+   node_part.resize(nnodes);
+   for (p = 0; p < nparts; p++) {
+      for (int i = part_node_ptr[p]; i < part_node_ptr[p+1]; i++) node_part[i] = p;
+   }
+
+   part_edge_ptr.assign(nparts+1, 0);
+   for (int i = 0; i < nedges; i++) part_edge_ptr[ node_part[edge[i].n1]+1 ]++;
+   for (p = 0; p < nparts; p++) part_edge_ptr[p+1] += part_edge_ptr[p];
+   part_edge.resize(nedges);
+   std::vector<int> fill(part_edge_ptr.begin(), part_edge_ptr.end()-1);
+   for (int i = 0; i < nedges; i++) part_edge[ fill[node_part[edge[i].n1]]++ ] = i;
+
+   int ncut = 0;
+   for (int i = 0; i < nedges; i++) {
+      if (node_part[edge[i].n1] != node_part[edge[i].n2]) ncut++;
+   }
+
+   // Halo buffers: the n2 of the cut edges of each part, in the order of its
+   // edges; then, for each part, the halo entries (q,m) of its nodes.
+   halo_node.assign(nparts, std::vector<int>());
+   halo_res.assign(nparts, std::vector<real>());
+   halo_in_ptr.assign(nparts+1, 0);
+   for (p = 0; p < nparts; p++) {
+      for (int k = part_edge_ptr[p]; k < part_edge_ptr[p+1]; k++) {
+         const int n2 = edge[part_edge[k]].n2;
+         if (node_part[n2] == p) continue;
+         halo_node[p].push_back(n2);
+         halo_in_ptr[ node_part[n2]+1 ]++;
+      }
+      halo_res[p].resize(5*halo_node[p].size());
+   }
+   for (p = 0; p < nparts; p++) halo_in_ptr[p+1] += halo_in_ptr[p];
+   halo_in.resize(2*halo_in_ptr[nparts]);
+   std::vector<int> next(halo_in_ptr.begin(), halo_in_ptr.end()-1);
+   for (int q = 0; q < nparts; q++) {
+      for (size_t m = 0; m < halo_node[q].size(); m++) {
+         const int j = next[ node_part[halo_node[q][m]] ]++;
+         halo_in[2*j  ] = q;
+         halo_in[2*j+1] = int(m);
+      }
+   }
+
+   cout << " Node partition: nparts = " << nparts << ", cut edges = " << ncut
+        << " of " << nedges << endl;
+
+} // end partition_nodes
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* Tiles for the tiled residual assembly.
+//*
+//* The owned nodes are split into contiguous blocks of tile_size nodes (nearby
+//* nodes, when they are numbered with locality, see node_ordering). A tile
+//* computes the gradients at its nodes and at its halo (the other ends of its
+//* edges), then the fluxes of all the edges with an end in the tile, and adds
+//* them to its own nodes only: no tile writes to the nodes of another, and the
+//* node and stencil data of a tile are read while they are in cache.
+//*
+//* The price: the gradients of the halo nodes and the fluxes of the cut edges
+//* are computed by both tiles (printed below). The edges of a tile are kept in
+//* the order of the edges, so each node gets its fluxes in the same order as
+//* in the serial assembly.
+//********************************************************************************
+void EulerSolver2D::MainData2D::tile_edges(int tile_size_in) {
+
+   const int nown = nodes_owned();
+   const int size = std::max(1, tile_size_in);
+
+   ntiles = std::max(1, (nown + size - 1)/size);
+
+   // Blocks of (almost) the same size.
+   tile_node_ptr.resize(ntiles+1);
+   for (int t = 0; t <= ntiles; t++) {
+      tile_node_ptr[t] = int( (long long)t*nown/ntiles );
+   }
+
+   std::vector<int> node_tile(nnodes, -1);   // -1: a ghost
+   for (int t = 0; t < ntiles; t++) {
+      for (int i = tile_node_ptr[t]; i < tile_node_ptr[t+1]; i++) node_tile[i] = t;
+   }
+
+   // The edges of each tile, in edge order.
+   int ncut = 0;
+   tile_edge_ptr.assign(ntiles+1, 0);
+   for (int i = 0; i < nedges; i++) {
+      const int t1 = node_tile[edge[i].n1];
+      const int t2 = node_tile[edge[i].n2];
+      if (t1 >= 0)             tile_edge_ptr[t1+1]++;
+      if (t2 >= 0 && t2 != t1) tile_edge_ptr[t2+1]++;
+      if (t1 >= 0 && t2 >= 0 && t2 != t1) ncut++;
+   }
+   for (int t = 0; t < ntiles; t++) tile_edge_ptr[t+1] += tile_edge_ptr[t];
+   tile_edge.resize(tile_edge_ptr[ntiles]);
+   std::vector<int> fill(tile_edge_ptr.begin(), tile_edge_ptr.end()-1);
+   for (int i = 0; i < nedges; i++) {
+      const int t1 = node_tile[edge[i].n1];
+      const int t2 = node_tile[edge[i].n2];
+      if (t1 >= 0)             tile_edge[ fill[t1]++ ] = i;
+      if (t2 >= 0 && t2 != t1) tile_edge[ fill[t2]++ ] = i;
+   }
+
+   // The halo of each tile (sorted), and the tile-local ends of its edges.
+   tile_halo_ptr.assign(1, 0);
+   tile_halo.clear();
+   tile_edge_local.resize(2*tile_edge.size());
+   tile_max_nodes = 0;
+
+   for (int t = 0; t < ntiles; t++) {
+
+      const int begin = tile_node_ptr[t];
+      const int nt    = tile_node_ptr[t+1] - begin;
+      const size_t h0 = tile_halo.size();
+
+      for (int k = tile_edge_ptr[t]; k < tile_edge_ptr[t+1]; k++) {
+         const int i = tile_edge[k];
+         if (node_tile[edge[i].n1] != t) tile_halo.push_back(edge[i].n1);
+         if (node_tile[edge[i].n2] != t) tile_halo.push_back(edge[i].n2);
+      }
+      std::sort(tile_halo.begin() + h0, tile_halo.end());
+      tile_halo.erase(std::unique(tile_halo.begin() + h0, tile_halo.end()), tile_halo.end());
+      tile_halo_ptr.push_back(int(tile_halo.size()));
+
+      for (int k = tile_edge_ptr[t]; k < tile_edge_ptr[t+1]; k++) {
+         const int n[2] = { edge[tile_edge[k]].n1, edge[tile_edge[k]].n2 };
+         for (int e = 0; e < 2; e++) {
+            if (node_tile[n[e]] == t) {
+               tile_edge_local[2*k+e] = n[e] - begin;
+            } else {
+               tile_edge_local[2*k+e] = nt + int( std::lower_bound(tile_halo.begin() + h0,
+                                                     tile_halo.end(), n[e]) - (tile_halo.begin() + h0) );
+            }
+         }
+      }
+
+      tile_max_nodes = std::max(tile_max_nodes, nt + int(tile_halo.size() - h0));
+   }
+
+   // (sized by the residual, once per thread)
+   tile_work.clear();
+
+   cout << " Tiles: ntiles = " << ntiles << " of " << size << " nodes, halo nodes = "
+        << tile_halo.size() << ", cut edges (computed twice) = " << ncut
+        << " of " << nedges << endl;
+
+} // end tile_edges
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* The outward unit normals of the slip walls at the nodes: wall_normal[2*i],
+//* [2*i+1] for node i (bnx, bny of its slip_wall segment), zero at the nodes
+//* not on a slip wall. A node on two slip walls (a corner of the domain) takes
+//* the normalized sum of the two normals.
+//*
+//* Used by the limiter of Solver::edge_flux: the gradient at a wall node is
+//* one-sided in the normal direction (all its neighbors are on one side), so
+//* the upwind differences of its edges are taken from the mirror image of the
+//* solution across the wall.
+//********************************************************************************
+void EulerSolver2D::MainData2D::compute_wall_normals() {
+
+   wall_normal.assign(2*size_t(nnodes), zero);
+
+   for (int ib = 0; ib < nbound; ib++) {
+      if (bound[ib].bc != BCType::slip_wall) continue;
+      for (int j = 0; j < bound[ib].nbnodes; j++) {
+         const int i = (*bound[ib].bnode)(j);
+         wall_normal[2*i  ] += (*bound[ib].bnx)(j);
+         wall_normal[2*i+1] += (*bound[ib].bny)(j);
+      }
+   }
+
+   for (int i = 0; i < nnodes; i++) {
+      const real mag = std::sqrt( wall_normal[2*i]*wall_normal[2*i] + wall_normal[2*i+1]*wall_normal[2*i+1] );
+      if (mag > zero) {
+         wall_normal[2*i  ] /= mag;
+         wall_normal[2*i+1] /= mag;
+      }
+   }
+
+} // end compute_wall_normals
+//********************************************************************************
+
+
+
+//********************************************************************************
+//* The subdomain s of the grid g (see Partition::subdomain), as a grid of its
+//* own for the explicit solver: local node k is the grid node s.global[k], the
+//* owned nodes first, then the ghosts.
+//*
+//*  - nodes      : copied from the grid.
+//*  - neighbors  : the lists (and linear LSQ coefficients) of the owned nodes
+//*                 are complete; the ghosts keep their owned neighbors only.
+//*  - edges      : the edges with an owned node, in grid order.
+//*  - boundaries : each run of boundary faces with an owned node is a segment,
+//*                 with the normals and the bc of its grid segment.
+//*  - wall_normal: from the whole grid (a ghost may be on a wall face that is
+//*                 not in the subdomain).
+//*
+//* There are no elements or faces (the node-centered solver does not use
+//* them). The residual at an owned node is the one of the grid, once the
+//* ghosts have their solution and gradients (see compute_residual).
+//*
+//* pack_subdomain writes the subdomain, from the grid, to bytes, and
+//* unpack_subdomain builds it from them: rank 0 packs the subdomains of the
+//* other ranks and sends them (Halo::scatter), so that only rank 0 reads and
+//* preprocesses the whole grid. extract_subdomain does both at once.
+//********************************************************************************
+void EulerSolver2D::MainData2D::extract_subdomain(const MainData2D& g,
+                                                  const Partition::Subdomain& s) {
+
+   unpack_subdomain( g.pack_subdomain(s) );
+
+} // end extract_subdomain
+
+
+
+std::vector<char> EulerSolver2D::MainData2D::pack_subdomain(const Partition::Subdomain& s) const {
+
+   const int nlocal = int(s.global.size());
+   std::vector<int> local(nnodes, -1);
+   for (int k = 0; k < nlocal; k++) local[s.global[k]] = k;
+   auto owned = [&](int gi) { return local[gi] >= 0 && local[gi] < s.nowned; };
+
+   Checkpoint::Writer out;
+
+   //  The subdomain (the halo exchange is set up from it).
+
+   out.put(int32_t(s.rank));
+   out.put(int32_t(s.nranks));
+   out.put(int32_t(s.nowned));
+   out.put_vector(s.global);
+   out.put_vector(s.nbr);
+   out.put_vector(s.send_ptr);  out.put_vector(s.send_idx);
+   out.put_vector(s.recv_ptr);  out.put_vector(s.recv_idx);
+   out.put(int32_t(nq));
+
+   //  Nodes, and their neighbors (CSR) with the linear LSQ coefficients.
+
+   std::vector<int>  l_ptr(1, 0), l_idx;
+   std::vector<real> l_cx, l_cy;
+   for (int k = 0; k < nlocal; k++) {
+      const int gi = s.global[k];
+      for (int j = nghbr_ptr[gi]; j < nghbr_ptr[gi+1]; j++) {
+         const int gn = nghbr_idx[j];
+         if ( k >= s.nowned && !owned(gn) ) continue;
+         l_idx.push_back(local[gn]);
+         if ( !lsq2x2_cx.empty() ) {
+            l_cx.push_back(lsq2x2_cx[j]);
+            l_cy.push_back(lsq2x2_cy[j]);
+         }
+      }
+      l_ptr.push_back(int(l_idx.size()));
+   }
+
+   out.put(int32_t(nlocal));
+   for (int k = 0; k < nlocal; k++) {
+      const node_type& n = node[ s.global[k] ];
+      out.put(n.x);      out.put(n.y);
+      out.put(l_ptr[k+1] - l_ptr[k]);
+      out.put(n.nelms);  out.put(n.vol);  out.put(n.bmark);
+      out.put(n.nbmarks); out.put(n.ar);
+   }
+   out.put_vector(l_ptr);  out.put_vector(l_idx);
+   out.put_vector(l_cx);   out.put_vector(l_cy);
+
+   //  Edges with an owned node (the other one is owned or a ghost).
+
+   std::vector<int> kept;
+   for (int i = 0; i < nedges; i++) {
+      if ( owned(edge[i].n1) || owned(edge[i].n2) ) kept.push_back(i);
+   }
+
+   out.put(int32_t(kept.size()));
+   for (int i : kept) {
+      const edge_type& e = edge[i];
+      const int n1 = local[e.n1];
+      const int n2 = local[e.n2];
+      int kth_nghbr_of_1 = -1, kth_nghbr_of_2 = -1;
+      for (int j = l_ptr[n1]; j < l_ptr[n1+1]; j++) {
+         if (l_idx[j] == n2) kth_nghbr_of_1 = j - l_ptr[n1];
+      }
+      for (int j = l_ptr[n2]; j < l_ptr[n2+1]; j++) {
+         if (l_idx[j] == n1) kth_nghbr_of_2 = j - l_ptr[n2];
+      }
+      out.put(n1); out.put(n2); out.put(e.e1); out.put(e.e2);
+      out.put_array(e.dav.array, 2); out.put(e.da);
+      out.put_array(e.ev.array,  2); out.put(e.e);
+      out.put(kth_nghbr_of_1); out.put(kth_nghbr_of_2);
+   }
+
+   //  Boundary segments: faces first ... last of the grid segment ib.
+
+   struct Run { int ib, first, last; };
+   std::vector<Run> runs;
+   for (int ib = 0; ib < nbound; ib++) {
+      const bgrid_type& b = bound[ib];
+      for (int j = 0; j < b.nbfaces; j++) {
+         if ( !owned((*b.bnode)(j)) && !owned((*b.bnode)(j+1)) ) continue;
+         if (runs.empty() || runs.back().ib != ib || runs.back().last != j-1) {
+            runs.push_back(Run{ib, j, j});
+         } else {
+            runs.back().last = j;
+         }
+      }
+   }
+
+   out.put(int32_t(runs.size()));
+   for (const Run& r : runs) {
+
+      const bgrid_type& b = bound[r.ib];
+      const int j0      = r.first;
+      const int nbfaces = r.last - j0 + 1;
+      const int nbnodes = nbfaces + 1;
+
+      out.put_array(b.bc_type, int64_t(sizeof(b.bc_type)));
+      out.put(b.bc);
+      out.put(int32_t(nbfaces));
+      out.put(int32_t( (b.corner >= j0 && b.corner <= j0 + nbfaces) ? b.corner - j0 : -1 ));
+
+      std::vector<int> bnode(nbnodes);
+      for (int j = 0; j < nbnodes; j++) bnode[j] = local[ (*b.bnode)(j0+j) ];
+      out.put_vector(bnode);
+      out.put_array(&(*b.bnx)(j0),  nbnodes);
+      out.put_array(&(*b.bny)(j0),  nbnodes);
+      out.put_array(&(*b.bn)(j0),   nbnodes);
+      out.put_array(&(*b.bfnx)(j0), nbfaces);
+      out.put_array(&(*b.bfny)(j0), nbfaces);
+      out.put_array(&(*b.bfn)(j0),  nbfaces);
+   }
+
+   //  Slip-wall normals, from the whole grid (a ghost may be on a wall face
+   //  that is not in the subdomain).
+
+   std::vector<real> l_normal(2*size_t(nlocal));
+   for (int k = 0; k < nlocal; k++) {
+      l_normal[2*k  ] = wall_normal[2*s.global[k]  ];
+      l_normal[2*k+1] = wall_normal[2*s.global[k]+1];
+   }
+   out.put_vector(l_normal);
+
+   return std::move(out.bytes);
+
+} // end pack_subdomain
+
+
+
+void EulerSolver2D::MainData2D::unpack_subdomain(const std::vector<char>& bytes) {
+
+   Checkpoint::Reader in(bytes);
+
+   //  The subdomain
+
+   sub.rank   = in.get<int32_t>();
+   sub.nranks = in.get<int32_t>();
+   sub.nowned = in.get<int32_t>();
+   in.get_vector(sub.global);
+   in.get_vector(sub.nbr);
+   in.get_vector(sub.send_ptr);  in.get_vector(sub.send_idx);
+   in.get_vector(sub.recv_ptr);  in.get_vector(sub.recv_idx);
+   nq = in.get<int32_t>();
+
+   //  Nodes, and their neighbors
+
+   nnodes = in.get<int32_t>();
+   if (!in.ok() || nnodes < 0) nnodes = 0;
+   node = new node_type[nnodes];
+   for (int k = 0; k < nnodes; k++) {
+      node_type& n = node[k];
+      n.x       = in.get<real>();  n.y     = in.get<real>();
+      n.nnghbrs = in.get<int>();
+      n.nelms   = in.get<int>();   n.vol   = in.get<real>();  n.bmark = in.get<int>();
+      n.nbmarks = in.get<int>();   n.ar    = in.get<real>();
+   }
+   in.get_vector(nghbr_ptr);  in.get_vector(nghbr_idx);
+   in.get_vector(lsq2x2_cx);  in.get_vector(lsq2x2_cy);
+
+   //  Edges
+
+   nedges = in.get<int32_t>();
+   if (!in.ok() || nedges < 0) nedges = 0;
+   edge = new edge_type[nedges];
+   for (int i = 0; i < nedges; i++) {
+      edge_type& e = edge[i];
+      e.n1 = in.get<int>(); e.n2 = in.get<int>(); e.e1 = in.get<int>(); e.e2 = in.get<int>();
+      in.get_array(e.dav.array, 2); e.da = in.get<real>();
+      in.get_array(e.ev.array,  2); e.e  = in.get<real>();
+      e.kth_nghbr_of_1 = in.get<int>(); e.kth_nghbr_of_2 = in.get<int>();
+   }
+
+   //  Boundary segments
+
+   nbound = in.get<int32_t>();
+   if (!in.ok() || nbound < 0) nbound = 0;
+   bound = new bgrid_type[nbound];
+   for (int r = 0; r < nbound; r++) {
+
+      bgrid_type& lb = bound[r];
+      in.get_array(lb.bc_type, int64_t(sizeof(lb.bc_type)));
+      lb.bc      = in.get<BCType>();
+      lb.nbfaces = std::max(in.get<int32_t>(), 0);
+      lb.nbnodes = lb.nbfaces + 1;
+      lb.corner  = in.get<int32_t>();
+
+      lb.bnode = new Array2D<int>(  lb.nbnodes, 1 );
+      lb.bnx   = new Array2D<real>( lb.nbnodes, 1 );
+      lb.bny   = new Array2D<real>( lb.nbnodes, 1 );
+      lb.bn    = new Array2D<real>( lb.nbnodes, 1 );
+      in.get_array(lb.bnode->array, lb.nbnodes);
+      in.get_array(lb.bnx->array,   lb.nbnodes);
+      in.get_array(lb.bny->array,   lb.nbnodes);
+      in.get_array(lb.bn->array,    lb.nbnodes);
+
+      lb.bfnx = new Array2D<real>( lb.nbfaces, 1 );
+      lb.bfny = new Array2D<real>( lb.nbfaces, 1 );
+      lb.bfn  = new Array2D<real>( lb.nbfaces, 1 );
+      lb.belm = new Array2D<int>(  lb.nbfaces, 1 );
+      lb.kth_nghbr_of_1 = new Array2D<int>( lb.nbfaces, 1 );
+      lb.kth_nghbr_of_2 = new Array2D<int>( lb.nbfaces, 1 );
+      in.get_array(lb.bfnx->array, lb.nbfaces);
+      in.get_array(lb.bfny->array, lb.nbfaces);
+      in.get_array(lb.bfn->array,  lb.nbfaces);
+      for (int j = 0; j < lb.nbfaces; j++) {
+         (*lb.belm)(j) = -1;                 // no elements
+         (*lb.kth_nghbr_of_1)(j) = -1;
+         (*lb.kth_nghbr_of_2)(j) = -1;
+      }
+   }
+
+   //  Slip-wall normals
+
+   in.get_vector(wall_normal);
+
+   if (!in.ok() || wall_normal.size() != 2*size_t(nnodes) || int(nghbr_ptr.size()) != nnodes+1) {
+      cout << " The subdomain of rank " << sub.rank << " is truncated or corrupt. Stop.\n";
+      std::exit(0); //stop
+   }
+
+   //  No elements or faces; the edge coloring, the node partition and the
+   //  tiles of the threaded assembly are built for the subdomain when first used.
+
+   ntria  = 0;
+   nquad  = 0;
+   nelms  = 0;
+   elm    = nullptr;
+   nfaces = 0;
+   face   = nullptr;
+   ncolors = 0;
+   nparts  = 0;
+   ntiles  = 0;
+
+} // end unpack_subdomain
+//********************************************************************************
+
+
+
+
 
 
 //********************************************************************************
@@ -2442,12 +3431,12 @@ void EulerSolver2D::MainData2D::compute_ar() {
       //do k = 1, elm[i].nvtx
       for (size_t k = 0; k < elm[i].nvtx; k ++) {
 
-         n1 = (*elm[i].vtx)(k);
+         n1 = e2v[ e2v_ptr[i] + k ];
          if (k == elm[i].nvtx-1) {
-            n2 = (*elm[i].vtx)(0);
+            n2 = e2v[ e2v_ptr[i] ];
          }
          else {
-            n2 = (*elm[i].vtx)(k+1);
+            n2 = e2v[ e2v_ptr[i] + k+1 ];
          }
 
          side(k) = std::sqrt( (node[n2].x-node[n1].x) * (node[n2].x-node[n1].x) \
@@ -2520,7 +3509,7 @@ void EulerSolver2D::MainData2D::compute_ar() {
       node[i].ar = zero;
       //do k = 1, node[i].nelms
       for (size_t k = 0; k < node[i].nelms; k++) {
-         node[i].ar = node[i].ar + elm[ node[i].elm(k) ].ar;
+         node[i].ar = node[i].ar + elm[ n2e_idx[ n2e_ptr[i] + k ] ].ar;
       } //end do
 
       node[i].ar = node[i].ar / real(node[i].nelms);
@@ -2602,18 +3591,18 @@ void EulerSolver2D::MainData2D::write_tecplot_file(const std::string& datafile)
    for ( int i = 0; i < nelms; ++i ) {
       //Triangles
       if (elm[i].nvtx==3) {
-         outfile  << (*elm[i].vtx)(0,0) << '\t' 
-                  << (*elm[i].vtx)(1,0) << '\t' 
-                  << (*elm[i].vtx)(2,0) << '\t' 
-                  << (*elm[i].vtx)(2,0) <<  "\n"; //The last one is a dummy.
+         outfile  << e2v[ e2v_ptr[i] ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 1 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 2 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 2 ] <<  "\n"; //The last one is a dummy.
       }
 
       //Quadrilaterals
       else if (elm[i].nvtx==4) {
-         outfile  << (*elm[i].vtx)(0,0) << '\t' 
-                  << (*elm[i].vtx)(1,0) << '\t' 
-                  << (*elm[i].vtx)(2,0) << '\t' 
-                  << (*elm[i].vtx)(3,0) <<  "\n"; //The last one is a dummy.
+         outfile  << e2v[ e2v_ptr[i] ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 1 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 2 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 3 ] <<  "\n"; //The last one is a dummy.
 
       }
    }
@@ -2640,6 +3629,508 @@ void EulerSolver2D::MainData2D::write_tecplot_file(const std::string& datafile)
 
 
 
+//********************************************************************************
+//* Write the grid and the solution at nodes in the VTK XML binary format (.vtu):
+//*
+//*   density, velocity (u,v,0), pressure, Mach number   at nodes
+//*   TimeValue                                           the time
+//*
+//* Here the primitive variables w are only copied into a staging buffer of the
+//* writer: the file (compression included) is built and written by the
+//* background I/O thread (see SolutionWriter.h), and the solver can go on
+//* updating the solution right after the call. Call writer.wait() to make sure
+//* the file is on disk.
+//********************************************************************************
+void EulerSolver2D::MainData2D::write_vtu_file(const std::string& datafile, real time) {
+
+   if (!vtu_grid) vtu_grid = make_vtu_grid();
+
+   int k;
+   std::vector<double>& wbuf = writer.acquire_staging(k);
+   wbuf.assign(field.w.begin(), field.w.end());
+
+   // Everything the I/O thread needs is captured by value (the grid is shared).
+   std::shared_ptr<const SolutionWriter::VTUGrid> grid = vtu_grid;
+   const int  nn = nnodes, nv = nq, level = vtu_compression;
+   const real g  = gamma;
+
+   writer.write_staged(datafile, k, [grid, nn, nv, level, g, time](const std::vector<double>& wv) {
+
+      std::vector<double> rho(nn), vel(3*nn), p(nn), mach(nn);
+      for (int i = 0; i < nn; i++) {
+         const double* w = &wv[i*nv];
+         rho[i]     = w[0];
+         vel[3*i  ] = w[1];
+         vel[3*i+1] = w[2];
+         vel[3*i+2] = 0.0;
+         p[i]       = w[3];
+         mach[i]    = std::sqrt( (w[1]*w[1] + w[2]*w[2]) / (g*w[3]/w[0]) );
+      }
+
+      SolutionWriter::VTUFile vtu;
+      vtu.set_grid(grid);
+      vtu.add_point_data("density",  1, std::move(rho));
+      vtu.add_point_data("velocity", 3, std::move(vel));
+      vtu.add_point_data("pressure", 1, std::move(p));
+      vtu.add_point_data("Mach",     1, std::move(mach));
+      vtu.set_time(time);
+      vtu.set_compression(level);
+      return vtu.bytes();
+   });
+}
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Write a snapshot of the solution during a run: snapshot_prefix_NNNN.vtu, and
+//* the collection file snapshot_prefix.pvd with all the snapshots so far (open
+//* the .pvd in ParaView for the time series).
+//*
+//* The solver waits only if the two staging buffers are both still being
+//* written, i.e., if snapshots are asked for faster than the disk can take.
+//********************************************************************************
+void EulerSolver2D::MainData2D::write_snapshot(real time) {
+
+   char number[16];
+   std::snprintf(number, sizeof(number), "_%04d.vtu", int(snapshot_files.size()));
+   const std::string datafile = snapshot_prefix + number;
+
+   write_vtu_file(datafile, time);
+
+   // The .pvd is next to the snapshots: list them without the directory.
+   const std::string::size_type slash = datafile.find_last_of('/');
+   snapshot_files.push_back( std::make_pair(double(time),
+                             slash == std::string::npos ? datafile : datafile.substr(slash+1)) );
+   writer.write(snapshot_prefix + ".pvd", SolutionWriter::pvd_bytes(snapshot_files));
+}
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* The grid part of the .vtu files: node coordinates and elements.
+//********************************************************************************
+std::shared_ptr<const SolutionWriter::VTUGrid> EulerSolver2D::MainData2D::make_vtu_grid() {
+
+   std::shared_ptr<SolutionWriter::VTUGrid> grid = std::make_shared<SolutionWriter::VTUGrid>();
+
+   grid->points.resize(3*nnodes);
+   for (int i = 0; i < nnodes; i++) {
+      grid->points[3*i  ] = node[i].x;
+      grid->points[3*i+1] = node[i].y;
+      grid->points[3*i+2] = zero;
+   }
+
+   grid->connectivity.assign(e2v.begin(), e2v.end());
+   grid->offsets.resize(nelms);
+   grid->types.resize(nelms);
+   for (int i = 0; i < nelms; i++) {
+      grid->offsets[i] = e2v_ptr[i+1];
+      grid->types[i]   = (elm[i].nvtx == 3) ? SolutionWriter::vtk_triangle : SolutionWriter::vtk_quad;
+   }
+
+   return grid;
+}
+//--------------------------------------------------------------------------------
+
+
+
+
+
+//********************************************************************************
+//* Checkpoint/restart (see Checkpoint.h for the dump format)
+//*
+//* A checkpoint holds the conservative variables u at all nodes, the time and
+//* the number of time steps done, tied to the grid by mesh_hash(). It is taken
+//* between two time steps (RK stage 0), where u is the whole state of the
+//* two-stage Runge-Kutta scheme: u0 is stored only for a checkpoint taken
+//* inside a step (stage > 0), which euler_solver_main does not do.
+//*
+//*   magic "EDU2DCKP", version, mesh hash, nnodes, nq, time, step, stage,
+//*   u (nnodes*nq), [u0 (nnodes*nq) if stage > 0]
+//*
+//* The file is written by the I/O thread from a staging copy of u, to
+//* "name.tmp" and then renamed: a run killed at any point leaves the previous
+//* checkpoint or the new one, complete.
+//********************************************************************************
+namespace {
+
+const char checkpoint_magic[8] = {'E','D','U','2','D','C','K','P'};
+const char grid_cache_magic[8] = {'E','D','U','2','D','G','R','D'};
+const int32_t checkpoint_version = 1;
+const int32_t grid_cache_version = 1;
+
+// Array2D<T>* as (nrows, ncols, values); nrows = -1 for a null pointer.
+template<class T>
+void put_array2d(Checkpoint::Writer& out, const Array2D<T>* a) {
+   out.put<int32_t>(a ? a->nrows : -1);
+   out.put<int32_t>(a ? a->ncols :  0);
+   if (a) out.put_array(a->array, int64_t(a->nrows)*a->ncols);
+}
+
+template<class T>
+Array2D<T>* get_array2d(Checkpoint::Reader& in) {
+   const int32_t nrows = in.get<int32_t>();
+   const int32_t ncols = in.get<int32_t>();
+   if (!in.ok() || nrows < 0 || ncols < 0) return nullptr;
+   Array2D<T>* a = new Array2D<T>(nrows, ncols);
+   in.get_array(a->array, int64_t(nrows)*ncols);
+   return a;
+}
+
+// The header of a grid cache file; false if it is not one for this grid.
+bool read_grid_cache_header(Checkpoint::Reader& in, EulerSolver2D::MainData2D& g,
+                            int64_t& lsq_offset, uint64_t& lsq_key) {
+   in.check_magic(grid_cache_magic);
+   const int32_t  version = in.get<int32_t>();
+   const uint64_t hash    = in.get<uint64_t>();
+   const int32_t  nn      = in.get<int32_t>();
+   const int32_t  ne      = in.get<int32_t>();
+   lsq_offset = in.get<int64_t>();
+   lsq_key    = in.get<uint64_t>();
+   return in.ok() && version == grid_cache_version && nn == g.nnodes && ne == g.nelms
+                  && hash == g.mesh_hash();
+}
+
+} // end anonymous namespace
+
+
+
+//********************************************************************************
+//* Hash of the grid as read (and renumbered): coordinates, elements and
+//* boundary nodes/conditions. A checkpoint or a grid cache file is used only
+//* with the grid it was made for.
+//********************************************************************************
+uint64_t EulerSolver2D::MainData2D::mesh_hash() {
+
+   uint64_t h = Checkpoint::hash_seed;
+   h = Checkpoint::hash_bytes(&nnodes, sizeof(nnodes), h);
+   for (int i = 0; i < nnodes; i++) {
+      h = Checkpoint::hash_bytes(&node[i].x, sizeof(real), h);
+      h = Checkpoint::hash_bytes(&node[i].y, sizeof(real), h);
+   }
+   h = Checkpoint::hash_vector(e2v_ptr, h);
+   h = Checkpoint::hash_vector(e2v, h);
+   h = Checkpoint::hash_bytes(&nbound, sizeof(nbound), h);
+   for (int ib = 0; ib < nbound; ib++) {
+      h = Checkpoint::hash_bytes(&bound[ib].bc, sizeof(BCType), h);
+      h = Checkpoint::hash_bytes(bound[ib].bnode->array, bound[ib].nbnodes*sizeof(int), h);
+   }
+   return h;
+}
+//--------------------------------------------------------------------------------
+
+
+
+// Hash of what the LSQ coefficients depend on besides the grid: the weight.
+// (gradient_type does not change them: both sets are always built.)
+uint64_t EulerSolver2D::MainData2D::lsq_hash() {
+
+   uint64_t h = Checkpoint::hash_seed;
+   h = Checkpoint::hash_bytes(&gradient_weight_id, sizeof(gradient_weight_id), h);
+   h = Checkpoint::hash_bytes(&gradient_weight_p,  sizeof(gradient_weight_p),  h);
+   return h;
+}
+//--------------------------------------------------------------------------------
+
+
+
+void EulerSolver2D::MainData2D::write_checkpoint(const std::string& datafile, real time, int step) {
+
+   int k;
+   std::vector<double>& ubuf = writer.acquire_staging(k);
+   ubuf.assign(field.u.begin(), field.u.end());
+
+   const uint64_t hash = mesh_hash();
+   const int32_t  nn = nnodes, nv = nq;
+
+   writer.write_staged(datafile, k, [hash, nn, nv, time, step](const std::vector<double>& u) {
+      Checkpoint::Writer out;
+      out.put_magic(checkpoint_magic);
+      out.put(checkpoint_version);
+      out.put(hash);
+      out.put(nn);
+      out.put(nv);
+      out.put(double(time));
+      out.put(int32_t(step));
+      out.put(int32_t(0));          // RK stage: between two steps
+      out.put_vector(u);
+      return out.bytes;
+   });
+}
+//--------------------------------------------------------------------------------
+
+
+
+// Read a checkpoint into field.u (w is not set here, see euler_solver_main).
+// Returns false, with a message, if the file cannot be used for this grid.
+bool EulerSolver2D::MainData2D::read_checkpoint(const std::string& datafile, real& time, int& step) {
+
+   std::vector<char> bytes;
+   if (!Checkpoint::read_file(datafile, bytes)) {
+      cout << " Cannot read the checkpoint " << datafile << "\n";
+      return false;
+   }
+
+   Checkpoint::Reader in(bytes);
+   in.check_magic(checkpoint_magic);
+   const int32_t  version = in.get<int32_t>();
+   const uint64_t hash    = in.get<uint64_t>();
+   const int32_t  nn      = in.get<int32_t>();
+   const int32_t  nv      = in.get<int32_t>();
+   const double   t       = in.get<double>();
+   const int32_t  nstep   = in.get<int32_t>();
+   const int32_t  stage   = in.get<int32_t>();
+
+   if (!in.ok() || version != checkpoint_version) {
+      cout << " " << datafile << " is not a checkpoint of this code (version " << checkpoint_version << ")\n";
+      return false;
+   }
+   if (hash != mesh_hash() || nn != nnodes || nv != nq) {
+      cout << " " << datafile << " is a checkpoint of another grid\n";
+      return false;
+   }
+
+   in.get_array(field.u.data(), int64_t(nnodes)*nq);
+   if (stage > 0) in.get_array(field.u0.data(), int64_t(nnodes)*nq);
+   if (!in.ok()) {
+      cout << " " << datafile << " is truncated\n";
+      return false;
+   }
+
+   time = t;
+   step = nstep;
+   return true;
+}
+//--------------------------------------------------------------------------------
+
+
+
+//********************************************************************************
+//* Grid data cache: everything construct_grid_data and check_grid_data build,
+//* and the LSQ coefficients (compute_lsq_coeff_nc), so that a later run on the
+//* same grid reads them instead of building them again.
+//*
+//*   magic "EDU2DGRD", version, mesh hash, nnodes, nelms,
+//*   offset of the LSQ section (0 = none), LSQ hash,
+//*   node data, CSR lists, element data, edges, boundary data, faces, colors,
+//*   [LSQ section: linear and quadratic coefficients]
+//*
+//* The file is tied to the grid by mesh_hash() (coordinates, elements and
+//* boundaries after renumbering), and the LSQ section to the gradient weight
+//* by lsq_hash(): a file made for another grid is ignored, and one made with
+//* another weight gives the grid data only. It is read through a memory map,
+//* so only the pages actually read are loaded.
+//********************************************************************************
+void EulerSolver2D::MainData2D::write_grid_cache(const std::string& datafile) {
+
+   Checkpoint::Writer out;
+   out.put_magic(grid_cache_magic);
+   out.put(grid_cache_version);
+   out.put(mesh_hash());
+   out.put(int32_t(nnodes));
+   out.put(int32_t(nelms));
+   const size_t lsq_offset_at = out.bytes.size();
+   out.put(int64_t(0));                  // LSQ section: set below
+   out.put(lsq_hash());
+
+   // Nodes
+   for (int i = 0; i < nnodes; i++) {
+      out.put(node[i].nnghbrs);  out.put(node[i].nelms);
+      out.put(node[i].vol);      out.put(node[i].bmark);
+      out.put(node[i].nbmarks);  out.put(node[i].ar);
+   }
+
+   // CSR lists
+   out.put_vector(n2e_ptr);    out.put_vector(n2e_idx);
+   out.put_vector(nghbr_ptr);  out.put_vector(nghbr_idx);
+   out.put_vector(vnghbr_ptr); out.put_vector(vnghbr_idx);
+
+   // Elements
+   for (int i = 0; i < nelms; i++) {
+      out.put(elm[i].nnghbrs);  out.put(elm[i].x);     out.put(elm[i].y);
+      out.put(elm[i].vol);      out.put(elm[i].bmark); out.put(elm[i].nvnghbrs);
+      out.put(elm[i].ar);
+      put_array2d(out, elm[i].nghbr);
+      put_array2d(out, elm[i].edge);
+   }
+
+   // Edges
+   out.put(int32_t(nedges));
+   for (int i = 0; i < nedges; i++) {
+      const edge_type& e = edge[i];
+      out.put(e.n1); out.put(e.n2); out.put(e.e1); out.put(e.e2);
+      out.put_array(e.dav.array, 2); out.put(e.da);
+      out.put_array(e.ev.array,  2); out.put(e.e);
+      out.put(e.kth_nghbr_of_1); out.put(e.kth_nghbr_of_2);
+   }
+
+   // Boundary data
+   for (int ib = 0; ib < nbound; ib++) {
+      const bgrid_type& b = bound[ib];
+      out.put(b.nbfaces);
+      put_array2d(out, b.bnx);  put_array2d(out, b.bny);  put_array2d(out, b.bn);
+      put_array2d(out, b.bfnx); put_array2d(out, b.bfny); put_array2d(out, b.bfn);
+      put_array2d(out, b.belm);
+      put_array2d(out, b.kth_nghbr_of_1); put_array2d(out, b.kth_nghbr_of_2);
+   }
+
+   // Faces
+   out.put(int32_t(nfaces));
+   for (int i = 0; i < nfaces; i++) {
+      const face_type& f = face[i];
+      out.put(f.n1); out.put(f.n2); out.put(f.e1); out.put(f.e2);
+      out.put(f.da); out.put_array(f.dav.array, 2);
+   }
+
+   // Edge colors
+   out.put(int32_t(ncolors));
+   out.put_vector(color_ptr);
+   out.put_vector(color_edge);
+
+   // LSQ coefficients, if they are built
+   if (!lsq2x2_cx.empty()) {
+      const int64_t lsq_offset = int64_t(out.bytes.size());
+      std::memcpy(out.bytes.data() + lsq_offset_at, &lsq_offset, sizeof(lsq_offset));
+      out.put_vector(lsq2x2_cx);  out.put_vector(lsq2x2_cy);
+      out.put_vector(lsq5x5_ptr); out.put_vector(lsq5x5_in); out.put_vector(lsq5x5_m);
+      out.put_vector(lsq5x5_cx);  out.put_vector(lsq5x5_cy);
+   }
+
+   writer.write(datafile, std::move(out.bytes));
+}
+//--------------------------------------------------------------------------------
+
+
+
+// Read the grid data in place of construct_grid_data and check_grid_data.
+// Returns false (and changes nothing) if there is no file for this grid; a
+// file that matches the grid but is truncated stops the program.
+bool EulerSolver2D::MainData2D::read_grid_cache(const std::string& datafile) {
+
+   Checkpoint::MappedFile file(datafile);
+   if (!file.ok()) return false;
+
+   Checkpoint::Reader in(file.data(), file.size());
+   int64_t lsq_offset;
+   uint64_t lsq_key;
+   if (!read_grid_cache_header(in, *this, lsq_offset, lsq_key)) {
+      cout << " " << datafile << " is not grid data for this grid: ignored\n";
+      return false;
+   }
+
+   cout << " Reading grid data from " << datafile << " (construct_grid_data skipped)\n";
+
+   // Nodes
+   for (int i = 0; i < nnodes; i++) {
+      node[i].nnghbrs = in.get<int>();   node[i].nelms   = in.get<int>();
+      node[i].vol     = in.get<real>();  node[i].bmark   = in.get<int>();
+      node[i].nbmarks = in.get<int>();   node[i].ar      = in.get<real>();
+   }
+
+   // CSR lists
+   in.get_vector(n2e_ptr);    in.get_vector(n2e_idx);
+   in.get_vector(nghbr_ptr);  in.get_vector(nghbr_idx);
+   in.get_vector(vnghbr_ptr); in.get_vector(vnghbr_idx);
+
+   // Elements
+   for (int i = 0; i < nelms && in.ok(); i++) {
+      elm[i].nnghbrs = in.get<int>();   elm[i].x     = in.get<real>(); elm[i].y = in.get<real>();
+      elm[i].vol     = in.get<real>();  elm[i].bmark = in.get<int>();  elm[i].nvnghbrs = in.get<int>();
+      elm[i].ar      = in.get<real>();
+      elm[i].nghbr   = get_array2d<int>(in);
+      elm[i].edge    = get_array2d<int>(in);
+   }
+
+   // Edges
+   nedges = in.get<int32_t>();
+   if (in.ok() && nedges >= 0) {
+      edge = new edge_type[nedges];
+      for (int i = 0; i < nedges && in.ok(); i++) {
+         edge_type& e = edge[i];
+         e.n1 = in.get<int>(); e.n2 = in.get<int>(); e.e1 = in.get<int>(); e.e2 = in.get<int>();
+         in.get_array(e.dav.array, 2); e.da = in.get<real>();
+         in.get_array(e.ev.array,  2); e.e  = in.get<real>();
+         e.kth_nghbr_of_1 = in.get<int>(); e.kth_nghbr_of_2 = in.get<int>();
+      }
+   }
+
+   // Boundary data
+   for (int ib = 0; ib < nbound && in.ok(); ib++) {
+      bgrid_type& b = bound[ib];
+      b.nbfaces = in.get<int>();
+      b.bnx  = get_array2d<real>(in); b.bny  = get_array2d<real>(in); b.bn  = get_array2d<real>(in);
+      b.bfnx = get_array2d<real>(in); b.bfny = get_array2d<real>(in); b.bfn = get_array2d<real>(in);
+      b.belm = get_array2d<int>(in);
+      b.kth_nghbr_of_1 = get_array2d<int>(in); b.kth_nghbr_of_2 = get_array2d<int>(in);
+   }
+
+   // Faces
+   nfaces = in.get<int32_t>();
+   if (in.ok() && nfaces >= 0) {
+      face = new face_type[nfaces];
+      for (int i = 0; i < nfaces && in.ok(); i++) {
+         face_type& f = face[i];
+         f.n1 = in.get<int>(); f.n2 = in.get<int>(); f.e1 = in.get<int>(); f.e2 = in.get<int>();
+         f.da = in.get<real>(); in.get_array(f.dav.array, 2);
+      }
+   }
+
+   // Edge colors
+   ncolors = in.get<int32_t>();
+   in.get_vector(color_ptr);
+   in.get_vector(color_edge);
+
+   if (!in.ok()) {
+      cout << " " << datafile << " is truncated or corrupt: delete it and run again. Stop.\n";
+      std::exit(0); //stop
+   }
+
+   // Slip-wall normals (from the boundary data above)
+   compute_wall_normals();
+
+   return true;
+}
+//--------------------------------------------------------------------------------
+
+
+
+
+
+// Read the LSQ coefficients in place of compute_lsq_coeff_nc. Returns false
+// if the file has none for this grid and gradient weight.
+bool EulerSolver2D::MainData2D::read_lsq_cache(const std::string& datafile) {
+
+   Checkpoint::MappedFile file(datafile);
+   if (!file.ok()) return false;
+
+   Checkpoint::Reader in(file.data(), file.size());
+   int64_t lsq_offset;
+   uint64_t lsq_key;
+   if (!read_grid_cache_header(in, *this, lsq_offset, lsq_key)
+       || lsq_offset <= 0 || lsq_key != lsq_hash()) return false;
+
+   in.seek(size_t(lsq_offset));
+   in.get_vector(lsq2x2_cx);  in.get_vector(lsq2x2_cy);
+   in.get_vector(lsq5x5_ptr); in.get_vector(lsq5x5_in); in.get_vector(lsq5x5_m);
+   in.get_vector(lsq5x5_cx);  in.get_vector(lsq5x5_cy);
+
+   if (!in.ok() || lsq2x2_cx.size() != nghbr_idx.size()
+                || lsq5x5_ptr.size() != size_t(nnodes)+1) {
+      cout << " " << datafile << " is truncated or corrupt: delete it and run again. Stop.\n";
+      std::exit(0); //stop
+   }
+
+   cout << " Reading LSQ coefficients from " << datafile << " (compute_lsq_coeff_nc skipped)\n";
+   return true;
+}
+//--------------------------------------------------------------------------------
+
+
+
+
+
 //********************************************************************************
 // This subroutine writes a grid file to be read by a solver.
 // NOTE: Unlike the tecplot file, this files contains boundary info.
@@ -2665,18 +4156,18 @@ void EulerSolver2D::MainData2D::write_grid_file(const std::string& datafile) {//
    for ( int i = 0; i < nelms; ++i ) {
       //Triangles
       if (elm[i].nvtx==3) {
-         outfile  << (*elm[i].vtx)(0,0) << '\t' 
-                  << (*elm[i].vtx)(1,0) << '\t' 
-                  //<< (*elm[i].vtx)(2,0) << '\t' 
-                  << (*elm[i].vtx)(2,0) <<  "\n"; //The last one is a dummy.
+         outfile  << e2v[ e2v_ptr[i] ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 1 ] << '\t' 
+                  //<< e2v[ e2v_ptr[i] + 2 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 2 ] <<  "\n"; //The last one is a dummy.
       }
 
       //Quadrilaterals
       else if (elm[i].nvtx==4) {
-         outfile  << (*elm[i].vtx)(0,0) << '\t' 
-                  << (*elm[i].vtx)(1,0) << '\t' 
-                  << (*elm[i].vtx)(2,0) << '\t' 
-                  << (*elm[i].vtx)(3,0) <<  "\n"; //The last one is a dummy.
+         outfile  << e2v[ e2v_ptr[i] ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 1 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 2 ] << '\t' 
+                  << e2v[ e2v_ptr[i] + 3 ] <<  "\n"; //The last one is a dummy.
 
       }
    }
@@ -2783,6 +4274,7 @@ void EulerSolver2D::MainData2D::write_grid_file(const std::string& datafile) {//
 //********************************************************************************
 void EulerSolver2D::MainData2D::boot_diagnostic( const std::string& filename = "out.dat") {
    int i,j,os;
+   if (Halo::rank() != 0) return;   // the log files of rank 0 only
    std::ostringstream message;
 
    message << " Euler Solver Log File" << endl;
@@ -2812,6 +4304,7 @@ void EulerSolver2D::MainData2D::boot_diagnostic( const std::string& filename = "
 void EulerSolver2D::MainData2D::write_diagnostic(  std::ostringstream& message,
                                                    const std::string& filename = "out.dat") {
    int i,j,os;
+   if (Halo::rank() != 0) return;
 //--------------------------------------------------------------------------------
    ofstream outfile;
    outfile.open( filename, std::fstream::app  );
@@ -0,0 +1,495 @@
+//********************************************************************************
+//* The ranks of a run and the halo exchange (see Halo.h).
+//*
+//* MPI (-DCFD_MPI): point-to-point messages between neighboring ranks, and the
+//* MPI reductions.
+//*
+//* Shared memory (forked processes): a control block mapped before the fork,
+//* with a process-shared barrier and one slot of max_values values per rank
+//* for the reductions. Each Exchange maps one shared memory object (shm_open)
+//* with a region per rank:
+//*
+//*   int64  nowned, dest[nranks]   dest[p]: the first node of the section of
+//*                                 data sent to rank p (-1: none)
+//*   int64  global[nowned]         grid numbers of the owned nodes
+//*   double data[...]              the values sent (update) or gathered (gather)
+//*
+//* A rank writes its own region, waits at the barrier, reads the regions of the
+//* others, and waits again before its region is written again.
+//*
+//* scatter maps a shared memory object of the same kind for the parts of all
+//* the ranks, written by rank 0 and unmapped when every rank has its part.
+//********************************************************************************
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../include/Halo.h"
+
+#ifdef CFD_MPI
+#include <mpi.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <signal.h>
+#include <sys/prctl.h>
+#endif
+#endif
+
+using std::cout;
+
+
+
+namespace {
+
+#ifndef CFD_MPI
+// Barrier of the forked processes (a process-shared mutex and condition),
+// followed in memory by the reduction slots.
+struct Control {
+   pthread_mutex_t mutex;
+   pthread_cond_t  cond;
+   int             count;
+   int             generation;
+   int             nranks;
+   int             root_pid;
+};
+#endif
+
+struct Group {
+   int rank = 0;
+   int size = 1;
+#ifndef CFD_MPI
+   Control*           control   = nullptr;
+   double*            slots     = nullptr;   // max_values per rank
+   std::vector<pid_t> children;              // rank 0
+   int                nexchange = 0;         // Exchange objects set up (shm names)
+#endif
+} group;
+
+void stop(const std::string& message) {
+   cout << " " << message << ". Stop.\n";
+   std::exit(0); //stop
+}
+
+#ifndef CFD_MPI
+void barrier() {
+   Control* c = group.control;
+   pthread_mutex_lock(&c->mutex);
+   const int generation = c->generation;
+   if (++c->count == c->nranks) {
+      c->count = 0;
+      c->generation++;
+      pthread_cond_broadcast(&c->cond);
+   } else {
+      while (generation == c->generation) pthread_cond_wait(&c->cond, &c->mutex);
+   }
+   pthread_mutex_unlock(&c->mutex);
+}
+#endif
+
+enum class Op { sum, min, max };
+
+void reduce(double* v, int n, Op op) {
+
+   if (group.size <= 1) return;
+
+#ifdef CFD_MPI
+   const MPI_Op mop = (op == Op::sum) ? MPI_SUM : (op == Op::min) ? MPI_MIN : MPI_MAX;
+   MPI_Allreduce(MPI_IN_PLACE, v, n, MPI_DOUBLE, mop, MPI_COMM_WORLD);
+#else
+   //  max_values at a time; every rank combines the slots in rank order, so
+   //  all get the same bits.
+   for (int k0 = 0; k0 < n; k0 += Halo::max_values) {
+      const int nk = std::min(Halo::max_values, n - k0);
+      std::memcpy(group.slots + size_t(group.rank)*Halo::max_values, v + k0, nk*sizeof(double));
+      barrier();
+      for (int k = 0; k < nk; k++) {
+         double r = group.slots[k];
+         for (int q = 1; q < group.size; q++) {
+            const double s = group.slots[size_t(q)*Halo::max_values + k];
+            if      (op == Op::sum) r = r + s;
+            else if (op == Op::min) r = std::min(r, s);
+            else                    r = std::max(r, s);
+         }
+         v[k0+k] = r;
+      }
+      barrier();
+   }
+#endif
+}
+
+} // end anonymous namespace
+
+
+
+void Halo::start(int& argc, char**& argv, int nranks) {
+
+#ifdef CFD_MPI
+   MPI_Init(&argc, &argv);
+   MPI_Comm_rank(MPI_COMM_WORLD, &group.rank);
+   MPI_Comm_size(MPI_COMM_WORLD, &group.size);
+   if (group.rank == 0 && nranks > 1 && nranks != group.size) {
+      cout << " ranks = " << nranks << " ignored: built with MPI, the run has the "
+           << group.size << " ranks of mpirun.\n";
+   }
+#else
+   (void)argc;
+   (void)argv;
+   if (nranks <= 1) return;
+
+   const size_t bytes = sizeof(Control) + size_t(nranks)*max_values*sizeof(double);
+   void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED) stop("Cannot map shared memory for ranks = " + std::to_string(nranks));
+
+   Control* c = static_cast<Control*>(p);
+   pthread_mutexattr_t mattr;
+   pthread_mutexattr_init(&mattr);
+   pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+   pthread_mutex_init(&c->mutex, &mattr);
+   pthread_mutexattr_destroy(&mattr);
+   pthread_condattr_t cattr;
+   pthread_condattr_init(&cattr);
+   pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+   pthread_cond_init(&c->cond, &cattr);
+   pthread_condattr_destroy(&cattr);
+   c->count      = 0;
+   c->generation = 0;
+   c->nranks     = nranks;
+   c->root_pid   = int(getpid());
+
+   group.control = c;
+   group.slots   = reinterpret_cast<double*>(static_cast<char*>(p) + sizeof(Control));
+   group.size    = nranks;
+
+   //  Nothing buffered may be printed again by the copies.
+   std::cout.flush();
+   std::fflush(stdout);
+
+   for (int r = 1; r < nranks; r++) {
+      const pid_t pid = fork();
+      if (pid < 0) stop("fork failed for rank " + std::to_string(r));
+      if (pid == 0) {
+         group.rank = r;
+         group.children.clear();
+#ifdef __linux__
+         prctl(PR_SET_PDEATHSIG, SIGTERM);   // do not wait forever for a rank 0 that stopped
+#endif
+         break;
+      }
+      group.children.push_back(pid);
+   }
+#endif
+
+   //  The other ranks print to their own log files.
+   if (group.rank > 0) {
+      const std::string log = "log/rank_" + std::to_string(group.rank) + ".log";
+      std::cout.flush();
+      if (!std::freopen(log.c_str(), "w", stdout) && !std::freopen("/dev/null", "w", stdout)) {
+         std::cout.setstate(std::ios::badbit);
+      }
+   }
+}
+
+
+
+void Halo::finish() {
+
+   std::cout.flush();
+   std::fflush(stdout);
+
+#ifdef CFD_MPI
+   MPI_Finalize();
+#else
+   for (size_t k = 0; k < group.children.size(); k++) {
+      int status = 0;
+      waitpid(group.children[k], &status, 0);
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+         cout << " Rank " << k+1 << " stopped abnormally (see log/rank_" << k+1 << ".log)\n";
+      }
+   }
+#endif
+}
+
+
+
+int Halo::rank() { return group.rank; }
+int Halo::size() { return group.size; }
+
+std::string Halo::backend() {
+   if (group.size <= 1) return "serial";
+#ifdef CFD_MPI
+   return "MPI";
+#else
+   return "shared memory";
+#endif
+}
+
+void Halo::sum(double* v, int n) { reduce(v, n, Op::sum); }
+void Halo::min(double* v, int n) { reduce(v, n, Op::min); }
+void Halo::max(double* v, int n) { reduce(v, n, Op::max); }
+
+bool Halo::all(bool ok) {
+   double v = ok ? 1.0 : 0.0;
+   reduce(&v, 1, Op::min);
+   return v > 0.0;
+}
+
+
+
+//********************************************************************************
+//* Exchange
+//********************************************************************************
+#ifndef CFD_MPI
+namespace {
+
+// The parts of the region of a rank, at arena + offset.
+int64_t* region_header(char* arena, size_t offset) {
+   return reinterpret_cast<int64_t*>(arena + offset);
+}
+
+double* region_data(char* arena, size_t offset, int nranks) {
+   const int64_t* h = region_header(arena, offset);
+   return reinterpret_cast<double*>(arena + offset + sizeof(int64_t)*(1 + nranks + h[0]));
+}
+
+// One shared memory object of nbytes: made by rank 0, mapped by all, then
+// unlinked (it stays until the last rank unmaps it). Collective.
+char* map_shared(size_t nbytes) {
+
+   const std::string name = "/edu2d_halo_" + std::to_string(group.control->root_pid)
+                          + "_" + std::to_string(group.nexchange++);
+   int fd = -1;
+   if (group.rank == 0) {
+      fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd >= 0 && ftruncate(fd, off_t(nbytes)) != 0) { close(fd); fd = -1; }
+   }
+   if ( !Halo::all(group.rank != 0 || fd >= 0) ) stop("Cannot create the shared memory " + name);
+   if (group.rank != 0) fd = shm_open(name.c_str(), O_RDWR, 0600);
+   void* p = (fd >= 0) ? mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+   if (fd >= 0) close(fd);
+   if ( !Halo::all(p != MAP_FAILED) ) stop("Cannot map the shared memory " + name);
+   if (group.rank == 0) shm_unlink(name.c_str());
+   return static_cast<char*>(p);
+}
+
+} // end anonymous namespace
+#endif
+
+
+
+Halo::Exchange::~Exchange() {
+   release();
+}
+
+
+
+void Halo::Exchange::release() {
+#ifndef CFD_MPI
+   if (arena) munmap(arena, arena_bytes);
+#endif
+   arena       = nullptr;
+   arena_bytes = 0;
+}
+
+
+
+void Halo::Exchange::setup(const Partition::Subdomain& s, int max_stride_in) {
+
+   release();
+
+   rank       = s.rank;
+   nranks     = s.nranks;
+   nowned     = s.nowned;
+   max_stride = max_stride_in;
+   nbr        = s.nbr;
+   send_ptr   = s.send_ptr;   send_idx = s.send_idx;
+   recv_ptr   = s.recv_ptr;   recv_idx = s.recv_idx;
+   owned_global.assign(s.global.begin(), s.global.begin() + s.nowned);
+
+   if (nranks <= 1) return;
+   if (nranks != group.size) stop("Subdomain of " + std::to_string(nranks) + " ranks in a run of "
+                                  + std::to_string(group.size));
+
+#ifdef CFD_MPI
+
+   sendbuf.resize(send_idx.size()*max_stride);
+   recvbuf.resize(recv_idx.size()*max_stride);
+
+   //  Rank 0: the grid numbers of the owned nodes of every rank (gather).
+   all_count.assign(rank == 0 ? nranks : 0, 0);
+   MPI_Gather(&nowned, 1, MPI_INT, all_count.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+   all_displ.assign(all_count.size(), 0);
+   for (size_t q = 1; q < all_count.size(); q++) all_displ[q] = all_displ[q-1] + all_count[q-1];
+   all_global.resize(rank == 0 ? all_displ.back() + all_count.back() : 0);
+   MPI_Gatherv(owned_global.data(), nowned, MPI_INT, all_global.data(), all_count.data(),
+               all_displ.data(), MPI_INT, 0, MPI_COMM_WORLD);
+
+#else
+
+   //  The size of the region of each rank, and their offsets.
+   const size_t nvalues = std::max(send_idx.size(), size_t(nowned))*max_stride;
+   std::vector<double> bytes(nranks, 0.0);
+   bytes[rank] = double( sizeof(int64_t)*(1 + nranks + nowned) + sizeof(double)*nvalues );
+   Halo::sum(bytes.data(), nranks);
+   region.assign(nranks+1, 0);
+   for (int q = 0; q < nranks; q++) region[q+1] = region[q] + size_t(bytes[q]);
+   arena_bytes = region[nranks];
+
+   arena = map_shared(arena_bytes);
+
+   //  The header of this rank.
+   int64_t* h = region_header(arena, region[rank]);
+   h[0] = nowned;
+   for (int q = 0; q < nranks; q++) h[1+q] = -1;
+   for (size_t k = 0; k < nbr.size(); k++) h[1+nbr[k]] = send_ptr[k];
+   for (int i = 0; i < nowned; i++) h[1+nranks+i] = owned_global[i];
+   barrier();
+
+#endif
+}
+
+
+
+void Halo::Exchange::update(double* data, int stride) {
+
+   if (nranks <= 1) return;
+   if (stride > max_stride) stop("Halo exchange of " + std::to_string(stride) + " values per node (set up for "
+                                 + std::to_string(max_stride) + ")");
+
+#ifdef CFD_MPI
+
+   std::vector<MPI_Request> request(2*nbr.size());
+   for (size_t k = 0; k < nbr.size(); k++) {
+      MPI_Irecv(&recvbuf[size_t(recv_ptr[k])*stride], (recv_ptr[k+1] - recv_ptr[k])*stride,
+                MPI_DOUBLE, nbr[k], 0, MPI_COMM_WORLD, &request[k]);
+   }
+   for (size_t m = 0; m < send_idx.size(); m++) {
+      std::memcpy(&sendbuf[m*stride], &data[size_t(send_idx[m])*stride], stride*sizeof(double));
+   }
+   for (size_t k = 0; k < nbr.size(); k++) {
+      MPI_Isend(&sendbuf[size_t(send_ptr[k])*stride], (send_ptr[k+1] - send_ptr[k])*stride,
+                MPI_DOUBLE, nbr[k], 0, MPI_COMM_WORLD, &request[nbr.size()+k]);
+   }
+   MPI_Waitall(int(request.size()), request.data(), MPI_STATUSES_IGNORE);
+   for (size_t m = 0; m < recv_idx.size(); m++) {
+      std::memcpy(&data[size_t(recv_idx[m])*stride], &recvbuf[m*stride], stride*sizeof(double));
+   }
+
+#else
+
+   double* out = region_data(arena, region[rank], nranks);
+   for (size_t m = 0; m < send_idx.size(); m++) {
+      std::memcpy(&out[m*stride], &data[size_t(send_idx[m])*stride], stride*sizeof(double));
+   }
+   barrier();
+
+   for (size_t k = 0; k < nbr.size(); k++) {
+      const int64_t first = region_header(arena, region[nbr[k]])[1+rank];
+      const double* in    = region_data(arena, region[nbr[k]], nranks) + first*stride;
+      for (int m = recv_ptr[k]; m < recv_ptr[k+1]; m++) {
+         std::memcpy(&data[size_t(recv_idx[m])*stride], &in[size_t(m - recv_ptr[k])*stride],
+                     stride*sizeof(double));
+      }
+   }
+   barrier();
+
+#endif
+}
+
+
+
+void Halo::Exchange::gather(const double* data, int stride, double* out) {
+
+   if (nranks <= 1) return;
+   if (stride > max_stride) stop("Gather of " + std::to_string(stride) + " values per node (set up for "
+                                 + std::to_string(max_stride) + ")");
+
+#ifdef CFD_MPI
+
+   std::vector<int> count(all_count.size()), displ(all_displ.size());
+   for (size_t q = 0; q < count.size(); q++) { count[q] = all_count[q]*stride; displ[q] = all_displ[q]*stride; }
+   gatherbuf.resize(all_global.size()*stride);
+   MPI_Gatherv(data, nowned*stride, MPI_DOUBLE, gatherbuf.data(), count.data(), displ.data(),
+               MPI_DOUBLE, 0, MPI_COMM_WORLD);
+   for (size_t m = 0; m < all_global.size(); m++) {
+      std::memcpy(&out[size_t(all_global[m])*stride], &gatherbuf[m*stride], stride*sizeof(double));
+   }
+
+#else
+
+   std::memcpy(region_data(arena, region[rank], nranks), data, size_t(nowned)*stride*sizeof(double));
+   barrier();
+
+   if (rank == 0) {
+      for (int q = 0; q < nranks; q++) {
+         const int64_t* h  = region_header(arena, region[q]);
+         const int64_t* g  = h + 1 + nranks;
+         const double*  in = region_data(arena, region[q], nranks);
+         for (int64_t i = 0; i < h[0]; i++) {
+            std::memcpy(&out[size_t(g[i])*stride], &in[size_t(i)*stride], stride*sizeof(double));
+         }
+      }
+   }
+   barrier();
+
+#endif
+}
+
+
+
+//********************************************************************************
+//* scatter
+//********************************************************************************
+void Halo::scatter(const std::vector< std::vector<char> >& parts, std::vector<char>& mine) {
+
+   if (group.rank == 0 && !parts.empty()) mine = parts[0];
+   if (group.size <= 1) return;
+
+#ifdef CFD_MPI
+
+   if (group.rank == 0) {
+      for (int q = 1; q < group.size; q++) {
+         const int64_t n = int64_t(parts[q].size());
+         MPI_Send(&n, 1, MPI_INT64_T, q, 1, MPI_COMM_WORLD);
+         MPI_Send(parts[q].data(), int(n), MPI_BYTE, q, 2, MPI_COMM_WORLD);
+      }
+   } else {
+      int64_t n = 0;
+      MPI_Recv(&n, 1, MPI_INT64_T, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      mine.resize(size_t(n));
+      MPI_Recv(mine.data(), int(n), MPI_BYTE, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+   }
+
+#else
+
+   //  The sizes of the parts from rank 0, then the parts in one shared object.
+   std::vector<double> nbytes(group.size, 0.0);
+   if (group.rank == 0) {
+      for (int q = 0; q < group.size; q++) nbytes[q] = double(parts[q].size());
+   }
+   Halo::sum(nbytes.data(), group.size);
+   std::vector<size_t> offset(group.size+1, 0);
+   for (int q = 0; q < group.size; q++) offset[q+1] = offset[q] + size_t(nbytes[q]);
+
+   const size_t total = std::max(offset[group.size], size_t(1));
+   char* p = map_shared(total);
+   if (group.rank == 0) {
+      for (int q = 1; q < group.size; q++) std::memcpy(p + offset[q], parts[q].data(), parts[q].size());
+   }
+   barrier();
+   if (group.rank != 0) {
+      mine.assign(p + offset[group.rank], p + offset[group.rank+1]);
+   }
+   barrier();
+   munmap(p, total);
+
+#endif
+}
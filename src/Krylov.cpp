@@ -0,0 +1,142 @@
+//********************************************************************************
+//* Krylov solvers (see Krylov.h).
+//********************************************************************************
+#include <algorithm>
+#include <cmath>
+
+#include "../include/Krylov.h"
+
+
+
+namespace {
+
+double dot(const double* a, const double* b, size_t n) {
+   double s = 0.0;
+   for (size_t k = 0; k < n; k++) s += a[k]*b[k];
+   return s;
+}
+
+} // end anonymous namespace
+
+
+
+//********************************************************************************
+//* Restarted GMRES(m), right-preconditioned (Saad, Iterative Methods for
+//* Sparse Linear Systems, Algorithm 9.5):
+//*
+//*   r = b - A*x,  v_0 = r/||r||
+//*   for j = 0..m-1:  w = A*M^{-1}*v_j, orthogonalized against v_0..v_j
+//*                    (modified Gram-Schmidt) -> column j of H, v_{j+1}
+//*   x = x + M^{-1}*V*y,  y = argmin || ||r|| e_1 - H*y ||
+//*
+//* The least-squares problem is solved progressively with Givens rotations,
+//* which also give its residual, ||b - A*x||, at each step without another
+//* A*x product.
+//********************************************************************************
+int Krylov::GMRES::solve(const linear_map& A, const linear_map& M,
+                         const std::vector<double>& b, std::vector<double>& x) {
+
+   const size_t n = b.size();
+   const int    m = std::max(1, restart);
+
+   v.resize(size_t(m+1)*n);
+   w.resize(n);
+   z.resize(n);
+   h.assign(size_t(m+1)*m, 0.0);
+   cs.assign(m, 0.0);
+   sn.assign(m, 0.0);
+   g.assign(m+1, 0.0);
+   y.assign(m, 0.0);
+   x.resize(n, 0.0);
+
+   const double bnorm = std::sqrt(dot(b.data(), b.data(), n));
+   if (bnorm == 0.0) {
+      std::fill(x.begin(), x.end(), 0.0);
+      rel_residual = 0.0;
+      return 0;
+   }
+
+   //  x = 0: r = b without an A*x product (it may be costly, see Krylov.h)
+   bool x_zero = std::all_of(x.begin(), x.end(), [](double xk) { return xk == 0.0; });
+
+   int its = 0;
+   for (;;) {
+
+      //  r = b - A*x  -> v_0
+
+      if (x_zero) {
+         for (size_t k = 0; k < n; k++) w[k] = b[k];
+         x_zero = false;
+      } else {
+         A(x.data(), w.data());
+         for (size_t k = 0; k < n; k++) w[k] = b[k] - w[k];
+      }
+      const double beta = std::sqrt(dot(w.data(), w.data(), n));
+      rel_residual = beta/bnorm;
+      if (rel_residual <= tolerance || its >= max_iterations) break;
+
+      for (size_t k = 0; k < n; k++) v[k] = w[k]/beta;
+      std::fill(g.begin(), g.end(), 0.0);
+      g[0] = beta;
+
+      //  Arnoldi
+
+      int nj = 0;
+      for (int j = 0; j < m && its < max_iterations; j++) {
+
+         M(&v[size_t(j)*n], z.data());
+         A(z.data(), w.data());
+         its++;
+
+         double* hj = &h[size_t(m+1)*j];
+         for (int i = 0; i <= j; i++) {
+            const double* vi = &v[size_t(i)*n];
+            hj[i] = dot(w.data(), vi, n);
+            for (size_t k = 0; k < n; k++) w[k] -= hj[i]*vi[k];
+         }
+         hj[j+1] = std::sqrt(dot(w.data(), w.data(), n));
+         if (hj[j+1] > 0.0) {
+            double* vn = &v[size_t(j+1)*n];
+            for (size_t k = 0; k < n; k++) vn[k] = w[k]/hj[j+1];
+         }
+
+         //  Previous rotations on the new column, then a new one for h(j+1,j).
+         for (int i = 0; i < j; i++) {
+            const double t = cs[i]*hj[i] + sn[i]*hj[i+1];
+            hj[i+1] = -sn[i]*hj[i] + cs[i]*hj[i+1];
+            hj[i]   = t;
+         }
+         const double r = std::sqrt(hj[j]*hj[j] + hj[j+1]*hj[j+1]);
+         cs[j] = (r > 0.0) ? hj[j]/r   : 1.0;
+         sn[j] = (r > 0.0) ? hj[j+1]/r : 0.0;
+         hj[j]   = r;
+         hj[j+1] = 0.0;
+         g[j+1] = -sn[j]*g[j];
+         g[j]   =  cs[j]*g[j];
+
+         nj = j+1;
+         rel_residual = std::abs(g[j+1])/bnorm;
+         if (rel_residual <= tolerance || r == 0.0) break;
+      }
+
+      //  y = H^{-1} g (upper triangular), x = x + M^{-1}*V*y
+
+      for (int i = nj-1; i >= 0; i--) {
+         double s = g[i];
+         for (int k = i+1; k < nj; k++) s -= h[size_t(m+1)*k + i]*y[k];
+         const double hii = h[size_t(m+1)*i + i];
+         y[i] = (hii != 0.0) ? s/hii : 0.0;
+      }
+      std::fill(w.begin(), w.end(), 0.0);
+      for (int i = 0; i < nj; i++) {
+         const double* vi = &v[size_t(i)*n];
+         for (size_t k = 0; k < n; k++) w[k] += y[i]*vi[k];
+      }
+      M(w.data(), z.data());
+      for (size_t k = 0; k < n; k++) x[k] += z[k];
+
+      if (rel_residual <= tolerance || its >= max_iterations) break;
+   }
+
+   return its;
+}
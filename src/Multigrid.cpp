@@ -0,0 +1,164 @@
+//********************************************************************************
+//* Coarse levels for agglomeration multigrid (see Multigrid.h).
+//********************************************************************************
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+#include "../include/Multigrid.h"
+
+
+
+void Multigrid::Level::allocate(int nq) {
+   u.assign(      size_t(nq)*ncells, 0.0);
+   u0.assign(     size_t(nq)*ncells, 0.0);
+   ur.assign(     size_t(nq)*ncells, 0.0);
+   w.assign(      size_t(nq)*ncells, 0.0);
+   res.assign(    size_t(nq)*ncells, 0.0);
+   forcing.assign(size_t(nq)*ncells, 0.0);
+   wsn.assign(    ncells, 0.0);
+}
+
+
+
+namespace {
+
+// Sum the entries with the same key, in key order: key[k] -> (ax[k], ay[k]).
+// Returns the distinct keys and their sums.
+void reduce_by_key(const std::vector<int64_t>& key,
+                   const std::vector<double>& ax, const std::vector<double>& ay,
+                   std::vector<int64_t>& key_out,
+                   std::vector<double>& ax_out, std::vector<double>& ay_out) {
+
+   std::vector<size_t> order(key.size());
+   std::iota(order.begin(), order.end(), size_t(0));
+   std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key[a] < key[b]; });
+
+   key_out.clear();
+   ax_out.clear();
+   ay_out.clear();
+   for (size_t m = 0; m < order.size(); m++) {
+      const size_t k = order[m];
+      if (key_out.empty() || key_out.back() != key[k]) {
+         key_out.push_back(key[k]);
+         ax_out.push_back(0.0);
+         ay_out.push_back(0.0);
+      }
+      ax_out.back() += ax[k];
+      ay_out.back() += ay[k];
+   }
+}
+
+} // end anonymous namespace
+
+
+
+void Multigrid::coarsen(const Level& fine, Level& coarse) {
+
+   const int n = fine.ncells;
+
+   //  Neighbors of each fine cell (CSR), from the interior faces
+
+   std::vector<int> ptr(n+1, 0), idx(2*fine.e1.size());
+   for (size_t k = 0; k < fine.e1.size(); k++) { ptr[fine.e1[k]+1]++; ptr[fine.e2[k]+1]++; }
+   for (int i = 0; i < n; i++) ptr[i+1] += ptr[i];
+   {
+      std::vector<int> fill(ptr.begin(), ptr.end()-1);
+      for (size_t k = 0; k < fine.e1.size(); k++) {
+         idx[fill[fine.e1[k]]++] = fine.e2[k];
+         idx[fill[fine.e2[k]]++] = fine.e1[k];
+      }
+   }
+
+   //  Seeds: cells with boundary faces first, so that the agglomerates
+   //  follow the boundary, then the others, in order.
+
+   std::vector<char> on_boundary(n, 0);
+   for (int c : fine.bcell) on_boundary[c] = 1;
+   std::vector<int> order;
+   order.reserve(n);
+   for (int i = 0; i < n; i++) if ( on_boundary[i]) order.push_back(i);
+   for (int i = 0; i < n; i++) if (!on_boundary[i]) order.push_back(i);
+
+   std::vector<int>& parent = coarse.parent;
+   parent.assign(n, -1);
+   int nc = 0;
+   for (int seed : order) {
+      if (parent[seed] >= 0) continue;
+      parent[seed] = nc;
+      for (int k = ptr[seed]; k < ptr[seed+1]; k++) {
+         if (parent[idx[k]] < 0) parent[idx[k]] = nc;
+      }
+      nc++;
+   }
+
+   //  Single-cell agglomerates join their smallest neighboring agglomerate.
+
+   std::vector<int> size(nc, 0);
+   for (int i = 0; i < n; i++) size[parent[i]]++;
+   for (int i = 0; i < n; i++) {
+      if (size[parent[i]] != 1) continue;
+      int best = -1;
+      for (int k = ptr[i]; k < ptr[i+1]; k++) {
+         const int a = parent[idx[k]];
+         if (a != parent[i] && (best < 0 || size[a] < size[best])) best = a;
+      }
+      if (best < 0) continue;   // no neighbor: stays alone
+      size[parent[i]]--;
+      size[best]++;
+      parent[i] = best;
+   }
+
+   //  Renumber the agglomerates that are left, in order of first appearance.
+
+   std::vector<int> number(nc, -1);
+   coarse.ncells = 0;
+   for (int i = 0; i < n; i++) {
+      if (number[parent[i]] < 0) number[parent[i]] = coarse.ncells++;
+      parent[i] = number[parent[i]];
+   }
+
+   //  Volumes
+
+   coarse.vol.assign(coarse.ncells, 0.0);
+   for (int i = 0; i < n; i++) coarse.vol[parent[i]] += fine.vol[i];
+
+   //  Interior faces: fine faces between two agglomerates, summed per pair
+   //  (oriented from the lower to the higher agglomerate number).
+
+   const int64_t nc64 = coarse.ncells;
+   std::vector<int64_t> key, key_out;
+   std::vector<double>  ax, ay;
+   for (size_t k = 0; k < fine.e1.size(); k++) {
+      const int c1 = parent[fine.e1[k]];
+      const int c2 = parent[fine.e2[k]];
+      if (c1 == c2) continue;
+      const double s = (c1 < c2) ? 1.0 : -1.0;
+      key.push_back( int64_t(std::min(c1,c2))*nc64 + std::max(c1,c2) );
+      ax.push_back(s*fine.eax[k]);
+      ay.push_back(s*fine.eay[k]);
+   }
+   reduce_by_key(key, ax, ay, key_out, coarse.eax, coarse.eay);
+   coarse.e1.resize(key_out.size());
+   coarse.e2.resize(key_out.size());
+   for (size_t k = 0; k < key_out.size(); k++) {
+      coarse.e1[k] = int(key_out[k] / nc64);
+      coarse.e2[k] = int(key_out[k] % nc64);
+   }
+
+   //  Boundary faces: summed per agglomerate and boundary segment.
+
+   int nseg = 0;
+   for (int s : fine.bseg) nseg = std::max(nseg, s+1);
+   key.clear();
+   for (size_t k = 0; k < fine.bcell.size(); k++) {
+      key.push_back( int64_t(parent[fine.bcell[k]])*nseg + fine.bseg[k] );
+   }
+   reduce_by_key(key, fine.bax, fine.bay, key_out, coarse.bax, coarse.bay);
+   coarse.bcell.resize(key_out.size());
+   coarse.bseg.resize(key_out.size());
+   for (size_t k = 0; k < key_out.size(); k++) {
+      coarse.bcell[k] = int(key_out[k] / nseg);
+      coarse.bseg[k]  = int(key_out[k] % nseg);
+   }
+}
@@ -0,0 +1,159 @@
+//********************************************************************************
+//* Domain decomposition (see Partition.h).
+//********************************************************************************
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <utility>
+
+#include "../include/Partition.h"
+
+#ifdef CFD_METIS
+#include <metis.h>
+#endif
+
+using std::cout;
+
+
+
+bool Partition::metis_available() {
+#ifdef CFD_METIS
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+
+void Partition::rcb(const std::vector<double>& x, const std::vector<double>& y, int nparts,
+                    std::vector<int>& part) {
+
+   const int n = int(x.size());
+   std::vector<int> order(n);
+   std::iota(order.begin(), order.end(), 0);
+   part.assign(n, 0);
+
+   //  Points order[begin ... end-1] -> parts first ... first+np-1: cut at the
+   //  point that leaves np1/np of them on the low side (ties by the node
+   //  number, so that the cut does not depend on the sort).
+
+   struct Range { int begin, end, first, np; };
+   std::vector<Range> stack(1, Range{0, n, 0, std::max(1, nparts)});
+
+   while (!stack.empty()) {
+
+      const Range r = stack.back();
+      stack.pop_back();
+
+      if (r.np == 1) {
+         for (int k = r.begin; k < r.end; k++) part[order[k]] = r.first;
+         continue;
+      }
+
+      double xmin = 1.0e+300, xmax = -1.0e+300, ymin = 1.0e+300, ymax = -1.0e+300;
+      for (int k = r.begin; k < r.end; k++) {
+         xmin = std::min(xmin, x[order[k]]);  xmax = std::max(xmax, x[order[k]]);
+         ymin = std::min(ymin, y[order[k]]);  ymax = std::max(ymax, y[order[k]]);
+      }
+      const std::vector<double>& c = (xmax - xmin >= ymax - ymin) ? x : y;
+
+      const int np1 = r.np/2;
+      const int mid = r.begin + int( int64_t(r.end - r.begin)*np1/r.np );
+      std::nth_element(order.begin() + r.begin, order.begin() + mid, order.begin() + r.end,
+                       [&c](int a, int b) { return c[a] < c[b] || (c[a] == c[b] && a < b); });
+
+      stack.push_back(Range{r.begin, mid, r.first,       np1       });
+      stack.push_back(Range{mid,   r.end, r.first + np1, r.np - np1});
+   }
+}
+
+
+
+void Partition::metis(const std::vector<int>& ptr, const std::vector<int>& idx, int nparts,
+                      std::vector<int>& part) {
+
+   const int n = int(ptr.size()) - 1;
+   part.assign(n, 0);
+   if (nparts <= 1) return;
+
+#ifdef CFD_METIS
+   std::vector<idx_t> xadj(ptr.begin(), ptr.end()), adjncy(idx.begin(), idx.end()), p(n);
+   idx_t nvtxs = n, ncon = 1, np = nparts, objval;
+   idx_t options[METIS_NOPTIONS];
+   METIS_SetDefaultOptions(options);
+   options[METIS_OPTION_SEED] = 1;   // the same partition on every rank
+
+   if (METIS_PartGraphKway(&nvtxs, &ncon, xadj.data(), adjncy.data(), nullptr, nullptr, nullptr,
+                           &np, nullptr, nullptr, options, &objval, p.data()) != METIS_OK) {
+      cout << " METIS_PartGraphKway failed. Stop.\n";
+      std::exit(0); //stop
+   }
+   for (int i = 0; i < n; i++) part[i] = int(p[i]);
+#else
+   (void)idx;
+   cout << " partitioner = metis: built without -DCFD_METIS (see Makefile). Stop.\n";
+   std::exit(0); //stop
+#endif
+}
+
+
+
+void Partition::subdomain(const std::vector<int>& part, int nranks,
+                          const std::vector<int>& ptr, const std::vector<int>& idx,
+                          int rank, Subdomain& s) {
+
+   const int n = int(part.size());
+
+   s.rank   = rank;
+   s.nranks = nranks;
+   s.global.clear();
+   for (int i = 0; i < n; i++) if (part[i] == rank) s.global.push_back(i);
+   s.nowned = int(s.global.size());
+
+   //  (rank, node) pairs: the ghosts (owner, ghost node) and the sent nodes
+   //  (receiver, owned node), sorted and without repeats.
+
+   std::vector< std::pair<int,int> > ghost, sent;
+   for (int m = 0; m < s.nowned; m++) {
+      const int i = s.global[m];
+      for (int k = ptr[i]; k < ptr[i+1]; k++) {
+         const int q = part[idx[k]];
+         if (q == rank) continue;
+         ghost.push_back(std::make_pair(q, idx[k]));
+         sent.push_back( std::make_pair(q, i));
+      }
+   }
+   std::sort(ghost.begin(), ghost.end());
+   ghost.erase(std::unique(ghost.begin(), ghost.end()), ghost.end());
+   std::sort(sent.begin(), sent.end());
+   sent.erase(std::unique(sent.begin(), sent.end()), sent.end());
+
+   //  Local numbers: owned nodes, then the ghosts.
+
+   std::vector<int> local(n, -1);
+   for (int m = 0; m < s.nowned; m++) local[s.global[m]] = m;
+   for (const auto& g : ghost) {
+      local[g.second] = int(s.global.size());
+      s.global.push_back(g.second);
+   }
+
+   //  Neighboring ranks (the graph is symmetric: a rank that has ghosts of
+   //  this one also sends to it), and the lists per rank.
+
+   s.nbr.clear();
+   s.send_ptr.assign(1, 0);  s.send_idx.clear();
+   s.recv_ptr.assign(1, 0);  s.recv_idx.clear();
+   size_t ig = 0, is = 0;
+   while (ig < ghost.size() || is < sent.size()) {
+      const int q = std::min(ig < ghost.size() ? ghost[ig].first : nranks,
+                             is < sent.size()  ? sent[is].first  : nranks);
+      s.nbr.push_back(q);
+      for (; ig < ghost.size() && ghost[ig].first == q; ig++) s.recv_idx.push_back(local[ghost[ig].second]);
+      for (; is < sent.size()  && sent[is].first  == q; is++) s.send_idx.push_back(local[sent[is].second]);
+      s.recv_ptr.push_back(int(s.recv_idx.size()));
+      s.send_ptr.push_back(int(s.send_idx.size()));
+   }
+}
@@ -0,0 +1,378 @@
+//********************************************************************************
+//* Binary solution output (see SolutionWriter.h).
+//********************************************************************************
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef CFD_ZLIB
+#include <zlib.h>
+#endif
+
+#include "../include/SolutionWriter.h"
+
+
+
+//********************************************************************************
+//* VTUFile
+//*
+//* Layout of the file:
+//*
+//*   <VTKFile type="UnstructuredGrid" ... header_type="UInt64">
+//*    <UnstructuredGrid>
+//*     <FieldData> TimeValue </FieldData>            (if set_time was called)
+//*     <Piece NumberOfPoints=.. NumberOfCells=..>
+//*      <PointData> one DataArray per field </PointData>
+//*      <Points> x,y,z </Points>
+//*      <Cells> connectivity, offsets, types </Cells>
+//*     </Piece>
+//*    </UnstructuredGrid>
+//*    <AppendedData encoding="raw">
+//*   _[block][block]...
+//*    </AppendedData>
+//*   </VTKFile>
+//*
+//* Each DataArray gives the offset of its block in the appended data, and a
+//* block is, in the byte order of this machine,
+//*
+//*   uncompressed : [n bytes] [array]
+//*   compressed   : [nchunks][chunk size][size of the last chunk][compressed
+//*                  size of each chunk] [compressed chunks]   (all UInt64;
+//*                  the array is cut into chunks compressed one by one)
+//*
+//********************************************************************************
+
+void SolutionWriter::VTUFile::set_grid(std::shared_ptr<const VTUGrid> g) {
+   grid = std::move(g);
+}
+
+void SolutionWriter::VTUFile::add_point_data(const std::string& name, int ncomp,
+                                             std::vector<double> values) {
+   point_data.push_back( data_array{name, ncomp, std::move(values)} );
+}
+
+void SolutionWriter::VTUFile::set_time(double t) {
+   has_time = true;
+   time     = t;
+}
+
+void SolutionWriter::VTUFile::set_compression(int level) {
+   compression = std::max(0, std::min(9, level));
+#ifndef CFD_ZLIB
+   compression = 0;
+#endif
+}
+
+bool SolutionWriter::zlib_available() {
+#ifdef CFD_ZLIB
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+
+namespace {
+
+// One block of the appended data. Uncompressed, the array is copied from
+// where it is (data, nbytes) when the file is put together; compressed, the
+// whole block is in encoded.
+struct vtu_block {
+   const char*       data   = nullptr;
+   uint64_t          nbytes = 0;
+   std::vector<char> encoded;
+   bool              compressed = false;
+
+   uint64_t size() const {
+      return compressed ? encoded.size() : sizeof(uint64_t) + nbytes;
+   }
+};
+
+const uint64_t chunk_size = 1 << 20;
+
+template<class T>
+vtu_block make_block(const std::vector<T>& a, int level) {
+
+   vtu_block b;
+   b.data   = reinterpret_cast<const char*>(a.data());
+   b.nbytes = a.size()*sizeof(T);
+   if (level == 0 || b.nbytes == 0) return b;
+
+#ifdef CFD_ZLIB
+   const uint64_t nchunks = (b.nbytes + chunk_size - 1)/chunk_size;
+   std::vector<uint64_t> header(3 + nchunks);
+   header[0] = nchunks;
+   header[1] = chunk_size;
+   header[2] = b.nbytes - (nchunks-1)*chunk_size;   // the last chunk
+
+   b.encoded.resize( header.size()*sizeof(uint64_t) + nchunks*compressBound(chunk_size) );
+   uint64_t pos = header.size()*sizeof(uint64_t);
+
+   for (uint64_t c = 0; c < nchunks; c++) {
+      const uint64_t usize = (c+1 < nchunks) ? chunk_size : header[2];
+      uLongf csize = compressBound(usize);
+      compress2(reinterpret_cast<Bytef*>(&b.encoded[pos]), &csize,
+                reinterpret_cast<const Bytef*>(b.data + c*chunk_size), usize, level);
+      header[3+c] = csize;
+      pos += csize;
+   }
+
+   std::memcpy(b.encoded.data(), header.data(), header.size()*sizeof(uint64_t));
+   b.encoded.resize(pos);
+   b.compressed = true;
+#endif
+
+   return b;
+}
+
+char* copy_block(char* dst, const vtu_block& b) {
+   if (b.compressed) {
+      std::memcpy(dst, b.encoded.data(), b.encoded.size());
+      return dst + b.encoded.size();
+   }
+   std::memcpy(dst, &b.nbytes, sizeof(uint64_t));
+   if (b.nbytes > 0) std::memcpy(dst + sizeof(uint64_t), b.data, b.nbytes);
+   return dst + sizeof(uint64_t) + b.nbytes;
+}
+
+bool little_endian() {
+   const uint16_t one = 1;
+   char c;
+   std::memcpy(&c, &one, 1);
+   return c == 1;
+}
+
+} // end anonymous namespace
+
+
+
+// The blocks are compressed first (if at all): the XML needs their offsets.
+// The arrays are then copied once into the file buffer.
+std::vector<char> SolutionWriter::VTUFile::bytes() const {
+
+   static const VTUGrid empty_grid;
+   const VTUGrid& g = grid ? *grid : empty_grid;
+
+   const size_t npoints = g.points.size()/3;
+   const size_t ncells  = g.types.size();
+
+   std::vector<vtu_block> blocks;
+   for (const data_array& d : point_data) blocks.push_back( make_block(d.values, compression) );
+   blocks.push_back( make_block(g.points,       compression) );
+   blocks.push_back( make_block(g.connectivity, compression) );
+   blocks.push_back( make_block(g.offsets,      compression) );
+   blocks.push_back( make_block(g.types,        compression) );
+
+   std::vector<uint64_t> offset(blocks.size()+1, 0);
+   for (size_t k = 0; k < blocks.size(); k++) offset[k+1] = offset[k] + blocks[k].size();
+
+   std::ostringstream xml;
+   size_t k = 0;
+   xml << "<?xml version=\"1.0\"?>\n";
+   xml << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\""
+       << (little_endian() ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\""
+       << (compression > 0 ? " compressor=\"vtkZLibDataCompressor\"" : "") << ">\n";
+   xml << " <UnstructuredGrid>\n";
+   if (has_time) {
+      xml.precision(17);
+      xml << "  <FieldData>\n";
+      xml << "   <DataArray type=\"Float64\" Name=\"TimeValue\" NumberOfTuples=\"1\" format=\"ascii\">"
+          << time << "</DataArray>\n";
+      xml << "  </FieldData>\n";
+   }
+   xml << "  <Piece NumberOfPoints=\"" << npoints << "\" NumberOfCells=\"" << ncells << "\">\n";
+
+   xml << "   <PointData>\n";
+   for (const data_array& d : point_data) {
+      xml << "    <DataArray type=\"Float64\" Name=\"" << d.name << "\" NumberOfComponents=\""
+          << d.ncomp << "\" format=\"appended\" offset=\"" << offset[k++] << "\"/>\n";
+   }
+   xml << "   </PointData>\n";
+
+   xml << "   <Points>\n";
+   xml << "    <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\""
+       << offset[k++] << "\"/>\n";
+   xml << "   </Points>\n";
+
+   xml << "   <Cells>\n";
+   xml << "    <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\""
+       << offset[k++] << "\"/>\n";
+   xml << "    <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\""
+       << offset[k++] << "\"/>\n";
+   xml << "    <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\""
+       << offset[k++] << "\"/>\n";
+   xml << "   </Cells>\n";
+
+   xml << "  </Piece>\n";
+   xml << " </UnstructuredGrid>\n";
+   xml << " <AppendedData encoding=\"raw\">\n_";
+
+   const std::string head = xml.str();
+   const std::string tail = "\n </AppendedData>\n</VTKFile>\n";
+
+   std::vector<char> file(head.size() + offset.back() + tail.size());
+   char* p = file.data();
+   std::memcpy(p, head.data(), head.size());
+   p += head.size();
+   for (const vtu_block& b : blocks) p = copy_block(p, b);
+   std::memcpy(p, tail.data(), tail.size());
+
+   return file;
+}
+
+
+
+//********************************************************************************
+//* ParaView collection file: the snapshots of a run as one time series.
+//********************************************************************************
+std::vector<char> SolutionWriter::pvd_bytes(
+                  const std::vector< std::pair<double,std::string> >& files) {
+
+   std::ostringstream xml;
+   xml.precision(17);
+   xml << "<?xml version=\"1.0\"?>\n";
+   xml << "<VTKFile type=\"Collection\" version=\"0.1\">\n";
+   xml << " <Collection>\n";
+   for (const auto& f : files) {
+      xml << "  <DataSet timestep=\"" << f.first << "\" part=\"0\" file=\"" << f.second << "\"/>\n";
+   }
+   xml << " </Collection>\n";
+   xml << "</VTKFile>\n";
+
+   const std::string s = xml.str();
+   return std::vector<char>(s.begin(), s.end());
+}
+
+
+
+//********************************************************************************
+//* AsyncWriter
+//*
+//* One I/O thread takes the jobs from a queue, in order. The caller gives up
+//* its buffer (std::move), so nothing is shared with the solver once a job is
+//* queued. A staging buffer belongs to the caller from acquire_staging to
+//* write_staged, and then to the I/O thread until its file is written.
+//********************************************************************************
+
+SolutionWriter::AsyncWriter::AsyncWriter(int nstaging)
+   : staging(std::max(1, nstaging)), staging_busy(std::max(1, nstaging), false) {}
+
+SolutionWriter::AsyncWriter::~AsyncWriter() {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+   }
+   queued.notify_one();
+   if (thread.joinable()) thread.join();
+}
+
+void SolutionWriter::AsyncWriter::queue_job(job j) {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back(std::move(j));
+      if (!thread.joinable()) thread = std::thread(&AsyncWriter::run, this);
+   }
+   queued.notify_one();
+}
+
+void SolutionWriter::AsyncWriter::write(const std::string& filename, std::vector<char> bytes) {
+   queue_job( job{filename, std::move(bytes), -1, encoder()} );
+}
+
+std::vector<double>& SolutionWriter::AsyncWriter::acquire_staging(int& k) {
+
+   std::unique_lock<std::mutex> lock(mutex);
+   auto free_buffer = [this]{
+      return std::find(staging_busy.begin(), staging_busy.end(), false) != staging_busy.end(); };
+
+   if (!free_buffer()) {
+      auto t0 = std::chrono::steady_clock::now();
+      released.wait(lock, free_buffer);
+      stall += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+   }
+
+   k = int( std::find(staging_busy.begin(), staging_busy.end(), false) - staging_busy.begin() );
+   staging_busy[k] = true;
+   return staging[k];
+}
+
+void SolutionWriter::AsyncWriter::write_staged(const std::string& filename, int k, encoder encode) {
+   queue_job( job{filename, std::vector<char>(), k, std::move(encode)} );
+}
+
+void SolutionWriter::AsyncWriter::wait() {
+   std::unique_lock<std::mutex> lock(mutex);
+   idle.wait(lock, [this]{ return queue.empty() && !busy; });
+}
+
+long SolutionWriter::AsyncWriter::files_written() const {
+   std::lock_guard<std::mutex> lock(mutex);
+   return nfiles;
+}
+
+long SolutionWriter::AsyncWriter::bytes_written() const {
+   std::lock_guard<std::mutex> lock(mutex);
+   return nbytes;
+}
+
+double SolutionWriter::AsyncWriter::stall_seconds() const {
+   std::lock_guard<std::mutex> lock(mutex);
+   return stall;
+}
+
+void SolutionWriter::AsyncWriter::run() {
+
+   std::unique_lock<std::mutex> lock(mutex);
+
+   while (true) {
+
+      queued.wait(lock, [this]{ return stop || !queue.empty(); });
+      if (queue.empty()) break;  // stop, and nothing left to write
+
+      job j = std::move(queue.front());
+      queue.pop_front();
+      busy = true;
+
+      lock.unlock();
+      if (j.staging >= 0) j.bytes = j.encode(staging[j.staging]);
+      write_file(j.filename, j.bytes);
+      lock.lock();
+
+      if (j.staging >= 0) {
+         staging_busy[j.staging] = false;
+         released.notify_all();
+      }
+      busy = false;
+      nfiles++;
+      nbytes += long(j.bytes.size());
+      if (queue.empty()) idle.notify_all();
+   }
+
+   idle.notify_all();
+}
+
+// Write to filename.tmp, then rename: the file appears complete or not at all.
+bool SolutionWriter::write_file(const std::string& filename, const std::vector<char>& bytes) {
+
+   const std::string tmpfile = filename + ".tmp";
+
+   std::FILE* out = std::fopen(tmpfile.c_str(), "wb");
+   if (!out) {
+      std::cout << " Cannot open " << tmpfile << " for writing \n";
+      return false;
+   }
+
+   const size_t nwritten = bytes.empty() ? 0 : std::fwrite(bytes.data(), 1, bytes.size(), out);
+   const bool ok = (std::fclose(out) == 0) && nwritten == bytes.size();
+
+   if (!ok || std::rename(tmpfile.c_str(), filename.c_str()) != 0) {
+      std::cout << " Error writing " << filename << " \n";
+      std::remove(tmpfile.c_str());
+      return false;
+   }
+   return true;
+}
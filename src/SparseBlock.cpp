@@ -0,0 +1,314 @@
+//********************************************************************************
+//* Sparse matrices of 4x4 blocks and their linear solvers (see SparseBlock.h).
+//********************************************************************************
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "../include/SparseBlock.h"
+
+#ifdef CFD_UMFPACK
+#include <umfpack.h>
+#endif
+
+using std::cout;
+
+
+
+bool SparseBlock::direct_available() {
+#ifdef CFD_UMFPACK
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+
+namespace {
+
+// inv = a^{-1} for a 4x4 block, Gauss-Jordan with partial pivoting;
+// false if a is singular.
+bool invert_block(const double* a, double* inv) {
+
+   const int nb = SparseBlock::nb;
+   double m[SparseBlock::nb][2*SparseBlock::nb];
+
+   for (int r = 0; r < nb; r++) {
+      for (int c = 0; c < nb; c++) {
+         m[r][c]    = a[nb*r+c];
+         m[r][nb+c] = (r == c) ? 1.0 : 0.0;
+      }
+   }
+
+   for (int c = 0; c < nb; c++) {
+      int p = c;
+      for (int r = c+1; r < nb; r++) if (std::abs(m[r][c]) > std::abs(m[p][c])) p = r;
+      if (m[p][c] == 0.0 || !std::isfinite(m[p][c])) return false;
+      if (p != c) for (int k = 0; k < 2*nb; k++) std::swap(m[p][k], m[c][k]);
+
+      const double s = 1.0/m[c][c];
+      for (int k = 0; k < 2*nb; k++) m[c][k] *= s;
+      for (int r = 0; r < nb; r++) {
+         if (r == c || m[r][c] == 0.0) continue;
+         const double f = m[r][c];
+         for (int k = 0; k < 2*nb; k++) m[r][k] -= f*m[c][k];
+      }
+   }
+
+   for (int r = 0; r < nb; r++) {
+      for (int c = 0; c < nb; c++) inv[nb*r+c] = m[r][nb+c];
+   }
+   return true;
+}
+
+// y += a*x and y -= a*x (a: 4x4 block, x and y: 4 values)
+inline void add_block_product(const double* a, const double* x, double* y) {
+   for (int r = 0; r < SparseBlock::nb; r++) {
+      const double* ar = a + SparseBlock::nb*r;
+      y[r] += ar[0]*x[0] + ar[1]*x[1] + ar[2]*x[2] + ar[3]*x[3];
+   }
+}
+
+inline void subtract_block_product(const double* a, const double* x, double* y) {
+   for (int r = 0; r < SparseBlock::nb; r++) {
+      const double* ar = a + SparseBlock::nb*r;
+      y[r] -= ar[0]*x[0] + ar[1]*x[1] + ar[2]*x[2] + ar[3]*x[3];
+   }
+}
+
+double norm2(const double* v, size_t n) {
+   double s = 0.0;
+   for (size_t k = 0; k < n; k++) s += v[k]*v[k];
+   return std::sqrt(s);
+}
+
+} // end anonymous namespace
+
+
+
+SparseBlock::BlockMatrix::~BlockMatrix() {
+   free_factors();
+}
+
+
+
+void SparseBlock::BlockMatrix::set_pattern(int nrows, const std::vector<int>& ptr_in,
+                                           const std::vector<int>& idx_in) {
+   free_factors();
+   n   = nrows;
+   ptr = &ptr_in;
+   idx = &idx_in;
+   d.assign(size_t(nb2)*n, 0.0);
+   o.assign(size_t(nb2)*idx_in.size(), 0.0);
+   dinv.assign(size_t(nb2)*n, 0.0);
+   ap.clear();
+}
+
+
+
+void SparseBlock::BlockMatrix::zero() {
+   std::fill(d.begin(), d.end(), 0.0);
+   std::fill(o.begin(), o.end(), 0.0);
+   dinv_ready = false;
+}
+
+
+
+bool SparseBlock::BlockMatrix::invert_diagonal() {
+   if (dinv_ready) return true;
+   for (int i = 0; i < n; i++) {
+      if ( !invert_block(diag(i), &dinv[nb2*i]) ) return false;
+   }
+   dinv_ready = true;
+   return true;
+}
+
+
+
+void SparseBlock::BlockMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const {
+   y.resize(size_t(nb)*n);
+   multiply(x.data(), y.data());
+}
+
+
+
+void SparseBlock::BlockMatrix::multiply(const double* x, double* y) const {
+
+   for (int i = 0; i < n; i++) {
+      double* yi = &y[nb*i];
+      for (int c = 0; c < nb; c++) yi[c] = 0.0;
+      add_block_product(diag(i), &x[nb*i], yi);
+      for (int k = row_begin(i); k < row_end(i); k++) {
+         add_block_product(off(k), &x[nb*col(k)], yi);
+      }
+   }
+}
+
+
+
+//********************************************************************************
+//* Symmetric block Gauss-Seidel:
+//*
+//*   x_i <- D_i^{-1} ( b_i - sum_{j != i} A_ij x_j ),  i = 1..n, then i = n..1
+//*
+//* x is updated in place, so each row uses the newest values of its neighbors.
+//* The residual norm is checked after each sweep pair (tolerance > 0).
+//********************************************************************************
+int SparseBlock::BlockMatrix::solve_gs(const std::vector<double>& b, std::vector<double>& x,
+                                       int max_sweeps, double tolerance, bool& ok) {
+
+   x.resize(size_t(nb)*n, 0.0);
+   return solve_gs(b.data(), x.data(), max_sweeps, tolerance, ok);
+}
+
+
+
+int SparseBlock::BlockMatrix::solve_gs(const double* b, double* x,
+                                       int max_sweeps, double tolerance, bool& ok) {
+
+   ok = invert_diagonal();
+   if (!ok) return 0;
+
+   const size_t nn = size_t(nb)*n;
+   const double bnorm = (tolerance > 0.0) ? norm2(b, nn) : 0.0;
+   std::vector<double> r(tolerance > 0.0 ? nn : 0);
+   double ri[nb];
+
+   int sweep = 0;
+   while (sweep < max_sweeps) {
+
+      for (int pass = 0; pass < 2; pass++) {
+         for (int m = 0; m < n; m++) {
+            const int i = (pass == 0) ? m : n-1-m;
+            for (int c = 0; c < nb; c++) ri[c] = b[nb*i+c];
+            for (int k = row_begin(i); k < row_end(i); k++) {
+               subtract_block_product(off(k), &x[nb*col(k)], ri);
+            }
+            const double* di = &dinv[nb2*i];
+            for (int c = 0; c < nb; c++) {
+               x[nb*i+c] = di[nb*c]*ri[0] + di[nb*c+1]*ri[1] + di[nb*c+2]*ri[2] + di[nb*c+3]*ri[3];
+            }
+         }
+      }
+      sweep++;
+
+      if (tolerance > 0.0) {
+         multiply(x, r.data());
+         for (size_t k = 0; k < nn; k++) r[k] = b[k] - r[k];
+         if (norm2(r.data(), nn) <= tolerance*bnorm) break;
+      }
+   }
+
+   return sweep;
+}
+
+
+
+//********************************************************************************
+//* Block Jacobi: x_i = D_i^{-1} b_i.
+//********************************************************************************
+bool SparseBlock::BlockMatrix::solve_block_jacobi(const double* b, double* x) {
+
+   if ( !invert_diagonal() ) return false;
+   for (int i = 0; i < n; i++) {
+      const double* di = &dinv[nb2*i];
+      const double* bi = &b[nb*i];
+      for (int c = 0; c < nb; c++) {
+         x[nb*i+c] = di[nb*c]*bi[0] + di[nb*c+1]*bi[1] + di[nb*c+2]*bi[2] + di[nb*c+3]*bi[3];
+      }
+   }
+   return true;
+}
+
+
+
+//********************************************************************************
+//* Sparse LU (UMFPACK). UMFPACK takes compressed columns; the CSR arrays of A
+//* are the compressed columns of A^T, and UMFPACK_At solves with the
+//* transpose of that, i.e., A x = b.
+//********************************************************************************
+void SparseBlock::BlockMatrix::build_scalar_pattern() {
+
+   // Block columns of each block row, sorted: -1-i for the diagonal, k for off(k).
+   const size_t nnz = size_t(nb2)*(n + idx->size());
+   ap.assign(size_t(nb)*n + 1, 0);
+   ai.resize(nnz);
+   ax.resize(nnz);
+   ax_source.resize(nnz);
+
+   std::vector< std::pair<int,int> > cols;   // (block column, source)
+   size_t e = 0;
+   for (int i = 0; i < n; i++) {
+      cols.clear();
+      cols.push_back(std::make_pair(i, -1));
+      for (int k = row_begin(i); k < row_end(i); k++) cols.push_back(std::make_pair(col(k), k));
+      std::sort(cols.begin(), cols.end());
+
+      for (int r = 0; r < nb; r++) {
+         for (const auto& jc : cols) {
+            for (int c = 0; c < nb; c++) {
+               ai[e] = nb*jc.first + c;
+               ax_source[e] = (jc.second < 0) ? nb2*i + nb*r + c
+                                              : -1 - (nb2*jc.second + nb*r + c);
+               e++;
+            }
+         }
+         ap[nb*i+r+1] = int(e);
+      }
+   }
+}
+
+
+
+bool SparseBlock::BlockMatrix::solve_direct(const std::vector<double>& b, std::vector<double>& x) {
+
+#ifdef CFD_UMFPACK
+   if (ap.empty()) build_scalar_pattern();
+   for (size_t e = 0; e < ax.size(); e++) {
+      const int s = ax_source[e];
+      ax[e] = (s >= 0) ? d[s] : o[-1-s];
+   }
+
+   const int nn = nb*n;
+   double control[UMFPACK_CONTROL], info[UMFPACK_INFO];
+   umfpack_di_defaults(control);
+
+   if (!symbolic) {
+      if (umfpack_di_symbolic(nn, nn, ap.data(), ai.data(), ax.data(), &symbolic, control, info) != UMFPACK_OK) {
+         cout << " UMFPACK: symbolic factorization failed \n";
+         symbolic = nullptr;
+         return false;
+      }
+   }
+
+   void* numeric = nullptr;
+   int status = umfpack_di_numeric(ap.data(), ai.data(), ax.data(), symbolic, &numeric, control, info);
+   if (status == UMFPACK_OK) {
+      x.resize(nn);
+      status = umfpack_di_solve(UMFPACK_At, ap.data(), ai.data(), ax.data(),
+                                x.data(), b.data(), numeric, control, info);
+   }
+   if (numeric) umfpack_di_free_numeric(&numeric);
+
+   if (status != UMFPACK_OK) {
+      cout << " UMFPACK: factorization or solve failed, status = " << status << " \n";
+      return false;
+   }
+   return true;
+#else
+   (void)b; (void)x;
+   cout << " Built without -DCFD_UMFPACK: no direct solver \n";
+   return false;
+#endif
+}
+
+
+
+void SparseBlock::BlockMatrix::free_factors() {
+#ifdef CFD_UMFPACK
+   if (symbolic) umfpack_di_free_symbolic(&symbolic);
+#endif
+   symbolic = nullptr;
+}
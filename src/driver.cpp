@@ -12,14 +12,63 @@
 
 
 
-int main(){
-
-    if (false){
-        EulerSolver1D::driverEuler1D();
-    }else if (true){
-        EulerSolver2D::driverEuler2D();
-    }else{
-        Grid2D::driverGrid2D();
+//======================================
+// case queue (case files and key=value arguments)
+#include "../include/CaseFile.h"
+
+//======================================
+// ranks of a multi-process run
+#include "../include/Halo.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+
+//********************************************************************************
+//* Usage:  run/Euler2D [key=value ...] [case_file ...]
+//*
+//* Without arguments: the 2D shock diffraction case with the default
+//* parameters. The solver of each case is selected by "solver":
+//* euler2d (default), euler1d (Sod's shock tube) or gridgen.
+//* Consecutive euler2d cases run as one batch, so that they share the grid
+//* and the LSQ coefficients when they can (see program_2D_euler_rk2).
+//*
+//* "ranks" of the first case starts that many processes (see Halo.h); they all
+//* run the euler2d cases on their subdomains, the other solvers run on rank 0.
+//********************************************************************************
+int main(int argc, char** argv){
+
+    std::vector<CaseFile::Case> cases = CaseFile::cases_from_args(argc, argv);
+
+    Halo::start(argc, argv, cases.empty() ? 1 : cases[0].get_int("ranks", 1));
+
+    size_t i = 0;
+    while (i < cases.size()){
+
+        const std::string solver = cases[i].get("solver", "euler2d");
+
+        if (solver == "euler1d"){
+            if (Halo::rank() == 0) EulerSolver1D::driverEuler1D(cases[i]);
+            i++;
+        }else if (solver == "euler2d"){
+            size_t j = i;
+            while (j < cases.size() && cases[j].get("solver", "euler2d") == "euler2d") j++;
+            EulerSolver2D::driverEuler2D(
+                std::vector<CaseFile::Case>(cases.begin()+i, cases.begin()+j));
+            i = j;
+        }else if (solver == "gridgen"){
+            cases[i].check_keys({"solver"});
+            if (Halo::rank() == 0) Grid2D::driverGrid2D();
+            i++;
+        }else{
+            std::cout << " Case " << cases[i].name << ": unknown solver " << solver
+                      << " (euler1d, euler2d or gridgen)\n";
+            Halo::finish();
+            return 1;
+        }
     }
-    return 1;
-}
\ No newline at end of file
+    Halo::finish();
+    return 0;
+}
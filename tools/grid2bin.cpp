@@ -0,0 +1,30 @@
+//********************************************************************************
+//* grid2bin: convert an ASCII grid file (project.grid) to the binary format
+//*           read (memory-mapped) by MainData2D::read_grid.
+//*
+//* Usage: run/grid2bin project.grid project.bcmap project.grid.bin
+//*
+//* The boundary condition file is only needed because read_grid reads it;
+//* the binary file holds the grid only, the .bcmap file is still used as is.
+//********************************************************************************
+#include <iostream>
+#include <string>
+
+// tests_array.hpp declares "int main();" for the solver executable;
+// skip it, this tool has its own main(argc, argv).
+#define __TESTS_ARRAY_INCLUDED__
+#include "../include/EulerUnsteady2D_basic_package.h"
+
+int main(int argc, char** argv) {
+
+   if (argc != 4) {
+      std::cout << " Usage: " << argv[0] << " grid_in(ascii) bcmap_in grid_out(binary)" << std::endl;
+      return 1;
+   }
+
+   EulerSolver2D::MainData2D grid;
+   grid.read_grid(argv[1], argv[2]);
+   grid.write_grid_binary(argv[3]);
+
+   return 0;
+}